@@ -16,7 +16,7 @@
 #
 
 Name:           yast2-pkg-bindings-devel-doc
-Version:        3.2.1
+Version:        3.2.61
 Release:        0
 License:        GPL-2.0
 Group:          Documentation/HTML
@@ -27,6 +27,8 @@ Prefix:         %_prefix
 # same as in the main package (because we use the same configure.in.in)
 BuildRequires:  docbook-xsl-stylesheets
 BuildRequires:  gcc-c++
+# the pool internals for Pkg::MemoryStats()
+BuildRequires:  libsolv-devel
 BuildRequires:  libtool
 BuildRequires:  libxslt
 BuildRequires:  libzypp-devel >= 14.29.0
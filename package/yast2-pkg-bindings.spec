@@ -17,7 +17,7 @@
 
 
 Name:           yast2-pkg-bindings
-Version:        3.2.1
+Version:        3.2.61
 Release:        0
 
 BuildRoot:      %{_tmppath}/%{name}-%{version}-build
@@ -28,6 +28,8 @@ License:        GPL-2.0
 
 BuildRequires:  docbook-xsl-stylesheets
 BuildRequires:  gcc-c++
+# the pool internals for Pkg::MemoryStats()
+BuildRequires:  libsolv-devel
 BuildRequires:  libtool
 BuildRequires:  libxslt
 BuildRequires:  libzypp-devel >= 14.29.0
@@ -0,0 +1,209 @@
+/*
+ * File:   BackgroundJobs.cc
+ *
+ * Run jobs in forked background processes while the main process
+ * continues, the caller collects the results later.
+ */
+
+#include "BackgroundJobs.h"
+#include "PkgProfiler.h"
+#include "log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// poll interval for the finished children (in microseconds)
+static const useconds_t poll_interval = 50000;
+
+BackgroundJobs::BackgroundJobs(unsigned max_jobs)
+  : _max_jobs(max_jobs > 0 ? max_jobs : PkgWorkers::defaultJobs()),
+  _running(0)
+{
+}
+
+BackgroundJobs::~BackgroundJobs()
+{
+  clear();
+}
+
+void BackgroundJobs::start(long long id, const PkgWorkers::Job &job, const PkgWorkers::ChildSetupFnc &child_setup)
+{
+  remove(id);
+
+  Task task;
+  task.job = job;
+  task.child_setup = child_setup;
+  task.pid = 0;
+  task.status = -1;
+
+  _tasks[id] = task;
+  _queue.push_back(id);
+
+  poll();
+}
+
+// collect the finished processes, start the queued jobs
+void BackgroundJobs::poll()
+{
+  for (std::map<long long, Task>::iterator it = _tasks.begin(); it != _tasks.end(); ++it)
+  {
+    Task &task = it->second;
+
+    if (task.pid <= 0)
+      continue;
+
+    int status = 0;
+    pid_t ret = ::waitpid(task.pid, &status, WNOHANG);
+
+    if (ret == 0 || (ret < 0 && errno == EINTR))
+      continue;
+
+    task.status = (ret > 0 && WIFEXITED(status)) ? WEXITSTATUS(status) : PkgWorkers::JOB_FAILED;
+    task.pid = 0;
+    --_running;
+
+    y2milestone("Background job %lld finished with status %d", it->first, task.status);
+  }
+
+  while (!_queue.empty() && _running < _max_jobs)
+  {
+    long long id = _queue.front();
+    _queue.pop_front();
+
+    Task &task = _tasks[id];
+    pid_t pid = ::fork();
+
+    if (pid == 0)
+    {
+      // child process
+      int status = PkgWorkers::JOB_FAILED;
+
+      try
+      {
+        if (task.child_setup)
+          task.child_setup();
+
+        status = task.job();
+      }
+      catch (...)
+      {
+        status = PkgWorkers::JOB_FAILED;
+      }
+
+      // do not run the atexit handlers and the static destructors,
+      // they belong to the parent process
+      ::_exit(status);
+    }
+
+    if (pid < 0)
+    {
+      y2error("Cannot fork a background process: %s", ::strerror(errno));
+      task.status = PkgWorkers::JOB_FAILED;
+      continue;
+    }
+
+    y2milestone("Started background process %d for job %lld", pid, id);
+    task.pid = pid;
+    ++_running;
+  }
+}
+
+bool BackgroundJobs::finished(const std::set<long long> &ids) const
+{
+  for (std::map<long long, Task>::const_iterator it = _tasks.begin(); it != _tasks.end(); ++it)
+  {
+    if (it->second.status == -1 && (ids.empty() || ids.find(it->first) != ids.end()))
+      return false;
+  }
+
+  return true;
+}
+
+bool BackgroundJobs::wait(const std::set<long long> &ids, long long timeout)
+{
+  long long deadline = PkgProfiler::now() + timeout * 1000;
+
+  poll();
+
+  while (!finished(ids))
+  {
+    if (timeout >= 0 && PkgProfiler::now() >= deadline)
+      return false;
+
+    ::usleep(poll_interval);
+    poll();
+  }
+
+  return true;
+}
+
+int BackgroundJobs::status(long long id)
+{
+  poll();
+
+  std::map<long long, Task>::const_iterator it = _tasks.find(id);
+  return it == _tasks.end() ? (int)PkgWorkers::JOB_ABORTED : it->second.status;
+}
+
+std::set<long long> BackgroundJobs::ids() const
+{
+  std::set<long long> ret;
+
+  for (std::map<long long, Task>::const_iterator it = _tasks.begin(); it != _tasks.end(); ++it)
+    ret.insert(it->first);
+
+  return ret;
+}
+
+void BackgroundJobs::stop(Task &task)
+{
+  if (task.pid <= 0)
+    return;
+
+  y2milestone("Killing background process %d", task.pid);
+  ::kill(task.pid, SIGTERM);
+
+  int status;
+  while (::waitpid(task.pid, &status, 0) < 0 && errno == EINTR) {}
+
+  task.pid = 0;
+  task.status = PkgWorkers::JOB_ABORTED;
+  --_running;
+}
+
+void BackgroundJobs::remove(long long id)
+{
+  std::map<long long, Task>::iterator it = _tasks.find(id);
+
+  if (it == _tasks.end())
+    return;
+
+  stop(it->second);
+  _tasks.erase(it);
+
+  for (std::deque<long long>::iterator q = _queue.begin(); q != _queue.end(); ++q)
+  {
+    if (*q == id)
+    {
+      _queue.erase(q);
+      break;
+    }
+  }
+
+  // a slot might be free now
+  poll();
+}
+
+void BackgroundJobs::clear()
+{
+  _queue.clear();
+
+  for (std::map<long long, Task>::iterator it = _tasks.begin(); it != _tasks.end(); ++it)
+    stop(it->second);
+
+  _tasks.clear();
+}
@@ -0,0 +1,75 @@
+/*
+ * File:   BackgroundJobs.h
+ *
+ * Run jobs in forked background processes while the main process
+ * continues, the caller collects the results later.
+ *
+ * (Note: the same restrictions as for PkgWorkers apply, the jobs must not
+ * call back into YCP and the results are passed back only via the exit
+ * status. The jobs are identified by an ID (e.g. the repository ID),
+ * the jobs above the limit wait in a queue and are started when a running
+ * job is collected.)
+ */
+
+#ifndef BACKGROUNDJOBS_H
+#define BACKGROUNDJOBS_H
+
+#include <deque>
+#include <map>
+#include <set>
+
+#include <sys/types.h>
+
+#include "PkgWorkers.h"
+
+class BackgroundJobs {
+
+public:
+  // max_jobs - max. number of running processes (0 = number of CPUs)
+  BackgroundJobs(unsigned max_jobs = 0);
+  // kills the running jobs
+  ~BackgroundJobs();
+
+  // start or queue a job, a previous job with the same ID is killed
+  void start(long long id, const PkgWorkers::Job &job,
+    const PkgWorkers::ChildSetupFnc &child_setup = PkgWorkers::ChildSetupFnc());
+
+  // wait for the jobs (empty set = all jobs), timeout in milliseconds
+  // (0 = just check, negative = no limit), returns true when all have finished
+  bool wait(const std::set<long long> &ids, long long timeout);
+
+  // the exit status of a finished job, -1 if it is still running or queued
+  // and PkgWorkers::JOB_ABORTED if there is no such job
+  int status(long long id);
+
+  // the known (running, queued or finished) jobs
+  std::set<long long> ids() const;
+
+  // forget a finished job, kill it if it is still running
+  void remove(long long id);
+
+  // kill all jobs
+  void clear();
+
+private:
+  struct Task {
+    PkgWorkers::Job job;
+    PkgWorkers::ChildSetupFnc child_setup;
+    // 0 = not started yet
+    pid_t pid;
+    // -1 = not finished yet
+    int status;
+  };
+
+  void poll();
+  bool finished(const std::set<long long> &ids) const;
+  void stop(Task &task);
+
+  unsigned _max_jobs;
+  unsigned _running;
+  std::map<long long, Task> _tasks;
+  // the jobs waiting for a free slot
+  std::deque<long long> _queue;
+};
+
+#endif	/* BACKGROUNDJOBS_H */
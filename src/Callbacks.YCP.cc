@@ -126,18 +126,38 @@
         ENUM_OUT( FileConflictProgress );
         ENUM_OUT( FileConflictReport );
         ENUM_OUT( FileConflictFinish );
+        ENUM_OUT( PoolChanged );
+        ENUM_OUT( SolverTestCaseDone );
 #undef ENUM_OUT
+	case CB_Count: break;
 	// no default! let compiler warn missing values
       }
       return stringutil::form( "CBid(%d)", id_r );
     }
 
+    PkgFunctions::CallbackHandler::YCPCallbacks::~YCPCallbacks() {
+       for (int id = 0; id < CB_Count; ++id)
+       {
+	   for_(it, _cbdata[id].begin(), _cbdata[id].end())
+	   {
+	       // a busy object is deleted by releaseCallback()
+	       if (!it->_busy)
+		   delete it->_func;
+	   }
+       }
+    }
+
     void PkgFunctions::CallbackHandler::YCPCallbacks::popCallback( CBid id_r ) {
-       _cbdata_t::iterator tmp1 = _cbdata.find(id_r);
-       if (tmp1 != _cbdata.end() && !tmp1->second.empty())
+       _cbstack_t &cbstack = _cbdata[id_r];
+       if (!cbstack.empty())
        {
 	   y2debug("Unregistering callback, restoring the previous one");
-           tmp1->second.pop();
+
+	   // the busy object is not in the stack anymore, releaseCallback() will delete it
+	   if (!cbstack.back()._busy)
+	       delete cbstack.back()._func;
+
+           cbstack.pop_back();
        }
     }
 
@@ -147,7 +167,7 @@
     void PkgFunctions::CallbackHandler::YCPCallbacks::setCallback( CBid id_r, const YCPReference &func_r ) {
 	y2debug ("Registering callback %s", cbName(id_r).c_str());
 
-        _cbdata[id_r].push(func_r);
+        _cbdata[id_r].push_back(CBdata(func_r));
     }
 
     /**
@@ -178,21 +198,20 @@
      * no need to create and evaluate it.
      **/
     bool PkgFunctions::CallbackHandler::YCPCallbacks::isSet( CBid id_r ) const {
-       const _cbdata_t::const_iterator tmp1 = _cbdata.find(id_r);
-       return tmp1 != _cbdata.end() && !tmp1->second.empty();
+       return !_cbdata[id_r].empty();
     }
 
     /**
-     * @return The YCPCallback term, ready to append any arguments.
+     * @return The number of registered callbacks (all stacks).
      **/
-    Y2Function* PkgFunctions::CallbackHandler::YCPCallbacks::createCallback( CBid id_r ) const {
-	const _cbdata_t::const_iterator tmp1 = _cbdata.find(id_r);
-
-	if (tmp1 == _cbdata.end())
-	    return NULL;
-
-	const YCPReference func(tmp1->second.top());
+    unsigned PkgFunctions::CallbackHandler::YCPCallbacks::size() const {
+       unsigned ret = 0;
+       for ( unsigned id = 0; id < CB_Count; ++id )
+         ret += _cbdata[id].size();
+       return ret;
+    }
 
+    Y2Function* PkgFunctions::CallbackHandler::YCPCallbacks::createFunctionCall( const YCPReference &func ) const {
 	if (func.isNull() || ! func->isReference())
 	{
 	    // TODO
@@ -219,6 +238,49 @@
 	return functioncall;
     }
 
+    /**
+     * @return The YCPCallback term, ready to append any arguments.
+     **/
+    Y2Function* PkgFunctions::CallbackHandler::YCPCallbacks::createCallback( CBid id_r ) const {
+	_cbstack_t &cbstack = _cbdata[id_r];
+
+	if (cbstack.empty())
+	    return NULL;
+
+	CBdata &cb = cbstack.back();
+
+	// nested call of the same callback, the cached object is in use
+	if (cb._busy)
+	    return createFunctionCall(cb._ref);
+
+	if (!cb._func)
+	    cb._func = createFunctionCall(cb._ref);
+
+	if (cb._func)
+	    cb._busy = true;
+
+	return cb._func;
+    }
+
+    void PkgFunctions::CallbackHandler::YCPCallbacks::releaseCallback( CBid id_r, Y2Function* func_r ) const {
+	_cbstack_t &cbstack = _cbdata[id_r];
+
+	// the callback might have been registered or unregistered meanwhile,
+	// search the whole stack
+	for_(it, cbstack.begin(), cbstack.end())
+	{
+	    if (it->_func == func_r && it->_busy)
+	    {
+		func_r->reset();
+		it->_busy = false;
+		return;
+	    }
+	}
+
+	// not cached
+	delete func_r;
+    }
+
 
 bool PkgFunctions::CallbackHandler::YCPCallbacks::Send::CB::expecting( YCPValueType exp_r ) const
 {
@@ -234,8 +296,8 @@ bool PkgFunctions::CallbackHandler::YCPCallbacks::Send::CB::evaluate()
       y2debug ("Evaluating callback (registered funciton: %s)", _func->name().c_str());
       _result = _func->evaluateCall ();
 
-      delete _func;
-      _func = _send.ycpcb().createCallback( _id );
+      // clear the parameters, the object can be used again
+      _func->reset();
       return true;
     }
 
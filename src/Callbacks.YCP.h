@@ -107,6 +107,12 @@ class PkgFunctions::CallbackHandler::YCPCallbacks
       CB_ProcessNextStage,
       CB_ProcessProgress,
       CB_ProcessFinished,
+
+      CB_PoolChanged,
+      CB_SolverTestCaseDone,
+
+      // number of the callbacks, must be the last value
+      CB_Count
     };
 
     /**
@@ -117,8 +123,28 @@ class PkgFunctions::CallbackHandler::YCPCallbacks
     static string cbName( CBid id_r );
   private:
 
-    typedef map <CBid, stack<YCPReference> > _cbdata_t;
-    _cbdata_t _cbdata;
+    /**
+     * A registered callback. The function call object is created
+     * at the first use and then reused for all the next calls.
+     **/
+    struct CBdata {
+      YCPReference _ref;
+      Y2Function * _func;
+      // the function call object is being evaluated
+      bool _busy;
+
+      CBdata( const YCPReference & ref_r )
+	: _ref( ref_r )
+	, _func( NULL )
+	, _busy( false )
+      {}
+    };
+
+    // callback stack for each CBid, the last one is the active one
+    typedef vector<CBdata> _cbstack_t;
+    mutable _cbstack_t _cbdata[CB_Count];
+
+    Y2Function* createFunctionCall( const YCPReference & func ) const;
 
   public:
 
@@ -128,6 +154,11 @@ class PkgFunctions::CallbackHandler::YCPCallbacks
     YCPCallbacks( )
     {}
 
+    /**
+     * Destructor, deletes the cached function call objects.
+     **/
+    ~YCPCallbacks( );
+
 
     void popCallback( CBid id_r );
 
@@ -148,13 +179,59 @@ class PkgFunctions::CallbackHandler::YCPCallbacks
      **/
     bool isSet( CBid id_r ) const;
 
+    /**
+     * @return The number of registered callbacks (all stacks).
+     **/
+    unsigned size() const;
+
   public:
 
     /**
      * @return The YCPCallback term, ready to append any arguments.
+     * The cached function call object is returned if it is not being
+     * evaluated (nested callback), return it back by @ref releaseCallback.
      **/
     Y2Function* createCallback( CBid id_r ) const;
 
+    /**
+     * Release the function call object returned by @ref createCallback,
+     * the cached object is reset for the next call, other objects are deleted.
+     **/
+    void releaseCallback( CBid id_r, Y2Function* func_r ) const;
+
+    /**
+     * @short Releases the object returned by @ref createCallback at the scope end
+     *
+     * The object is released also when the evaluated YCP callback throws,
+     * otherwise the cached object would stay busy. NULL is ignored.
+     * <PRE>
+     *   Y2Function* func = ycpcb.createCallback( CB_ProcessStart );
+     *   YCPCallbacks::Release release( ycpcb, CB_ProcessStart, func );
+     * </PRE>
+     **/
+    class Release {
+      public:
+	Release( const YCPCallbacks & ycpcb_r, CBid id_r, Y2Function* func_r )
+	  : _ycpcb( ycpcb_r )
+	  , _id( id_r )
+	  , _func( func_r )
+	{}
+
+	~Release()
+	{
+	  if (_func) _ycpcb.releaseCallback( _id, _func );
+	}
+
+      private:
+	// not copyable
+	Release( const Release & );
+	Release & operator=( const Release & );
+
+	const YCPCallbacks & _ycpcb;
+	CBid _id;
+	Y2Function* _func;
+    };
+
   public:
 
     /**
@@ -183,13 +260,13 @@ class PkgFunctions::CallbackHandler::YCPCallbacks
 	    : _send( send_r )
 	    , _id( func )
 	    , _set( _send.ycpcb().isSet( func ) )
-	    , _func( _send.ycpcb().createCallback( func ) )
+	    , _func( _set ? _send.ycpcb().createCallback( func ) : NULL )
 	    , _result( YCPVoid() )
 	  {}
 
 	  ~CB ()
 	  {
-	    if (_func) delete _func;
+	    if (_func) _send.ycpcb().releaseCallback( _id, _func );
 	  }
 
 	  CB & addStr( const string & arg ) { if (_func != NULL) _func->appendParameter( YCPString( arg ) ); return *this; }
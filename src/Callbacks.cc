@@ -43,6 +43,7 @@
 #include "zypp/target/rpm/RpmDb.h"
 
 #include <ctime>
+#include <map>
 
 // FIXME: do this nicer, source create use this to avoid user feedback
 // on probing of source type
@@ -58,7 +59,7 @@ typedef std::map<zypp::Url, MediaMap> RedirectMap;
 RedirectMap redirect_map;
 
 // default timeout for callbacks, evaluate the callbacks after 3 seconds
-// even if the progress percent has not been changed
+// even if the progress percent has not been changed (see ProgressThrottle)
 static const time_t callback_timeout = 3;
 
 ///////////////////////////////////////////////////////////////////
@@ -67,11 +68,144 @@ namespace ZyppRecipients {
 
   typedef PkgFunctions::CallbackHandler::YCPCallbacks YCPCallbacks;
 
+  ProgressThrottle::ProgressThrottle()
+    : min_delta( 5 )
+    , min_interval( 0 )
+    , timeout( callback_timeout * 1000LL )
+    , async( false )
+    , async_interval( 200 )
+    , forwarded( 0 )
+    , suppressed( 0 )
+    , coalesced( 0 )
+    , abort_requested( 0 )
+  {}
+
+  bool ProgressThrottle::takeAbort()
+  {
+    if ( !abort_requested )
+      return false;
+
+    y2milestone( "Aborting the progress on request" );
+    abort_requested = 0;
+    return true;
+  }
+
+  ProgressLimiter::ProgressLimiter()
+    : _last_value( 0 )
+    , _last_time( PkgProfiler::nowMs() )
+    , _pending( -1 )
+  {}
+
+  void ProgressLimiter::reset( int value )
+  {
+    _last_value = value;
+    _last_time = PkgProfiler::nowMs();
+    _pending = -1;
+  }
+
+  bool ProgressLimiter::pass( ProgressThrottle & throttle, int value, bool finish )
+  {
+    long long now = PkgProfiler::nowMs();
+    long long elapsed = now - _last_time;
+    int delta = value > _last_value ? value - _last_value : _last_value - value;
+
+    if ( finish || value == 100
+      || ( elapsed >= throttle.min_interval
+	&& ( delta >= throttle.min_delta || ( throttle.timeout > 0 && elapsed >= throttle.timeout ) ) ) )
+    {
+      _last_value = value;
+      _last_time = now;
+      ++throttle.forwarded;
+      return true;
+    }
+
+    ++throttle.suppressed;
+    return false;
+  }
+
+  bool ProgressLimiter::passAlive( ProgressThrottle & throttle )
+  {
+    long long now = PkgProfiler::nowMs();
+
+    if ( now - _last_time >= throttle.min_interval )
+    {
+      _last_time = now;
+      ++throttle.forwarded;
+      return true;
+    }
+
+    ++throttle.suppressed;
+    return false;
+  }
+
+  bool ProgressLimiter::passAsync( ProgressThrottle & throttle, int value )
+  {
+    if ( !throttle.async )
+      return pass( throttle, value );
+
+    long long now = PkgProfiler::nowMs();
+
+    if ( value == 100 || now - _last_time >= throttle.async_interval )
+    {
+      _last_value = value;
+      _last_time = now;
+      _pending = -1;
+      ++throttle.forwarded;
+      return true;
+    }
+
+    // keep only the latest value
+    _pending = value;
+    ++throttle.coalesced;
+    return false;
+  }
+
+  bool ProgressLimiter::takePending( int & value )
+  {
+    if ( _pending < 0 )
+      return false;
+
+    value = _pending;
+    _last_value = _pending;
+    _pending = -1;
+    return true;
+  }
+
+  CommitStats::CommitStats()
+    : active( false )
+  {
+    start();
+    active = false;
+  }
+
+  void CommitStats::start()
+  {
+    active = true;
+    total_time = prefetch_time = download_time = check_time = rpm_time = script_time = 0;
+    downloaded_bytes = 0;
+    downloaded = installed = removed = scripts = 0;
+    install_latency.clear();
+
+    started = PkgProfiler::nowMs();
+    download_start = transfer_end = rpm_start = script_start = 0;
+  }
+
+  void CommitStats::stop()
+  {
+    if ( !active )
+      return;
+
+    total_time = PkgProfiler::nowMs() - started;
+    active = false;
+  }
+
   ///////////////////////////////////////////////////////////////////
   // Data excange. Shared between Recipients, inherited by ZyppReceive.
   ///////////////////////////////////////////////////////////////////
   struct RecipientCtl {
     const YCPCallbacks & _ycpcb;
+    ProgressThrottle _throttle;
+    CommitStats _commit_stats;
     public:
       RecipientCtl( const YCPCallbacks & ycpcb_r )
 	: _ycpcb( ycpcb_r )
@@ -91,6 +225,12 @@ namespace ZyppRecipients {
         , _control( control_r )
       {}
       virtual ~Recipient() {}
+
+      // shared progress rate limit settings
+      ProgressThrottle & throttle() { return _control._throttle; }
+
+      // shared commit statistics
+      CommitStats & stats() { return _control._commit_stats; }
   };
 
 
@@ -99,6 +239,8 @@ namespace ZyppRecipients {
     ///////////////////////////////////////////////////////////////////
     struct ConvertDbReceive : public Recipient, public zypp::callback::ReceiveReport<zypp::target::rpm::ConvertDBReport>
     {
+	ProgressLimiter _limiter;
+
 	ConvertDbReceive( RecipientCtl & construct_r ) : Recipient( construct_r ) {}
 
 	virtual void reportbegin()
@@ -112,6 +254,7 @@ namespace ZyppRecipients {
 	}
 
 	virtual void start(zypp::Pathname pname) {
+	    _limiter.reset();
 	    CB callback(ycpcb(YCPCallbacks::CB_StartConvertDb));
 	    if (callback._set) {
 		callback.addStr(pname.asString());
@@ -122,7 +265,7 @@ namespace ZyppRecipients {
 	virtual bool progress(int value, zypp::Pathname pth)
 	{
 	    CB callback( ycpcb( YCPCallbacks::CB_ProgressConvertDb ) );
-	    if (callback._set) {
+	    if (callback._set && _limiter.pass(throttle(), value)) {
 		callback.addInt( value );
 		callback.addStr(pth.asString());
 		callback.evaluate();
@@ -150,6 +293,8 @@ namespace ZyppRecipients {
     ///////////////////////////////////////////////////////////////////
     struct RebuildDbReceive : public Recipient, public zypp::callback::ReceiveReport<zypp::target::rpm::RebuildDBReport>
     {
+	ProgressLimiter _limiter;
+
 	RebuildDbReceive( RecipientCtl & construct_r ) : Recipient( construct_r ) {}
 
         virtual void reportbegin()
@@ -162,6 +307,7 @@ namespace ZyppRecipients {
 
 	virtual void start(zypp::Pathname path)
 	{
+	    _limiter.reset();
 	    CB callback( ycpcb( YCPCallbacks::CB_StartRebuildDb ) );
 	    if ( callback._set ) {
 		callback.evaluate();
@@ -171,7 +317,7 @@ namespace ZyppRecipients {
 	virtual bool progress(int value, zypp::Pathname pth)
 	{
 	    CB callback( ycpcb( YCPCallbacks::CB_ProgressRebuildDb ) );
-	    if ( callback._set ) {
+	    if ( callback._set && _limiter.pass(throttle(), value) ) {
 		// report changed values
 		callback.addInt( value );
 		callback.evaluate();
@@ -200,8 +346,7 @@ namespace ZyppRecipients {
     {
 	zypp::Resolvable::constPtr _last;
 	PkgFunctions &_pkg_ref;
-	int last_reported;
-	time_t last_reported_time;
+	ProgressLimiter _limiter;
 
 	InstallPkgReceive(RecipientCtl & construct_r, PkgFunctions &pk) : Recipient(construct_r), _last(NULL), _pkg_ref(pk)
 	{
@@ -218,8 +363,8 @@ namespace ZyppRecipients {
 	virtual void start(zypp::Resolvable::constPtr resolvable)
 	{
 	  // initialize the counter
-	  last_reported = 0;
-	  last_reported_time = time(NULL);
+	  _limiter.reset();
+	  throttle().clearAbort();
 
 #warning install non-package
 	  zypp::Package::constPtr res =
@@ -256,15 +401,20 @@ namespace ZyppRecipients {
 	  }
 
 	  _last = resolvable;
+
+	  if (stats().active)
+	    stats().rpm_start = PkgProfiler::nowMs();
 	}
 
 	virtual bool progress(int value, zypp::Resolvable::constPtr resolvable)
 	{
+	    if (throttle().async && throttle().takeAbort())
+		return false;
+
 	    CB callback( ycpcb( YCPCallbacks::CB_ProgressPackage) );
-	    // call the callback function only if the difference since the last call is at least 5%
-	    // or if 100% is reached or at least 3 seconds have elapsed
-	    time_t current_time = time(NULL);
-	    if (callback._set && (value - last_reported >= 5 || last_reported - value >= 5 || value == 100 || current_time - last_reported_time >= callback_timeout))
+	    // call the callback function only if the progress change is big enough,
+	    // see ProgressThrottle
+	    if (callback._set && _limiter.passAsync(throttle(), value))
 	    {
 		callback.addInt( value );
 		bool res = callback.evaluateBool();
@@ -272,8 +422,6 @@ namespace ZyppRecipients {
 		if( !res )
 		    y2milestone( "Package installation callback returned abort" );
 
-		last_reported = value;
-		last_reported_time = current_time;
 		return res;
 	    }
 
@@ -316,12 +464,39 @@ namespace ZyppRecipients {
         // note: the RpmLevel argument is not used anymore, ignore it
 	virtual void finish(zypp::Resolvable::constPtr resolvable, Error error, const std::string &reason, zypp::target::rpm::InstallResolvableReport::RpmLevel /*level*/)
 	{
+	    throttle().clearAbort();
+
+	    CommitStats &commit_stats = stats();
+	    if (commit_stats.active && commit_stats.rpm_start > 0)
+	    {
+		long long latency = PkgProfiler::nowMs() - commit_stats.rpm_start;
+		commit_stats.rpm_time += latency;
+		commit_stats.rpm_start = 0;
+
+		if (error == NO_ERROR)
+		{
+		    ++commit_stats.installed;
+		    commit_stats.install_latency.push_back(std::make_pair(latency, resolvable->name()));
+		}
+	    }
+
             // errors are handled in the problem() callback above, here just log the message
             if (error != zypp::target::rpm::InstallResolvableReport::NO_ERROR)
             {
                 y2milestone("Error in finish callback: %s", reason.c_str());
             }
 
+            // deliver the last deferred progress
+            int pending;
+            if (_limiter.takePending(pending))
+            {
+                CB progress_callback( ycpcb( YCPCallbacks::CB_ProgressPackage) );
+                if (progress_callback._set) {
+                    progress_callback.addInt( pending );
+                    progress_callback.evaluateBool();
+                }
+            }
+
             CB callback( ycpcb( YCPCallbacks::CB_DonePackage) );
             if (callback._set) {
                 // report no error, errors were already reported in problem() callback above,
@@ -341,6 +516,8 @@ namespace ZyppRecipients {
     ///////////////////////////////////////////////////////////////////
     struct RemovePkgReceive : public Recipient, public zypp::callback::ReceiveReport<zypp::target::rpm::RemoveResolvableReport>
     {
+	ProgressLimiter _limiter;
+
 	RemovePkgReceive( RecipientCtl & construct_r ) : Recipient( construct_r ) {}
 
 	virtual void reportbegin()
@@ -353,6 +530,8 @@ namespace ZyppRecipients {
 
 	virtual void start(zypp::Resolvable::constPtr resolvable)
 	{
+	  _limiter.reset();
+
 	  CB callback( ycpcb( YCPCallbacks::CB_StartPackage ) );
 	  if (callback._set) {
 	    callback.addStr(resolvable->name());
@@ -362,12 +541,15 @@ namespace ZyppRecipients {
 	    callback.addBool(true);	// is_delete = true
 	    callback.evaluate();
 	  }
+
+	  if (stats().active)
+	    stats().rpm_start = PkgProfiler::nowMs();
 	}
 
 	virtual bool progress(int value, zypp::Resolvable::constPtr resolvable)
 	{
 	    CB callback( ycpcb( YCPCallbacks::CB_ProgressPackage) );
-	    if (callback._set) {
+	    if (callback._set && _limiter.pass(throttle(), value)) {
 		callback.addInt( value );
 
 		bool res = callback.evaluateBool();
@@ -413,6 +595,16 @@ namespace ZyppRecipients {
 
 	virtual void finish(zypp::Resolvable::constPtr resolvable, zypp::target::rpm::RemoveResolvableReport::Error error, const std::string &reason)
 	{
+	    CommitStats &commit_stats = stats();
+	    if (commit_stats.active && commit_stats.rpm_start > 0)
+	    {
+		commit_stats.rpm_time += PkgProfiler::nowMs() - commit_stats.rpm_start;
+		commit_stats.rpm_start = 0;
+
+		if (error == zypp::target::rpm::RemoveResolvableReport::NO_ERROR)
+		    ++commit_stats.removed;
+	    }
+
 	    CB callback( ycpcb( YCPCallbacks::CB_DonePackage) );
 	    if (callback._set) {
 		callback.addInt( error );
@@ -425,10 +617,15 @@ namespace ZyppRecipients {
 
     struct ProgressReceive : public Recipient, public zypp::callback::ReceiveReport<zypp::ProgressReport>
     {
+	// the progress tasks can be nested, keep the state per task ID
+	std::map<int, ProgressLimiter> _limiters;
+
 	ProgressReceive( RecipientCtl & construct_r ) : Recipient( construct_r ) {}
 
 	virtual void start(const zypp::ProgressData &task)
 	{
+	    _limiters[task.numericId()].reset(task.reportValue());
+
 	    CB callback( ycpcb( YCPCallbacks::CB_ProgressStart ) );
 	    y2debug("ProgressStart: id:%d, %s", task.numericId(), task.name().c_str());
 
@@ -451,7 +648,8 @@ namespace ZyppRecipients {
 	    CB callback( ycpcb( YCPCallbacks::CB_ProgressProgress ) );
 	    y2debug("ProgressProgress: id:%d, %s: %lld%%", task.numericId(), task.name().c_str(), task.reportValue());
 
-	    if (callback._set)
+	    if (callback._set && (task.reportPercent() ? _limiters[task.numericId()].pass(throttle(), task.reportValue())
+		: _limiters[task.numericId()].passAlive(throttle())))
 	    {
 		callback.addInt( task.numericId() );
 		callback.addInt( task.val() );
@@ -466,6 +664,7 @@ namespace ZyppRecipients {
 	{
 	    CB callback( ycpcb( YCPCallbacks::CB_ProgressDone ) );
 	    y2debug("ProgressFinish: id:%d, %s", task.numericId(), task.name().c_str());
+	    _limiters.erase(task.numericId());
 
 	    if (callback._set)
 	    {
@@ -485,17 +684,9 @@ namespace ZyppRecipients {
 	PkgFunctions &_pkg_ref;
 
 	DownloadResolvableReceive( RecipientCtl & construct_r, PkgFunctions &pk ) : Recipient( construct_r ), _pkg_ref(pk) {}
-	int last_reported;
-	time_t last_reported_time;
-
-	int last_reported_delta_download;
-	time_t last_reported_delta_download_time;
-
-	int last_reported_delta_apply;
-	time_t last_reported_delta_apply_time;
-
-	int last_reported_patch_download;
-	time_t last_reported_patch_download_time;
+	ProgressLimiter _limiter;
+	ProgressLimiter _delta_download_limiter;
+	ProgressLimiter _delta_apply_limiter;
 
 	virtual void reportbegin()
 	{
@@ -508,8 +699,7 @@ namespace ZyppRecipients {
 	virtual void start( zypp::Resolvable::constPtr resolvable_ptr, const zypp::Url &url)
 	{
 	  unsigned size = 0;
-	  last_reported = 0;
-	  last_reported_time = time(NULL);
+	  _limiter.reset();
 
 	  if ( zypp::isKind<zypp::Package> (resolvable_ptr) )
 	  {
@@ -545,10 +735,44 @@ namespace ZyppRecipients {
 	    callback.addBool(remote);
 	    callback.evaluate();
 	  }
+
+	  if (stats().active)
+	  {
+	    stats().download_start = PkgProfiler::nowMs();
+	    stats().transfer_end = 0;
+	  }
 	}
 
 	virtual void finish(zypp::Resolvable::constPtr resolvable, zypp::repo::DownloadResolvableReport::Error error, const std::string &reason)
 	{
+	    CommitStats &commit_stats = stats();
+	    if (commit_stats.active && commit_stats.download_start > 0)
+	    {
+		long long now = PkgProfiler::nowMs();
+
+		// the time after the file transfer is spent in checking the package
+		if (commit_stats.transfer_end > 0)
+		{
+		    commit_stats.download_time += commit_stats.transfer_end - commit_stats.download_start;
+		    commit_stats.check_time += now - commit_stats.transfer_end;
+		}
+		else
+		{
+		    commit_stats.download_time += now - commit_stats.download_start;
+		}
+
+		if (error == zypp::repo::DownloadResolvableReport::NO_ERROR)
+		{
+		    ++commit_stats.downloaded;
+
+		    zypp::Package::constPtr pkg = zypp::asKind<zypp::Package>(resolvable);
+		    if (pkg)
+			commit_stats.downloaded_bytes += pkg->downloadSize();
+		}
+
+		commit_stats.download_start = commit_stats.transfer_end = 0;
+	    }
+
 	    CB callback( ycpcb( YCPCallbacks::CB_DoneProvide) );
 	    if (callback._set) {
 		callback.addInt( error );
@@ -561,11 +785,8 @@ namespace ZyppRecipients {
         virtual bool progress(int value, zypp::Resolvable::constPtr resolvable_ptr)
         {
 	    CB callback( ycpcb( YCPCallbacks::CB_ProgressProvide) );
-	    time_t current_time = time(NULL);
-	    if (callback._set && (value - last_reported >= 5 || last_reported - value >= 5 || value == 100 || current_time - last_reported_time >= callback_timeout))
+	    if (callback._set && _limiter.pass(throttle(), value))
 	    {
-		last_reported = value;
-		last_reported_time = current_time;
 		callback.addInt( value );
 		return callback.evaluateBool(); // return value ignored by RpmDb
 	    }
@@ -606,8 +827,7 @@ namespace ZyppRecipients {
 	virtual void startDeltaDownload( const zypp::Pathname & filename, const zypp::ByteCount & downloadsize )
 	{
 	    // reset the counter
-	    last_reported_delta_download = 0;
-	    last_reported_delta_download_time = time(NULL);
+	    _delta_download_limiter.reset();
 
 	    CB callback( ycpcb( YCPCallbacks::CB_StartDeltaDownload) );
 	    if (callback._set) {
@@ -621,11 +841,8 @@ namespace ZyppRecipients {
 	virtual bool progressDeltaDownload( int value )
 	{
 	    CB callback( ycpcb( YCPCallbacks::CB_ProgressDeltaDownload) );
-	    time_t current_time = time(NULL);
-	    if (callback._set && (value - last_reported_delta_download >= 5 || last_reported_delta_download - value >= 5 || value == 100 || current_time - last_reported_delta_download_time >= callback_timeout))
+	    if (callback._set && _delta_download_limiter.pass(throttle(), value))
 	    {
-		last_reported_delta_download = value;
-		last_reported_delta_download_time = current_time;
 		callback.addInt( value );
 
 		return callback.evaluateBool();
@@ -662,8 +879,7 @@ namespace ZyppRecipients {
 	virtual void startDeltaApply( const zypp::Pathname & filename )
 	{
 	    // reset the counter
-	    last_reported_delta_apply = 0;
-	    last_reported_delta_apply_time = time(NULL);
+	    _delta_apply_limiter.reset();
 
 	    CB callback( ycpcb( YCPCallbacks::CB_StartDeltaApply) );
 	    if (callback._set) {
@@ -676,11 +892,8 @@ namespace ZyppRecipients {
 	virtual void progressDeltaApply( int value )
 	{
 	    CB callback( ycpcb( YCPCallbacks::CB_ProgressDeltaApply ) );
-	    time_t current_time = time(NULL);
-	    if (callback._set && (value - last_reported_delta_apply >= 5 || last_reported_delta_apply - value >= 5 || value == 100 || current_time - last_reported_delta_apply_time >= callback_timeout))
+	    if (callback._set && _delta_apply_limiter.pass(throttle(), value))
 	    {
-		last_reported_delta_apply = value;
-		last_reported_delta_apply_time = current_time;
 		callback.addInt( value );
 
 		callback.evaluate();
@@ -769,15 +982,18 @@ namespace ZyppRecipients {
     ///////////////////////////////////////////////////////////////////
     struct DownloadProgressReceive : public Recipient, public zypp::callback::ReceiveReport<zypp::media::DownloadProgressReport>
     {
-	int last_reported;
-	time_t last_reported_time;
+	ProgressLimiter _limiter;
+	// the speed of the last deferred progress
+	double _pending_bps_avg;
+	double _pending_bps_current;
 
-	DownloadProgressReceive( RecipientCtl & construct_r ) : Recipient( construct_r ) {}
+	DownloadProgressReceive( RecipientCtl & construct_r ) : Recipient( construct_r ),
+	    _pending_bps_avg(0.0), _pending_bps_current(0.0) {}
 
         virtual void start( const zypp::Url &file, zypp::Pathname localfile )
 	{
-	    last_reported = 0;
-	    last_reported_time = time(NULL);
+	    _limiter.reset();
+	    throttle().clearAbort();
 	    CB callback( ycpcb( YCPCallbacks::CB_StartDownload ) );
 
 	    if ( callback._set )
@@ -790,14 +1006,14 @@ namespace ZyppRecipients {
 
         virtual bool progress(int value, const zypp::Url &file, double bps_avg, double bps_current)
         {
+	    if (throttle().async && throttle().takeAbort())
+		return false;
+
 	    CB callback( ycpcb( YCPCallbacks::CB_ProgressDownload ) );
-	    // call the callback function only if the difference since the last call is at least 5%
-	    // or if 100% is reached or if at least 3 seconds have elapsed
-	    time_t current_time = time(NULL);
-	    if (callback._set && (value - last_reported >= 5 || last_reported - value >= 5 || value == 100 || current_time - last_reported_time >= callback_timeout))
+	    // call the callback function only if the progress change is big enough,
+	    // see ProgressThrottle
+	    if (callback._set && _limiter.passAsync(throttle(), value))
 	    {
-		last_reported = value;
-		last_reported_time = current_time;
 		// report changed values
 		callback.addInt( value );
 		callback.addInt( (long long) bps_avg  );
@@ -805,6 +1021,9 @@ namespace ZyppRecipients {
 		return callback.evaluateBool( true ); // default == continue
 	    }
 
+	    _pending_bps_avg = bps_avg;
+	    _pending_bps_current = bps_current;
+
 	    return zypp::media::DownloadProgressReport::progress(value, file, bps_avg, bps_current);
 	}
 
@@ -836,6 +1055,25 @@ namespace ZyppRecipients {
 
         virtual void finish( const zypp::Url &file, zypp::media::DownloadProgressReport::Error error, const std::string &reason)
 	{
+	    throttle().clearAbort();
+
+	    // the end of the file transfer of the currently downloaded package
+	    if (stats().active && stats().download_start > 0)
+		stats().transfer_end = PkgProfiler::nowMs();
+
+	    // deliver the last deferred progress
+	    int pending;
+	    if (_limiter.takePending(pending))
+	    {
+		CB progress_callback( ycpcb( YCPCallbacks::CB_ProgressDownload ) );
+		if (progress_callback._set) {
+		    progress_callback.addInt( pending );
+		    progress_callback.addInt( (long long) _pending_bps_avg );
+		    progress_callback.addInt( (long long) _pending_bps_current );
+		    progress_callback.evaluateBool( true );
+		}
+	    }
+
 	    CB callback( ycpcb( YCPCallbacks::CB_DoneDownload ) );
 
 	    zypp::media::DownloadProgressReport::Error err = error;
@@ -875,6 +1113,9 @@ namespace ZyppRecipients {
 
 		callback.evaluate();
 	    }
+
+	    if (stats().active)
+		stats().script_start = PkgProfiler::nowMs();
 	}
 
 	virtual bool progress( zypp::target::PatchScriptReport::Notify ping, const std::string &out = std::string() )
@@ -925,6 +1166,14 @@ namespace ZyppRecipients {
 
 	virtual void finish()
 	{
+	    CommitStats &commit_stats = stats();
+	    if (commit_stats.active && commit_stats.script_start > 0)
+	    {
+		commit_stats.script_time += PkgProfiler::nowMs() - commit_stats.script_start;
+		commit_stats.script_start = 0;
+		++commit_stats.scripts;
+	    }
+
 	    CB callback( ycpcb( YCPCallbacks::CB_ScriptFinish) );
 
 	    if ( callback._set )
@@ -1184,6 +1433,8 @@ namespace ZyppRecipients {
 
     struct SourceCreateReceive : public Recipient, public zypp::callback::ReceiveReport<zypp::repo::RepoCreateReport>
     {
+	ProgressLimiter _limiter;
+
 	SourceCreateReceive( RecipientCtl & construct_r ) : Recipient( construct_r ) {}
 
 	virtual void reportbegin()
@@ -1210,6 +1461,7 @@ namespace ZyppRecipients {
 
 	virtual void start( const zypp::Url &url )
 	{
+	    _limiter.reset();
 	    CB callback( ycpcb( YCPCallbacks::CB_SourceCreateStart ) );
 
 	    if (callback._set)
@@ -1224,7 +1476,7 @@ namespace ZyppRecipients {
 	{
 	    CB callback( ycpcb( YCPCallbacks::CB_SourceCreateProgress ) );
 
-	    if (callback._set)
+	    if (callback._set && _limiter.pass(throttle(), value))
 	    {
 		callback.addInt(value);
 
@@ -1303,10 +1555,13 @@ namespace ZyppRecipients {
     ///////////////////////////////////////////////////////////////////
     struct ProbeSourceReceive : public Recipient, public zypp::callback::ReceiveReport<zypp::repo::ProbeRepoReport>
     {
+	ProgressLimiter _limiter;
+
 	ProbeSourceReceive( RecipientCtl & construct_r ) : Recipient( construct_r ) {}
 
 	virtual void start(const zypp::Url &url)
 	{
+	    _limiter.reset();
 	    _silent_probing = MEDIA_CHANGE_DISABLE;
 
 	    CB callback( ycpcb( YCPCallbacks::CB_SourceProbeStart ) );
@@ -1387,7 +1642,7 @@ namespace ZyppRecipients {
 	{
 	    CB callback( ycpcb( YCPCallbacks::CB_SourceProbeProgress ) );
 
-	    if (callback._set)
+	    if (callback._set && _limiter.pass(throttle(), value))
 	    {
 		callback.addStr(url);
 		callback.addInt(value);
@@ -1451,10 +1706,13 @@ namespace ZyppRecipients {
 	    }
 	}
 
+	ProgressLimiter _limiter;
+
 	RepoReport( RecipientCtl & construct_r, const PkgFunctions &pk ) : Recipient( construct_r ), _pkg_ref(pk) {}
 
         virtual void start(const zypp::ProgressData &task, const zypp::RepoInfo repo)
 	{
+	    _limiter.reset(task.reportValue());
 	    CB callback( ycpcb( YCPCallbacks::CB_SourceReportStart ) );
 
 	    if (callback._set)
@@ -1478,7 +1736,7 @@ namespace ZyppRecipients {
 	{
 	    CB callback( ycpcb( YCPCallbacks::CB_SourceReportProgress ) );
 
-	    if (callback._set)
+	    if (callback._set && _limiter.pass(throttle(), task.reportValue()))
 	    {
 		callback.addInt(task.reportValue());
 
@@ -1726,10 +1984,14 @@ namespace ZyppRecipients {
     ///////////////////////////////////////////////////////////////////
     struct KeyRingSignal : public Recipient, public zypp::callback::ReceiveReport<zypp::KeyRingSignals>
     {
-	KeyRingSignal ( RecipientCtl & construct_r ) : Recipient( construct_r ) {}
+	PkgFunctions &_pkg_ref;
+
+	KeyRingSignal ( RecipientCtl & construct_r, PkgFunctions &pk ) : Recipient( construct_r ), _pkg_ref(pk) {}
 
 	virtual void trustedKeyAdded( const zypp::PublicKey &key )
 	{
+	    _pkg_ref.InvalidateGPGKeys();
+
 	    CB callback( ycpcb( YCPCallbacks::CB_TrustedKeyAdded) );
 
 	    if (callback._set)
@@ -1743,6 +2005,8 @@ namespace ZyppRecipients {
 
         virtual void trustedKeyRemoved( const zypp::PublicKey &key )
 	{
+	    _pkg_ref.InvalidateGPGKeys();
+
 	    CB callback( ycpcb( YCPCallbacks::CB_TrustedKeyRemoved) );
 
 	    if (callback._set)
@@ -1761,6 +2025,8 @@ namespace ZyppRecipients {
     struct FileConflictReceive : public Recipient,
             public zypp::callback::ReceiveReport<zypp::target::FindFileConflictstReport>
     {
+        ProgressLimiter _limiter;
+
         FileConflictReceive( RecipientCtl & construct_r ) : Recipient( construct_r ) {}
 
         virtual void reportbegin()
@@ -1775,7 +2041,8 @@ namespace ZyppRecipients {
 
         virtual bool start( const zypp::ProgressData & progress_r )
         {
-            return report_progress(progress_r);
+            _limiter.reset();
+            return report_progress(progress_r, true);
         }
 
         virtual bool progress( const zypp::ProgressData & progress_r,
@@ -1831,12 +2098,12 @@ namespace ZyppRecipients {
 
     private:
 
-        bool report_progress(const zypp::ProgressData & progress_r)
+        bool report_progress(const zypp::ProgressData & progress_r, bool force = false)
         {
             CB callback( ycpcb( YCPCallbacks::CB_FileConflictProgress) );
 
             // continue
-            if (!callback._set)
+            if (!callback._set || !_limiter.pass(throttle(), progress_r.reportValue(), force))
             {
                 return true;
             }
@@ -1918,7 +2185,7 @@ class PkgFunctions::CallbackHandler::ZyppReceive : public ZyppRecipients::Recipi
       , _progressReceive( *this )
       , _digestReceive( *this )
       , _keyRingReceive( *this, pkg )
-      , _keyRingSignal( *this )
+      , _keyRingSignal( *this, pkg )
       , _authReceive( *this )
     {
 	// connect the receivers
@@ -1943,6 +2210,11 @@ class PkgFunctions::CallbackHandler::ZyppReceive : public ZyppRecipients::Recipi
     }
 
     virtual ~ZyppReceive()
+    {
+	disconnect();
+    }
+
+    void disconnect()
     {
 	// disconnect the receivers
 	_convertDbReceive.disconnect();
@@ -1999,3 +2271,173 @@ PkgFunctions::CallbackHandler::~CallbackHandler()
   delete &_ycpCallbacks;
 }
 
+///////////////////////////////////////////////////////////////////
+//
+//
+//	METHOD NAME : PkgFunctions::CallbackHandler::disconnectReceivers
+//	METHOD TYPE : void
+//
+void PkgFunctions::CallbackHandler::disconnectReceivers()
+{
+  y2debug("Disconnecting the zypp receivers");
+  _zyppReceive.disconnect();
+}
+
+///////////////////////////////////////////////////////////////////
+//
+//
+//	METHOD NAME : PkgFunctions::CallbackHandler::progressThrottle
+//	METHOD TYPE : ZyppRecipients::ProgressThrottle &
+//
+ZyppRecipients::ProgressThrottle & PkgFunctions::CallbackHandler::progressThrottle() const
+{
+  return _zyppReceive._throttle;
+}
+
+///////////////////////////////////////////////////////////////////
+//
+//
+//	METHOD NAME : PkgFunctions::CallbackHandler::commitStats
+//	METHOD TYPE : ZyppRecipients::CommitStats &
+//
+ZyppRecipients::CommitStats & PkgFunctions::CallbackHandler::commitStats() const
+{
+  return _zyppReceive._commit_stats;
+}
+
+
+///////////////////////////////////////////////////////////////////
+//
+//	CLASS NAME : PkgFunctions
+//
+//      Progress callback rate limit
+//
+///////////////////////////////////////////////////////////////////
+
+/**
+ * @builtin SetProgressThrottle
+ * @short Configure the rate limit of the progress callbacks
+ * @description
+ * The progress callbacks (download, package installation and removal, rpm db rebuild,
+ * repository refresh, generic progress, file conflicts...) are evaluated only when
+ * the progress has changed enough. The start and 100% are always reported.
+ * All keys are optional, the missing values are not changed.
+ *
+ * In the async mode the non-interactive progress callbacks (download, package
+ * installation and process progress) are coalesced, only the latest value is delivered
+ * at most once per "async_interval" and the last pending value is delivered before
+ * the finish callback. Use Pkg::ProgressAbort() to abort the running progress in this mode.
+ *
+ * @param map settings $[ "min_delta" : integer (minimal progress change in percent, default 5),
+ *   "min_interval" : integer (minimal time between two callbacks in miliseconds, default 0),
+ *   "timeout" : integer (report an unchanged progress after this time in miliseconds,
+ *   0 = disabled, default 3000), "async" : boolean (async mode, default false),
+ *   "async_interval" : integer (in miliseconds, default 200) ]
+ * @return boolean true on success, false if a value is not valid
+ * @usage Pkg::SetProgressThrottle($[ "min_delta" : 2, "min_interval" : 100 ])
+ */
+YCPValue PkgFunctions::SetProgressThrottle(const YCPMap& settings)
+{
+    ZyppRecipients::ProgressThrottle &throttle = _callbackHandler.progressThrottle();
+    ZyppRecipients::ProgressThrottle updated(throttle);
+
+    YCPValue async = settings->value(YCPString("async"));
+    if (!async.isNull())
+    {
+	if (!async->isBoolean())
+	{
+	    y2error("Invalid value for \"async\": %s", async->toString().c_str());
+	    return YCPBoolean(false);
+	}
+
+	updated.async = async->asBoolean()->value();
+    }
+
+    const char *keys[] = { "min_delta", "min_interval", "timeout", "async_interval" };
+
+    for (unsigned i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i)
+    {
+	YCPValue val = settings->value(YCPString(keys[i]));
+
+	if (val.isNull())
+	    continue;
+
+	if (!val->isInteger() || val->asInteger()->value() < 0)
+	{
+	    y2error("Invalid value for \"%s\": %s", keys[i], val->toString().c_str());
+	    return YCPBoolean(false);
+	}
+
+	long long value = val->asInteger()->value();
+
+	if (i == 0)
+	    updated.min_delta = value;
+	else if (i == 1)
+	    updated.min_interval = value;
+	else if (i == 2)
+	    updated.timeout = value;
+	else
+	    updated.async_interval = value;
+    }
+
+    throttle = updated;
+
+    y2milestone("Progress throttle: min_delta: %d%%, min_interval: %lldms, timeout: %lldms, async: %s (%lldms)",
+	throttle.min_delta, throttle.min_interval, throttle.timeout, throttle.async ? "true" : "false",
+	throttle.async_interval);
+
+    return YCPBoolean(true);
+}
+
+/**
+ * @builtin ProgressThrottleStats
+ * @short Return the progress callback rate limit settings and statistics
+ * @return map $[ "min_delta" : integer, "min_interval" : integer, "timeout" : integer,
+ *   "async" : boolean, "async_interval" : integer,
+ *   "forwarded" : integer (number of evaluated progress callbacks),
+ *   "suppressed" : integer (number of skipped progress callbacks),
+ *   "coalesced" : integer (number of deferred progress values in the async mode) ]
+ */
+YCPValue PkgFunctions::ProgressThrottleStats()
+{
+    const ZyppRecipients::ProgressThrottle &throttle = _callbackHandler.progressThrottle();
+
+    YCPMap ret;
+    ret->add(YCPString("min_delta"), YCPInteger(throttle.min_delta));
+    ret->add(YCPString("min_interval"), YCPInteger(throttle.min_interval));
+    ret->add(YCPString("timeout"), YCPInteger(throttle.timeout));
+    ret->add(YCPString("async"), YCPBoolean(throttle.async));
+    ret->add(YCPString("async_interval"), YCPInteger(throttle.async_interval));
+    ret->add(YCPString("forwarded"), YCPInteger(throttle.forwarded));
+    ret->add(YCPString("suppressed"), YCPInteger(throttle.suppressed));
+    ret->add(YCPString("coalesced"), YCPInteger(throttle.coalesced));
+
+    return ret;
+}
+
+/**
+ * @builtin ProgressAbort
+ * @short Request abort of the running progress
+ * @description
+ * In the async mode (see Pkg::SetProgressThrottle()) the next tick of the running
+ * download, package installation or process progress is aborted (as if the progress
+ * callback returned false). Can be called from any callback handler. The request
+ * applies only to the running progress, it is dropped when the progress finishes
+ * or a new one starts.
+ * @return boolean false if the async mode is not active (the request is ignored)
+ */
+YCPValue PkgFunctions::ProgressAbort()
+{
+    ZyppRecipients::ProgressThrottle &throttle = _callbackHandler.progressThrottle();
+
+    if (!throttle.async)
+    {
+	y2warning("The async progress mode is not active, ignoring the abort request");
+	return YCPBoolean(false);
+    }
+
+    y2milestone("Progress abort requested");
+    throttle.abort_requested = 1;
+
+    return YCPBoolean(true);
+}
@@ -22,9 +22,121 @@
 #define PkgModuleCallbacks_h
 
 #include <iosfwd>
+#include <csignal>
 
 #include <PkgFunctions.h>
 
+namespace ZyppRecipients {
+
+  enum MediaChangeSensitivity {
+    MEDIA_CHANGE_FULL,
+    MEDIA_CHANGE_OPTIONALFILE,
+    MEDIA_CHANGE_DISABLE,
+  };
+
+  ///////////////////////////////////////////////////////////////////
+  // Rate limit settings for the progress callbacks, shared by all
+  // Recipients. Evaluating a YCP callback is much more expensive
+  // than the reported work, the unimportant progress changes are
+  // not passed to YCP.
+  ///////////////////////////////////////////////////////////////////
+  struct ProgressThrottle {
+    // minimal progress change (in percent) to report
+    int min_delta;
+    // minimal time between two reports (in ms)
+    long long min_interval;
+    // report even an unchanged progress after this time (in ms), 0 = disabled
+    long long timeout;
+    // deferred delivery of the non-interactive progress callbacks (download,
+    // package installation, process progress): the values are coalesced and only
+    // the latest one is delivered at most once per async_interval (in ms),
+    // the last pending value is delivered before the finish callback
+    bool async;
+    long long async_interval;
+    // statistics
+    unsigned long long forwarded;
+    unsigned long long suppressed;
+    unsigned long long coalesced;
+    // abort request (Pkg::ProgressAbort()), returned by the next tick
+    // of a deferred progress callback, it applies only to the running
+    // progress (cleared when a progress starts or finishes)
+    volatile sig_atomic_t abort_requested;
+
+    ProgressThrottle();
+
+    // returns true (and clears the flag) if an abort has been requested
+    bool takeAbort();
+    // drop a not delivered abort request
+    void clearAbort() { abort_requested = 0; }
+  };
+
+  ///////////////////////////////////////////////////////////////////
+  // The last reported state of a progress, decides whether to pass
+  // a progress change to YCP. The start (reset) and 100% are always
+  // reported.
+  ///////////////////////////////////////////////////////////////////
+  class ProgressLimiter {
+    int _last_value;
+    long long _last_time;
+    // the latest not delivered value in the async mode (-1 = none)
+    int _pending;
+    public:
+      ProgressLimiter();
+
+      void reset( int value = 0 );
+
+      bool pass( ProgressThrottle & throttle, int value, bool finish = false );
+
+      // for the progresses without percent (alive tick) only the minimal interval is checked
+      bool passAlive( ProgressThrottle & throttle );
+
+      // the same as pass() if the async mode is disabled, otherwise only
+      // the interval is checked and a skipped value is remembered
+      bool passAsync( ProgressThrottle & throttle, int value );
+
+      // get the remembered value not delivered yet (if any)
+      bool takePending( int & value );
+  };
+
+  ///////////////////////////////////////////////////////////////////
+  // Timing statistics of a package commit, collected by the Recipients
+  // while active (see the "stats" option of Pkg::Commit()).
+  // The time of the YCP callbacks is not included.
+  ///////////////////////////////////////////////////////////////////
+  struct CommitStats {
+    bool active;
+    // the accumulated wall time of the commit phases (in ms)
+    long long total_time;
+    long long prefetch_time;
+    long long download_time;
+    // checking the downloaded package (checksum, signature)
+    long long check_time;
+    long long rpm_time;
+    long long script_time;
+    long long downloaded_bytes;
+    unsigned downloaded;
+    unsigned installed;
+    unsigned removed;
+    unsigned scripts;
+    // the install time of each package (in ms, name)
+    std::vector<std::pair<long long, std::string> > install_latency;
+
+    // start of the running operations, 0 = not running
+    long long started;
+    long long download_start;
+    long long transfer_end;
+    long long rpm_start;
+    long long script_start;
+
+    CommitStats();
+
+    // reset the values and start collecting
+    void start();
+    void stop();
+  };
+
+};
+
 ///////////////////////////////////////////////////////////////////
 //
 //	CLASS NAME : PkgFunctions::CallbackHandler
@@ -93,16 +205,22 @@ class PkgFunctions::CallbackHandler {
      * Destructor. Reset Y2PMCallbacks to it's defaults.
      **/
     ~CallbackHandler();
-};
 
-namespace ZyppRecipients {
+    /**
+     * Reset Y2PMCallbacks to it's defaults. Used in the forked worker
+     * processes (see @ref PkgWorkers) which must not call the YCP code.
+     **/
+    void disconnectReceivers();
 
-  enum MediaChangeSensitivity {
-    MEDIA_CHANGE_FULL,
-    MEDIA_CHANGE_OPTIONALFILE,
-    MEDIA_CHANGE_DISABLE,
-  };
+    /**
+     * The progress callback rate limit settings shared by the receivers.
+     **/
+    ZyppRecipients::ProgressThrottle & progressThrottle() const;
 
+    /**
+     * The commit statistics collected by the receivers.
+     **/
+    ZyppRecipients::CommitStats & commitStats() const;
 };
 
 ///////////////////////////////////////////////////////////////////
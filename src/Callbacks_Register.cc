@@ -726,5 +726,33 @@ YCPValue PkgFunctions::CallbackFileConflictFinish( const YCPValue& args )
     return SET_YCP_CB( CB_FileConflictFinish, args);
 }
 
+/**
+ * @builtin CallbackPoolChanged
+ * @short Register a callback function
+ * @param string args Name of the callback handler function. Required callback prototype is <code>void(integer generation, integer changes)</code>.
+ * The callback function is evaluated once after a builtin call which has changed the pool state,
+ * the changes are bits of PoolGeneration() kinds (1 = selection, 2 = solver, 4 = repositories,
+ * 8 = target, 16 = locks, 32 = locales), generation is the new PoolGeneration() value.
+ * @return void
+ */
+YCPValue PkgFunctions::CallbackPoolChanged( const YCPValue& args )
+{
+    return SET_YCP_CB( CB_PoolChanged, args);
+}
+
+/**
+ * @builtin CallbackSolverTestCaseDone
+ * @short Register a callback function
+ * @param string args Name of the callback handler function. Required callback prototype is <code>void(string dir, boolean success)</code>.
+ * The callback function is evaluated when a testcase written in background
+ * (see CreateSolverTestCaseOptions()) is finished. The success is false also
+ * for an incomplete testcase (the "max_size" limit has been exceeded).
+ * @return void
+ */
+YCPValue PkgFunctions::CallbackSolverTestCaseDone( const YCPValue& args )
+{
+    return SET_YCP_CB( CB_SolverTestCaseDone, args);
+}
+
 
 #undef SET_YCP_CB
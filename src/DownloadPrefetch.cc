@@ -0,0 +1,206 @@
+/*
+ * File:   DownloadPrefetch.cc
+ *
+ * Download the files which are usually requested via Pkg::SourceProvide*()
+ * in advance.
+ */
+
+#include "DownloadPrefetch.h"
+#include "log.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include <boost/bind.hpp>
+
+#include <zypp/RepoInfo.h>
+#include <zypp/MediaSetAccess.h>
+#include <zypp/PathInfo.h>
+#include <zypp/base/String.h>
+
+DownloadPrefetch::DownloadPrefetch()
+  : _last_job(0)
+{
+}
+
+DownloadPrefetch::~DownloadPrefetch()
+{
+  clear();
+}
+
+std::string DownloadPrefetch::normalize(const std::string &file)
+{
+  std::string::size_type pos = file.find_first_not_of('/');
+  return pos == std::string::npos ? std::string() : file.substr(pos);
+}
+
+void DownloadPrefetch::setManifest(const zypp::Pathname &manifest)
+{
+  _manifest = manifest;
+  _entries.clear();
+
+  if (_manifest.empty())
+  {
+    clear();
+    return;
+  }
+
+  std::ifstream in(_manifest.c_str());
+  std::string line;
+
+  while (std::getline(in, line))
+  {
+    // "<medium>\t<file>"
+    std::string::size_type pos = line.find('\t');
+
+    if (pos == std::string::npos || pos == 0)
+      continue;
+
+    unsigned medium = zypp::str::strtonum<unsigned>(line.substr(0, pos));
+    std::string file(normalize(line.substr(pos + 1)));
+
+    if (medium > 0 && !file.empty())
+      _entries.insert(Entry(medium, file));
+  }
+
+  y2milestone("Loaded %zd prefetch entries from %s", _entries.size(), _manifest.c_str());
+}
+
+void DownloadPrefetch::record(const std::string &file, unsigned medium)
+{
+  std::string name(normalize(file));
+
+  if (!enabled() || medium == 0 || name.empty())
+    return;
+
+  if (!_entries.insert(Entry(medium, name)).second)
+    return;
+
+  std::ofstream out(_manifest.c_str(), std::ios_base::app);
+  out << medium << '\t' << name << std::endl;
+
+  if (!out)
+    y2warning("Cannot write the prefetch manifest %s", _manifest.c_str());
+  else
+    y2debug("Recorded prefetch entry %s (medium %u)", name.c_str(), medium);
+}
+
+bool DownloadPrefetch::start(const zypp::RepoInfo &repo, const zypp::Pathname &download_area,
+  const PkgWorkers::ChildSetupFnc &child_setup)
+{
+  if (!enabled() || _entries.empty() || repo.baseUrlsEmpty())
+    return false;
+
+  // mounting a medium in the background would block the medium for the main process
+  const zypp::Url &url = *repo.baseUrlsBegin();
+  if (!url.isValid() || !url.schemeIsDownloading())
+    return false;
+
+  std::map<std::string, Download>::iterator it = _downloads.find(repo.alias());
+  if (it != _downloads.end())
+  {
+    // kills the running download
+    _jobs.remove(it->second.job);
+    _downloads.erase(it);
+  }
+
+  Download download = { zypp::filesystem::TmpDir(download_area, "prefetch."), ++_last_job };
+  zypp::Pathname path(download.dir.path());
+
+  if (path.empty())
+  {
+    y2error("Cannot create a prefetch directory in %s", download_area.c_str());
+    return false;
+  }
+
+  _jobs.start(download.job, boost::bind(&DownloadPrefetch::download, repo, _entries, path), child_setup);
+
+  y2milestone("Prefetching %zd files from %s to %s (job %lld)", _entries.size(),
+    repo.alias().c_str(), path.c_str(), download.job);
+
+  _downloads.insert(std::make_pair(repo.alias(), download));
+
+  return true;
+}
+
+// runs in the prefetch process
+int DownloadPrefetch::download(const zypp::RepoInfo &repo, const std::set<Entry> &entries,
+  const zypp::Pathname &dir)
+{
+  unsigned done = 0;
+
+  try
+  {
+    // one media access for all files => the connection is reused
+    zypp::MediaSetAccess access(repo.name(), *repo.baseUrlsBegin());
+
+    for (std::set<Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+    {
+      try
+      {
+        zypp::Pathname local = access.provideFile(it->second, it->first, zypp::MediaSetAccess::PROVIDE_NON_INTERACTIVE);
+
+        zypp::Pathname target(dir / zypp::str::numstring(it->first) / it->second);
+        zypp::Pathname part(target.extend(".part"));
+
+        // the file must appear complete, rename it at the end
+        if (zypp::filesystem::assert_dir(target.dirname()) != 0
+          || zypp::filesystem::hardlinkCopy(local, part) != 0
+          || ::rename(part.c_str(), target.c_str()) != 0)
+        {
+          y2warning("Cannot store the prefetched file %s", target.c_str());
+          continue;
+        }
+
+        ++done;
+      }
+      catch (const zypp::Exception &e)
+      {
+        // the recorded file might be optional
+        y2debug("Cannot prefetch %s: %s", it->second.c_str(), e.asString().c_str());
+      }
+    }
+  }
+  catch (const zypp::Exception &e)
+  {
+    y2warning("Cannot access %s: %s", repo.alias().c_str(), e.asString().c_str());
+    return PkgWorkers::JOB_FAILED;
+  }
+
+  y2milestone("Prefetched %u of %zd files from %s", done, entries.size(), repo.alias().c_str());
+
+  return done > 0 ? PkgWorkers::JOB_DONE : PkgWorkers::JOB_SKIPPED;
+}
+
+zypp::Pathname DownloadPrefetch::lookup(const std::string &alias, const std::string &file, unsigned medium)
+{
+  // collect the finished downloads
+  _jobs.wait(std::set<long long>(), 0);
+
+  zypp::Pathname path(dir(alias, medium));
+
+  if (path.empty())
+    return path;
+
+  path /= normalize(file);
+
+  return zypp::PathInfo(path).isFile() ? path : zypp::Pathname();
+}
+
+zypp::Pathname DownloadPrefetch::dir(const std::string &alias, unsigned medium) const
+{
+  std::map<std::string, Download>::const_iterator it = _downloads.find(alias);
+
+  if (it == _downloads.end())
+    return zypp::Pathname();
+
+  return it->second.dir.path() / zypp::str::numstring(medium);
+}
+
+void DownloadPrefetch::clear()
+{
+  _jobs.clear();
+
+  // removes the downloaded files
+  _downloads.clear();
+}
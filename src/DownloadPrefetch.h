@@ -0,0 +1,85 @@
+/*
+ * File:   DownloadPrefetch.h
+ *
+ * Download the files which are usually requested via Pkg::SourceProvide*()
+ * (control.xml, licenses, release notes...) in advance.
+ *
+ * (Note: the provided files are recorded in a manifest file which is kept
+ * across the runs. When a repository is added the recorded files are
+ * downloaded in a forked background process (libzypp is not thread safe,
+ * see BackgroundJobs) to a private download directory, the files appear there atomically
+ * (renamed after the download is finished) so a file can be used
+ * as soon as it exists.)
+ */
+
+#ifndef DOWNLOADPREFETCH_H
+#define DOWNLOADPREFETCH_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+
+#include <zypp/Pathname.h>
+#include <zypp/TmpPath.h>
+
+#include "BackgroundJobs.h"
+
+namespace zypp
+{
+    class RepoInfo;
+}
+
+class DownloadPrefetch {
+
+public:
+  DownloadPrefetch();
+  // kills the running downloads
+  ~DownloadPrefetch();
+
+  // set the manifest file (empty = prefetch disabled), the recorded files are loaded
+  void setManifest(const zypp::Pathname &manifest);
+  const zypp::Pathname &manifest() const { return _manifest; }
+  bool enabled() const { return !_manifest.empty(); }
+
+  // record a successfully provided file
+  void record(const std::string &file, unsigned medium);
+
+  // start downloading the recorded files from the repository into a new
+  // directory in download_area, returns false if nothing has been started
+  // (disabled, nothing recorded or not a downloading URL)
+  bool start(const zypp::RepoInfo &repo, const zypp::Pathname &download_area,
+    const PkgWorkers::ChildSetupFnc &child_setup = PkgWorkers::ChildSetupFnc());
+
+  // the prefetched file, empty if it has not been downloaded (yet)
+  zypp::Pathname lookup(const std::string &alias, const std::string &file, unsigned medium);
+
+  // the download directory for the medium (empty if not started)
+  zypp::Pathname dir(const std::string &alias, unsigned medium) const;
+
+  // stop the downloads and remove the downloaded files
+  void clear();
+
+private:
+  // medium, file
+  typedef std::pair<unsigned, std::string> Entry;
+
+  struct Download {
+    zypp::filesystem::TmpDir dir;
+    // the background job ID
+    long long job;
+  };
+
+  static int download(const zypp::RepoInfo &repo, const std::set<Entry> &entries,
+    const zypp::Pathname &dir);
+  static std::string normalize(const std::string &file);
+
+  zypp::Pathname _manifest;
+  std::set<Entry> _entries;
+  // alias => download
+  std::map<std::string, Download> _downloads;
+  BackgroundJobs _jobs;
+  long long _last_job;
+};
+
+#endif	/* DOWNLOADPREFETCH_H */
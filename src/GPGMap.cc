@@ -26,6 +26,7 @@
 
 #include "GPGMap.h"
 #include "i18n.h"
+#include "ycpTools.h"
 
 #include <ycp/YCPString.h>
 #include <ycp/YCPInteger.h>
@@ -40,24 +41,24 @@
 
 GPGMap::GPGMap(const zypp::PublicKey &key)
 {
-    gpg_map->add(YCPString("id"), YCPString(key.id()));
-    gpg_map->add(YCPString("name"), YCPString(key.name()));
-    gpg_map->add(YCPString("fingerprint"), YCPString(key.fingerprint()));
-    gpg_map->add(YCPString("path"), YCPString(key.path().asString()));
+    gpg_map->add(YCPKey::id, YCPString(key.id()));
+    gpg_map->add(YCPKey::name, YCPString(key.name()));
+    gpg_map->add(YCPKey::fingerprint, YCPString(key.fingerprint()));
+    gpg_map->add(YCPKey::path, YCPString(key.path().asString()));
 
     zypp::Date date(key.created());
     // %x = date only, see man strftime
-    gpg_map->add(YCPString("created"), YCPString(date.form("%x")));
-    gpg_map->add(YCPString("created_raw"), YCPInteger(zypp::Date::ValueType(date)));
+    gpg_map->add(YCPKey::created, YCPString(date.form("%x")));
+    gpg_map->add(YCPKey::created_raw, YCPInteger(zypp::Date::ValueType(date)));
 
     date = key.expires();
     std::string expires((date == 0) ? _("Never") : date.form("%x"));
-    gpg_map->add(YCPString("expires"), YCPString(expires));
-    gpg_map->add(YCPString("expires_raw"), YCPInteger(zypp::Date::ValueType(date)));
+    gpg_map->add(YCPKey::expires, YCPString(expires));
+    gpg_map->add(YCPKey::expires_raw, YCPInteger(zypp::Date::ValueType(date)));
 }
 
 void GPGMap::setTrusted(bool trusted)
 {
     // is the key trusted?
-    gpg_map->add(YCPString("trusted"), YCPBoolean(trusted));
+    gpg_map->add(YCPKey::trusted, YCPBoolean(trusted));
 }
@@ -30,10 +30,13 @@
 #include <ycp/YCPString.h>
 #include <ycp/YCPList.h>
 #include <ycp/YCPInteger.h>
+#include <ycp/YCPMap.h>
 
 #include <zypp/KeyRing.h>
 #include <zypp/PublicKey.h>
 #include <zypp/Pathname.h>
+#include <zypp/PathInfo.h>
+#include <zypp/Date.h>
 
 /*
   Textdomain "pkg-bindings"
@@ -63,6 +66,7 @@ PkgFunctions::ImportGPGKey(const YCPString& filename, const YCPBoolean& trusted)
 	zypp::PublicKey pubkey(pname);
 
 	zypp_ptr()->keyRing()->importKey(pubkey, trusted_key);
+	InvalidateGPGKeys();
     }
     catch (...)
     {
@@ -73,6 +77,85 @@ PkgFunctions::ImportGPGKey(const YCPString& filename, const YCPBoolean& trusted)
     return YCPBoolean(true);
 }
 
+/****************************************************************************************
+ * @builtin ImportGPGKeys
+ * @short Import several GPG keys into the keyring
+ * @description
+ * Import GPG keys into the keyring in the package manager. A directory in the list
+ * is expanded to the files it contains (not recursively).
+ *
+ * @param list<string> files Paths to the key files or directories
+ * @param boolean trusted Set to true if the keys are trusted
+ * @return map<string,boolean> key file => true if the key has been imported
+ **/
+YCPValue
+PkgFunctions::ImportGPGKeys(const YCPList& files, const YCPBoolean& trusted)
+{
+    const bool trusted_key = trusted->value();
+    std::vector<zypp::Pathname> key_files;
+
+    for (int index = 0; index < files.size(); ++index)
+    {
+	if (files->value(index).isNull() || !files->value(index)->isString())
+	{
+	    y2error("Invalid item at index %d in the key file list, string expected", index);
+	    continue;
+	}
+
+	zypp::Pathname path(files->value(index)->asString()->value());
+
+	if (zypp::PathInfo(path).isDir())
+	{
+	    std::list<zypp::Pathname> dir_files;
+	    zypp::filesystem::readdir(dir_files, path, false);
+	    dir_files.sort();
+
+	    for_(it, dir_files.begin(), dir_files.end())
+	    {
+		if (zypp::PathInfo(*it).isFile())
+		    key_files.push_back(*it);
+	    }
+	}
+	else
+	{
+	    key_files.push_back(path);
+	}
+    }
+
+    YCPMap ret;
+    const zypp::KeyRing_Ptr keyring(zypp_ptr()->keyRing());
+    unsigned imported = 0;
+
+    // the keyring and the RPM database are written by the import,
+    // the keys are imported one by one
+    for_(it, key_files.begin(), key_files.end())
+    {
+	bool success = false;
+
+	try
+	{
+	    zypp::PublicKey pubkey(*it);
+	    keyring->importKey(pubkey, trusted_key);
+
+	    success = true;
+	    ++imported;
+	}
+	catch (const zypp::Exception &excpt)
+	{
+	    y2error("Key %s: Import failed: %s", it->c_str(), excpt.asString().c_str());
+	}
+
+	ret->add(YCPString(it->asString()), YCPBoolean(success));
+    }
+
+    if (imported > 0)
+	InvalidateGPGKeys();
+
+    y2milestone("Imported %u of %zd %s keys", imported, key_files.size(), trusted_key ? "trusted" : "untrusted");
+
+    return ret;
+}
+
 // A helper class
 // converts PublicKey to YCPMap and adds it to an YCPList
 class PublicKeyAdder : public std::unary_function<const zypp::PublicKey &, void>
@@ -115,20 +198,7 @@ YCPValue PkgFunctions::GPGKeys(const YCPBoolean& trusted)
 {
     try
     {
-	YCPList ret;
-	const bool trusted_only = trusted->value();
-	const zypp::KeyRing_Ptr keyring(zypp_ptr()->keyRing());
-
-	// use the required keyring
-	std::list<zypp::PublicKey> key_list(
-	    trusted_only ? keyring->trustedPublicKeys()
-	    : keyring->publicKeys()
-	);
-
-	// convert std::list<PublicKey> to YCPList, pass the known/trusted flag
-	for_each(key_list.begin(), key_list.end(), PublicKeyAdder(ret, trusted_only));
-
-	return ret;
+	return CachedGPGKeys(trusted->value());
     }
     catch (const zypp::Exception& excpt)
     {
@@ -138,6 +208,46 @@ YCPValue PkgFunctions::GPGKeys(const YCPBoolean& trusted)
     }
 }
 
+// the converted keys from the known or the trusted keyring,
+// the keys are exported and converted only when the keyring has been changed
+const YCPList &PkgFunctions::CachedGPGKeys(bool trusted_only)
+{
+    GPGKeyCache &cache = trusted_only ? trusted_gpg_keys : known_gpg_keys;
+    const zypp::KeyRing_Ptr keyring(zypp_ptr()->keyRing());
+
+    // listing the key data is cheap, exporting all keys is not
+    std::list<zypp::PublicKeyData> key_data(
+	trusted_only ? keyring->trustedPublicKeyData()
+	: keyring->publicKeyData()
+    );
+
+    std::vector<std::pair<std::string, long long> > stamp;
+    stamp.reserve(key_data.size());
+
+    for_(it, key_data.begin(), key_data.end())
+    {
+	stamp.push_back(std::make_pair(it->fingerprint(), zypp::Date::ValueType(it->expires())));
+    }
+
+    if (cache.valid && cache.stamp == stamp)
+	return cache.list;
+
+    // use the required keyring
+    cache.keys = trusted_only ? keyring->trustedPublicKeys() : keyring->publicKeys();
+
+    // convert std::list<PublicKey> to YCPList, pass the known/trusted flag
+    YCPList ret;
+    for_each(cache.keys.begin(), cache.keys.end(), PublicKeyAdder(ret, trusted_only));
+
+    cache.list = ret;
+    cache.stamp.swap(stamp);
+    cache.valid = true;
+
+    y2milestone("Converted %zd %s GPG keys", cache.keys.size(), trusted_only ? "trusted" : "known");
+
+    return cache.list;
+}
+
 /****************************************************************************************
  * @builtin DeleteGPGKey
  * @short Remove the GPG key from the package manager keyring
@@ -154,6 +264,7 @@ YCPValue PkgFunctions::DeleteGPGKey(const YCPString& key_id, const YCPBoolean& t
     try
     {
 	zypp_ptr()->keyRing()->deleteKey(key_id->value(), trusted->value());
+	InvalidateGPGKeys();
 	ret = true;
     }
     catch(const zypp::Exception &excpt)
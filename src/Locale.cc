@@ -175,6 +175,13 @@ PkgFunctions::SetAdditionalLocales (const YCPList &langycplist)
 
     try
     {
+	// setting the same locales again would only drop the solver caches
+	if (zypp::sat::Pool::instance().getRequestedLocales() == lset)
+	{
+	    y2debug("The requested locales have not been changed");
+	    return YCPVoid();
+	}
+
 	zypp::sat::Pool::instance().setRequestedLocales(lset);
     }
     catch(...)
@@ -27,6 +27,7 @@
 
 
 #include <ostream>
+#include <sstream>
 
 #include "PkgFunctions.h"
 #include "log.h"
@@ -46,283 +47,344 @@
 #include <climits>
 
 
-/**
- * @builtin AddLock
- * @short Add a lock to the package manager
- * @description
- * Add a new lock to the package manager. Input parameter is a map $[ "kind" : list<string>,
- * "install_status":string, "repo_id":list<integer>, "case_sensitive" : boolean, "global_string":list<string>
- * "string_type" : string, "solvable:.*" : list<string> ]
- *
- * see http://en.opensuse.org/Libzypp/Locksfile for more information
- * @param map lock Definition of the lock
- * @return boolean true on success
- */
-YCPValue
-PkgFunctions::AddLock(const YCPMap &lock)
+// convert the lock map (see AddLock()) to a query,
+// returns false if the map is not valid
+bool PkgFunctions::YCPMap2PoolQuery(const YCPMap &lock, zypp::PoolQuery &query)
 {
-    zypp::PoolQuery query;
-
-    try
+    for_(map_it, lock.begin(), lock.end())
     {
-	for_(map_it, lock.begin(), lock.end())
+	YCPValue key(map_it->first);
+	YCPValue val(map_it->second);
+
+	if (key.isNull())
 	{
-	    YCPValue key(map_it->first);
-	    YCPValue val(map_it->second);
+	    y2warning("Warning: ignoring 'nil' key in lock map");
+	    continue;
+	}
 
-	    if (key.isNull())
-	    {
-		y2warning("Warning: ignoring 'nil' key in lock map");
-		continue;
-	    }
+	if (val.isNull())
+	{
+	    y2warning("Warning: ignoring 'nil' value in lock map");
+	    continue;
+	}
 
-	    if (val.isNull())
-	    {
-		y2warning("Warning: ignoring 'nil' value in lock map");
-		continue;
-	    }
+	if (key->isString())
+	{
+	    std::string key_str(key->asString()->value());
 
-	    if (key->isString())
+	    // add kind
+	    if (key_str == "kind")
 	    {
-		std::string key_str(key->asString()->value());
-
-		// add kind
-		if (key_str == "kind")
+		if (val->isList())
 		{
-		    if (val->isList())
-		    {
-			YCPList items(val->asList());
-
-			int index = 0;
-			int list_size = items.size();
+		    YCPList items(val->asList());
 
-			while(index < list_size)
-			{
-			    YCPValue list_item(items->value(index));
-
-			    if (!list_item.isNull() && list_item->isString())
-			    {
-				query.addKind(zypp::ResKind(list_item->asString()->value()));
-			    }
-			    else
-			    {
-				y2error("Invalid item at index %d in \"kind\" list", index);
-				return YCPBoolean(false);
-			    }
+		    int index = 0;
+		    int list_size = items.size();
 
-			    index++;
-			}
-		    }
-		    else
+		    while(index < list_size)
 		    {
-			y2error("Error %s is not list", val->toString().c_str());
-			return YCPBoolean(false);
-		    }
-		}
-		else if (key_str == "install_status")
-		{
-		    if (val->isString())
-		    {
-			std::string status_str(val->asString()->value());
+			YCPValue list_item(items->value(index));
 
-			if (status_str == "installed")
-			{
-			    query.setInstalledOnly();
-			}
-			else if (status_str == "uninstalled")
-			{
-			    query.setUninstalledOnly();
-			}
-			else if (status_str == "all")
+			if (!list_item.isNull() && list_item->isString())
 			{
-			    query.setStatusFilterFlags(zypp::PoolQuery::ALL);
+			    query.addKind(zypp::ResKind(list_item->asString()->value()));
 			}
 			else
 			{
-			    y2error("Unknown install_status status value: %s", status_str.c_str());
-			    return YCPBoolean(false);
+			    y2error("Invalid item at index %d in \"kind\" list", index);
+			    return false;
 			}
-		    }
-		    else
-		    {
-			y2error("Type of key 'install_status' must be string, found: %s", val->toString().c_str());
-			return YCPBoolean(false);
+
+			index++;
 		    }
 		}
-		else if (key_str == "repo_id")
+		else
 		{
-		    if (val->isList())
-		    {
-			YCPList items(val->asList());
-
-			int index = 0;
-			int list_size = items.size();
-
-			while(index < list_size)
-			{
-			    YCPValue list_item(items->value(index));
-
-			    if (!list_item.isNull() && list_item->isInteger())
-			    {
-				RepoId repo_id = list_item->asInteger()->value();
-
-				YRepo_Ptr repo_ptr = logFindRepository(repo_id);
-
-				if (repo_ptr)
-				{
-				    query.addRepo(repo_ptr->repoInfo().alias());
-				}
-				else
-				{
-				    y2error("Repository %lld not found", repo_id);
-				    return YCPBoolean(false);
-				}
-			    }
-			    else
-			    {
-				y2error("Invalid item at index %d in \"repo_id\" list", index);
-				return YCPBoolean(false);
-			    }
+		    y2error("Error %s is not list", val->toString().c_str());
+		    return false;
+		}
+	    }
+	    else if (key_str == "install_status")
+	    {
+		if (val->isString())
+		{
+		    std::string status_str(val->asString()->value());
 
-			    index++;
-			}
+		    if (status_str == "installed")
+		    {
+			query.setInstalledOnly();
 		    }
-		    else
+		    else if (status_str == "uninstalled")
 		    {
-			y2error("Error: 'repo_id' value is not list: %s", val->toString().c_str());
-			return YCPBoolean(false);
+			query.setUninstalledOnly();
 		    }
-		}
-		else if (key_str == "case_sensitive")
-		{
-		    if (val->isBoolean())
+		    else if (status_str == "all")
 		    {
-			bool cs = val->asBoolean()->value();
-			query.setCaseSensitive(cs);
+			query.setStatusFilterFlags(zypp::PoolQuery::ALL);
 		    }
 		    else
 		    {
-			y2error("Type of key 'case_sensitive' must be boolean, found: %s", val->toString().c_str());
-			return YCPBoolean(false);
+			y2error("Unknown install_status status value: %s", status_str.c_str());
+			return false;
 		    }
 		}
-		else if (key_str == "global_string")
+		else
 		{
-		    if (val->isList())
-		    {
-			YCPList items(val->asList());
+		    y2error("Type of key 'install_status' must be string, found: %s", val->toString().c_str());
+		    return false;
+		}
+	    }
+	    else if (key_str == "repo_id")
+	    {
+		if (val->isList())
+		{
+		    YCPList items(val->asList());
+
+		    int index = 0;
+		    int list_size = items.size();
 
-			int index = 0;
-			int list_size = items.size();
+		    while(index < list_size)
+		    {
+			YCPValue list_item(items->value(index));
 
-			while(index < list_size)
+			if (!list_item.isNull() && list_item->isInteger())
 			{
-			    YCPValue list_item(items->value(index));
+			    RepoId repo_id = list_item->asInteger()->value();
+
+			    YRepo_Ptr repo_ptr = logFindRepository(repo_id);
 
-			    if (!list_item.isNull() && list_item->isString())
+			    if (repo_ptr)
 			    {
-				std::string global_str = list_item->asString()->value();
-				query.addString(global_str);
+				query.addRepo(repo_ptr->repoInfo().alias());
 			    }
 			    else
 			    {
-				y2error("Invalid item at index %d in \"global_string\" list: %s, string expected", index, list_item->toString().c_str());
-				return YCPBoolean(false);
+				y2error("Repository %lld not found", repo_id);
+				return false;
 			    }
-
-			    index++;
 			}
-		    }
-		    else
-		    {
-			y2error("Error: 'global_string' value is not list: %s", val->toString().c_str());
-			return YCPBoolean(false);
+			else
+			{
+			    y2error("Invalid item at index %d in \"repo_id\" list", index);
+			    return false;
+			}
+
+			index++;
 		    }
 		}
-		else if (key_str == "string_type")
+		else
 		{
-		    if (val->isString())
+		    y2error("Error: 'repo_id' value is not list: %s", val->toString().c_str());
+		    return false;
+		}
+	    }
+	    else if (key_str == "case_sensitive")
+	    {
+		if (val->isBoolean())
+		{
+		    bool cs = val->asBoolean()->value();
+		    query.setCaseSensitive(cs);
+		}
+		else
+		{
+		    y2error("Type of key 'case_sensitive' must be boolean, found: %s", val->toString().c_str());
+		    return false;
+		}
+	    }
+	    else if (key_str == "global_string")
+	    {
+		if (val->isList())
+		{
+		    YCPList items(val->asList());
+
+		    int index = 0;
+		    int list_size = items.size();
+
+		    while(index < list_size)
 		    {
-			std::string str_type = val->asString()->value();
-
-			if (str_type == "exact")
-			    query.setMatchExact();
-			else if (str_type == "substring")
-			    query.setMatchSubstring();
-			else if (str_type == "glob")
-			    query.setMatchGlob();
-			else if (str_type == "regex")
-			    query.setMatchRegex();
+			YCPValue list_item(items->value(index));
+
+			if (!list_item.isNull() && list_item->isString())
+			{
+			    std::string global_str = list_item->asString()->value();
+			    query.addString(global_str);
+			}
 			else
 			{
-			    y2error("Unknown 'string_type' value: %s", val->toString().c_str());
-			    return YCPBoolean(false);
+			    y2error("Invalid item at index %d in \"global_string\" list: %s, string expected", index, list_item->toString().c_str());
+			    return false;
 			}
+
+			index++;
 		    }
+		}
+		else
+		{
+		    y2error("Error: 'global_string' value is not list: %s", val->toString().c_str());
+		    return false;
+		}
+	    }
+	    else if (key_str == "string_type")
+	    {
+		if (val->isString())
+		{
+		    std::string str_type = val->asString()->value();
+
+		    if (str_type == "exact")
+			query.setMatchExact();
+		    else if (str_type == "substring")
+			query.setMatchSubstring();
+		    else if (str_type == "glob")
+			query.setMatchGlob();
+		    else if (str_type == "regex")
+			query.setMatchRegex();
 		    else
 		    {
-			y2error("Type of key 'string_type' must be string, found: %s", val->toString().c_str());
-			return YCPBoolean(false);
+			y2error("Unknown 'string_type' value: %s", val->toString().c_str());
+			return false;
 		    }
 		}
-		// it is probably an attribute
-		else if (std::string(key_str, 0, 9) == "solvable:")
+		else
 		{
-		    if (val->isList())
-		    {
-			YCPList items(val->asList());
-
-			int index = 0;
-			int list_size = items.size();
+		    y2error("Type of key 'string_type' must be string, found: %s", val->toString().c_str());
+		    return false;
+		}
+	    }
+	    // it is probably an attribute
+	    else if (std::string(key_str, 0, 9) == "solvable:")
+	    {
+		if (val->isList())
+		{
+		    YCPList items(val->asList());
 
-			while(index < list_size)
-			{
-			    YCPValue list_item(items->value(index));
+		    int index = 0;
+		    int list_size = items.size();
 
-			    if (!list_item.isNull() && list_item->isString())
-			    {
-				std::string attr = list_item->asString()->value();
+		    while(index < list_size)
+		    {
+			YCPValue list_item(items->value(index));
 
-				query.addAttribute(zypp::sat::SolvAttr(key_str), attr);
-			    }
-			    else
-			    {
-				y2error("Invalid item at index %d at \"%s\" key: %s, string expected", index, key_str.c_str(), list_item->toString().c_str());
-				return YCPBoolean(false);
-			    }
+			if (!list_item.isNull() && list_item->isString())
+			{
+			    std::string attr = list_item->asString()->value();
 
-			    index++;
+			    query.addAttribute(zypp::sat::SolvAttr(key_str), attr);
 			}
-		    }
-		    else
-		    {
-			y2error("Error: value '%s' in list at key '%s' is not a list", val->toString().c_str(), key_str.c_str());
-			return YCPBoolean(false);
+			else
+			{
+			    y2error("Invalid item at index %d at \"%s\" key: %s, string expected", index, key_str.c_str(), list_item->toString().c_str());
+			    return false;
+			}
+
+			index++;
 		    }
 		}
+		else
+		{
+		    y2error("Error: value '%s' in list at key '%s' is not a list", val->toString().c_str(), key_str.c_str());
+		    return false;
+		}
+	    }
+	}
+	else
+	{
+	    y2error("Key %s is not string", key->toString().c_str());
+	}
+    }
+
+    return true;
+}
+
+/**
+ * @builtin AddLock
+ * @short Add a lock to the package manager
+ * @description
+ * Add a new lock to the package manager. Input parameter is a map $[ "kind" : list<string>,
+ * "install_status":string, "repo_id":list<integer>, "case_sensitive" : boolean, "global_string":list<string>
+ * "string_type" : string, "solvable:.*" : list<string> ]
+ *
+ * see http://en.opensuse.org/Libzypp/Locksfile for more information
+ * @param map lock Definition of the lock
+ * @return boolean true on success
+ */
+YCPValue
+PkgFunctions::AddLock(const YCPMap &lock)
+{
+    YCPList locks;
+    locks->add(lock);
+
+    return AddLocks(locks);
+}
+
+/**
+ * @builtin AddLocks
+ * @short Add several locks to the package manager
+ * @description
+ * Add new locks to the package manager, see AddLock() for the lock map
+ * description. The locks are merged to the current locks at once, that is
+ * much faster than calling AddLock() for each lock.
+ *
+ * If any lock map is not valid no lock is added.
+ *
+ * @param list<map> locks Definitions of the locks
+ * @return boolean true on success
+ */
+YCPValue
+PkgFunctions::AddLocks(const YCPList &locks)
+{
+    std::vector<zypp::PoolQuery> queries;
+    queries.reserve(locks.size());
+
+    try
+    {
+	for (int index = 0; index < locks.size(); ++index)
+	{
+	    YCPValue lock(locks->value(index));
+
+	    if (lock.isNull() || !lock->isMap())
+	    {
+		y2error("Invalid item at index %d in the lock list, map expected", index);
+		return YCPBoolean(false);
 	    }
-	    else
+
+	    zypp::PoolQuery query;
+
+	    if (!YCPMap2PoolQuery(lock->asMap(), query))
 	    {
-		y2error("Key %s is not string", key->toString().c_str());
+		y2error("Invalid lock map %s", lock->toString().c_str());
+		return YCPBoolean(false);
 	    }
+
+	    queries.push_back(query);
 	}
 
-	// and finally add the lock
-	zypp::Locks &locks = zypp::Locks::instance();
+	// the locks are applied by the solver
+	solve_fingerprint_valid = false;
+	lock_cache.valid = false;
+	// apply the locks file again in the next TargetInit()
+	target_locks_stamp.clear();
 
-	DBG << "Adding query: " << query << std::endl;
+	// and finally add the locks
+	zypp::Locks &zypp_locks = zypp::Locks::instance();
 
-	locks.addLock(query);
+	for_(it, queries.begin(), queries.end())
+	{
+	    DBG << "Adding query: " << *it << std::endl;
+	    zypp_locks.addLock(*it);
+	}
 
-	// merge the lock to the current locks (to be returned by GetLocks())
-	locks.merge();
+	// merge the locks to the current locks (to be returned by GetLocks())
+	zypp_locks.merge();
     }
     catch (zypp::Exception & excpt)
     {
-	y2warning("Error while parsing lock map %s: %s", lock->toString().c_str(), excpt.asString().c_str());
+	y2warning("Error while adding locks %s: %s", locks->toString().c_str(), excpt.asString().c_str());
 	return YCPBoolean(false);
     }
 
+    y2milestone("Added %zd locks", queries.size());
+
     return YCPBoolean(true);
 }
 
@@ -428,27 +490,63 @@ YCPMap PkgFunctions::PoolQuery2YCPMap(const zypp::PoolQuery &pool_query)
     return lock;
 }
 
+// the current locks with the converted lock maps and IDs,
+// the conversion is done only when the locks or the repositories have been changed
+const PkgFunctions::LockCache &PkgFunctions::CurrentLocks()
+{
+    unsigned serial = zypp_ptr()->pool().serial().serial();
+
+    if (lock_cache.valid && lock_cache.pool_serial == serial)
+	return lock_cache;
+
+    zypp::Locks &locks = zypp::Locks::instance();
+
+    YCPList converted;
+    std::map<long long, zypp::PoolQuery> queries;
+    boost::unordered_map<std::string, long long> ids;
+
+    for_(it, locks.begin(), locks.end())
+    {
+	std::ostringstream str;
+	it->serialize(str);
+
+	// keep the ID of an already known lock
+	boost::unordered_map<std::string, long long>::const_iterator known = lock_cache.ids.find(str.str());
+	long long id = (known == lock_cache.ids.end()) ? lock_cache.next_id++ : known->second;
+
+	ids[str.str()] = id;
+	queries.insert(std::make_pair(id, *it));
+
+	YCPMap lock(PoolQuery2YCPMap(*it));
+	lock->add(YCPString("id"), YCPInteger(id));
+	converted->add(lock);
+    }
+
+    lock_cache.locks = converted;
+    lock_cache.queries.swap(queries);
+    lock_cache.ids.swap(ids);
+    lock_cache.pool_serial = serial;
+    lock_cache.valid = true;
+
+    y2debug("Converted %zd locks", lock_cache.queries.size());
+
+    return lock_cache;
+}
+
 /**
  * @builtin GetLocks
  * @short Get list of current locks
  * @description
  * Returns list of of current locks, see AddLock() for details about returned lock map.
+ * Each map contains also an "id" key with the lock ID which can be used in RemoveLocks().
+ * The ID does not change when other locks are added or removed.
  *
  * see http://en.opensuse.org/Libzypp/Locksfile for more information
  * @return list list of locks (YCP maps)
  */
 YCPValue PkgFunctions::GetLocks()
 {
-    YCPList ret;
-
-    zypp::Locks &locks = zypp::Locks::instance();
-
-    for_(it, locks.begin(), locks.end())
-    {
-	ret->add(PoolQuery2YCPMap(*it));
-    }
-
-    return ret;
+    return CurrentLocks().locks;
 }
 
 
@@ -463,6 +561,11 @@ YCPValue PkgFunctions::GetLocks()
  */
 YCPValue PkgFunctions::RemoveLock(const YCPInteger &lock_idx)
 {
+    solve_fingerprint_valid = false;
+    lock_cache.valid = false;
+    // apply the locks file again in the next TargetInit()
+    target_locks_stamp.clear();
+
     if (lock_idx.isNull())
     {
 	y2error("Invaid lock index: nil");
@@ -511,3 +614,70 @@ YCPValue PkgFunctions::RemoveLock(const YCPInteger &lock_idx)
     return YCPBoolean(false);
 }
 
+/**
+ * @builtin RemoveLocks
+ * @short Remove several locks
+ * @description
+ * Removes the locks with the specified IDs from the package manager,
+ * the IDs are returned in the "id" key by GetLocks(). Unlike the index
+ * used by RemoveLock() the ID does not change when other locks are removed.
+ *
+ * @param list<integer> ids IDs of the locks to remove
+ * @return boolean true on success, false if a lock was not found
+ * (the other locks are removed)
+ */
+YCPValue PkgFunctions::RemoveLocks(const YCPList &ids)
+{
+    bool ret = true;
+
+    try
+    {
+	// copy the queries, the cache is invalidated below
+	std::map<long long, zypp::PoolQuery> queries(CurrentLocks().queries);
+
+	solve_fingerprint_valid = false;
+	lock_cache.valid = false;
+	// apply the locks file again in the next TargetInit()
+	target_locks_stamp.clear();
+
+	zypp::Locks &locks = zypp::Locks::instance();
+	unsigned removed = 0;
+
+	for (int index = 0; index < ids.size(); ++index)
+	{
+	    YCPValue id(ids->value(index));
+
+	    if (id.isNull() || !id->isInteger())
+	    {
+		y2error("Invalid item at index %d in the lock ID list, integer expected", index);
+		ret = false;
+		continue;
+	    }
+
+	    std::map<long long, zypp::PoolQuery>::iterator it = queries.find(id->asInteger()->value());
+
+	    if (it == queries.end())
+	    {
+		y2error("Lock %lld not found", id->asInteger()->value());
+		ret = false;
+		continue;
+	    }
+
+	    locks.removeLock(it->second);
+	    // do not remove the same lock twice
+	    queries.erase(it);
+	    ++removed;
+	}
+
+	locks.merge();
+
+	y2milestone("Removed %u locks", removed);
+    }
+    catch (zypp::Exception &excpt)
+    {
+	y2warning("Error while removing locks %s: %s", ids->toString().c_str(), excpt.asString().c_str());
+	ret = false;
+    }
+
+    return YCPBoolean(ret);
+}
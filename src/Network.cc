@@ -29,8 +29,21 @@
 #include <PkgFunctions.h>
 #include "log.h"
 
-// system()
-#include <cstdlib>
+#include <ycp/YCPBoolean.h>
+#include <ycp/YCPInteger.h>
+#include <ycp/YCPMap.h>
+#include <ycp/YCPString.h>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 
 #include <zypp/Url.h>
 
@@ -38,19 +51,182 @@
   Textdomain "pkg-bindings"
 */
 
+// how long the detected network status is valid (in milliseconds),
+// the cache is invalidated earlier when a netlink event is received
+static const long long network_status_ttl = 5000;
+
+/*
+  A helper function
+  Open a netlink socket for receiving link and IPv4 address changes,
+  returns -1 on error (then only the TTL is used)
+*/
+static int open_netlink()
+{
+    int fd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+
+    if (fd < 0)
+    {
+	y2warning("Cannot open netlink socket: %s", ::strerror(errno));
+	return -1;
+    }
+
+    struct sockaddr_nl addr;
+    ::memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR;
+
+    if (::bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0)
+    {
+	y2warning("Cannot bind netlink socket: %s", ::strerror(errno));
+	::close(fd);
+	return -1;
+    }
+
+    return fd;
+}
+
+/*
+  A helper function
+  Read all pending netlink messages, returns true if there was any
+  (i.e. the network configuration has been changed)
+*/
+static bool netlink_changed(int fd)
+{
+    bool changed = false;
+    char buffer[4096];
+
+    while (true)
+    {
+	ssize_t len = ::recv(fd, buffer, sizeof(buffer), 0);
+
+	if (len > 0)
+	{
+	    changed = true;
+	    continue;
+	}
+
+	// ENOBUFS = some events have been lost, they were changes anyway
+	if (len < 0 && errno == ENOBUFS)
+	{
+	    changed = true;
+	    continue;
+	}
+
+	if (len < 0 && errno == EINTR)
+	    continue;
+
+	break;
+    }
+
+    return changed;
+}
+
+/*
+  A helper function
+  Is there any IPv4 address configured except the loopback?
+*/
+static bool ipv4_configured()
+{
+    struct ifaddrs *ifaddr = NULL;
+
+    if (::getifaddrs(&ifaddr) < 0)
+    {
+	y2error("getifaddrs() failed: %s", ::strerror(errno));
+	return false;
+    }
+
+    bool found = false;
+
+    for (struct ifaddrs *ifa = ifaddr; ifa != NULL && !found; ifa = ifa->ifa_next)
+    {
+	if (ifa->ifa_addr == NULL || ifa->ifa_addr->sa_family != AF_INET)
+	    continue;
+
+	const struct sockaddr_in *addr = reinterpret_cast<const struct sockaddr_in *>(ifa->ifa_addr);
+
+	// ignore the 127.0.0.0/8 loopback network
+	if ((ntohl(addr->sin_addr.s_addr) >> 24) == 127)
+	    continue;
+
+	y2debug("Found IPv4 address at interface %s", ifa->ifa_name);
+	found = true;
+    }
+
+    ::freeifaddrs(ifaddr);
+    return found;
+}
+
 /*
   A helper function
   Detect whether there is a network connection.
   See isNetworkRunning() function in NetworkService.ycp
+
+  The result is cached, it is refreshed after a short timeout or when
+  a link/address change is reported via netlink.
 */
 bool PkgFunctions::NetworkDetected()
 {
-    y2milestone("Checking the network status...");
-    // check IPv4 network
-    int result = ::system("ip addr|grep -v '127.0.0\\|inet6'|grep -q inet &> /dev/null");
-    y2milestone("Network is running: %s", (result == 0) ? "yes" : "no");
+    if (network_netlink_fd == -2)
+    {
+	network_netlink_fd = open_netlink();
+    }
+
+    long long now = PkgProfiler::nowMs();
+    bool expired = network_checked < 0 || now - network_checked > network_status_ttl;
+
+    if (!expired && network_netlink_fd >= 0 && netlink_changed(network_netlink_fd))
+    {
+	y2milestone("Network configuration changed");
+	expired = true;
+    }
+
+    if (expired)
+    {
+	// drop the events received so far, they are included in the new result
+	if (network_netlink_fd >= 0)
+	    netlink_changed(network_netlink_fd);
+
+	// check IPv4 network
+	network_running = ipv4_configured();
+	network_checked = now;
+	y2milestone("Network is running: %s", network_running ? "yes" : "no");
+    }
+    else
+    {
+	y2debug("Using cached network status: %s", network_running ? "yes" : "no");
+    }
+
+    return network_running;
+}
+
+/**
+ * @builtin NetworkStatus
+ * @short Get the network status used for skipping the remote repositories
+ * @description
+ * The network status is cached, the cache is refreshed after a short time
+ * or when the network configuration is changed.
+ * @param boolean refresh if true the status is detected again (the cached value is ignored)
+ * @return map $[ "running" : boolean, // is there any (non-loopback) IPv4 address?
+ *  "age" : integer, // age of the cached value in milliseconds
+ *  "ttl" : integer, // validity of the cached value in milliseconds
+ *  "netlink" : boolean ] // are the netlink change events used?
+ */
+YCPValue PkgFunctions::NetworkStatus(const YCPBoolean &refresh)
+{
+    if (!refresh.isNull() && refresh->value())
+    {
+	network_checked = -1;
+    }
+
+    bool running = NetworkDetected();
+
+    YCPMap ret;
+    ret->add(YCPString("running"), YCPBoolean(running));
+    ret->add(YCPString("age"), YCPInteger(PkgProfiler::nowMs() - network_checked));
+    ret->add(YCPString("ttl"), YCPInteger(network_status_ttl));
+    ret->add(YCPString("netlink"), YCPBoolean(network_netlink_fd >= 0));
 
-    return !result;
+    return ret;
 }
 
 /*
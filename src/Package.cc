@@ -24,6 +24,8 @@
 #include "PkgFunctions.h"
 #include "log.h"
 #include "Callbacks.YCP.h"
+#include "PkgWorkers.h"
+#include "ycpTools.h"
 
 #include <ycp/YCPVoid.h>
 #include <ycp/YCPBoolean.h>
@@ -46,16 +48,29 @@
 #include <zypp/base/Regex.h>
 
 #include <zypp/sat/WhatProvides.h>
+#include <zypp/sat/LookupAttr.h>
+#include <zypp/sat/Pool.h>
 #include <zypp/ZYppFactory.h>
+#include <zypp/ZConfig.h>
 #include <zypp/repo/PackageProvider.h>
+#include <zypp/ZYppCallbacks.h>
+#include <zypp/ExternalProgram.h>
+#include <zypp/PathInfo.h>
+#include <zypp/base/String.h>
+
+#include <boost/bind.hpp>
+#include <boost/functional/hash.hpp>
 
 #include <fstream>
+#include <algorithm>
+#include <iterator>
 #include <sstream>
 
 extern "C"
 {
 // ::stat, ::unlink, ::symlink
 #include <unistd.h>
+#include <fnmatch.h>
 // errno
 #include <errno.h>
 }
@@ -130,8 +145,6 @@ PkgFunctions::PkgQueryProvides( const YCPString& tag )
 	    continue;
 	}
 
-	std::string pkgname = package->name();
-
 	// get instance status
 	bool installed = provider.status().staysInstalled();
 	std::string instance;
@@ -166,7 +179,7 @@ PkgFunctions::PkgQueryProvides( const YCPString& tag )
 
 	// create list item
 	YCPList item;
-	item->add(YCPString(pkgname));
+	item->add(asYCPString(package->ident()));
 	item->add(YCPSymbol(instance));
 	item->add(YCPSymbol(onSystem));
 
@@ -262,18 +275,20 @@ PkgFunctions::PkgMediaNames ()
 	}
     }
 
-    y2milestone( "Pkg::PkgMediaNames result: %s", res->toString().c_str());
+    // serialize the result only when debug logging is enabled
+    y2debug( "Pkg::PkgMediaNames result: %s", res->toString().c_str());
 
     return res;
 }
 
 
 
-YCPValue
-PkgFunctions::PkgMediaSizesOrCount (bool sizes, bool download_size)
+// update the cached media sizes, only the changes since the last call are evaluated
+void
+PkgFunctions::UpdateMediaSizes()
 {
     // all enabled sources
-    std::list<RepoId> source_ids;
+    std::vector<RepoId> source_ids;
 
     RepoId index = 0;
     for(RepoCont::const_iterator it = repos.begin(); it != repos.end() ; ++it, ++index)
@@ -285,72 +300,149 @@ PkgFunctions::PkgMediaSizesOrCount (bool sizes, bool download_size)
 	source_ids.push_back(index);
     }
 
+    unsigned serial = zypp_ptr()->pool().serial().serial();
+
+    // the packages to install, checking the status is cheap
+    std::vector<zypp::sat::Solvable::IdType> selected;
+
+    for_(it, zypp_ptr()->pool().byKindBegin(zypp::ResKind::package), zypp_ptr()->pool().byKindEnd(zypp::ResKind::package))
+    {
+	if (it->status().isToBeInstalled())
+	{
+	    selected.push_back(it->satSolvable().id());
+	}
+    }
 
-    // map SourceId -> [ number_of_media, total_size ]
-    std::map<RepoId, std::vector<zypp::ByteCount> > result;
+    std::sort(selected.begin(), selected.end());
 
-    // map alias -> SourceID
-    std::map<std::string, RepoId> source_map;
+    std::vector<zypp::sat::Solvable::IdType> added;
+    std::vector<zypp::sat::Solvable::IdType> removed;
 
-    // initialize the structures
-    for( std::list<RepoId>::const_iterator sit = source_ids.begin();
-	sit != source_ids.end(); ++sit, ++index)
+    if (!media_sizes.valid || media_sizes.pool_serial != serial || media_sizes.repos != source_ids)
     {
-	RepoId id = *sit;
+	y2debug("Computing the media sizes from scratch");
 
-	YRepo_Ptr repo = logFindRepository(id);
-	if (!repo)
-	    continue;
+	media_sizes.inst_size.clear();
+	media_sizes.download_size.clear();
+	media_sizes.count.clear();
+
+	// initialize the structures
+	for( std::vector<RepoId>::const_iterator sit = source_ids.begin();
+	    sit != source_ids.end(); ++sit)
+	{
+	    RepoId id = *sit;
+
+	    YRepo_Ptr repo = logFindRepository(id);
+	    if (!repo)
+		continue;
+
+	    // we don't know the number of media in advance
+	    // the vector is dynamically resized during package search
+	    media_sizes.inst_size[id] = std::vector<long long>();
+	    media_sizes.download_size[id] = std::vector<long long>();
+	    media_sizes.count[id] = std::vector<long long>();
+	}
 
-	// we don't know the number of media in advance
-	// the vector is dynamically resized during package search
-	result[id] = std::vector<zypp::ByteCount>();
-	source_map[ repo->repoInfo().alias() ] = id;
+	added = selected;
     }
+    else
+    {
+	std::set_difference(selected.begin(), selected.end(),
+	    media_sizes.selected.begin(), media_sizes.selected.end(), std::back_inserter(added));
+	std::set_difference(media_sizes.selected.begin(), media_sizes.selected.end(),
+	    selected.begin(), selected.end(), std::back_inserter(removed));
 
+	y2debug("Media sizes update: %zd added, %zd removed packages", added.size(), removed.size());
+    }
 
-    for (zypp::ResPoolProxy::const_iterator it = zypp_ptr()->poolProxy().byKindBegin(zypp::ResKind::package);
-        it != zypp_ptr()->poolProxy().byKindEnd(zypp::ResKind::package);
-        ++it)
+    // add the new packages, subtract the deselected ones
+    for (int pass = 0; pass < 2; ++pass)
     {
-        if ((*it)->fate() == zypp::ui::Selectable::TO_INSTALL)
+	const std::vector<zypp::sat::Solvable::IdType> &ids = pass == 0 ? added : removed;
+	long long sign = pass == 0 ? 1 : -1;
+
+	for_(id_it, ids.begin(), ids.end())
 	{
-	    zypp::Package::constPtr pkg = zypp::asKind<zypp::Package>((*it)->candidateObj().resolvable());
+	    zypp::Package::constPtr pkg = zypp::asKind<zypp::Package>(zypp::PoolItem(zypp::sat::Solvable(*id_it)).resolvable());
 
 	    if (!pkg)
 		continue;
 
+	    RepoId repo_id = PoolRepoId(pkg->repository());
+
+	    // ignore the disabled repositories as well
+	    if (repo_id < 0 || media_sizes.count.find(repo_id) == media_sizes.count.end())
+	    {
+		y2debug("Ignoring package %s from an unknown repository", pkg->name().c_str());
+		continue;
+	    }
+
 	    unsigned int medium = pkg->mediaNr();
 	    if (medium == 0)
 	    {
 		medium = 1;
 	    }
 
-	    if (medium > 0)
+	    std::vector<long long> &inst = media_sizes.inst_size[repo_id];
+	    std::vector<long long> &download = media_sizes.download_size[repo_id];
+	    std::vector<long long> &cnt = media_sizes.count[repo_id];
+
+	    // resize media array - the found index is out of array
+	    if (medium > cnt.size())
 	    {
-		zypp::ByteCount size = sizes ? (download_size ? pkg->downloadSize() : pkg->installSize()) : zypp::ByteCount(1); //count only
+		inst.resize(medium, 0LL);
+		download.resize(medium, 0LL);
+		cnt.resize(medium, 0LL);
+	    }
 
-		// refence to the found media array
-		std::vector<zypp::ByteCount> &ref = result[source_map[pkg->repoInfo().alias()]];
-		int add_count = (medium - 1) - ref.size() + 1;
+	    // media are numbered from 1
+	    inst[medium - 1] += sign * pkg->installSize();
+	    download[medium - 1] += sign * pkg->downloadSize();
+	    cnt[medium - 1] += sign;
+	}
+    }
 
-		// resize media array - the found index is out of array
-		if (add_count > 0)
-		{
-                    ref.insert(ref.end(), add_count, zypp::ByteCount(0));
-		}
+    if (!removed.empty())
+    {
+	// remove the trailing unused media, the media array is as long as the highest used medium
+	for(std::map<RepoId, std::vector<long long> >::iterator it = media_sizes.count.begin();
+	    it != media_sizes.count.end(); ++it)
+	{
+	    std::vector<long long> &cnt = it->second;
+	    std::vector<long long>::size_type used = cnt.size();
 
-		ref[medium - 1] += size ;	// media are numbered from 1
+	    while (used > 0 && cnt[used - 1] == 0)
+	    {
+		--used;
 	    }
+
+	    cnt.resize(used);
+	    media_sizes.inst_size[it->first].resize(used);
+	    media_sizes.download_size[it->first].resize(used);
 	}
     }
 
+    media_sizes.selected.swap(selected);
+    media_sizes.repos.swap(source_ids);
+    media_sizes.pool_serial = serial;
+    media_sizes.valid = true;
+}
+
+YCPValue
+PkgFunctions::PkgMediaSizesOrCount (bool sizes, bool download_size)
+{
+    UpdateMediaSizes();
+
+    // map SourceId -> [ total_size_medium1, total_size_medium2, ... ]
+    const std::map<RepoId, std::vector<long long> > &result = sizes ?
+	(download_size ? media_sizes.download_size : media_sizes.inst_size) : media_sizes.count;
+
     YCPList res;
 
-    for(std::map<RepoId, std::vector<zypp::ByteCount> >::const_iterator it =
+    for(std::map<RepoId, std::vector<long long> >::const_iterator it =
 	result.begin(); it != result.end() ; ++it)
     {
-	const std::vector<zypp::ByteCount> &values = it->second;
+	const std::vector<long long> &values = it->second;
 	YCPList source;
 
 	for( unsigned i = 0 ; i < values.size() ; i++ )
@@ -361,7 +453,11 @@ PkgFunctions::PkgMediaSizesOrCount (bool sizes, bool download_size)
 	res->add( source );
     }
 
-    y2milestone( "Pkg::%s result: %s", sizes ? (download_size ? "PkgMediaPackageSizes" : "PkgMediaSizes" ): "PkgMediaCount", res->toString().c_str());
+    // the result might be huge, log it only in the debug mode
+    if (get_log_debug())
+    {
+	y2debug( "Pkg::%s result: %s", sizes ? (download_size ? "PkgMediaPackageSizes" : "PkgMediaSizes" ): "PkgMediaCount", res->toString().c_str());
+    }
 
     return res;
 }
@@ -449,12 +545,12 @@ PkgFunctions::IsProvided (const YCPString& tag)
 	// is it installed?
 	if (provider.status().isInstalled())
 	{
-	    y2milestone("Tag %s is provided by %s", name.c_str(), provider->name().c_str());
+	    y2debug("Tag %s is provided by %s", name.c_str(), provider->name().c_str());
 	    return YCPBoolean(true);
 	}
     }
 
-    y2milestone("Tag %s is not provided", name.c_str());
+    y2debug("Tag %s is not provided", name.c_str());
 
     return YCPBoolean(false);
 }
@@ -490,12 +586,12 @@ PkgFunctions::IsSelected (const YCPString& tag)
 	// is it installed?
 	if (provider.status().isToBeInstalled())
 	{
-	    y2milestone("Tag %s provided by %s is selected to install", name.c_str(), provider->name().c_str());
+	    y2debug("Tag %s provided by %s is selected to install", name.c_str(), provider->name().c_str());
 	    return YCPBoolean(true);
 	}
     }
 
-    y2milestone("Tag %s is not selected to install", name.c_str());
+    y2debug("Tag %s is not selected to install", name.c_str());
 
     return YCPBoolean(false);
 }
@@ -533,16 +629,104 @@ PkgFunctions::IsAvailable (const YCPString& tag)
 	// is it installed?
 	if (!provider.status().isInstalled())
 	{
-	    y2milestone("Tag %s provided by %s is available to install", name.c_str(), provider->name().c_str());
+	    y2debug("Tag %s provided by %s is available to install", name.c_str(), provider->name().c_str());
 	    return YCPBoolean(true);
 	}
     }
 
-    y2milestone("Tag %s is not available to install", name.c_str());
+    y2debug("Tag %s is not available to install", name.c_str());
 
     return YCPBoolean(false);
 }
 
+// ------------------------
+/**
+ *  @builtin CapabilitiesStatus
+ *  @short Check the status of many tags at once
+ *  @description
+ *  Batch version of IsProvided, IsSelected and IsAvailable, all flags
+ *  are evaluated in a single pass over the providers of each tag.
+ *
+ *  tag can be a package name, a string from requires/provides
+ *  or a file name (since a package implictly provides all its files)
+ *
+ *  @param list<string> tags
+ *  @return map<string,map<string,boolean>> tag => $[ "provided" : boolean,
+ *    "selected" : boolean, "available" : boolean ], nil on error
+ *  @usage Pkg::CapabilitiesStatus (["yast2", "/bin/bash"]) -> $[ "yast2" : $[ "provided" : true,
+ *    "selected" : false, "available" : true ], ... ]
+*/
+YCPValue
+PkgFunctions::CapabilitiesStatus (const YCPList& tags)
+{
+    YCPMap ret;
+    int provided_count = 0;
+
+    try
+    {
+	for (int i = 0; i < tags->size(); ++i)
+	{
+	    if (!tags->value(i)->isString())
+	    {
+		y2error("Pkg::CapabilitiesStatus: ignoring non-string tag: %s", tags->value(i)->toString().c_str());
+		continue;
+	    }
+
+	    std::string name = tags->value(i)->asString()->value();
+	    bool provided = false;
+	    bool selected = false;
+	    bool available = false;
+
+	    if (!name.empty())
+	    {
+		// look for packages
+		zypp::Capability cap(name, zypp::ResKind::package);
+		zypp::sat::WhatProvides possibleProviders(cap);
+
+		for_(iter, possibleProviders.begin(), possibleProviders.end())
+		{
+		    zypp::PoolItem provider = zypp::ResPool::instance().find(*iter);
+		    zypp::ResStatus status = provider.status();
+
+		    if (status.isInstalled())
+			provided = true;
+		    else
+			available = true;
+
+		    if (status.isToBeInstalled())
+			selected = true;
+
+		    // all flags set, no need to check the other providers
+		    if (provided && selected && available)
+			break;
+		}
+	    }
+
+	    y2debug("Tag %s: provided: %d, selected: %d, available: %d", name.c_str(), provided, selected, available);
+
+	    if (provided)
+		++provided_count;
+
+	    YCPMap tag_status;
+	    tag_status->add(YCPString("provided"), YCPBoolean(provided));
+	    tag_status->add(YCPString("selected"), YCPBoolean(selected));
+	    tag_status->add(YCPKey::available, YCPBoolean(available));
+
+	    ret->add(YCPString(name), tag_status);
+	}
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	y2error("Pkg::CapabilitiesStatus failed: %s", excpt.asString().c_str());
+	_last_error.setLastError(ExceptionAsString(excpt));
+	return YCPVoid();
+    }
+
+    y2milestone("Checked %d tags, %d provided", ret->size(), provided_count);
+
+    return ret;
+}
+
 YCPValue
 PkgFunctions::searchPackage(const YCPString &package, bool installed)
 {
@@ -880,12 +1064,12 @@ PkgFunctions::PkgProp(const zypp::PoolItem &item)
 	return YCPVoid();
     }
 
-    data->add( YCPString("arch"), YCPString( pkg->arch().asString() ) );
-    data->add( YCPString("medianr"), YCPInteger( pkg->mediaNr() ) );
+    data->add( YCPKey::arch, asYCPString( pkg->arch().idStr() ) );
+    data->add( YCPKey::medianr, YCPInteger( pkg->mediaNr() ) );
 
-    long long sid = logFindAlias(pkg->repoInfo().alias());
+    long long sid = PoolRepoId(pkg->repository());
     y2debug("srcId: %lld", sid );
-    data->add( YCPString("srcid"), YCPInteger( sid ) );
+    data->add( YCPKey::srcid, YCPInteger( sid ) );
 
     std::string status("available");
 
@@ -902,12 +1086,12 @@ PkgFunctions::PkgProp(const zypp::PoolItem &item)
 	status = "removed";
     }
 
-    data->add( YCPString("status"), YCPSymbol(status));
+    data->add( YCPKey::status, YCPSymbol(status));
 
-    data->add(YCPString("on_system_by_user"), YCPBoolean(item.satSolvable().onSystemByUser()));
+    data->add(YCPKey::on_system_by_user, YCPBoolean(item.satSolvable().onSystemByUser()));
 
-    data->add( YCPString("location"), YCPString( pkg->location().filename().basename() ) );
-    data->add( YCPString("path"), YCPString( pkg->location().filename().asString() ) );
+    data->add( YCPKey::location, YCPString( pkg->location().filename().basename() ) );
+    data->add( YCPKey::path, YCPString( pkg->location().filename().asString() ) );
 
     return data;
 }
@@ -958,6 +1142,143 @@ PkgFunctions::PkgProperties (const YCPString& p)
     return YCPVoid();
 }
 
+// ------------------------
+/**
+ * @builtin PkgPropertiesBatch
+ * @short Return information about many packages at once
+ * @description
+ * Like PkgSummary, PkgVersion, PkgSize, PkgGroup and PkgProperties
+ * together, but for a list of packages in one call. Only the requested
+ * keys are computed.
+ *
+ * Supported keys: "summary", "version", "size", "group" and the keys
+ * returned by PkgProperties ("arch", "medianr", "srcid", "status",
+ * "on_system_by_user", "location", "path").
+ *
+ * @param list<string> names package names, empty list = all packages
+ * @param list<string> keys requested keys, empty list = all keys
+ * @return map<string,map<string,any>> package name => properties,
+ *   missing packages are not included in the result
+ * @usage Pkg::PkgPropertiesBatch (["yast2", "glibc"], ["version", "size"]) -> $["glibc" : $["size" : 4929254, "version" : "2.22-4.3"], ...]
+ */
+
+YCPValue
+PkgFunctions::PkgPropertiesBatch (const YCPList& names, const YCPList& keys)
+{
+    // the supported keys
+    static const char *all_keys[] = { "summary", "version", "size", "group", "arch", "medianr",
+	"srcid", "status", "on_system_by_user", "location", "path" };
+
+    std::set<std::string> wanted;
+
+    if (!keys.isNull())
+    {
+	for (int i = 0; i < keys->size(); ++i)
+	{
+	    if (!keys->value(i)->isString())
+	    {
+		y2error("Pkg::PkgPropertiesBatch: not a string: %s", keys->value(i)->toString().c_str());
+		continue;
+	    }
+
+	    wanted.insert(keys->value(i)->asString()->value());
+	}
+    }
+
+    if (wanted.empty())
+    {
+	wanted.insert(all_keys, all_keys + sizeof(all_keys) / sizeof(all_keys[0]));
+    }
+
+    YCPMap ret;
+
+    try
+    {
+	const bool pkg_prop = wanted.count("arch") || wanted.count("medianr") || wanted.count("srcid")
+	    || wanted.count("status") || wanted.count("on_system_by_user") || wanted.count("location")
+	    || wanted.count("path");
+
+	std::vector<zypp::ui::Selectable::Ptr> selectables;
+
+	if (names.isNull() || names->size() == 0)
+	{
+	    // all packages in one pass
+	    zypp::ResPoolProxy proxy(zypp_ptr()->poolProxy());
+	    for_(it, proxy.byKindBegin(zypp::ResKind::package), proxy.byKindEnd(zypp::ResKind::package))
+	    {
+		selectables.push_back(*it);
+	    }
+	}
+	else
+	{
+	    selectables.reserve(names->size());
+
+	    for (int i = 0; i < names->size(); ++i)
+	    {
+		if (!names->value(i)->isString())
+		{
+		    y2error("Pkg::PkgPropertiesBatch: not a string: %s", names->value(i)->toString().c_str());
+		    continue;
+		}
+
+		const std::string &name = names->value(i)->asString()->value();
+		zypp::ui::Selectable::Ptr s = name.empty() ? zypp::ui::Selectable::Ptr() : zypp::ui::Selectable::get(name);
+
+		if (s)
+		    selectables.push_back(s);
+	    }
+	}
+
+	for_(it, selectables.begin(), selectables.end())
+	{
+	    const zypp::PoolItem item((*it)->theObj());
+	    zypp::Package::constPtr pkg = zypp::asKind<zypp::Package>(item.resolvable());
+
+	    if (!pkg)
+		continue;
+
+	    YCPMap data;
+
+	    if (pkg_prop)
+	    {
+		YCPValue prop = PkgProp(item);
+
+		if (!prop.isNull() && prop->isMap())
+		{
+		    YCPMap prop_map = prop->asMap();
+
+		    for_(kit, wanted.begin(), wanted.end())
+		    {
+			YCPString key(*kit);
+			YCPValue val = prop_map->value(key);
+
+			if (!val.isNull())
+			    data->add(key, val);
+		    }
+		}
+	    }
+
+	    if (wanted.count("summary"))
+		data->add(YCPKey::summary, YCPString(pkg->summary()));
+	    if (wanted.count("version"))
+		data->add(YCPKey::version, YCPString(pkg->edition().asString()));
+	    if (wanted.count("size"))
+		data->add(YCPString("size"), YCPInteger(pkg->installSize()));
+	    if (wanted.count("group"))
+		data->add(YCPString("group"), YCPString(pkg->group()));
+
+	    ret->add(YCPString((*it)->name()), data);
+	}
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	y2error("Pkg::PkgPropertiesBatch failed: %s", excpt.asString().c_str());
+	_last_error.setLastError(ExceptionAsString(excpt));
+    }
+
+    return ret;
+}
+
 YCPValue
 PkgFunctions::PkgPropertiesAll (const YCPString& p)
 {
@@ -1040,13 +1361,38 @@ PkgFunctions::PkgPath (const YCPString& p)
 }
 
 
+// file list filter, see PkgGetFilelistEx()
+struct FilelistFilter
+{
+    FilelistFilter() : offset(0), limit(0) {}
+
+    bool match(const std::string &file) const
+    {
+	return (prefix.empty() || file.compare(0, prefix.size(), prefix) == 0)
+	    && (glob.empty() || ::fnmatch(glob.c_str(), file.c_str(), 0) == 0);
+    }
+
+    std::string prefix;
+    std::string glob;
+    // skip the first "offset" matching files
+    long long offset;
+    // max. number of the returned files, 0 = unlimited
+    long long limit;
+};
+
 // a helper function
-YCPList _create_filelist(const zypp::PoolItem &pi)
+// the filter is applied while iterating the solv file list, the YCP
+// strings are created only for the returned files, "more" is set to true
+// if the limit has been reached and there are more matching files
+YCPList _create_filelist(const zypp::PoolItem &pi, const FilelistFilter &filter = FilelistFilter(), bool *more = NULL)
 {
     zypp::Package::constPtr package = zypp::asKind<zypp::Package>(pi.resolvable());
 
     YCPList ret;
 
+    if (more)
+	*more = false;
+
     if (!package)
     {
 	y2error("Not a package");
@@ -1054,16 +1400,90 @@ YCPList _create_filelist(const zypp::PoolItem &pi)
     }
 
     zypp::Package::FileList files( package->filelist() );
+    long long matched = 0;
+    long long added = 0;
 
     // insert the file names
     for_( it, files.begin(), files.end() )
     {
-	ret->add(YCPString(*it));
+	std::string file(*it);
+
+	if (!filter.match(file) || matched++ < filter.offset)
+	    continue;
+
+	if (filter.limit > 0 && added >= filter.limit)
+	{
+	    // do not scan the rest of the list
+	    if (more)
+		*more = true;
+
+	    break;
+	}
+
+	ret->add(YCPString(file));
+	++added;
     }
 
     return ret;
 }
 
+// a helper function - find the package instance for PkgGetFilelist
+// (an empty PoolItem if not found)
+static zypp::PoolItem _filelist_item(const std::string &pkgname, const std::string &type)
+{
+    zypp::ui::Selectable::Ptr s = zypp::ui::Selectable::get(pkgname);
+
+    if (!s)
+    {
+	y2warning("Package %s was not found", pkgname.c_str());
+	return zypp::PoolItem();
+    }
+
+    if (type == "any")
+    {
+	if (s->hasInstalledObj())
+	{
+	    return s->installedObj();
+	}
+	else if (s->hasCandidateObj())
+	{
+	    return s->candidateObj();
+	}
+	else
+	{
+	    y2milestone("Package %s is not installed and is not available", pkgname.c_str());
+	}
+    }
+    else if (type == "installed")
+    {
+	if (s->hasInstalledObj())
+	{
+	    return s->installedObj();
+	}
+	else
+	{
+	    y2milestone("Package %s is not installed", pkgname.c_str());
+	}
+    }
+    else if (type == "candidate")
+    {
+	if (s->hasCandidateObj())
+	{
+	    return s->candidateObj();
+	}
+	else
+	{
+	    y2milestone("Package %s is not available", pkgname.c_str());
+	}
+    }
+    else
+    {
+	y2internal("Unhandled package type %s", type.c_str());
+    }
+
+    return zypp::PoolItem();
+}
+
 /**
  *  @builtin PkgGetFilelist
  *  @short Get File List of a package
@@ -1097,55 +1517,11 @@ YCPList PkgFunctions::PkgGetFilelist( const YCPString & package, const YCPSymbol
     {
 	try
 	{
-	    zypp::ui::Selectable::Ptr s = zypp::ui::Selectable::get(pkgname);
+	    zypp::PoolItem pi = _filelist_item(pkgname, type);
 
-	    if (s)
-	    {
-		if (type == "any")
-		{
-		    if (s->hasInstalledObj())
-		    {
-			return _create_filelist(s->installedObj());
-		    }
-		    else if (s->hasCandidateObj())
-		    {
-			return _create_filelist(s->candidateObj());
-		    }
-		    else
-		    {
-			y2milestone("Package %s is not installed and is not available", pkgname.c_str());
-		    }
-		}
-		else if (type == "installed")
-		{
-		    if (s->hasInstalledObj())
-		    {
-			return _create_filelist(s->installedObj());
-		    }
-		    else
-		    {
-			y2milestone("Package %s is not installed", pkgname.c_str());
-		    }
-		}
-		else if (type == "candidate")
-		{
-		    if (s->hasCandidateObj())
-		    {
-			return _create_filelist(s->candidateObj());
-		    }
-		    else
-		    {
-			y2milestone("Package %s is not available", pkgname.c_str());
-		    }
-		}
-		else
-		{
-		    y2internal("Unhandled package type %s", type.c_str());
-		}
-	    }
-	    else
+	    if (pi)
 	    {
-		y2warning("Package %s was not found", pkgname.c_str());
+		return _create_filelist(pi);
 	    }
 	}
 	catch (...)
@@ -1156,19 +1532,276 @@ YCPList PkgFunctions::PkgGetFilelist( const YCPString & package, const YCPSymbol
     return YCPList();
 }
 
-bool state_saved = false;
-
-// ------------------------
 /**
-   @builtin SaveState
-   @short Save the current selection state, can be restored later using Pkg::RestoreState()
-   @description
-   Save the current status of all resolvables for later restoration via Pkg::RestoreState() function. Only one state is stored, the following call will rewrite the saved status.
-
-   @return boolean
-   @see Pkg::RestoreState
-
-*/
+ *  @builtin PkgGetFilelistEx
+ *  @short Get a filtered part of the file list of a package
+ *  @description
+ *  Like Pkg::PkgGetFilelist() but only the matching files are returned,
+ *  the files are filtered before creating the result so the whole file list
+ *  of a big package is not built just for checking a few files. Options:
+ *
+ *  <code>
+ *  "prefix" : string  - only the files starting with the prefix
+ *  "glob" : string    - only the files matching the shell pattern (see fnmatch(3),
+ *                       "*" matches also "/")
+ *  "offset" : integer - skip the first matching files (default 0)
+ *  "limit" : integer  - max. number of the returned files (default 0 = all)
+ *  </code>
+ *
+ *  @param string name Package Name
+ *  @param symbol which Which packages (`installed, `candidate or `any)
+ *  @param map options the filter options
+ *  @return map $["files" : list<string>, "more" : boolean] ("more" is true if
+ *    the limit has been reached and there are more matching files), nil on error
+ *  @usage Pkg::PkgGetFilelistEx("foo", `installed, $["prefix" : "/etc/", "limit" : 1])
+ *    -> $["files" : ["/etc/foo.conf"], "more" : true]
+ **/
+YCPValue PkgFunctions::PkgGetFilelistEx( const YCPString & package, const YCPSymbol & which, const YCPMap & options )
+{
+    std::string pkgname = package->value();
+    std::string type = which->symbol();
+
+    if (type != "any" && type != "installed" && type != "candidate")
+    {
+	y2error("PkgGetFilelistEx: Unknown parameter, use `any, `installed or `candidate");
+	return YCPVoid();
+    }
+
+    FilelistFilter filter;
+
+    if (!options.isNull())
+    {
+	YCPValue val = options->value(YCPString("prefix"));
+	if (!val.isNull())
+	{
+	    if (!val->isString())
+	    {
+		y2error("PkgGetFilelistEx: Invalid \"prefix\" value: %s", val->toString().c_str());
+		return YCPVoid();
+	    }
+
+	    filter.prefix = val->asString()->value();
+	}
+
+	val = options->value(YCPString("glob"));
+	if (!val.isNull())
+	{
+	    if (!val->isString())
+	    {
+		y2error("PkgGetFilelistEx: Invalid \"glob\" value: %s", val->toString().c_str());
+		return YCPVoid();
+	    }
+
+	    filter.glob = val->asString()->value();
+	}
+
+	val = options->value(YCPString("offset"));
+	if (!val.isNull())
+	{
+	    if (!val->isInteger() || val->asInteger()->value() < 0)
+	    {
+		y2error("PkgGetFilelistEx: Invalid \"offset\" value: %s", val->toString().c_str());
+		return YCPVoid();
+	    }
+
+	    filter.offset = val->asInteger()->value();
+	}
+
+	val = options->value(YCPString("limit"));
+	if (!val.isNull())
+	{
+	    if (!val->isInteger() || val->asInteger()->value() < 0)
+	    {
+		y2error("PkgGetFilelistEx: Invalid \"limit\" value: %s", val->toString().c_str());
+		return YCPVoid();
+	    }
+
+	    filter.limit = val->asInteger()->value();
+	}
+    }
+
+    YCPList files;
+    bool more = false;
+
+    if (!pkgname.empty())
+    {
+	try
+	{
+	    zypp::PoolItem pi = _filelist_item(pkgname, type);
+
+	    if (pi)
+	    {
+		files = _create_filelist(pi, filter, &more);
+	    }
+	}
+	catch (...)
+	{
+	}
+    }
+
+    YCPMap ret;
+    ret->add(YCPString("files"), files);
+    ret->add(YCPString("more"), YCPBoolean(more));
+
+    return ret;
+}
+
+// the directory part of the path ("/" for the files in the root)
+static std::string FileDir(const std::string &path)
+{
+    std::string::size_type pos = path.rfind('/');
+    return pos == std::string::npos || pos == 0 ? std::string("/") : path.substr(0, pos);
+}
+
+// add the files from the new directories to the file => package index,
+// all new directories are added in one pass over the file lists,
+// the index is dropped when the pool is changed
+void PkgFunctions::UpdateFileOwnerIndex(const std::set<std::string> &dirs)
+{
+    unsigned serial = zypp_ptr()->pool().serial().serial();
+
+    if (!file_owners.valid || file_owners.pool_serial != serial)
+    {
+	file_owners.dirs.clear();
+	file_owners.owners.clear();
+	file_owners.pool_serial = serial;
+	file_owners.valid = true;
+    }
+
+    std::set<std::string> missing;
+    std::set_difference(dirs.begin(), dirs.end(), file_owners.dirs.begin(), file_owners.dirs.end(),
+	std::inserter(missing, missing.end()));
+
+    if (missing.empty())
+	return;
+
+    long long start = PkgProfiler::now();
+    zypp::sat::LookupFileAttr files(zypp::sat::SolvAttr::filelist);
+
+    for_(it, files.begin(), files.end())
+    {
+	zypp::sat::Solvable solvable(it.inSolvable());
+
+	// skip the source packages
+	if (!solvable.isKind<zypp::Package>())
+	    continue;
+
+	std::string path(it.asString());
+
+	if (missing.find(FileDir(path)) != missing.end())
+	    file_owners.owners[path].push_back(solvable);
+    }
+
+    file_owners.dirs.insert(missing.begin(), missing.end());
+
+    y2milestone("File owner index: %zd new directories, %zd files (%lldms)", missing.size(),
+	file_owners.owners.size(), (PkgProfiler::now() - start) / 1000);
+}
+
+/**
+ *  @builtin FileOwners
+ *  @short Find the packages which contain the files
+ *  @description
+ *  Returns the installed and available packages which contain the files.
+ *  The files from the queried directories are indexed in one pass over the file
+ *  lists, the index is reused until the repositories or the target are changed.
+ *  A query in an already indexed directory is a hash lookup, the paths from
+ *  new directories should be passed in one call (each call with a new directory
+ *  scans the file lists once). This is much faster than calling
+ *  Pkg::PkgQueryProvides() for each file.
+ *
+ *  Note: the available packages usually contain only the files from the
+ *  primary file list in the repository metadata (/etc, /usr/bin and similar).
+ *
+ *  @param list<string> paths the absolute file names, the other values are ignored
+ *  @return map $[ path : [ $["name":string, "version":string, "arch":string,
+ *    "source":integer, "status":symbol], ... ] ] the files without any owner
+ *    are not included, nil on error
+ *  @usage Pkg::FileOwners(["/etc/passwd"]) -> $["/etc/passwd" : [$["name":"aaa_base", ...]]]
+ **/
+YCPValue PkgFunctions::FileOwners(const YCPList& paths)
+{
+    if (paths.isNull())
+    {
+	y2error("FileOwners: nil parameter");
+	return YCPVoid();
+    }
+
+    std::set<std::string> files;
+    std::set<std::string> dirs;
+
+    for (int i = 0; i < paths->size(); ++i)
+    {
+	if (!paths->value(i)->isString())
+	{
+	    y2error("FileOwners: not a string, skipping: %s", paths->value(i)->toString().c_str());
+	    continue;
+	}
+
+	const std::string path(paths->value(i)->asString()->value());
+	files.insert(path);
+	dirs.insert(FileDir(path));
+    }
+
+    YCPMap ret;
+
+    if (files.empty())
+	return ret;
+
+    try
+    {
+	UpdateFileOwnerIndex(dirs);
+
+	std::set<std::string> keys;
+	keys.insert("name");
+	keys.insert("version");
+	keys.insert("arch");
+	keys.insert("source");
+	keys.insert("status");
+
+	for_(it, files.begin(), files.end())
+	{
+	    boost::unordered_map<std::string, std::vector<zypp::sat::Solvable> >::const_iterator found
+		= file_owners.owners.find(*it);
+
+	    if (found == file_owners.owners.end())
+		continue;
+
+	    YCPList owners;
+
+	    for_(solvable, found->second.begin(), found->second.end())
+	    {
+		owners->add(Resolvable2YCPMap(zypp::ResPool::instance().find(*solvable), "package", false, keys));
+	    }
+
+	    ret->add(YCPString(*it), owners);
+	}
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	y2error("FileOwners failed: %s", excpt.asString().c_str());
+	_last_error.setLastError(ExceptionAsString(excpt));
+	return YCPVoid();
+    }
+
+    y2milestone("FileOwners: found %d of %zd files", ret->size(), files.size());
+
+    return ret;
+}
+
+bool state_saved = false;
+
+// ------------------------
+/**
+   @builtin SaveState
+   @short Save the current selection state, can be restored later using Pkg::RestoreState()
+   @description
+   Save the current status of all resolvables for later restoration via Pkg::RestoreState() function. Only one state is stored, the following call will rewrite the saved status.
+
+   @return boolean
+   @see Pkg::RestoreState
+
+*/
 YCPValue
 PkgFunctions::SaveState ()
 {
@@ -1233,16 +1866,367 @@ PkgFunctions::RestoreState (const YCPBoolean& ch)
 /**
    @builtin ClearSaveState
 
-   @short Clear the saved state - do not use, does nothing (the saved state cannot be removed, it is part of each resolvable object)
+   @short Clear the saved state - removes the checkpoints saved by Pkg::StateCheckpoint()
+   @description
+   The state saved by Pkg::SaveState() cannot be removed, it is part of each resolvable object.
    @return boolean
 
 */
 YCPValue
 PkgFunctions::ClearSaveState ()
 {
+    state_checkpoints.clear();
     return YCPBoolean (true);
 }
 
+// has the status been changed? (the solvables with the default status
+// are not stored in the checkpoints)
+static bool changedStatus(const zypp::ResStatus &status)
+{
+    return status.transacts() || status.isLocked() || status.isSoftLocked();
+}
+
+// the status symbol in StateDiff()
+static std::string stateSymbol(const zypp::ResStatus &status)
+{
+    if (status.isToBeInstalled())
+	return "selected";
+
+    if (status.isInstalled())
+    {
+	if (status.isToBeUninstalled())
+	    return "removed";
+
+	return status.isLocked() ? "protected" : "installed";
+    }
+
+    return status.isLocked() ? "taboo" : "available";
+}
+
+typedef std::pair<zypp::sat::Solvable::IdType, zypp::ResStatus> StateItem;
+
+static bool stateItemLess(const StateItem &a, const StateItem &b)
+{
+    return a.first < b.first;
+}
+
+PkgFunctions::StateSnapshot PkgFunctions::CurrentState()
+{
+    StateSnapshot ret;
+    ret.pool_serial = zypp_ptr()->pool().serial().serial();
+
+    // the pool is sorted by the solvable ID
+    for_(it, zypp_ptr()->pool().begin(), zypp_ptr()->pool().end())
+    {
+	if (changedStatus(it->status()))
+	    ret.items.push_back(std::make_pair(it->satSolvable().id(), it->status()));
+    }
+
+    std::sort(ret.items.begin(), ret.items.end(), stateItemLess);
+
+    return ret;
+}
+
+/**
+   @builtin StateCheckpoint
+   @short Save the current selection state under a name
+   @description
+   Unlike Pkg::SaveState() any number of the states can be saved, only the changed
+   resolvables (to install, to remove, locked) are stored. A checkpoint
+   with the same name is replaced. Use Pkg::StateRollback() for restoring
+   the state, Pkg::StateDiff() for comparing the states and
+   Pkg::ClearSaveState() for removing all checkpoints.
+
+   @param string name name of the checkpoint
+   @return boolean true on success
+*/
+YCPValue
+PkgFunctions::StateCheckpoint (const YCPString& name)
+{
+    if (name.isNull() || name->value().empty())
+    {
+	y2error("StateCheckpoint: missing checkpoint name");
+	return YCPBoolean(false);
+    }
+
+    try
+    {
+	StateSnapshot &snapshot = state_checkpoints[name->value()];
+	snapshot = CurrentState();
+
+	y2milestone("Saved checkpoint '%s': %zd changed resolvables", name->value().c_str(), snapshot.items.size());
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	y2error("Cannot save the checkpoint: %s", excpt.asString().c_str());
+	_last_error.setLastError(ExceptionAsString(excpt));
+	state_checkpoints.erase(name->value());
+	return YCPBoolean(false);
+    }
+
+    return YCPBoolean(true);
+}
+
+/**
+   @builtin StateRollback
+   @short Restore the selection state saved by Pkg::StateCheckpoint()
+   @description
+   The checkpoint is kept, it can be restored again later.
+   The checkpoint cannot be restored after adding or removing a repository.
+
+   @param string name name of the checkpoint
+   @return boolean false if the checkpoint does not exist or it is not valid anymore
+*/
+YCPValue
+PkgFunctions::StateRollback (const YCPString& name)
+{
+    if (name.isNull())
+    {
+	y2error("StateRollback: missing checkpoint name");
+	return YCPBoolean(false);
+    }
+
+    std::map<std::string, StateSnapshot>::const_iterator found = state_checkpoints.find(name->value());
+
+    if (found == state_checkpoints.end())
+    {
+	y2error("Checkpoint '%s' does not exist", name->value().c_str());
+	return YCPBoolean(false);
+    }
+
+    const StateSnapshot &snapshot = found->second;
+
+    if (snapshot.pool_serial != zypp_ptr()->pool().serial().serial())
+    {
+	y2error("The pool has been changed, checkpoint '%s' cannot be restored", name->value().c_str());
+	return YCPBoolean(false);
+    }
+
+    try
+    {
+	unsigned changed = 0;
+
+	for_(it, zypp_ptr()->pool().begin(), zypp_ptr()->pool().end())
+	{
+	    StateItem key(it->satSolvable().id(), zypp::ResStatus());
+	    std::vector<StateItem>::const_iterator saved = std::lower_bound(snapshot.items.begin(),
+		snapshot.items.end(), key, stateItemLess);
+
+	    zypp::ResStatus &status = it->status();
+
+	    if (saved != snapshot.items.end() && saved->first == key.first)
+	    {
+		status = saved->second;
+		++changed;
+	    }
+	    else if (changedStatus(status))
+	    {
+		// back to the default status
+		status.setLock(false, zypp::ResStatus::USER);
+		status.resetTransact(zypp::ResStatus::USER);
+		++changed;
+	    }
+	}
+
+	y2milestone("Restored checkpoint '%s': %u resolvables changed", name->value().c_str(), changed);
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	y2error("Cannot restore the checkpoint: %s", excpt.asString().c_str());
+	_last_error.setLastError(ExceptionAsString(excpt));
+	return YCPBoolean(false);
+    }
+
+    return YCPBoolean(true);
+}
+
+/**
+   @builtin StateDiff
+   @short Compare two selection states
+   @description
+   Returns the resolvables which have a different status in the states,
+   the states are either the names of the checkpoints saved by Pkg::StateCheckpoint()
+   or an empty string for the current state. The status symbols are the same
+   as in Pkg::ResolvableProperties() (`selected, `removed, `installed, `available),
+   the locked resolvables have status `taboo (not installed) or `protected (installed).
+
+   @param string from the first state
+   @param string to the second state
+   @return list<map> [ $["name":string, "kind":symbol, "version":string, "arch":string,
+     "from":symbol, "to":symbol] ], nil on error
+   @usage Pkg::StateDiff("proposal", "") -> [$["name":"foo", "kind":`package, ..., "from":`available, "to":`selected]]
+*/
+YCPValue
+PkgFunctions::StateDiff (const YCPString& from, const YCPString& to)
+{
+    if (from.isNull() || to.isNull())
+    {
+	y2error("StateDiff: nil parameter");
+	return YCPVoid();
+    }
+
+    YCPList ret;
+
+    try
+    {
+	StateSnapshot states[2];
+	const std::string names[2] = { from->value(), to->value() };
+
+	for (int i = 0; i < 2; ++i)
+	{
+	    if (names[i].empty())
+	    {
+		states[i] = CurrentState();
+		continue;
+	    }
+
+	    std::map<std::string, StateSnapshot>::const_iterator found = state_checkpoints.find(names[i]);
+
+	    if (found == state_checkpoints.end())
+	    {
+		y2error("Checkpoint '%s' does not exist", names[i].c_str());
+		return YCPVoid();
+	    }
+
+	    if (found->second.pool_serial != zypp_ptr()->pool().serial().serial())
+	    {
+		y2error("The pool has been changed, checkpoint '%s' is not valid", names[i].c_str());
+		return YCPVoid();
+	    }
+
+	    states[i] = found->second;
+	}
+
+	// merge the sorted lists, the missing solvables have the default status
+	std::vector<StateItem>::const_iterator a = states[0].items.begin();
+	std::vector<StateItem>::const_iterator b = states[1].items.begin();
+
+	while (a != states[0].items.end() || b != states[1].items.end())
+	{
+	    zypp::sat::Solvable::IdType id;
+	    bool in_a = false;
+	    bool in_b = false;
+
+	    if (b == states[1].items.end() || (a != states[0].items.end() && a->first <= b->first))
+	    {
+		id = a->first;
+		in_a = true;
+		in_b = b != states[1].items.end() && b->first == id;
+	    }
+	    else
+	    {
+		id = b->first;
+		in_b = true;
+	    }
+
+	    zypp::PoolItem item(zypp::ResPool::instance().find(zypp::sat::Solvable(id)));
+
+	    // the default status is the current status without the transaction and the lock
+	    zypp::ResStatus neutral(item.status());
+	    neutral.setLock(false, zypp::ResStatus::USER);
+	    neutral.resetTransact(zypp::ResStatus::USER);
+
+	    std::string from_stat(stateSymbol(in_a ? a->second : neutral));
+	    std::string to_stat(stateSymbol(in_b ? b->second : neutral));
+
+	    if (from_stat != to_stat)
+	    {
+		YCPMap info;
+		info->add(YCPKey::name, YCPString(item->name()));
+		info->add(YCPKey::kind, YCPSymbol(item->kind().asString()));
+		info->add(YCPKey::version, YCPString(item->edition().asString()));
+		info->add(YCPKey::arch, YCPString(item->arch().asString()));
+		info->add(YCPString("from"), YCPSymbol(from_stat));
+		info->add(YCPString("to"), YCPSymbol(to_stat));
+		ret->add(info);
+	    }
+
+	    if (in_a)
+		++a;
+	    if (in_b)
+		++b;
+	}
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	y2error("Cannot compare the states: %s", excpt.asString().c_str());
+	_last_error.setLastError(ExceptionAsString(excpt));
+	return YCPVoid();
+    }
+
+    return ret;
+}
+
+unsigned PkgFunctions::TransactSummary::count(const zypp::ResKind &kind, zypp::ui::Selectable::Fate fate) const
+{
+    std::map<Key, Counts>::const_iterator it = counts.find(Key(kind, fate));
+    return it == counts.end() ? 0 : it->second.total();
+}
+
+const PkgFunctions::TransactSummary &PkgFunctions::BuildTransactSummary()
+{
+    unsigned serial = zypp_ptr()->pool().serial().serial();
+
+    // libzypp does not notify about the status changes (e.g. the package
+    // selector changes the status directly), so each call scans the status
+    // bits of all pool items (O(pool)), but this is cheap compared to
+    // evaluating the selectables which is done only when the bits differ
+    std::vector<std::pair<zypp::sat::Solvable::IdType, int> > transacting;
+
+    for_(it, zypp_ptr()->pool().begin(), zypp_ptr()->pool().end())
+    {
+	const zypp::ResStatus &status = it->status();
+
+	if (status.transacts())
+	{
+	    transacting.push_back(std::make_pair(it->satSolvable().id(),
+		static_cast<int>(status.getTransactByValue()) * 2 + status.isToBeInstalled()));
+	}
+    }
+
+    if (transact_summary.valid && transact_summary.pool_serial == serial
+	&& transact_summary.transacting == transacting)
+    {
+	return transact_summary;
+    }
+
+    long long start = PkgProfiler::now();
+
+    transact_summary.counts.clear();
+    transact_summary.members.clear();
+
+    // only the selectables containing a transacting item can be modified
+    std::set<zypp::ui::Selectable::Ptr> done;
+
+    for_(it, transacting.begin(), transacting.end())
+    {
+	zypp::ui::Selectable::Ptr s = zypp::ui::Selectable::get(zypp::sat::Solvable(it->first));
+
+	if (!s || !done.insert(s).second)
+	    continue;
+
+	zypp::ui::Selectable::Fate fate = s->fate();
+
+	if (fate == zypp::ui::Selectable::UNMODIFIED)
+	    continue;
+
+	TransactSummary::Key key(s->kind(), fate);
+	TransactSummary::Member member = { s, s->modifiedBy() };
+
+	transact_summary.counts[key].by[member.by]++;
+	transact_summary.members[key].push_back(member);
+    }
+
+    transact_summary.valid = true;
+    transact_summary.pool_serial = serial;
+    transact_summary.transacting.swap(transacting);
+
+    y2milestone("Transaction summary: %zd transacting items, %zd selectables (%lldus)",
+	transact_summary.transacting.size(), done.size(), PkgProfiler::now() - start);
+
+    return transact_summary;
+}
+
 // ------------------------
 /**
    @builtin IsManualSelection
@@ -1259,15 +2243,11 @@ PkgFunctions::IsManualSelection ()
 {
     try
     {
-	// access to the Pool of Selectables
-	zypp::ResPoolProxy selectablePool(zypp::ResPool::instance().proxy());
+	const TransactSummary &summary = BuildTransactSummary();
 
-	for_(it, selectablePool.byKindBegin<zypp::Package>(),
-	    selectablePool.byKindEnd<zypp::Package>())
+	for_(it, summary.counts.begin(), summary.counts.end())
 	{
-	    zypp::ui::Selectable::Ptr s = (*it);
-
-	    if (s && s->fate() != zypp::ui::Selectable::UNMODIFIED && s->modifiedBy() == zypp::ResStatus::USER)
+	    if (it->first.first == zypp::ResKind::package && it->second.by[zypp::ResStatus::USER] > 0)
 	    {
 		return YCPBoolean(true);
 	    }
@@ -1293,14 +2273,21 @@ pkg2list (YCPList &list, const zypp::PoolItem &item, bool names_only)
 
     if (names_only)
     {
-	list->add(YCPString(pkg->name()));
+	list->add(asYCPString(pkg->ident()));
     }
     else
     {
-	string fullname = pkg->name();
-	fullname += (" " + pkg->edition().version());
-	fullname += (" " + pkg->edition().release());
-	fullname += (" " + pkg->arch().asString());
+	const string &name = pkg->name();
+	const string version(pkg->edition().version());
+	const string release(pkg->edition().release());
+	const string &arch = pkg->arch().asString();
+
+	// build the full name in one buffer, avoid the temporary strings
+	string fullname;
+	fullname.reserve(name.size() + version.size() + release.size() + arch.size() + 3);
+	fullname.append(name).append(1, ' ').append(version).append(1, ' ')
+	    .append(release).append(1, ' ').append(arch);
+
 	list->add (YCPString (fullname));
     }
 }
@@ -1334,25 +2321,25 @@ PkgFunctions::FilterPackages(const YCPBoolean& y_byAuto, const YCPBoolean& y_byA
 
     try
     {
-	// access to the Pool of Selectables
-	zypp::ResPoolProxy selectablePool(zypp::ResPool::instance().proxy());
+	const TransactSummary &summary = BuildTransactSummary();
+	std::map<TransactSummary::Key, std::vector<TransactSummary::Member> >::const_iterator members
+	    = summary.members.find(TransactSummary::Key(zypp::ResKind::package, zypp::ui::Selectable::TO_INSTALL));
 
-	for_(it, selectablePool.byKindBegin<zypp::Package>(),
-	    selectablePool.byKindEnd<zypp::Package>())
+	if (members == summary.members.end())
 	{
-	    zypp::ui::Selectable::Ptr s = (*it);
+	    return packages;
+	}
 
-	    if (s && s->fate() == zypp::ui::Selectable::TO_INSTALL)
-	    {
-		zypp::ResStatus::TransactByValue by = s->modifiedBy();
+	for_(it, members->second.begin(), members->second.end())
+	{
+	    zypp::ResStatus::TransactByValue by = it->by;
 
-		if ((byAuto && by == zypp::ResStatus::SOLVER) ||
-		    (byApp && (by == zypp::ResStatus::APPL_HIGH || by == zypp::ResStatus::APPL_LOW)) ||
-		    (byUser && by == zypp::ResStatus::USER)
-		)
-		{
-		    pkg2list(packages, s->candidateObj(), names_only);
-		}
+	    if ((byAuto && by == zypp::ResStatus::SOLVER) ||
+		(byApp && (by == zypp::ResStatus::APPL_HIGH || by == zypp::ResStatus::APPL_LOW)) ||
+		(byUser && by == zypp::ResStatus::USER)
+	    )
+	    {
+		pkg2list(packages, it->selectable->candidateObj(), names_only);
 	    }
 	}
     }
@@ -1381,6 +2368,110 @@ PkgFunctions::FilterPackages(const YCPBoolean& y_byAuto, const YCPBoolean& y_byA
 
 */
 
+// package categories returned by GetPackages()
+enum PackageCategory
+{
+    PKG_INSTALLED,
+    PKG_SELECTED,
+    PKG_REMOVED,
+    PKG_AVAILABLE,
+    PKG_LOCKED,
+    PKG_TABOO
+};
+
+static bool
+packageCategory(const string &which, PackageCategory &category)
+{
+    if (which == "installed")
+	category = PKG_INSTALLED;
+    else if (which == "selected")
+	category = PKG_SELECTED;
+    else if (which == "removed")
+	category = PKG_REMOVED;
+    else if (which == "available")
+	category = PKG_AVAILABLE;
+    else if (which == "locked")
+	category = PKG_LOCKED;
+    else if (which == "taboo")
+	category = PKG_TABOO;
+    else
+	return false;
+
+    return true;
+}
+
+// the fate and the status of a selectable, evaluated only when a category
+// needs them and then only once for all requested categories
+class SelectableState
+{
+    public:
+	SelectableState(const zypp::ui::Selectable::Ptr &s)
+	    : _s(s), _has_fate(false), _has_status(false) {}
+
+	zypp::ui::Selectable::Fate fate()
+	{
+	    if (!_has_fate)
+	    {
+		_fate = _s->fate();
+		_has_fate = true;
+	    }
+
+	    return _fate;
+	}
+
+	zypp::ui::Status status()
+	{
+	    if (!_has_status)
+	    {
+		_status = _s->status();
+		_has_status = true;
+	    }
+
+	    return _status;
+	}
+
+    private:
+	const zypp::ui::Selectable::Ptr &_s;
+	bool _has_fate;
+	bool _has_status;
+	zypp::ui::Selectable::Fate _fate;
+	zypp::ui::Status _status;
+};
+
+// add the package to the list if it belongs to the category
+static void
+categoryPkg2list(YCPList &list, const zypp::ui::Selectable::Ptr &s, PackageCategory category,
+    SelectableState &state, bool names_only)
+{
+    switch (category)
+    {
+	case PKG_INSTALLED:
+	    if (s->hasInstalledObj())
+		pkg2list(list, s->installedObj(), names_only);
+	    break;
+	case PKG_SELECTED:
+	    if (s->hasCandidateObj() && state.fate() == zypp::ui::Selectable::TO_INSTALL)
+		pkg2list(list, s->candidateObj(), names_only);
+	    break;
+	case PKG_REMOVED:
+	    if (s->hasInstalledObj() && state.fate() == zypp::ui::Selectable::TO_DELETE)
+		pkg2list(list, s->installedObj(), names_only);
+	    break;
+	case PKG_AVAILABLE:
+	    if (s->hasCandidateObj())
+		pkg2list(list, s->candidateObj(), names_only);
+	    break;
+	case PKG_LOCKED:
+	    if (state.status() == zypp::ui::S_Protected)
+		pkg2list(list, s->installedObj(), names_only);
+	    break;
+	case PKG_TABOO:
+	    if (state.status() == zypp::ui::S_Taboo)
+		pkg2list(list, s->candidateObj(), names_only);
+	    break;
+    }
+}
+
 YCPValue
 PkgFunctions::GetPackages(const YCPSymbol& y_which, const YCPBoolean& y_names_only)
 {
@@ -1389,6 +2480,12 @@ PkgFunctions::GetPackages(const YCPSymbol& y_which, const YCPBoolean& y_names_on
 
     YCPList packages;
 
+    PackageCategory category;
+    if (!packageCategory(which, category))
+    {
+	return YCPError ("Wrong parameter for Pkg::GetPackages");
+    }
+
     try
     {
 	// access to the Pool of Selectables
@@ -1401,51 +2498,74 @@ PkgFunctions::GetPackages(const YCPSymbol& y_which, const YCPBoolean& y_names_on
 
 	    if (!s) continue;
 
-	    if (which == "installed")
-	    {
-		if (s->hasInstalledObj())
-		{
-		    pkg2list(packages, s->installedObj(), names_only);
-		}
-	    }
-	    else if (which == "selected")
-	    {
-		if (s->fate() == zypp::ui::Selectable::TO_INSTALL && s->hasCandidateObj())
-		{
-		    pkg2list(packages, s->candidateObj(), names_only);
-		}
-	    }
-	    else if (which == "removed")
-	    {
-		if (s->fate() == zypp::ui::Selectable::TO_DELETE && s->hasInstalledObj())
-		{
-		    pkg2list(packages, s->installedObj(), names_only);
-		}
-	    }
-	    else if (which == "available")
-	    {
-		if (s->hasCandidateObj())
-		{
-		    pkg2list(packages, s->candidateObj(), names_only);
-		}
-	    }
-	    else if (which == "locked")
-	    {
-		if (s->status() == zypp::ui::S_Protected)
-		{
-		    pkg2list(packages, s->installedObj(), names_only);
-		}
-	    }
-	    else if (which == "taboo")
-	    {
-		if (s->status() == zypp::ui::S_Taboo)
-		{
-		    pkg2list(packages, s->candidateObj(), names_only);
-		}
-	    }
-	    else
+	    SelectableState state(s);
+	    categoryPkg2list(packages, s, category, state, names_only);
+	}
+    }
+    catch (...)
+    {
+    }
+
+    return packages;
+}
+
+/**
+   @builtin GetPackagesMulti
+
+   @short Get lists of packages in several categories at once
+   @description
+   Same as GetPackages() called for each requested category but the pool
+   is scanned only once.
+
+   @param list<symbol> categories the requested categories: `installed, `selected,
+   `available, `removed, `locked or `taboo, see GetPackages()
+   @param boolean names_only If true, return package names only
+   @return map<symbol,list<string>> category => list of packages, nil if a category is not known
+
+   @usage Pkg::GetPackagesMulti([`installed, `selected, `removed], true)
+     -> $[ `installed : [...], `selected : [...], `removed : [...] ]
+*/
+
+YCPValue
+PkgFunctions::GetPackagesMulti(const YCPList& y_which, const YCPBoolean& y_names_only)
+{
+    bool names_only = y_names_only->value();
+
+    std::vector<std::pair<string, PackageCategory> > categories;
+    categories.reserve(y_which->size());
+
+    for (int i = 0; i < y_which->size(); ++i)
+    {
+	PackageCategory category;
+
+	if (!y_which->value(i)->isSymbol() || !packageCategory(y_which->value(i)->asSymbol()->symbol(), category))
+	{
+	    y2error("Wrong parameter for Pkg::GetPackagesMulti: %s", y_which->value(i)->toString().c_str());
+	    return YCPVoid();
+	}
+
+	categories.push_back(std::make_pair(y_which->value(i)->asSymbol()->symbol(), category));
+    }
+
+    std::vector<YCPList> packages(categories.size());
+
+    try
+    {
+	// access to the Pool of Selectables
+	zypp::ResPoolProxy selectablePool(zypp::ResPool::instance().proxy());
+
+	for_(it, selectablePool.byKindBegin<zypp::Package>(),
+	    selectablePool.byKindEnd<zypp::Package>())
+	{
+	    zypp::ui::Selectable::Ptr s = (*it);
+
+	    if (!s) continue;
+
+	    SelectableState state(s);
+
+	    for (unsigned i = 0; i < categories.size(); ++i)
 	    {
-		return YCPError ("Wrong parameter for Pkg::GetPackages");
+		categoryPkg2list(packages[i], s, categories[i].second, state, names_only);
 	    }
 	}
     }
@@ -1453,7 +2573,14 @@ PkgFunctions::GetPackages(const YCPSymbol& y_which, const YCPBoolean& y_names_on
     {
     }
 
-    return packages;
+    YCPMap ret;
+
+    for (unsigned i = 0; i < categories.size(); ++i)
+    {
+	ret->add(YCPSymbol(categories[i].first), packages[i]);
+    }
+
+    return ret;
 }
 
 
@@ -1850,6 +2977,9 @@ YCPValue PkgFunctions::SetSolverFlags(const YCPMap& params)
     zypp::Resolver_Ptr solver = zypp_ptr()->resolver();
     const YCPValue reset_value(params->value(YCPString("reset")));
 
+    // the solver state is changed, run the solver again
+    solve_fingerprint_valid = false;
+
     if (!reset_value.isNull() && reset_value->isBoolean())
     {
 	bool reset = reset_value->asBoolean()->value();
@@ -1960,9 +3090,30 @@ PkgFunctions::PkgSolve (const YCPBoolean& filter)
 {
     bool result = false;
 
+    solve_stats.start("PkgSolve");
+
+    if (solver_cache && solve_fingerprint_valid && SolveFingerprint() == solve_fingerprint)
+    {
+	y2milestone("Nothing changed since the last solver run, skipping the solver");
+	solve_stats.cached = true;
+	solve_stats.stop(true);
+	return YCPBoolean(true);
+    }
+
+    solve_fingerprint_valid = false;
+
     try
     {
+	long long start = PkgProfiler::now();
 	result = zypp_ptr()->resolver()->resolvePool();
+	solve_stats.solver_time = PkgProfiler::now() - start;
+
+	// remember the solved state
+	if (result && solver_cache)
+	{
+	    solve_fingerprint = SolveFingerprint();
+	    solve_fingerprint_valid = true;
+	}
     }
     catch (const zypp::Exception& excpt)
     {
@@ -1974,10 +3125,15 @@ PkgFunctions::PkgSolve (const YCPBoolean& filter)
     // save information about failed dependencies to file
     if (!result)
     {
+	long long start = PkgProfiler::now();
 	zypp::ResolverProblemList problems = zypp_ptr()->resolver()->problems();
 	SaveProblemList(problems, "/var/log/YaST2/badlist");
+	solve_stats.problems = problems.size();
+	solve_stats.problems_time = PkgProfiler::now() - start;
     }
 
+    solve_stats.stop(result);
+
     return YCPBoolean(result);
 }
 
@@ -1994,12 +3150,17 @@ PkgFunctions::PkgSolve (const YCPBoolean& filter)
 YCPBoolean
 PkgFunctions::PkgSolveCheckTargetOnly()
 {
+    solve_stats.start("PkgSolveCheckTargetOnly");
+
     try
     {
+	long long start = PkgProfiler::now();
 	zypp_ptr()->target()->load();
+	solve_stats.target_load_time = PkgProfiler::now() - start;
     }
     catch (...)
     {
+	solve_stats.stop(false);
 	return YCPBoolean(false);
     }
 
@@ -2008,7 +3169,16 @@ PkgFunctions::PkgSolveCheckTargetOnly()
     try
     {
 	// verify consistency of system
+	long long start = PkgProfiler::now();
 	result = zypp_ptr()->resolver()->verifySystem();
+	solve_stats.solver_time = PkgProfiler::now() - start;
+
+	if (!result)
+	{
+	    start = PkgProfiler::now();
+	    solve_stats.problems = zypp_ptr()->resolver()->problems().size();
+	    solve_stats.problems_time = PkgProfiler::now() - start;
+	}
     }
     catch (const zypp::Exception& excpt)
     {
@@ -2016,6 +3186,8 @@ PkgFunctions::PkgSolveCheckTargetOnly()
 	_last_error.setLastError(ExceptionAsString(excpt));
     }
 
+    solve_stats.stop(result);
+
     return YCPBoolean(result);
 }
 
@@ -2043,6 +3215,123 @@ PkgFunctions::PkgSolveErrors()
     return YCPVoid();
 }
 
+/*
+ * A helper function - compute the fingerprint of everything the solver
+ * result depends on: the repositories (the pool serial number), the changed
+ * resolvable states (including the locks and the solver decisions), the solver
+ * flags, the requested locales and the architecture.
+ */
+std::size_t PkgFunctions::SolveFingerprint()
+{
+    std::size_t seed = 0;
+    zypp::Resolver_Ptr solver = zypp_ptr()->resolver();
+
+    boost::hash_combine(seed, zypp_ptr()->pool().serial().serial());
+
+    for_(it, zypp_ptr()->pool().begin(), zypp_ptr()->pool().end())
+    {
+	const zypp::ResStatus &status = it->status();
+
+	if (status.transacts() || status.isLocked() || status.isSoftLocked())
+	{
+	    boost::hash_combine(seed, it->satSolvable().id());
+	    boost::hash_combine(seed, static_cast<int>(status.getTransactValue()));
+	    boost::hash_combine(seed, static_cast<int>(status.getTransactByValue()));
+	    boost::hash_combine(seed, status.isToBeInstalled());
+	}
+    }
+
+    boost::hash_combine(seed, solver->onlyRequires());
+    boost::hash_combine(seed, solver->ignoreAlreadyRecommended());
+    boost::hash_combine(seed, solver->allowVendorChange());
+    boost::hash_combine(seed, solver->upgradeMode());
+#ifdef HAVE_ZYPP_DUP_FLAGS
+    boost::hash_combine(seed, solver->dupAllowDowngrade());
+    boost::hash_combine(seed, solver->dupAllowNameChange());
+    boost::hash_combine(seed, solver->dupAllowArchChange());
+    boost::hash_combine(seed, solver->dupAllowVendorChange());
+#endif
+
+    const zypp::LocaleSet &locales = zypp::sat::Pool::instance().getRequestedLocales();
+    for_(it, locales.begin(), locales.end())
+    {
+	boost::hash_combine(seed, it->code());
+    }
+
+    boost::hash_combine(seed, zypp::ZConfig::instance().systemArchitecture().asString());
+
+    return seed;
+}
+
+void PkgFunctions::SolveStats::start(const std::string &call_r)
+{
+    *this = SolveStats();
+    call = call_r;
+    start_time = PkgProfiler::now();
+}
+
+void PkgFunctions::SolveStats::stop(bool result_r)
+{
+    result = result_r;
+    total_time = PkgProfiler::now() - start_time;
+    solvables = zypp::sat::Pool::instance().solvablesSize();
+
+    for_(it, zypp::ResPool::instance().begin(), zypp::ResPool::instance().end())
+    {
+	if (it->status().transacts())
+	    ++transacting;
+    }
+
+    valid = true;
+
+    y2milestone("%s: result %s, total %lldms, solver %lldms, %u solvables, %u transacting, %u problems",
+	call.c_str(), result ? "true" : "false", total_time / 1000, solver_time / 1000,
+	solvables, transacting, problems);
+}
+
+/**
+   @builtin PkgSolveStats
+   @short Returns the statistics of the last solver run
+   @description
+   The statistics of the last Pkg::PkgSolve() or Pkg::PkgSolveCheckTargetOnly() call:
+
+   <code>
+   $[ "call" : string (the builtin name), "result" : boolean,
+      "cached" : boolean (the solver has been skipped, see "solver_cache" in Pkg::SetZConfig()),
+      "total_time" : integer (the wall time of the call in ms),
+      "target_load_time" : integer (loading the target, PkgSolveCheckTargetOnly only),
+      "solver_time" : integer (the time spent in the solver),
+      "problems_time" : integer (collecting and saving the problems),
+      "problems" : integer (number of problems), "solvables" : integer (pool size),
+      "transacting" : integer (resolvables to install or remove after the run) ]
+   </code>
+
+   Note: the solver rules and decisions are not available via the libzypp API.
+
+   @return map<string,any> the statistics, nil if the solver has not been run yet
+*/
+YCPValue
+PkgFunctions::PkgSolveStats()
+{
+    if (!solve_stats.valid)
+	return YCPVoid();
+
+    YCPMap ret;
+
+    ret->add(YCPString("call"), YCPString(solve_stats.call));
+    ret->add(YCPString("result"), YCPBoolean(solve_stats.result));
+    ret->add(YCPString("cached"), YCPBoolean(solve_stats.cached));
+    ret->add(YCPString("total_time"), YCPInteger(solve_stats.total_time / 1000));
+    ret->add(YCPString("target_load_time"), YCPInteger(solve_stats.target_load_time / 1000));
+    ret->add(YCPString("solver_time"), YCPInteger(solve_stats.solver_time / 1000));
+    ret->add(YCPString("problems_time"), YCPInteger(solve_stats.problems_time / 1000));
+    ret->add(YCPString("problems"), YCPInteger(solve_stats.problems));
+    ret->add(YCPString("solvables"), YCPInteger(solve_stats.solvables));
+    ret->add(YCPString("transacting"), YCPInteger(solve_stats.transacting));
+
+    return ret;
+}
+
 namespace
 {
   ///////////////////////////////////////////////////////////////////
@@ -2150,6 +3439,9 @@ YCPValue PkgFunctions::CommitHelper(const zypp::ZYppCommitPolicy *policy)
 
     SourceReleaseAll();
 
+    // the installed products have been changed
+    base_product_cache.reset();
+
     // create the base product link (bnc#413444)
     CreateBaseProductSymlink();
 
@@ -2168,19 +3460,19 @@ YCPValue PkgFunctions::CommitHelper(const zypp::ZYppCommitPolicy *policy)
     for (zypp::PoolItemList::const_iterator it = result._remaining.begin(); it != result._remaining.end(); ++it)
     {
 	YCPMap resolvable;
-	resolvable->add (YCPString ("name"),
+	resolvable->add (YCPKey::name,
 	    YCPString(it->resolvable()->name()));
 	if (zypp::isKind<zypp::Product>(it->resolvable()))
-	    resolvable->add (YCPString ("kind"), YCPSymbol ("product"));
+	    resolvable->add (YCPKey::kind, YCPSymbol ("product"));
 	else if (zypp::isKind<zypp::Pattern>(it->resolvable()))
-	    resolvable->add (YCPString ("kind"), YCPSymbol ("pattern"));
+	    resolvable->add (YCPKey::kind, YCPSymbol ("pattern"));
 	else if (zypp::isKind<zypp::Patch>(it->resolvable()))
-	    resolvable->add (YCPString ("kind"), YCPSymbol ("patch"));
+	    resolvable->add (YCPKey::kind, YCPSymbol ("patch"));
 	else
-	    resolvable->add (YCPString ("kind"), YCPSymbol ("package"));
-	resolvable->add (YCPString ("arch"),
+	    resolvable->add (YCPKey::kind, YCPSymbol ("package"));
+	resolvable->add (YCPKey::arch,
 	    YCPString (it->resolvable()->arch().asString()));
-	resolvable->add (YCPString ("version"),
+	resolvable->add (YCPKey::version,
 	    YCPString (it->resolvable()->edition().asString()));
 	remlist->add(resolvable);
     }
@@ -2221,6 +3513,210 @@ YCPValue PkgFunctions::CommitHelper(const zypp::ZYppCommitPolicy *policy)
     return ret;
 }
 
+/*
+ * A helper function - worker job for the parallel package download,
+ * it runs in a forked child process, see PkgWorkers.
+ * The package is stored in the package cache of the repository
+ * where the commit finds it later.
+ */
+// a worker downloads a batch of packages one after another, the opened
+// media (the connections) are shared by all of them; used only in the worker
+// processes, released by PrefetchCleanup() before the worker exits
+static zypp::repo::RepoMediaAccess *prefetch_access = NULL;
+
+static void PrefetchCleanup()
+{
+    delete prefetch_access;
+    prefetch_access = NULL;
+}
+
+static int PrefetchJob(const zypp::Package::constPtr &package)
+{
+    if (prefetch_access == NULL)
+	prefetch_access = new zypp::repo::RepoMediaAccess();
+
+    zypp::repo::RepoMediaAccess &access = *prefetch_access;
+    zypp::repo::PackageProviderPolicy packageProviderPolicy;
+    zypp::repo::DeltaCandidates deltas;
+    zypp::repo::PackageProvider pkgProvider(access, package, deltas, packageProviderPolicy);
+
+    // already downloaded
+    if (!pkgProvider.providePackageFromCache()->empty())
+    {
+	return PkgWorkers::JOB_SKIPPED;
+    }
+
+    zypp::ManagedFile file(pkgProvider.providePackage());
+    // keep the downloaded file in the cache
+    file.resetDispose();
+
+    return PkgWorkers::JOB_DONE;
+}
+
+// the shared state of the parallel package download
+struct PrefetchState
+{
+    PrefetchState(const std::vector<zypp::Package::constPtr> &packages_r)
+	: packages(packages_r), downloaded(0), cached(0), failed(0)
+    {}
+
+    const std::vector<zypp::Package::constPtr> &packages;
+    zypp::callback::SendReport<zypp::repo::DownloadResolvableReport> report;
+    unsigned downloaded;
+    unsigned cached;
+    unsigned failed;
+};
+
+static bool PrefetchFinished(PrefetchState *state, unsigned index, int status)
+{
+    const zypp::Package::constPtr &package = state->packages[index];
+
+    if (status == PkgWorkers::JOB_SKIPPED)
+    {
+	++state->cached;
+	return true;
+    }
+
+    if (status != PkgWorkers::JOB_DONE)
+    {
+	// the commit downloads it again and reports the problem as usual
+	y2warning("Parallel download of %s failed (status %d), will retry",
+	    package->name().c_str(), status);
+	++state->failed;
+	return true;
+    }
+
+    ++state->downloaded;
+
+    // report the finished download via the usual download callbacks
+    state->report->start(package, package->repoInfo().url());
+    bool ret = state->report->progress(100, package);
+    state->report->finish(package, zypp::repo::DownloadResolvableReport::NO_ERROR, "");
+
+    if (!ret)
+    {
+	y2milestone("Parallel download aborted by user");
+    }
+
+    return ret;
+}
+
+/*
+ * A helper function - download the packages to install from the remote
+ * repositories into the package cache in forked worker processes.
+ * The workers run without any user interaction, the failed packages are
+ * downloaded again by the commit which reports the errors as usual.
+ *
+ * Returns false if aborted by user.
+ */
+bool PkgFunctions::PrefetchPackages(unsigned jobs, const zypp::ZYppCommitPolicy &policy)
+{
+    std::vector<zypp::Package::constPtr> packages;
+    PkgWorkers workers(jobs, boost::bind(&CallbackHandler::disconnectReceivers, &_callbackHandler),
+	PrefetchCleanup);
+
+    for_(it, zypp_ptr()->pool().byKindBegin<zypp::Package>(), zypp_ptr()->pool().byKindEnd<zypp::Package>())
+    {
+	if (!it->status().isToBeInstalled())
+	    continue;
+
+	zypp::Package::constPtr package = zypp::asKind<zypp::Package>(it->resolvable());
+
+	if (!package || (policy.restrictToMedia() != 0 && package->mediaNr() != policy.restrictToMedia()))
+	    continue;
+
+	const zypp::RepoInfo &repoinfo = package->repoInfo();
+
+	// only the downloading schemes, mounting a medium in a child process
+	// would leave it mounted after exiting the child
+	if (repoinfo.baseUrlsEmpty() || !repoinfo.baseUrlsBegin()->schemeIsDownloading())
+	    continue;
+
+	workers.add(boost::bind(PrefetchJob, package));
+	packages.push_back(package);
+    }
+
+    if (packages.size() < 2)
+    {
+	y2milestone("Not enough remote packages for the parallel download");
+	return true;
+    }
+
+    PrefetchState state(packages);
+    bool ret = workers.run(boost::bind(PrefetchFinished, &state, _1, _2));
+
+    y2milestone("Downloaded in parallel: %u, already cached: %u, failed: %u (%zd packages, %u jobs)",
+	state.downloaded, state.cached, state.failed, packages.size(), jobs);
+
+    return ret;
+}
+
+// sort the install latencies, the slowest first
+static bool slowerInstall(const std::pair<long long, std::string> &a, const std::pair<long long, std::string> &b)
+{
+    return a.first > b.first;
+}
+
+/*
+ * A helper function - convert the collected commit statistics to a YCP map
+ */
+static YCPMap CommitStats2YCPMap(const ZyppRecipients::CommitStats &stats, unsigned slowest)
+{
+    YCPMap ret;
+
+    ret->add(YCPString("total_time"), YCPInteger(stats.total_time));
+    ret->add(YCPString("prefetch_time"), YCPInteger(stats.prefetch_time));
+    ret->add(YCPString("download_time"), YCPInteger(stats.download_time));
+    ret->add(YCPString("check_time"), YCPInteger(stats.check_time));
+    ret->add(YCPString("rpm_time"), YCPInteger(stats.rpm_time));
+    ret->add(YCPString("script_time"), YCPInteger(stats.script_time));
+    ret->add(YCPString("downloaded"), YCPInteger(stats.downloaded));
+    ret->add(YCPString("downloaded_bytes"), YCPInteger(stats.downloaded_bytes));
+
+    long long transfer_time = stats.download_time + stats.prefetch_time;
+    ret->add(YCPString("download_rate"),
+	YCPInteger(transfer_time > 0 ? stats.downloaded_bytes * 1000 / transfer_time : 0LL));
+
+    ret->add(YCPString("installed"), YCPInteger(stats.installed));
+    ret->add(YCPString("removed"), YCPInteger(stats.removed));
+    ret->add(YCPString("scripts"), YCPInteger(stats.scripts));
+
+    // the upper limits of the histogram buckets (in ms), -1 = above the last limit
+    const long long limits[] = { 100, 500, 1000, 5000, 30000, -1 };
+    const unsigned buckets = sizeof(limits) / sizeof(limits[0]);
+    std::vector<long long> histogram(buckets, 0);
+
+    for_(it, stats.install_latency.begin(), stats.install_latency.end())
+    {
+	unsigned i = 0;
+	while (i < buckets - 1 && it->first >= limits[i])
+	    ++i;
+
+	++histogram[i];
+    }
+
+    YCPMap hist;
+    for (unsigned i = 0; i < buckets; ++i)
+	hist->add(YCPInteger(limits[i]), YCPInteger(histogram[i]));
+    ret->add(YCPString("install_histogram"), hist);
+
+    std::vector<std::pair<long long, std::string> > sorted(stats.install_latency);
+    unsigned count = std::min<size_t>(slowest, sorted.size());
+    std::partial_sort(sorted.begin(), sorted.begin() + count, sorted.end(), slowerInstall);
+
+    YCPList slow;
+    for (unsigned i = 0; i < count; ++i)
+    {
+	YCPMap pkg;
+	pkg->add(YCPKey::name, YCPString(sorted[i].second));
+	pkg->add(YCPString("time"), YCPInteger(sorted[i].first));
+	slow->add(pkg);
+    }
+    ret->add(YCPString("slowest"), slow);
+
+    return ret;
+}
+
 YCPValue PkgFunctions::CommitPolicy()
 {
     YCPMap ret;
@@ -2308,172 +3804,170 @@ PkgFunctions::PkgCommit (const YCPInteger& media)
  * @param map commit configuration, currently supported values:
  *   $["download_mode":`default|`download_only|`download_only|`download_in_advance|
  *      `download_in_heaps|`download_as_needed, "medium_nr":<integer>,
- *      "dry_run":<boolean>, "exclude_docs":<boolean>, "no_signature":<boolean>],
+ *      "dry_run":<boolean>, "exclude_docs":<boolean>, "no_signature":<boolean>,
+ *      "parallel_downloads":<integer>, "stats":<boolean>, "stats_slowest":<integer>],
  *   the default is $["download_mode":`default, "medium_nr":0 (all media),
- *      "dry_run":false, "exclude_docs":false, "no_signature":false],
+ *      "dry_run":false, "exclude_docs":false, "no_signature":false,
+ *      "parallel_downloads":1, "stats":false, "stats_slowest":10],
+ *
+ *   "parallel_downloads" is the max. number of packages downloaded at once from
+ *   the remote repositories before starting the installation, 1 = no parallel
+ *   download (the packages are downloaded by libzypp during the commit)
  *
- *  @return list [ int successful, list failed, list remaining, list srcremaining, list update_messages ]
- * The 'successful' value will be negative, if installation was aborted !
+ *   If "stats" is true the commit statistics map is appended to the result:
+ *   $["total_time", "prefetch_time", "download_time", "check_time", "rpm_time",
+ *   "script_time" (the accumulated wall time of the phases in ms, without
+ *   the time spent in the YCP callbacks), "downloaded", "downloaded_bytes",
+ *   "download_rate" (bytes/s), "installed", "removed", "scripts" (counts),
+ *   "install_histogram" : map<integer,integer> (package install time histogram,
+ *   the key is the upper limit of the bucket in ms, -1 = unlimited),
+ *   "slowest" : list<map> (the "stats_slowest" slowest packages,
+ *   $["name":string, "time":integer])]
+ *
+ *  @return list [ int successful, list failed, list remaining, list srcremaining, list update_messages
+ *   (, map stats) ]
+ * The 'successful' value will be negative, if installation was aborted ! The stats map
+ * is always the sixth item, the lists are empty for an aborted installation.
 */
 /* TYPEINFO: list<any>(integer)*/
 YCPValue PkgFunctions::Commit (const YCPMap& config)
 {
-    commit_policy = new zypp::ZYppCommitPolicy;
+    YcpMapLoad options("Pkg::Commit");
+    std::string &download_mode(options.arg<YT_SYMBOL, std::string>("download_mode", "default"));
+    unsigned &medium_nr(options.arg<YT_INTEGER, unsigned>("medium_nr", 0));
+    bool &dry_run(options.arg<YT_BOOLEAN, bool>("dry_run", false));
+    bool &exclude_docs(options.arg<YT_BOOLEAN, bool>("exclude_docs", false));
+    bool &no_signature(options.arg<YT_BOOLEAN, bool>("no_signature", false));
+    long long &parallel_downloads(options.arg<YT_INTEGER, long long>("parallel_downloads", 1LL));
+    bool &stats(options.arg<YT_BOOLEAN, bool>("stats", false));
+    long long &stats_slowest(options.arg<YT_INTEGER, long long>("stats_slowest", 10LL));
+
+    if (!options.load(config))
+    {
+	_last_error.setLastError(std::string("Invalid commit option ") + options.error());
+	return YCPVoid();
+    }
 
-    if (!config.isNull())
+    zypp::DownloadMode mode = zypp::DownloadDefault;
+
+    if (download_mode == "default")
+	mode = zypp::DownloadDefault;
+    else if (download_mode == "download_only")
+	mode = zypp::DownloadOnly;
+    else if (download_mode == "download_in_advance")
+	mode = zypp::DownloadInAdvance;
+    else if (download_mode == "download_in_heaps")
+	mode = zypp::DownloadInHeaps;
+    else if (download_mode == "download_as_needed")
+	mode = zypp::DownloadAsNeeded;
+    else
     {
-        YCPString key("download_mode");
+	y2error("Invalid download mode: %s", download_mode.c_str());
+	_last_error.setLastError(std::string("Invalid download mode: ") + download_mode);
+	return YCPVoid();
+    }
 
-        // set the download mode
-        if(!config->value(key).isNull())
-        {
-            if (config->value(key)->isSymbol())
-            {
-                std::string mode = config->value(key)->asSymbol()->symbol();
-
-                if (mode == "default")
-                {
-                    commit_policy->downloadMode(zypp::DownloadDefault);
-                }
-                else if (mode == "download_only")
-                {
-                    commit_policy->downloadMode(zypp::DownloadOnly);
-                }
-                else if (mode == "download_in_advance")
-                {
-                    commit_policy->downloadMode(zypp::DownloadInAdvance);
-                }
-                else if (mode == "download_in_heaps")
-                {
-                    commit_policy->downloadMode(zypp::DownloadInHeaps);
-                }
-                else if (mode == "download_as_needed")
-                {
-                    commit_policy->downloadMode(zypp::DownloadAsNeeded);
-                }
-                else
-                {
-                    y2error("Invalid download mode: %s", mode.c_str());
-                    _last_error.setLastError(std::string("Invalid download mode: ") + mode);
-
-		    delete commit_policy;
-		    commit_policy = NULL;
-
-                    return YCPVoid();
-                }
-
-                y2milestone("Using download mode: %s", mode.c_str());
-            }
-            else
-            {
-                y2error("Invalid download mode: symbol is required, got: %s", config->value(key)->asString()->value().c_str());
-                _last_error.setLastError(std::string("Invalid download mode: ") + config->value(key)->asString()->value());
+    if (parallel_downloads < 1)
+    {
+	y2error("Parallel downloads option: positive integer is required, got: %lld", parallel_downloads);
+	_last_error.setLastError(std::string("Invalid parallel downloads option: ") + zypp::str::numstring(parallel_downloads));
+	return YCPVoid();
+    }
 
-		delete commit_policy;
-		commit_policy = NULL;
+    if (stats_slowest < 0)
+    {
+	y2error("Stats slowest option: non-negative integer is required, got: %lld", stats_slowest);
+	_last_error.setLastError(std::string("Invalid stats slowest option: ") + zypp::str::numstring(stats_slowest));
+	return YCPVoid();
+    }
 
-                return YCPVoid();
-            }
-        }
+    commit_policy = new zypp::ZYppCommitPolicy;
 
-        key = YCPString("medium_nr");
-        // set the medium number
-        if(!config->value(key).isNull())
-        {
-            if (config->value(key)->isInteger())
-            {
-                unsigned medium_nr = config->value(key)->asInteger()->value();
-                commit_policy->restrictToMedia(medium_nr);
+    // keep the libzypp defaults (from zypp.conf) for the missing options
+    if (options.has("download_mode"))
+    {
+	commit_policy->downloadMode(mode);
+	y2milestone("Using download mode: %s", download_mode.c_str());
+    }
 
-                y2milestone("Restricting commit only to medium number: %u", medium_nr);
-            }
-            else
-            {
-                y2error("Invalid medium number: integer is required, got: %s", config->value(key)->asString()->value().c_str());
-                _last_error.setLastError(std::string("Invalid medium number: ") + config->value(key)->asString()->value());
+    if (options.has("medium_nr"))
+    {
+	commit_policy->restrictToMedia(medium_nr);
+	y2milestone("Restricting commit only to medium number: %u", medium_nr);
+    }
 
-		delete commit_policy;
-		commit_policy = NULL;
+    if (options.has("dry_run"))
+    {
+	commit_policy->dryRun(dry_run);
+	y2milestone("Dry run commit: %s", dry_run ? "true" : "false");
+    }
 
-                return YCPVoid();
-            }
-        }
+    if (options.has("exclude_docs"))
+    {
+	commit_policy->rpmExcludeDocs(exclude_docs);
+	y2milestone("Excluding documentation: %s", exclude_docs ? "true" : "false");
+    }
 
-        key = YCPString("dry_run");
-        // set the medium number
-        if(!config->value(key).isNull())
-        {
-            if (config->value(key)->isBoolean())
-            {
-                bool dry_run = config->value(key)->asBoolean()->value();
-                commit_policy->dryRun(dry_run);
+    if (options.has("no_signature"))
+    {
+	commit_policy->rpmNoSignature(no_signature);
+	y2milestone("Don't check RPM signature: %s", no_signature ? "true" : "false");
+    }
 
-                y2milestone("Dry run commit: %s", config->value(key)->asString()->value().c_str());
-            }
-            else
-            {
-                y2error("Dry run option: boolean is required, got: %s", config->value(key)->asString()->value().c_str());
-                _last_error.setLastError(std::string("Invalid dry run option: ") + config->value(key)->asString()->value());
+    if (options.has("parallel_downloads"))
+    {
+	y2milestone("Parallel downloads: %lld", parallel_downloads);
+    }
 
-		delete commit_policy;
-		commit_policy = NULL;
+    ZyppRecipients::CommitStats &commit_stats = _callbackHandler.commitStats();
+    if (stats)
+    {
+	commit_stats.start();
+    }
 
-                return YCPVoid();
-            }
-        }
+    YCPValue ret = YCPVoid();
 
-        key = YCPString("exclude_docs");
-        // set the medium number
-        if(!config->value(key).isNull())
-        {
-            if (config->value(key)->isBoolean())
-            {
-                bool exclude_docs = config->value(key)->asBoolean()->value();
-                commit_policy->rpmExcludeDocs(exclude_docs);
+    // nothing is downloaded in the dry run mode
+    if (parallel_downloads > 1 && !commit_policy->dryRun()
+	&& !PrefetchPackages(parallel_downloads, *commit_policy))
+    {
+	YCPList aborted;
+	aborted->add(YCPInteger(-1));
+	ret = aborted;
+    }
+    else
+    {
+	if (stats)
+	    commit_stats.prefetch_time = PkgProfiler::nowMs() - commit_stats.started;
 
-                y2milestone("Excluding documentation: %s", config->value(key)->asString()->value().c_str());
-            }
-            else
-            {
-                y2error("Exclude documentation option: boolean is required, got: %s", config->value(key)->asString()->value().c_str());
-                _last_error.setLastError(std::string("Invalid exclude documentation option: ") + config->value(key)->asString()->value());
+	ret = CommitHelper(commit_policy);
+    }
 
-		delete commit_policy;
-		commit_policy = NULL;
+    delete commit_policy;
+    commit_policy = NULL;
 
-                return YCPVoid();
-            }
-        }
+    if (stats)
+    {
+	commit_stats.stop();
 
-        key = YCPString("no_signature");
-        // set the medium number
-        if(!config->value(key).isNull())
-        {
-            if (config->value(key)->isBoolean())
-            {
-                bool no_signature = config->value(key)->asBoolean()->value();
-                commit_policy->rpmNoSignature(no_signature);
+	y2milestone("Commit stats: total: %lldms, download: %lldms, check: %lldms, rpm: %lldms, scripts: %lldms",
+	    commit_stats.total_time, commit_stats.download_time, commit_stats.check_time,
+	    commit_stats.rpm_time, commit_stats.script_time);
 
-                y2milestone("Don't check RPM signature: %s", config->value(key)->asString()->value().c_str());
-            }
-            else
-            {
-                y2error("No signature option: boolean is required, got: %s", config->value(key)->asString()->value().c_str());
-                _last_error.setLastError(std::string("Invalid no signature option: ") + config->value(key)->asString()->value());
+	if (!ret.isNull() && ret->isList())
+	{
+	    YCPList lst = ret->asList();
 
-		delete commit_policy;
-		commit_policy = NULL;
+	    // the aborted commit returns only the result code, keep the stats
+	    // at the documented position
+	    while (lst->size() < 5)
+		lst->add(YCPList());
 
-                return YCPVoid();
-            }
-        }
+	    lst->add(CommitStats2YCPMap(commit_stats, stats_slowest));
+	    ret = lst;
+	}
     }
 
-    YCPValue ret = CommitHelper(commit_policy);
-
-    delete commit_policy;
-    commit_policy = NULL;
-
     return ret;
 }
 
@@ -2490,15 +3984,7 @@ YCPValue PkgFunctions::AddRemoveUpgradeRepo(const YCPInteger &repo, bool add)
     }
 
     long long repo_id = repo->value();
-    YRepo_Ptr r = logFindRepository(repo_id);
-    if (!r)
-    {
-	y2error("Invalid repository ID %lld", repo_id);
-        _last_error.setLastError("Invalid repository ID " + repo->toString());
-	return YCPBoolean(false);
-    }
-
-    zypp::Repository repository(zypp::ResPool::instance().reposFind(r->repoInfo().alias()));
+    zypp::Repository repository(PoolRepository(repo_id));
 
     if (repository == zypp::Repository::noRepository)
     {
@@ -2529,6 +4015,7 @@ YCPValue PkgFunctions::AddRemoveUpgradeRepo(const YCPInteger &repo, bool add)
 */
 YCPValue PkgFunctions::AddUpgradeRepo(const YCPInteger &repo)
 {
+    solve_fingerprint_valid = false;
     return AddRemoveUpgradeRepo(repo, true);
 }
 
@@ -2540,6 +4027,7 @@ YCPValue PkgFunctions::AddUpgradeRepo(const YCPInteger &repo)
 */
 YCPValue PkgFunctions::RemoveUpgradeRepo(const YCPInteger &repo)
 {
+    solve_fingerprint_valid = false;
     return AddRemoveUpgradeRepo(repo, false);
 }
 
@@ -2553,23 +4041,78 @@ YCPValue PkgFunctions::GetUpgradeRepos()
 {
     YCPList ret;
 
-    unsigned long index = 0;
-    for_(it, repos.begin(), repos.end())
+    // only the loaded repositories can be used for upgrade, sorted by ID
+    for_(it, pool_repos.begin(), pool_repos.end())
+    {
+	if (zypp_ptr()->resolver()->upgradingRepo(it->second))
+	{
+	    ret->add(YCPInteger(it->first));
+	}
+    }
+
+    std::string result(ret->toString());
+    y2milestone("Current upgrade repos: %s", result.c_str());
+    return ret;
+}
+
+/**
+   @builtin SetUpgradeRepos
+
+   @short Set the upgrade repositories for distribution upgrade
+   @description
+   Replace the current upgrade repositories by the passed ones at once.
+   If any repository ID is not valid (or the repository is not loaded)
+   the upgrade repositories are not changed.
+   @param list<integer> repos the repository IDs
+   @return boolean true on success
+*/
+YCPValue PkgFunctions::SetUpgradeRepos(const YCPList &repo_ids)
+{
+    std::set<zypp::Repository> wanted;
+
+    for (int index = 0; index < repo_ids->size(); ++index)
+    {
+	YCPValue val(repo_ids->value(index));
+
+	if (val.isNull() || !val->isInteger())
+	{
+	    y2error("Invalid item at index %d in the repository list, integer expected", index);
+	    _last_error.setLastError("Invalid repository ID " + (val.isNull() ? std::string("nil") : val->toString()));
+	    return YCPBoolean(false);
+	}
+
+	zypp::Repository repository(PoolRepository(val->asInteger()->value()));
+
+	if (repository == zypp::Repository::noRepository)
+	{
+	    y2error("Invalid repository ID %lld", val->asInteger()->value());
+	    _last_error.setLastError("Invalid repository ID " + val->toString());
+	    return YCPBoolean(false);
+	}
+
+	wanted.insert(repository);
+    }
+
+    solve_fingerprint_valid = false;
+    zypp::Resolver_Ptr resolver(zypp_ptr()->resolver());
+
+    for_(it, pool_repos.begin(), pool_repos.end())
     {
-	if (!(*it)->isDeleted())
+	bool upgrade = wanted.find(it->second) != wanted.end();
+
+	if (upgrade && !resolver->upgradingRepo(it->second))
 	{
-	    zypp::Repository repository(zypp::ResPool::instance().reposFind((*it)->repoInfo().alias()));
-	    if (zypp_ptr()->resolver()->upgradingRepo(repository))
-	    {
-		ret->add(YCPInteger(index));
-	    }
+	    y2milestone("Adding upgrade repo %lld", it->first);
+	    resolver->addUpgradeRepo(it->second);
+	}
+	else if (!upgrade && resolver->upgradingRepo(it->second))
+	{
+	    y2milestone("Removing upgrade repo %lld", it->first);
+	    resolver->removeUpgradeRepo(it->second);
 	}
-	index++;
     }
 
-    std::string result(ret->toString());
-    y2milestone("Current upgrade repos: %s", result.c_str());
-    return ret;
+    return YCPBoolean(true);
 }
 
 /**
@@ -2654,16 +4197,7 @@ YCPString PkgFunctions::PkgGetLicenseToConfirm( const YCPString & package )
     {
 	try
 	{
-	    zypp::ui::Selectable::Ptr s = zypp::ui::Selectable::get(pkgname);
-
-	    if (s && s->toInstall() && !s->hasLicenceConfirmed())
-	    {
-		zypp::Package::constPtr package = zypp::asKind<zypp::Package>(s->candidateObj().resolvable());
-		if (package)
-		{
-		    return YCPString(package->licenseToConfirm());
-		}
-	    }
+	    return LicenseToConfirm(zypp::ui::Selectable::get(pkgname));
 	}
 	catch (...)
 	{
@@ -2673,6 +4207,48 @@ YCPString PkgFunctions::PkgGetLicenseToConfirm( const YCPString & package )
     return YCPString("");
 }
 
+YCPString PkgFunctions::LicenseToConfirm(const zypp::ui::Selectable::Ptr &s)
+{
+    static const YCPString no_license("");
+
+    if (!s || !s->toInstall() || s->hasLicenceConfirmed())
+	return no_license;
+
+    zypp::PoolItem candidate(s->candidateObj());
+    if (!candidate || !candidate.satSolvable().isKind<zypp::Package>())
+	return no_license;
+
+    unsigned serial = zypp_ptr()->pool().serial().serial();
+    std::string locale(zypp::ZConfig::instance().textLocale().code());
+
+    if (license_cache.pool_serial != serial || license_cache.locale != locale)
+    {
+	license_cache.packages.clear();
+	license_cache.texts.clear();
+	license_cache.pool_serial = serial;
+	license_cache.locale = locale;
+    }
+
+    // the candidate can be changed, the cache is per candidate
+    zypp::sat::Solvable::IdType id = candidate.satSolvable().id();
+    std::map<zypp::sat::Solvable::IdType, YCPString>::const_iterator cached = license_cache.packages.find(id);
+
+    if (cached != license_cache.packages.end())
+	return cached->second;
+
+    zypp::Package::constPtr package = zypp::asKind<zypp::Package>(candidate.resolvable());
+    std::string text(package->licenseToConfirm());
+
+    boost::unordered_map<std::string, YCPString>::const_iterator shared = license_cache.texts.find(text);
+
+    if (shared == license_cache.texts.end())
+	shared = license_cache.texts.insert(std::make_pair(text, text.empty() ? no_license : YCPString(text))).first;
+
+    license_cache.packages.insert(std::make_pair(id, shared->second));
+
+    return shared->second;
+}
+
 /**
    @builtin PkgGetLicensesToConfirm
 
@@ -2687,17 +4263,38 @@ YCPString PkgFunctions::PkgGetLicenseToConfirm( const YCPString & package )
 YCPMap PkgFunctions::PkgGetLicensesToConfirm( const YCPList & packages )
 {
     YCPMap ret;
+    long long start = PkgProfiler::now();
+    unsigned texts = license_cache.texts.size();
 
     for ( int i = 0; i < packages->size(); ++i ) {
-	YCPString license = PkgGetLicenseToConfirm(packages->value(i)->asString());
+	if (!packages->value(i)->isString())
+	    continue;
+
+	const std::string pkgname(packages->value(i)->asString()->value());
+
+	if (pkgname.empty())
+	    continue;
+
+	try
+	{
+	    // the same text is the same shared YCP string in the result
+	    YCPString license = LicenseToConfirm(zypp::ui::Selectable::get(pkgname));
 
-	// found a license to confirm?
-	if (!license->value().empty())
+	    // found a license to confirm?
+	    if (!license->value().empty())
+	    {
+		ret->add(packages->value(i), license);
+	    }
+	}
+	catch (...)
 	{
-	    ret->add(packages->value(i), license);
 	}
     }
 
+    y2milestone("Licenses to confirm: %d of %d packages, %zd distinct texts (%zd new, %lldms)",
+	ret->size(), packages->size(), license_cache.texts.size(),
+	license_cache.texts.size() - texts, (PkgProfiler::now() - start) / 1000);
+
     return ret;
 }
 
@@ -2751,6 +4348,119 @@ YCPBoolean PkgFunctions::RpmChecksig( const YCPString & filename )
     return YCPBoolean(false);
 }
 
+// the min. number of files checked by a worker process, a worker checks
+// the files one after another (see PkgWorkers), do not fork more workers
+// than needed for a short list
+static const unsigned checksig_files_per_job = 8;
+
+/*
+ * A helper function - worker job for the parallel signature check,
+ * it runs in a forked child process, see PkgWorkers.
+ * The workers share the keyring of the parent process (read only).
+ */
+static int ChecksigJob(zypp::target::rpm::RpmDb *rpmdb, const std::string &file)
+{
+    return rpmdb->checkPackage(file) == 0 ? PkgWorkers::JOB_DONE : PkgWorkers::JOB_FAILED;
+}
+
+static bool ChecksigFinished(std::vector<bool> *results, unsigned index, int status)
+{
+    (*results)[index] = (status == PkgWorkers::JOB_DONE);
+    // check all files
+    return true;
+}
+
+/****************************************************************************************
+ * @builtin RpmChecksigBatch
+ * @short Check signatures of several RPMs in parallel
+ * @description
+ * The same check as Pkg::RpmChecksig(), the files are checked in parallel
+ * worker processes, each worker checks a batch of files.
+ * @param list<string> files file names
+ * @param integer jobs max. number of parallel checks (0 = number of CPUs)
+ * @return map<string,boolean> file name => true if the file is a rpm package with valid signature,
+ * nil on error (e.g. the target is not initialized)
+ * @usage Pkg::RpmChecksigBatch(["/tmp/a.rpm", "/tmp/b.rpm"], 0) -> $["/tmp/a.rpm" : true, "/tmp/b.rpm" : false]
+ **/
+YCPValue PkgFunctions::RpmChecksigBatch( const YCPList & files, const YCPInteger & jobs )
+{
+    if (files.isNull() || jobs.isNull())
+    {
+	y2error("RpmChecksigBatch: nil argument!");
+	return YCPVoid();
+    }
+
+    std::vector<std::string> paths;
+
+    for (int i = 0; i < files->size(); ++i)
+    {
+	if (!files->value(i)->isString())
+	{
+	    y2error("RpmChecksigBatch: not a string at index %d: %s", i, files->value(i)->toString().c_str());
+	    return YCPVoid();
+	}
+
+	paths.push_back(files->value(i)->asString()->value());
+    }
+
+    zypp::target::rpm::RpmDb *rpmdb = NULL;
+
+    try
+    {
+	rpmdb = &zypp_ptr()->target()->rpmDb();
+    }
+    catch (const zypp::Exception &excpt)
+    {
+	y2error("The target is not initialized: %s", excpt.asString().c_str());
+	_last_error.setLastError(ExceptionAsString(excpt));
+	return YCPVoid();
+    }
+
+    long long start = PkgProfiler::now();
+    std::vector<bool> results(paths.size(), false);
+    unsigned max_jobs = jobs->value() > 0 ? jobs->value() : PkgWorkers::defaultJobs();
+    max_jobs = std::min<unsigned>(max_jobs, (paths.size() + checksig_files_per_job - 1) / checksig_files_per_job);
+
+    if (paths.size() < 2 || max_jobs <= 1)
+    {
+	for (std::vector<std::string>::size_type i = 0; i < paths.size(); ++i)
+	{
+	    try
+	    {
+		results[i] = (rpmdb->checkPackage(paths[i]) == 0);
+	    }
+	    catch (...)
+	    {
+	    }
+	}
+    }
+    else
+    {
+	PkgWorkers workers(max_jobs, boost::bind(&CallbackHandler::disconnectReceivers, &_callbackHandler));
+
+	for_(it, paths.begin(), paths.end())
+	    workers.add(boost::bind(ChecksigJob, rpmdb, *it));
+
+	workers.run(boost::bind(ChecksigFinished, &results, _1, _2));
+    }
+
+    YCPMap ret;
+    unsigned valid = 0;
+
+    for (std::vector<std::string>::size_type i = 0; i < paths.size(); ++i)
+    {
+	ret->add(YCPString(paths[i]), YCPBoolean(results[i]));
+
+	if (results[i])
+	    ++valid;
+    }
+
+    y2milestone("Checked %zd packages: %u valid (%u jobs, %lldms)", paths.size(), valid,
+	max_jobs, (PkgProfiler::now() - start) / 1000);
+
+    return ret;
+}
+
 
 YCPValue
 PkgFunctions::PkgDU(const YCPString& package)
@@ -2763,55 +4473,100 @@ PkgFunctions::PkgDU(const YCPString& package)
 	return YCPVoid();
     }
 
+    unsigned serial = zypp_ptr()->pool().serial().serial();
+
+    if (du_cache.pool_serial != serial)
+    {
+	du_cache.reset();
+	du_cache.pool_serial = serial;
+    }
+
+    // the package disk usage depends only on the partitions
+    zypp::sat::Solvable::IdType id = pkg->satSolvable().id();
+    std::map<zypp::sat::Solvable::IdType, YCPMap>::const_iterator cached = du_cache.packages.find(id);
+
+    if (cached != du_cache.packages.end())
+    {
+	return cached->second;
+    }
+
     // get partitioning
     zypp::DiskUsageCounter ducounter( zypp_ptr()->getPartitions() );
-    return MPS2YCPMap( ducounter.disk_usage( pkg ) );
+    YCPMap ret = MPS2YCPMap( ducounter.disk_usage( pkg ) );
+    du_cache.packages[id] = ret;
+
+    return ret;
 }
 
 
+void PkgFunctions::CheckBaseProductCache()
+{
+    unsigned serial = zypp_ptr()->pool().serial().serial();
+    std::string base;
+
+    if (base_product)
+    {
+	base = base_product->name + "-" + base_product->edition.asString() + "." + base_product->arch.asString();
+    }
+
+    if (base_product_cache.pool_serial != serial || base_product_cache.base != base)
+    {
+	base_product_cache.reset();
+	base_product_cache.pool_serial = serial;
+	base_product_cache.base = base;
+    }
+}
+
 zypp::Product::constPtr PkgFunctions::FindInstalledBaseProduct()
 {
-    // access to the Pool of Selectables
-    zypp::ResPoolProxy selectablePool(zypp::ResPool::instance().proxy());
+    CheckBaseProductCache();
 
-    // iterate over zypp::Products
-    for_(product_it, selectablePool.byKindBegin<zypp::Product>(),
-        selectablePool.byKindEnd<zypp::Product>())
+    if (!base_product_cache.installed_valid)
     {
-	// search an installed product
-	for_(installed_product_it, (*product_it)->installedBegin(),
-            (*product_it)->installedEnd())
-	{
-	    // get the resolvable
-	    zypp::ResObject::constPtr res = *installed_product_it;
+	base_product_cache.installed = zypp::sat::Solvable::noSolvable;
 
-	    // check if NVRA matches the base product
-            if (res && res->name() == base_product->name &&
-                res->edition() == base_product->edition &&
-                res->arch() == base_product->arch)
+	// only the products with the same name need to be checked
+	zypp::ui::Selectable::Ptr s = zypp::ui::Selectable::get(zypp::ResKind::product, base_product->name);
 
+	// search an installed product
+	if (s)
+	{
+	    for_(installed_product_it, s->installedBegin(), s->installedEnd())
 	    {
-		zypp::Product::constPtr product = res->asKind<zypp::Product>();
+		// get the resolvable
+		zypp::ResObject::constPtr res = *installed_product_it;
 
-		if (product)
+		// check if EVRA matches the base product
+		if (res && res->isKind<zypp::Product>() &&
+		    res->edition() == base_product->edition &&
+		    res->arch() == base_product->arch)
 		{
-                    y2milestone("Found installed base product: %s-%s-%s (%s)",
-                        product->name().c_str(),
-                        product->edition().asString().c_str(),
-                        product->arch().asString().c_str(),
-                        product->summary().c_str()
-                    );
-
-		    return product;
+		    base_product_cache.installed = res->satSolvable();
+		    break;
 		}
 	    }
 	}
+
+	base_product_cache.installed_valid = true;
     }
 
-    // matching installed product was not found
-    y2error("Cannot find the installed base product");
+    if (base_product_cache.installed == zypp::sat::Solvable::noSolvable)
+    {
+	// matching installed product was not found
+	y2error("Cannot find the installed base product");
+	return NULL;
+    }
 
-    return NULL;
+    zypp::Product::constPtr product = zypp::make<zypp::Product>(base_product_cache.installed);
+
+    y2milestone("Found installed base product: %s-%s-%s (%s)",
+	product->name().c_str(),
+	product->edition().asString().c_str(),
+	product->arch().asString().c_str(),
+	product->summary().c_str()
+    );
+
+    return product;
 }
 
 // helper function - create a symbolic link to the created base product (by SourceCreateBase() function)
@@ -2945,6 +4700,261 @@ YCPValue PkgFunctions::CreateSolverTestCase(const YCPString &dir)
     return YCPBoolean(success);
 }
 
+// the control file of the testcase, it is never compressed or removed
+static const char *testcase_control = "solver-test.xml";
+// the list of the files removed because of the size limit
+static const char *testcase_removed = "removed-files.txt";
+
+/*
+ * A helper function - compress the testcase files by zstd and keep
+ * the testcase within the size limit (0 = unlimited), the largest files
+ * (the repositories) are removed first. Returns false if the testcase
+ * is incomplete (see testcase_removed).
+ */
+static bool FinishSolverTestCase(const std::string &dir, bool compress, long long max_size)
+{
+    std::list<std::string> files;
+
+    if (zypp::filesystem::readdir(files, zypp::Pathname(dir), false) != 0)
+    {
+	y2error("Cannot read the testcase directory %s", dir.c_str());
+	return false;
+    }
+
+    // size => file name
+    std::multimap<long long, std::string> sizes;
+    long long total = 0;
+
+    for_(it, files.begin(), files.end())
+    {
+	zypp::Pathname path(zypp::Pathname(dir) / *it);
+
+	if (compress && *it != testcase_control && zypp::filesystem::PathInfo(path).isFile()
+	    && !zypp::str::hasSuffix(*it, ".zst"))
+	{
+	    const char* argv[] =
+	    {
+		"zstd",
+		// quiet, overwrite, remove the original file
+		"-q", "-f", "--rm",
+		"--",
+		path.c_str(),
+		NULL
+	    };
+
+	    zypp::ExternalProgram prog(argv, zypp::ExternalProgram::Discard_Stderr, false, -1, true);
+
+	    if (prog.close() == 0)
+	    {
+		path = path.extend(".zst");
+	    }
+	    else
+	    {
+		// e.g. zstd is not installed, keep the rest uncompressed
+		y2warning("Cannot compress %s, the testcase is not compressed", path.c_str());
+		compress = false;
+	    }
+	}
+
+	zypp::filesystem::PathInfo info(path);
+
+	if (info.isFile())
+	{
+	    total += info.size();
+
+	    if (path.basename() != testcase_control)
+		sizes.insert(std::make_pair(static_cast<long long>(info.size()), path.basename()));
+	}
+    }
+
+    if (max_size <= 0 || total <= max_size)
+    {
+	y2milestone("Testcase size: %lld bytes", total);
+	return true;
+    }
+
+    std::ofstream removed((zypp::Pathname(dir) / testcase_removed).c_str());
+
+    for (std::multimap<long long, std::string>::reverse_iterator it = sizes.rbegin();
+	it != sizes.rend() && total > max_size; ++it)
+    {
+	y2warning("Testcase size limit %lld exceeded, removing %s (%lld bytes)", max_size, it->second.c_str(), it->first);
+	zypp::filesystem::unlink(zypp::Pathname(dir) / it->second);
+	removed << it->second << ' ' << it->first << std::endl;
+	total -= it->first;
+    }
+
+    y2warning("Testcase size: %lld bytes, the testcase is incomplete", total);
+    return false;
+}
+
+/*
+ * A helper function - write the testcase in a forked child process
+ * (the child has a frozen copy of the pool and the solver), see BackgroundJobs.
+ */
+static int SolverTestCaseJob(zypp::Resolver_Ptr resolver, std::string dir, bool compress, long long max_size)
+{
+    if (!resolver->createSolverTestcase(dir))
+	return PkgWorkers::JOB_FAILED;
+
+    return FinishSolverTestCase(dir, compress, max_size) ? PkgWorkers::JOB_DONE : PkgWorkers::JOB_FAILED;
+}
+
+/**
+   @builtin CreateSolverTestCaseOptions
+   @short Create a solver testcase
+   @description
+   Like CreateSolverTestCase(), the options are:
+   <code>
+   $[
+     // compress the testcase files by zstd (except the solver-test.xml control file),
+     // the files are kept uncompressed if the zstd tool is not available
+     "compress" : boolean,
+     // size limit in bytes (after compression), the largest files are removed
+     // if the limit is exceeded (see removed-files.txt), 0 = unlimited (default),
+     // the incomplete testcase is reported as a failure
+     "max_size" : integer,
+     // write the testcase in a background process, the current state is used,
+     // the completion is reported by the CallbackSolverTestCaseDone() callback
+     // (evaluated after the next Pkg call), see also SolverTestCaseWait()
+     "async" : boolean
+   ]
+   </code>
+   @param string dir the target directory
+   @param map<string,any> options
+   @return boolean true on success (async: the testcase has been started), false
+   also when some files have been removed because of "max_size" (the written part
+   of the testcase is kept, see removed-files.txt and LastError())
+*/
+YCPValue PkgFunctions::CreateSolverTestCaseOptions(const YCPString &dir, const YCPMap &options)
+{
+    if (dir.isNull() || options.isNull())
+    {
+	y2error("Pkg::CreateSolverTestCaseOptions(): nil parameter!");
+	return YCPBoolean(false);
+    }
+
+    YcpMapLoad opts("Pkg::CreateSolverTestCaseOptions");
+    bool &compress(opts.arg<YT_BOOLEAN, bool>("compress", false));
+    bool &async(opts.arg<YT_BOOLEAN, bool>("async", false));
+    long long &max_size(opts.arg<YT_INTEGER, long long>("max_size", 0LL));
+
+    if (!opts.load(options))
+    {
+	_last_error.setLastError(std::string("Invalid testcase option ") + opts.error());
+	return YCPBoolean(false);
+    }
+
+    std::string testcase_dir(dir->value());
+    y2milestone("Creating a solver test case in directory %s (compress: %d, max_size: %lld, async: %d)",
+	testcase_dir.c_str(), compress, max_size, async);
+
+    try
+    {
+	if (async)
+	{
+	    // the same directory is written again, stop the previous testcase
+	    for_(it, testcase_dirs.begin(), testcase_dirs.end())
+	    {
+		if (it->second == testcase_dir)
+		{
+		    testcase_jobs.remove(it->first);
+		    testcase_dirs.erase(it);
+		    break;
+		}
+	    }
+
+	    long long id = ++last_testcase;
+	    testcase_jobs.start(id, boost::bind(SolverTestCaseJob, zypp_ptr()->resolver(), testcase_dir, compress, max_size),
+		boost::bind(&CallbackHandler::disconnectReceivers, &_callbackHandler));
+	    testcase_dirs[id] = testcase_dir;
+
+	    return YCPBoolean(true);
+	}
+
+	bool success = zypp_ptr()->resolver()->createSolverTestcase(testcase_dir);
+
+	if (success && !FinishSolverTestCase(testcase_dir, compress, max_size))
+	{
+	    _last_error.setLastError("The testcase exceeds the size limit, it is incomplete (see "
+		+ (zypp::Pathname(testcase_dir) / testcase_removed).asString() + ")");
+	    success = false;
+	}
+
+	y2milestone("Testcase saved: %s", success ? "true" : "false");
+
+	return YCPBoolean(success);
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	y2error("Cannot create the testcase: %s", excpt.asString().c_str());
+	_last_error.setLastError(ExceptionAsString(excpt));
+    }
+
+    return YCPBoolean(false);
+}
+
+bool PkgFunctions::CollectSolverTestCases(long long timeout)
+{
+    std::set<long long> ids;
+    for_(it, testcase_dirs.begin(), testcase_dirs.end())
+    {
+	ids.insert(it->first);
+    }
+
+    bool ret = testcase_jobs.wait(ids, timeout);
+
+    for_(it, ids.begin(), ids.end())
+    {
+	int status = testcase_jobs.status(*it);
+
+	// still running
+	if (status == -1)
+	    continue;
+
+	// remove it before evaluating the callback, it might call Pkg builtins
+	std::string testcase_dir(testcase_dirs[*it]);
+	testcase_jobs.remove(*it);
+	testcase_dirs.erase(*it);
+
+	bool success = status == PkgWorkers::JOB_DONE;
+	y2milestone("Testcase %s saved: %s", testcase_dir.c_str(), success ? "true" : "false");
+
+	Y2Function* ycp_handler = _callbackHandler._ycpCallbacks.createCallback(CallbackHandler::YCPCallbacks::CB_SolverTestCaseDone);
+	CallbackHandler::YCPCallbacks::Release ycp_handler_release(_callbackHandler._ycpCallbacks, CallbackHandler::YCPCallbacks::CB_SolverTestCaseDone, ycp_handler);
+
+	// is the callback registered?
+	if (ycp_handler != NULL)
+	{
+	    ycp_handler->appendParameter(YCPString(testcase_dir));
+	    ycp_handler->appendParameter(YCPBoolean(success));
+	    ycp_handler->evaluateCall();
+	}
+    }
+
+    return ret;
+}
+
+/**
+   @builtin SolverTestCaseWait
+   @short Wait for the testcases written in background
+   @description
+   Wait for the testcases started by CreateSolverTestCaseOptions() with the "async" option,
+   the CallbackSolverTestCaseDone() callback is evaluated for the finished ones.
+   @param integer timeout in milliseconds (0 = do not wait, negative = no limit)
+   @return boolean true if all testcases have been finished, false on timeout
+*/
+YCPValue PkgFunctions::SolverTestCaseWait(const YCPInteger &timeout)
+{
+    if (timeout.isNull())
+    {
+	y2error("Pkg::SolverTestCaseWait(): nil parameter!");
+	return YCPBoolean(false);
+    }
+
+    return YCPBoolean(CollectSolverTestCases(timeout->value()));
+}
+
 /**
  * Get a package object from a given repository
  *
@@ -29,6 +29,8 @@
 #include "log.h"
 
 #include "Callbacks.h"
+#include "Callbacks.YCP.h"
+#include "PkgWorkers.h"
 
 #include <ycp/YCPInteger.h>
 #include <ycp/YCPString.h>
@@ -39,10 +41,29 @@
 #include <ycp/YCPList.h>
 
 #include <zypp/ZYppFactory.h>
+#include <zypp/PathInfo.h>
+#include <zypp/sat/Pool.h>
+
+// the pool internals for MemoryStats()
+extern "C"
+{
+#include <solv/repo.h>
+#include <solv/repodata.h>
+}
+
+#include <fstream>
+#include <list>
+
+// mallinfo
+#include <malloc.h>
 
 // sleep
 #include <unistd.h>
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 // textdomain
 #include <libintl.h>
 /*
@@ -63,10 +84,28 @@ PkgFunctions::PkgFunctions () :
     , zypp_pointer(NULL)
     , repo_manager(NULL)
     , autorefresh_skipped(false)
+    , refresh_jobs(1)
+    , build_jobs(1)
+    , lazy_load(false)
+    , solver_cache(false)
+    , solve_fingerprint_valid(false)
+    , solve_fingerprint(0)
+    , pool_generation(0LL)
+    , pool_changes(0)
+    , pool_changes_depth(0)
+    , pool_changes_notifying(false)
+    , pool_changes_serial(0)
+    , lazy_pending(false)
     , current_repo(-1LL)
+    , network_running(false)
+    , network_checked(-1LL)
+    , network_netlink_fd(-2)
     , commit_policy(NULL)
     ,_callbackHandler( *new CallbackHandler(*this) )
     , base_product(NULL)
+    , testcase_jobs(1)
+    , last_testcase(0LL)
+    , last_cursor(0LL)
 {
     const char *domain = "pkg-bindings";
     bindtextdomain( domain, LOCALEDIR );
@@ -138,6 +177,13 @@ zypp::ZYpp::Ptr PkgFunctions::zypp_ptr()
  */
 PkgFunctions::~PkgFunctions ()
 {
+    // do not kill a testcase being written
+    if (!testcase_dirs.empty())
+    {
+	y2milestone("Waiting for %zd solver testcases...", testcase_dirs.size());
+	testcase_jobs.wait(std::set<long long>(), -1);
+    }
+
     delete &_callbackHandler;
 
     if (base_product)
@@ -146,6 +192,12 @@ PkgFunctions::~PkgFunctions ()
 	base_product = NULL;
     }
 
+    if (network_netlink_fd >= 0)
+    {
+	::close(network_netlink_fd);
+	network_netlink_fd = -1;
+    }
+
     if (repo_manager)
     {
       y2milestone("Releasing the repo manager...");
@@ -216,18 +268,269 @@ PkgFunctions::LastErrorDetails ()
     return YCPString (_last_error.lastErrorDetails());
 }
 
+/**
+ * @builtin ProfilingStart
+ *
+ * @short Start collecting the Pkg builtin call statistics
+ * @description
+ * The profiler can be also started at load time by setting
+ * the Y2PKG_PROFILE environment variable.
+ * @param boolean reset true = clear the previous statistics
+ * @return boolean true
+ */
+YCPValue
+PkgFunctions::ProfilingStart (const YCPBoolean &reset)
+{
+    bool clear = !reset.isNull() && reset->value();
+    y2milestone("Starting the builtin profiler (reset: %s)", clear ? "true" : "false");
+
+    _profiler.start(clear);
+    return YCPBoolean(true);
+}
+
+/**
+ * @builtin ProfilingStop
+ *
+ * @short Stop collecting the Pkg builtin call statistics
+ * @description
+ * The collected statistics are written to the log.
+ * @return boolean true
+ */
+YCPValue
+PkgFunctions::ProfilingStop ()
+{
+    _profiler.stop();
+    _profiler.log();
+    return YCPBoolean(true);
+}
+
+/**
+ * @builtin ProfilingReport
+ *
+ * @short Get the Pkg builtin call statistics
+ * @description
+ * The statistics are also written to the log.
+ * @return map $[ "builtin_name" : $[ "calls" : integer, "total_time" : integer,
+ *   "max_time" : integer (in microseconds), "result_bytes" : integer
+ *   (size of the results in the YCP string representation) ] ]
+ */
+YCPValue
+PkgFunctions::ProfilingReport ()
+{
+    YCPMap ret;
+    const PkgProfiler::Entries &entries = _profiler.entries();
+
+    for (PkgProfiler::Entries::const_iterator it = entries.begin(); it != entries.end(); ++it)
+    {
+	YCPMap entry;
+	entry->add(YCPString("calls"), YCPInteger(it->second.calls));
+	entry->add(YCPString("total_time"), YCPInteger(it->second.total_time));
+	entry->add(YCPString("max_time"), YCPInteger(it->second.max_time));
+	entry->add(YCPString("result_bytes"), YCPInteger(it->second.result_bytes));
+
+	ret->add(YCPString(it->second.name), entry);
+    }
+
+    _profiler.log();
+    return ret;
+}
+
+/**
+ * @builtin ProfilingSave
+ *
+ * @short Save the Pkg builtin call statistics to a file
+ * @description
+ * The file contains tab separated values (builtin name, number of calls,
+ * total time, max. time (in microseconds), size of the results in bytes),
+ * the first line is a header. The format is intended for collecting
+ * the results of automated benchmarks, the same file is written at exit
+ * when the Y2PKG_PROFILE environment variable contains an absolute path.
+ * @param string path target file
+ * @return boolean true on success
+ */
+YCPValue
+PkgFunctions::ProfilingSave (const YCPString &path)
+{
+    if (path.isNull() || path->value().empty())
+    {
+	y2error("Missing the target file");
+	return YCPBoolean(false);
+    }
+
+    return YCPBoolean(_profiler.save(path->value()));
+}
+
+// see SaveState()
+extern bool state_saved;
+
+long long PkgFunctions::DirSize(const zypp::Pathname &dir, long long &files)
+{
+    long long ret = 0;
+    std::list<zypp::filesystem::DirEntry> entries;
+
+    if (zypp::filesystem::readdir(entries, dir, false) != 0)
+	return 0;
+
+    for_(it, entries.begin(), entries.end())
+    {
+	zypp::PathInfo info(dir / it->name, zypp::PathInfo::LSTAT);
+
+	if (info.isDir())
+	{
+	    ret += DirSize(dir / it->name, files);
+	}
+	else
+	{
+	    ret += info.size();
+	    ++files;
+	}
+    }
+
+    return ret;
+}
+
+/**
+ * @builtin MemoryStats
+ *
+ * @short Get the memory usage statistics
+ * @description
+ * The sizes of the libzypp pool and of the state kept by the bindings,
+ * intended for finding leaks in long running sessions. The values are
+ * also written to the log.
+ * @return map $[ "pool" : $[ "solvables" : integer, "capacity" : integer,
+ *   "strings" : integer, "string_bytes" : integer, "repos" : list<map> ],
+ *   "bindings" : $[ "repos" : integer, "deleted_repos" : integer, "repo_refs" : integer,
+ *   "services" : integer, "callbacks" : integer, "tmp_dirs" : integer,
+ *   "saved_state" : boolean, "cursors" : integer ],
+ *   "download_area" : $[ "path" : string, "files" : integer, "bytes" : integer ],
+ *   "malloc" : $[ "arena" : integer, "mmap" : integer, "used" : integer, "free" : integer ],
+ *   "rss" : integer ]
+ *   (the pool "repos" maps contain "alias", "solvables", "repodata"
+ *   and "bytes" (the in-core repository data), the sizes are in bytes)
+ */
+YCPValue
+PkgFunctions::MemoryStats ()
+{
+    YCPMap ret;
+
+    // the libsolv pool
+    YCPMap pool;
+    zypp::sat::Pool sat_pool(zypp::sat::Pool::instance());
+    zypp::sat::detail::CPool *cpool = sat_pool.get();
+
+    pool->add(YCPString("solvables"), YCPInteger(sat_pool.solvablesSize()));
+    pool->add(YCPString("capacity"), YCPInteger(sat_pool.capacity()));
+    pool->add(YCPString("strings"), YCPInteger(cpool->ss.nstrings));
+    pool->add(YCPString("string_bytes"), YCPInteger(cpool->ss.sstrings));
+
+    YCPList pool_repos;
+    for_(it, sat_pool.reposBegin(), sat_pool.reposEnd())
+    {
+	zypp::sat::detail::CRepo *crepo = it->get();
+	long long bytes = crepo->idarraysize * sizeof(zypp::sat::detail::IdType);
+
+	int rdid;
+	::Repodata *data;
+	FOR_REPODATAS(crepo, rdid, data)
+	{
+	    bytes += data->incoredatalen;
+	}
+
+	YCPMap repo;
+	repo->add(YCPString("alias"), YCPString(it->alias()));
+	repo->add(YCPString("solvables"), YCPInteger(it->solvablesSize()));
+	repo->add(YCPString("repodata"), YCPInteger(crepo->nrepodata));
+	repo->add(YCPString("bytes"), YCPInteger(bytes));
+	pool_repos->add(repo);
+    }
+    pool->add(YCPString("repos"), pool_repos);
+    ret->add(YCPString("pool"), pool);
+
+    // the bindings state
+    YCPMap bindings;
+    long long deleted = 0;
+    long long refs = 0;
+    for_(it, repos.begin(), repos.end())
+    {
+	if ((*it)->isDeleted())
+	    ++deleted;
+
+	// without the reference in 'repos'
+	refs += (*it)->refCount() - 1;
+    }
+
+    bindings->add(YCPString("repos"), YCPInteger(repos.size()));
+    bindings->add(YCPString("deleted_repos"), YCPInteger(deleted));
+    bindings->add(YCPString("repo_refs"), YCPInteger(refs));
+    bindings->add(YCPString("services"), YCPInteger(service_manager.size()));
+    bindings->add(YCPString("callbacks"), YCPInteger(_callbackHandler._ycpCallbacks.size()));
+    bindings->add(YCPString("tmp_dirs"), YCPInteger(tmp_dirs.size()));
+    bindings->add(YCPString("saved_state"), YCPBoolean(state_saved));
+    bindings->add(YCPString("cursors"), YCPInteger(resolvable_cursors.size()));
+    ret->add(YCPString("bindings"), bindings);
+
+    // the temporary files retained in the download area
+    YCPMap area;
+    zypp::Pathname area_path(download_area_path());
+    long long files = 0;
+    long long bytes = DirSize(area_path, files);
+    area->add(YCPString("path"), YCPString(area_path.asString()));
+    area->add(YCPString("files"), YCPInteger(files));
+    area->add(YCPString("bytes"), YCPInteger(bytes));
+    ret->add(YCPString("download_area"), area);
+
+    // the allocator
+    YCPMap alloc;
+#ifdef HAVE_MALLINFO2
+    struct mallinfo2 mi = ::mallinfo2();
+#else
+    struct mallinfo mi = ::mallinfo();
+#endif
+    alloc->add(YCPString("arena"), YCPInteger((long long)mi.arena));
+    alloc->add(YCPString("mmap"), YCPInteger((long long)mi.hblkhd));
+    alloc->add(YCPString("used"), YCPInteger((long long)mi.uordblks));
+    alloc->add(YCPString("free"), YCPInteger((long long)mi.fordblks));
+    ret->add(YCPString("malloc"), alloc);
+
+    // resident set size of the whole process (the second /proc/self/statm value in pages)
+    long long size = 0, resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    if (statm >> size >> resident)
+    {
+	ret->add(YCPString("rss"), YCPInteger(resident * ::sysconf(_SC_PAGESIZE)));
+    }
+
+    y2milestone("Memory stats: %s", ret->toString().c_str());
+
+    return ret;
+}
+
+// returns the shared repository manager, the known repositories and services
+// are read only once, a new manager is created only when the target changes
+// (see RepoManagerUpdateTarget())
 zypp::RepoManager* PkgFunctions::CreateRepoManager()
 {
     if (repo_manager) return repo_manager;
 
-    // set path option, use root dir as a prefix for the default directory
-    zypp::RepoManagerOptions repo_options(_target_root);
+    zypp::RepoManagerOptions repo_options(TargetRepoManagerOptions());
     y2milestone("Path to repository files: %s", repo_options.knownReposPath.asString().c_str());
 
     repo_manager = new zypp::RepoManager(repo_options);
     return repo_manager;
 }
 
+// the repository manager options for the current target
+zypp::RepoManagerOptions PkgFunctions::TargetRepoManagerOptions() const
+{
+    // set path option, use root dir as a prefix for the default directory
+    zypp::RepoManagerOptions repo_options(_target_root);
+
+    if (!services_target_distro.empty())
+        repo_options.servicesTargetDistro = services_target_distro;
+
+    return repo_options;
+}
+
 // convert Exception object to string represenatation
 std::string PkgFunctions::ExceptionAsString(const zypp::Exception &e)
 {
@@ -359,6 +662,13 @@ YCPValue PkgFunctions::ZConfig()
 
     ret->add(YCPString("distro_version_pkg"), YCPString(zconfig.distroverpkg()));
 
+    // pkg-bindings specific options
+    ret->add(YCPString("refresh_jobs"), YCPInteger(refresh_jobs));
+    ret->add(YCPString("build_jobs"), YCPInteger(build_jobs));
+    ret->add(YCPString("lazy_load"), YCPBoolean(lazy_load));
+    ret->add(YCPString("solver_cache"), YCPBoolean(solver_cache));
+    ret->add(YCPString("prefetch_manifest"), YCPString(download_prefetch.manifest().asString()));
+
     return ret;
 }
 
@@ -368,7 +678,27 @@ YCPValue PkgFunctions::ZConfig()
  * This is a set counterpart to Pkg::ZConfig(). Note that the set of options which can be changed is very limited.
  * Currently supported values: $[ "download_media_prefer_download" : boolean,
  * "update_messages_notify" : string,
- * "solver_upgrade_remove_dropped_packages" : boolean ]
+ * "solver_upgrade_remove_dropped_packages" : boolean,
+ * "refresh_jobs" : integer, "build_jobs" : integer,
+ * "lazy_load" : boolean, "solver_cache" : boolean, "prefetch_manifest" : string ]
+ * "refresh_jobs" is the max. number of repositories refreshed in parallel
+ * in SourceLoad (1 = sequential refresh, 0 = number of CPUs), the workers
+ * also rebuild the cache and the resolvables are loaded as soon as
+ * the repository is ready (pipelined load)
+ * "build_jobs" is the max. number of solv caches built in parallel in SourceLoad
+ * (1 = sequential build, the default, 0 = number of CPUs)
+ * "lazy_load" - SourceStartManager(true) only restores the repositories,
+ * the resolvables are refreshed and loaded when a builtin which needs them
+ * is called for the first time (e.g. Pkg::ResolvableProperties(), Pkg::PkgSolve()),
+ * the target-only clients do not need to load the repositories at all (default false)
+ * "solver_cache" - Pkg::PkgSolve() does not run the solver again if the resolvable
+ * states, the locks, the solver flags, the requested locales and the repositories
+ * have not been changed since the last successful run (default false)
+ * "prefetch_manifest" - the files provided by Pkg::SourceProvide*() are recorded
+ * in this file, the recorded files are downloaded in the background when
+ * a remote repository is added (Pkg::SourceCreate(), Pkg::RepositoryAdd())
+ * and the later Pkg::SourceProvide*() calls use the downloaded files
+ * (default "" = disabled)
  * @return boolean true on success
  */
 YCPValue PkgFunctions::SetZConfig(const YCPMap &cfg)
@@ -426,6 +756,90 @@ YCPValue PkgFunctions::SetZConfig(const YCPMap &cfg)
 	}
     }
 
+    key = "refresh_jobs";
+    if(!cfg->value(YCPString(key)).isNull())
+    {
+	const YCPValue val = cfg->value(YCPString(key));
+	if (val->isInteger() && val->asInteger()->value() >= 0)
+	{
+	    long long jobs = val->asInteger()->value();
+	    refresh_jobs = (jobs == 0) ? PkgWorkers::defaultJobs() : jobs;
+	    y2milestone("new refresh_jobs value: %u", refresh_jobs);
+	}
+	else
+	{
+	    y2error("Expected non-negative integer value for '%s' key, found %s", key, val->toString().c_str());
+	    return YCPBoolean(false);
+	}
+    }
+
+    key = "build_jobs";
+    if(!cfg->value(YCPString(key)).isNull())
+    {
+	const YCPValue val = cfg->value(YCPString(key));
+	if (val->isInteger() && val->asInteger()->value() >= 0)
+	{
+	    long long jobs = val->asInteger()->value();
+	    build_jobs = (jobs == 0) ? PkgWorkers::defaultJobs() : jobs;
+	    y2milestone("new build_jobs value: %u", build_jobs);
+	}
+	else
+	{
+	    y2error("Expected non-negative integer value for '%s' key, found %s", key, val->toString().c_str());
+	    return YCPBoolean(false);
+	}
+    }
+
+    key = "solver_cache";
+    if(!cfg->value(YCPString(key)).isNull())
+    {
+	const YCPValue val = cfg->value(YCPString(key));
+	if (val->isBoolean())
+	{
+	    solver_cache = val->asBoolean()->value();
+	    solve_fingerprint_valid = false;
+	    y2milestone("new solver_cache value: %s", solver_cache ? "true" : "false");
+	}
+	else
+	{
+	    y2error("Expected boolean value for '%s' key, found %s", key, val->toString().c_str());
+	    return YCPBoolean(false);
+	}
+    }
+
+    key = "lazy_load";
+    if(!cfg->value(YCPString(key)).isNull())
+    {
+	const YCPValue val = cfg->value(YCPString(key));
+	if (val->isBoolean())
+	{
+	    lazy_load = val->asBoolean()->value();
+	    y2milestone("new lazy_load value: %s", lazy_load ? "true" : "false");
+	}
+	else
+	{
+	    y2error("Expected boolean value for '%s' key, found %s", key, val->toString().c_str());
+	    return YCPBoolean(false);
+	}
+    }
+
+    key = "prefetch_manifest";
+    if(!cfg->value(YCPString(key)).isNull())
+    {
+	const YCPValue val = cfg->value(YCPString(key));
+	if (val->isString())
+	{
+	    const std::string manifest(val->asString()->value());
+	    y2milestone("new prefetch_manifest value: %s", manifest.c_str());
+	    download_prefetch.setManifest(manifest);
+	}
+	else
+	{
+	    y2error("Expected string value for '%s' key, found %s", key, val->toString().c_str());
+	    return YCPBoolean(false);
+	}
+    }
+
     return YCPBoolean(true);
 }
 
@@ -440,13 +854,15 @@ bool PkgFunctions::RepoManagerUpdateTarget(const std::string& root, const YCPMap
         y2milestone("Updating RepoManager (target changed from %s to %s)", _target_root.c_str(), root.c_str());
 
         zypp::RepoManagerOptions repo_manager_options(root);
+        services_target_distro.clear();
 
         y2debug("repomanager options size: %zd", options.size());
         if(!options->value(YCPString("target_distro")).isNull() && options->value(YCPString("target_distro"))->isString())
         {
             // override the target distribution autodetection
             y2milestone("Using target_distro: %s", options->value(YCPString("target_distro"))->asString()->value().c_str());
-            repo_manager_options.servicesTargetDistro = options->value(YCPString("target_distro"))->asString()->value();
+            services_target_distro = options->value(YCPString("target_distro"))->asString()->value();
+            repo_manager_options.servicesTargetDistro = services_target_distro;
         }
 
         // repository manager options cannot be replaced, a new repository manager is needed
@@ -474,6 +890,15 @@ bool PkgFunctions::RepoManagerUpdateTarget(const std::string& root, const YCPMap
     // update package cache path for loaded repositories when changing the target
     if (new_target)
     {
+        // the repositories and services have not been written to the new target yet,
+        // SourceSaveAll() must not skip them as unchanged
+        for_(it, repos.begin(), repos.end())
+        {
+            (*it)->resetSaved();
+        }
+
+        service_manager.ResetSaved();
+
         zypp::RepoManagerOptions repo_options(root);
         zypp::Pathname packages_prefix = repo_options.repoPackagesCachePath;
 
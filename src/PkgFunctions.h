@@ -30,8 +30,15 @@
 
 #include <string>
 #include <vector>
+#include <set>
+#include <map>
+#include <list>
+#include <algorithm>
+
+#include <boost/unordered_map.hpp>
 
 #include <ycp/YCPMap.h>
+#include <ycp/YCPList.h>
 
 class YCPBoolean;
 class YCPValue;
@@ -51,6 +58,9 @@ class YCPReference;
 #include <zypp/ProgressData.h>
 #include <zypp/TmpPath.h>
 #include <zypp/ZYppCommitPolicy.h>
+#include <zypp/PoolQuery.h>
+#include <zypp/ui/Selectable.h>
+#include <zypp/PublicKey.h>
 
 #include <YRepo.h>
 #include <i18n.h>
@@ -59,6 +69,9 @@ class YCPReference;
 #include "BaseProduct.h"
 
 #include "PkgError.h"
+#include "PkgProfiler.h"
+#include "DownloadPrefetch.h"
+#include "BackgroundJobs.h"
 class PkgProgress;
 
 namespace zypp
@@ -89,6 +102,8 @@ class PkgFunctions
         // use a single RepoManager instance to avoid "unused" metadata cleanup
         // see https://bugzilla.novell.com/show_bug.cgi?id=802665#c27
         zypp::RepoManager* repo_manager;
+        // the target distribution for the services (empty = autodetect)
+        std::string services_target_distro;
 
 	// remember the main locale (set by SetLocale) for SetAdditionalLocales,
 	// add the main locale to the additional ones
@@ -112,17 +127,72 @@ class PkgFunctions
 
         RepoId current_repo_id() const { return current_repo; }
 
+	// the builtin call statistics
+	PkgProfiler & profiler() { return _profiler; }
+
+	// load the resolvables skipped by the lazy SourceStartManager()
+	// if the builtin needs them, returns false if the load has failed
+	// (see LastError())
+	bool LazyLoad(const std::string &builtin) { return !lazy_pending || LazyLoadRepos(builtin); }
+	// the builtins which do not trigger the lazy load
+	static const std::set<std::string> &LazySafeBuiltins();
+
+	// a builtin call starts/finishes, the nested calls (from the callbacks)
+	// belong to the outermost one, see CallbackPoolChanged()
+	void PoolChangesEnter() { ++pool_changes_depth; }
+	void PoolChangesLeave(const std::string &builtin, const YCPValue &ret);
+
+	// report the testcases finished in background (from the outermost call)
+	void CheckSolverTestCases() { if (!testcase_dirs.empty() && pool_changes_depth == 0) CollectSolverTestCases(0); }
+
+	// the keyring has been changed, see GPGKeys()
+	void InvalidateGPGKeys() { known_gpg_keys.valid = trusted_gpg_keys.valid = false; }
+
     private: // source related
 
       // all known installation sources
       RepoCont repos;
 
+      // alias => ID index of the repositories in 'repos', see logFindAlias(),
+      // all insertions must use AddRepo(), the deleted repositories are
+      // detected (and the index rebuilt) at lookup
+      typedef boost::unordered_map<std::string, RepoId> AliasIndex;
+      mutable AliasIndex alias_index;
+
+      // add a repository to 'repos', returns the new ID
+      RepoId AddRepo(const YRepo_Ptr &repo);
+      // remove all repositories
+      void ClearRepos();
+      void RebuildAliasIndex() const;
+
+      // ID <=> pool repository index of the loaded repositories,
+      // maintained by LoadResolvablesFrom() and RemoveResolvablesFrom()
+      std::map<RepoId, zypp::Repository> pool_repos;
+      std::map<zypp::Repository, RepoId> pool_repo_ids;
+      void AddPoolRepo(RepoId id, const zypp::Repository &repository);
+      void RemovePoolRepo(const zypp::Repository &repository);
+
       // table for converting libzypp source type to Yast type (for backward compatibility)
       std::map<std::string, std::string> type_conversion_table;
 
       // flag for skipping autorefresh
       volatile bool autorefresh_skipped;
 
+      // max. number of parallel workers for refreshing the repositories
+      // (1 = sequential refresh)
+      unsigned refresh_jobs;
+
+      // max. number of parallel workers for building the solv caches
+      // (1 = sequential build)
+      unsigned build_jobs;
+
+      // SourceStartManager(true) only restores the repositories,
+      // the resolvables are loaded by the first builtin which needs them
+      bool lazy_load;
+      // the resolvables have not been loaded yet
+      bool lazy_pending;
+      bool LazyLoadRepos(const std::string &builtin);
+
       // flag
       RepoId current_repo;
 
@@ -131,6 +201,10 @@ class PkgFunctions
 
       YCPValue SourceRefreshHelper(const YCPInteger &id, bool forced = false);
       YCPValue ServiceRefreshHelper(const YCPString &alias, bool forced = false);
+      // update the loaded repositories after refreshing the services
+      void SyncServiceRepos(zypp::RepoManager &repomgr, const std::set<std::string> &services);
+      // the repository manager options for the current target
+      zypp::RepoManagerOptions TargetRepoManagerOptions() const;
 
       // helper for updating repository manager after changing the target root
       // return true if the target root has been changed
@@ -145,6 +219,13 @@ class PkgFunctions
       // helper - is the network running?
       bool NetworkDetected();
 
+      // cached network status (see NetworkDetected())
+      bool network_running;
+      // monotonic time of the last check in ms (-1 = not checked yet)
+      long long network_checked;
+      // netlink socket (-1 = not available, -2 = not opened yet)
+      int network_netlink_fd;
+
       // is the URL remote?
       bool remoteRepo(const zypp::Url &url);
 
@@ -164,9 +245,40 @@ class PkgFunctions
       YCPValue GetPkgLocation(const YCPString& p, bool full_path);
       YCPValue PkgProp(const zypp::PoolItem &item);
       YCPValue PkgMediaSizesOrCount (bool sizes, bool download_size = false);
+
+      // the aggregated sizes and counts of the packages to install, see PkgMediaSizesOrCount()
+      struct MediaSizes
+      {
+	  MediaSizes() : valid(false), pool_serial(0) {}
+
+	  bool valid;
+	  // the pool serial number and the enabled repositories the values are valid for
+	  unsigned pool_serial;
+	  std::vector<RepoId> repos;
+	  // the packages to install the values have been computed for (sorted solvable IDs)
+	  std::vector<zypp::sat::Solvable::IdType> selected;
+	  // repository => per medium values
+	  std::map<RepoId, std::vector<long long> > inst_size;
+	  std::map<RepoId, std::vector<long long> > download_size;
+	  std::map<RepoId, std::vector<long long> > count;
+      };
+      MediaSizes media_sizes;
+      void UpdateMediaSizes();
       YCPValue TargetInitInternal(const YCPString& root, bool rebuild_rpmdb);
 
-      bool aliasExists(const std::string &alias, const std::list<zypp::RepoInfo> &reps) const;
+      // the applied locks file and the pool serial, empty = apply again,
+      // see ApplyTargetLocks()
+      std::string target_locks_stamp;
+      static std::string FileStamp(const zypp::Pathname &file);
+      void ApplyTargetLocks();
+
+      // the parsed pool snapshot, see PoolSnapshotLoad()
+      struct PoolSnapshot;
+      bool PoolSnapshotApply(const PoolSnapshot &snapshot);
+      void PoolSnapshotRollback(const zypp::Pathname &root, bool target_loaded, bool services_loaded,
+	  const zypp::LocaleSet &locales);
+
+      bool aliasExists(const std::string &alias);
 
       // remember the base product attributes for finding it later in
       // the installed system
@@ -176,6 +288,271 @@ class PkgFunctions
 
       void SetCurrentDU();
 
+      // the cached disk usage results, see TargetGetDU() and PkgDU()
+      struct DiskUsageCache
+      {
+	  DiskUsageCache() : valid(false), pool_serial(0) {}
+
+	  bool valid;
+	  // the pool serial number the values are valid for
+	  unsigned pool_serial;
+	  // the transacting solvables (sorted IDs) the values have been computed for
+	  std::vector<zypp::sat::Solvable::IdType> transacting;
+	  zypp::DiskUsageCounter::MountPointSet mps;
+	  YCPMap result;
+	  // PkgDU() results (solvable ID => result)
+	  std::map<zypp::sat::Solvable::IdType, YCPMap> packages;
+
+	  // the partitions or the pool have been changed
+	  void reset() { valid = false; transacting.clear(); mps.clear(); packages.clear(); }
+      };
+      DiskUsageCache du_cache;
+
+      // the license texts of the candidate packages, many packages use
+      // the same EULA, each distinct text is stored (and returned) only once
+      struct LicenseCache
+      {
+	  LicenseCache() : pool_serial(0) {}
+
+	  // the pool serial number and the text locale the texts have been read for
+	  unsigned pool_serial;
+	  std::string locale;
+	  // candidate solvable ID => license text (shared, "" = no license)
+	  std::map<zypp::sat::Solvable::IdType, YCPString> packages;
+	  // license text => the shared YCP string
+	  boost::unordered_map<std::string, YCPString> texts;
+      };
+      LicenseCache license_cache;
+
+      // ResolvableProperties("", `language, "") result, the language dialogs
+      // ask for it repeatedly
+      struct LocaleListCache
+      {
+	  LocaleListCache() : valid(false), pool_serial(0) {}
+
+	  bool valid;
+	  unsigned pool_serial;
+	  // the requested locales and the requested keys the list has been built for
+	  zypp::LocaleSet requested;
+	  std::set<std::string> keys;
+	  YCPList list;
+      };
+      LocaleListCache locale_list_cache;
+      // the license text of the candidate to confirm, "" if none
+      YCPString LicenseToConfirm(const zypp::ui::Selectable::Ptr &s);
+      // apply the disk usage of the changed items to the cached values
+      bool UpdateDUIncrementally(const std::vector<zypp::sat::Solvable::IdType> &transacting);
+
+      // the file => owning packages index, see FileOwners(), only the files
+      // from the already queried directories are indexed
+      struct FileOwnerIndex
+      {
+	  FileOwnerIndex() : valid(false), pool_serial(0) {}
+
+	  bool valid;
+	  // the pool serial number the index has been built for
+	  unsigned pool_serial;
+	  // the indexed directories
+	  std::set<std::string> dirs;
+	  boost::unordered_map<std::string, std::vector<zypp::sat::Solvable> > owners;
+      };
+      FileOwnerIndex file_owners;
+      void UpdateFileOwnerIndex(const std::set<std::string> &dirs);
+
+      // the non-optional patches grouped by the flags, see ResolvableSetPatches()
+      struct PatchIndex
+      {
+	  PatchIndex() : valid(false), pool_serial(0), optional(0) {}
+
+	  bool valid;
+	  // the pool serial number the index has been built for
+	  unsigned pool_serial;
+	  // "all", "interactive", "reboot_needed", ... => patches
+	  std::map<std::string, std::vector<zypp::ui::Selectable::Ptr> > buckets;
+	  // number of ignored optional patches
+	  unsigned optional;
+      };
+      PatchIndex patch_index;
+      void BuildPatchIndex();
+
+      // the modified selectables grouped by kind, fate and the modifier,
+      // see IsAnyResolvable(), FilterPackages() and IsManualSelection()
+      struct TransactSummary
+      {
+	  TransactSummary() : valid(false), pool_serial(0) {}
+
+	  struct Member
+	  {
+	      zypp::ui::Selectable::Ptr selectable;
+	      zypp::ResStatus::TransactByValue by;
+	  };
+
+	  // (kind, fate) => number of selectables per modifier
+	  struct Counts
+	  {
+	      Counts() { std::fill(by, by + 4, 0u); }
+	      unsigned by[4];
+	      unsigned total() const { return by[0] + by[1] + by[2] + by[3]; }
+	  };
+
+	  typedef std::pair<zypp::ResKind, zypp::ui::Selectable::Fate> Key;
+
+	  bool valid;
+	  // the pool serial number the summary has been built for
+	  unsigned pool_serial;
+	  // the transacting items (solvable ID, transact by, to install)
+	  // the summary has been built for
+	  std::vector<std::pair<zypp::sat::Solvable::IdType, int> > transacting;
+	  std::map<Key, Counts> counts;
+	  std::map<Key, std::vector<Member> > members;
+
+	  unsigned count(const zypp::ResKind &kind, zypp::ui::Selectable::Fate fate) const;
+      };
+      TransactSummary transact_summary;
+      // refresh the summary if the pool state has been changed
+      const TransactSummary &BuildTransactSummary();
+
+      // the converted GPG keys, see GPGKeys()
+      struct GPGKeyCache
+      {
+	  GPGKeyCache() : valid(false) {}
+
+	  bool valid;
+	  // fingerprint and expiration of the keys the list has been built for
+	  // (libzypp imports the keys silently when verifying the metadata)
+	  std::vector<std::pair<std::string, long long> > stamp;
+	  // keep the keys, the "path" files are removed together with the keys
+	  std::list<zypp::PublicKey> keys;
+	  YCPList list;
+      };
+      GPGKeyCache known_gpg_keys;
+      GPGKeyCache trusted_gpg_keys;
+      const YCPList &CachedGPGKeys(bool trusted);
+
+      // a saved selection state, see StateCheckpoint()
+      struct StateSnapshot
+      {
+	  StateSnapshot() : pool_serial(0) {}
+
+	  // the pool serial number the solvable IDs are valid for
+	  unsigned pool_serial;
+	  // only the solvables with a changed status (transacting or locked),
+	  // sorted by the ID
+	  std::vector<std::pair<zypp::sat::Solvable::IdType, zypp::ResStatus> > items;
+      };
+      // the named checkpoints
+      std::map<std::string, StateSnapshot> state_checkpoints;
+      StateSnapshot CurrentState();
+
+      // statistics of the last solver run, see PkgSolveStats()
+      struct SolveStats
+      {
+	  SolveStats() : valid(false), result(false), cached(false), start_time(0), total_time(0), target_load_time(0),
+	    solver_time(0), problems_time(0), problems(0), solvables(0), transacting(0) {}
+
+	  // start a new run
+	  void start(const std::string &call_r);
+	  // finish the run, collect the pool counts
+	  void stop(bool result_r);
+
+	  bool valid;
+	  // the builtin name
+	  std::string call;
+	  bool result;
+	  // the solver has been skipped, see "solver_cache"
+	  bool cached;
+	  // wall time (in microseconds)
+	  long long start_time;
+	  long long total_time;
+	  long long target_load_time;
+	  long long solver_time;
+	  // collecting and saving the problems
+	  long long problems_time;
+	  unsigned problems;
+	  unsigned solvables;
+	  unsigned transacting;
+      };
+      SolveStats solve_stats;
+
+      // statistics of the last SourceLoad(), see SourceLoadStats()
+      struct LoadStats
+      {
+	  // the values of a repository, wall time in microseconds
+	  struct Repo
+	  {
+	      Repo() : check_time(0), refresh_time(0), build_time(0), load_time(0), downloaded(0),
+		solvables(0), refreshed(false), failed(false), cache_built(false), parallel(false) {}
+
+	      // checkIfToRefreshMetadata()
+	      long long check_time;
+	      // downloading the metadata (in a worker process including the cache build)
+	      long long refresh_time;
+	      long long build_time;
+	      // loadFromCache()
+	      long long load_time;
+	      // the size of the downloaded metadata (bytes)
+	      long long downloaded;
+	      // the added solvables
+	      unsigned solvables;
+	      bool refreshed;
+	      bool failed;
+	      // the solv cache has been (re)built, i.e. a cache miss
+	      bool cache_built;
+	      // refreshed or built by the worker processes (the time includes
+	      // waiting for a free worker)
+	      bool parallel;
+	  };
+
+	  LoadStats() : valid(false), active(false), start_time(0), total_time(0), solvables(0) {}
+
+	  bool valid;
+	  // SourceLoad() is running
+	  bool active;
+	  long long start_time;
+	  long long total_time;
+	  unsigned solvables;
+	  std::map<RepoId, Repo> repos;
+      };
+      LoadStats load_stats;
+      // the statistics of the repository (created if needed)
+      LoadStats::Repo &RepoLoadStats(const YRepo_Ptr &repo);
+      void LogLoadStats();
+      // the size of the downloaded metadata of the repository
+      long long MetadataSize(const zypp::RepoInfo &repo);
+      // the size of the files in the directory (recursively), sets the file count
+      static long long DirSize(const zypp::Pathname &dir, long long &files);
+
+      // skip the solver if nothing has been changed since the last successful run
+      bool solver_cache;
+      // the fingerprint of the pool state after the last successful PkgSolve()
+      bool solve_fingerprint_valid;
+      std::size_t solve_fingerprint;
+      std::size_t SolveFingerprint();
+
+      // the changed pool state kinds, see PoolGeneration()
+      enum PoolChange
+      {
+	  POOL_CHANGED_SELECTION = 1,
+	  POOL_CHANGED_SOLVER = 2,
+	  POOL_CHANGED_REPOS = 4,
+	  POOL_CHANGED_TARGET = 8,
+	  POOL_CHANGED_LOCKS = 16,
+	  POOL_CHANGED_LOCALES = 32
+      };
+      // increased after each builtin call which has changed the pool
+      long long pool_generation;
+      // the changes not reported yet (POOL_CHANGED_* bits)
+      unsigned pool_changes;
+      // the nesting level of the builtin calls
+      unsigned pool_changes_depth;
+      // CB_PoolChanged is being evaluated
+      bool pool_changes_notifying;
+      // the pool serial number at the last check
+      unsigned pool_changes_serial;
+      void CallPoolChanged(unsigned changes);
+      // the POOL_CHANGED_* bits changed by the builtin
+      static unsigned PoolChangesOf(const std::string &builtin);
+
       // callback related funcions
       void CallSourceReportStart(const std::string &text);
       void CallSourceReportEnd(const std::string &text);
@@ -189,12 +566,33 @@ class PkgFunctions
 	zypp::RepoManager::RawMetadataRefreshPolicy refresh = zypp::RepoManager::RefreshIfNeeded);
       zypp::repo::RepoType ProbeWithCallbacks(const zypp::Url &url);
       void ScanProductsWithCallBacks(const zypp::Url &url);
+      void ProbeProducts(const zypp::Url &url, const std::vector<zypp::Pathname> &dirs);
+      bool ProbeFinished(const std::vector<zypp::Url> &urls, unsigned index, int status);
+
+      // probed repository and service types for this session
+      struct ProbeCacheEntry
+      {
+	  // "yast2", "rpm-md", "ris"...
+	  std::string type;
+	  // PkgProfiler::now() of the probe
+	  long long stamp;
+      };
+      // ProbeKey() => entry
+      std::map<std::string, ProbeCacheEntry> probe_cache;
+      std::string ProbeKey(const std::string &kind, const zypp::Url &url, const zypp::Pathname &dir = zypp::Pathname()) const;
+      // once - remove the entry (the CD/DVD medium might be changed)
+      bool CachedProbe(const std::string &key, std::string &type, bool once = false);
+      void StoreProbe(const std::string &key, const std::string &type);
+      void InvalidateProbe(const std::string &key);
       void CallRefreshStarted();
       void CallRefreshDone();
       YCPValue SourceProvideDirectoryInternal(const YCPInteger& id, const YCPInteger& mid,
 	const YCPString& d, const YCPBoolean &optional,
 	const YCPBoolean &recursive, bool check_signatures);
 
+      std::set<YRepo_Ptr> ParallelRefresh(const RepoCont &candidates, zypp::ProgressData &prog_total, bool &success);
+      bool LoadPipelinedRepo(const YRepo_Ptr &repo, zypp::ProgressData &prog_total);
+      std::set<YRepo_Ptr> ParallelBuildCache(const RepoCont &candidates, zypp::ProgressData &prog_total);
       YCPValue SourceLoadImpl(PkgProgress &progress);
       YCPValue SourceStartManagerImpl(const YCPBoolean& enable, PkgProgress &progress);
 
@@ -207,6 +605,25 @@ class PkgFunctions
       YCPMap MPS2YCPMap(const zypp::DiskUsageCounter::MountPointSet &mps);
 
       YCPMap PoolQuery2YCPMap(const zypp::PoolQuery &pool_query);
+      bool YCPMap2PoolQuery(const YCPMap &lock, zypp::PoolQuery &query);
+
+      // the converted locks with stable IDs, see GetLocks()
+      struct LockCache
+      {
+	  LockCache() : valid(false), pool_serial(0), next_id(1) {}
+
+	  bool valid;
+	  // the repository IDs in the lock maps depend on the loaded repositories
+	  unsigned pool_serial;
+	  YCPList locks;
+	  // lock ID => lock
+	  std::map<long long, zypp::PoolQuery> queries;
+	  // serialized lock => lock ID (to keep the ID when rebuilding the cache)
+	  boost::unordered_map<std::string, long long> ids;
+	  long long next_id;
+      };
+      LockCache lock_cache;
+      const LockCache &CurrentLocks();
 
       zypp::Url shortenUrl(const zypp::Url &url);
 
@@ -217,7 +634,9 @@ class PkgFunctions
 
       bool CreateBaseProductSymlink();
 
-      YCPMap Resolvable2YCPMap(const zypp::PoolItem &item, const std::string &req_kind, bool dependencies);
+      // keys - the requested keys (empty = all keys)
+      YCPMap Resolvable2YCPMap(const zypp::PoolItem &item, const std::string &req_kind, bool dependencies,
+	const std::set<std::string> &keys = std::set<std::string>());
 
       // CommitPolicy used for commit
       zypp::ZYppCommitPolicy *commit_policy;
@@ -240,6 +659,54 @@ class PkgFunctions
 
       std::vector<zypp::filesystem::TmpDir> tmp_dirs;
 
+      // the files provided by SourceProvide*() are downloaded in advance
+      // when a repository is added (see DownloadPrefetch)
+      DownloadPrefetch download_prefetch;
+      void StartPrefetch(RepoId id);
+
+      // RepositoryAdd($[ "async_refresh" : true ]) refreshes the repositories
+      // and builds the solv cache in background processes
+      BackgroundJobs async_refresh;
+      // wait for the refresh of the repositories (empty = all), timeout in ms
+      // (negative = no limit), returns true if all have finished
+      bool WaitAsyncRefresh(const std::set<RepoId> &ids, long long timeout = -1);
+
+      // CreateSolverTestCaseOptions($[ "async" : true ]) writes the testcase
+      // in a background process
+      BackgroundJobs testcase_jobs;
+      // job ID => testcase directory
+      std::map<long long, std::string> testcase_dirs;
+      long long last_testcase;
+      // evaluate CB_SolverTestCaseDone for the finished testcases,
+      // timeout in ms (negative = no limit), returns true if all have finished
+      bool CollectSolverTestCases(long long timeout);
+
+      // flush the saved .repo and .service files
+      void SyncReposDir();
+
+      // state of a ResolvablePropertiesOpen() cursor
+      struct ResolvableCursor
+      {
+	  std::string req_kind;
+	  bool dependencies;
+	  std::set<std::string> keys;
+	  // the matching items, converted to YCP maps lazily in ResolvablePropertiesNext()
+	  std::vector<zypp::PoolItem> items;
+	  std::vector<zypp::PoolItem>::size_type next;
+	  // the pool serial number at open, the items are not valid after a pool change
+	  unsigned pool_serial;
+      };
+
+      // open cursors (cursor ID => cursor)
+      std::map<long long, ResolvableCursor> resolvable_cursors;
+      long long last_cursor;
+
+      PkgProfiler _profiler;
+
+      // find the items matching the name and the version
+      void ResolvableMatching(const zypp::ResKind &kind, const std::string &name, const std::string &version,
+	std::vector<zypp::PoolItem> &items);
+
       /**
        * Logging helper:
        * search for a repository and in case of exception, log error
@@ -275,10 +742,33 @@ class PkgFunctions
       // it finds the resolvable using attributes saved earlier by RememberBaseProduct
       zypp::Product::constPtr FindInstalledBaseProduct();
 
+      // the found base products, see FindInstalledBaseProduct() and BaseProductInfo()
+      struct BaseProductCache
+      {
+	  BaseProductCache() : pool_serial(0), installed_valid(false), info_valid(false) {}
+
+	  // the pool serial number and the remembered base product
+	  // ("" = none) the products have been found for
+	  unsigned pool_serial;
+	  std::string base;
+	  bool installed_valid;
+	  zypp::sat::Solvable installed;
+	  bool info_valid;
+	  zypp::sat::Solvable info;
+
+	  void reset() { installed_valid = info_valid = false; }
+      };
+      BaseProductCache base_product_cache;
+      // reset the cache if the pool or the base product has been changed
+      void CheckBaseProductCache();
+
       // adds authentication data to a URL
       void AddAuthData(zypp::Url url);
       // helper with common code to SourceURL and SourceRawUrl
       YCPValue GetSourceUrl(const YCPInteger& id, bool raw);
+      // helpers for SourceGeneralData, SourceMediaData and SourceGetAll
+      YCPMap RepoGeneralData(const YRepo_Ptr &repo);
+      YCPMap RepoMediaData(const YRepo_Ptr &repo, int media_count);
 
     public:
 	// general
@@ -298,6 +788,18 @@ class PkgFunctions
 	YCPValue LastError ();
 	/* TYPEINFO: string() */
 	YCPValue LastErrorDetails ();
+	/* TYPEINFO: boolean(boolean) */
+	YCPValue ProfilingStart (const YCPBoolean &reset);
+	/* TYPEINFO: boolean() */
+	YCPValue ProfilingStop ();
+	/* TYPEINFO: map<string,map<string,integer> >() */
+	YCPValue ProfilingReport ();
+	/* TYPEINFO: boolean(string) */
+	YCPValue ProfilingSave (const YCPString &path);
+	/* TYPEINFO: map<string,any>() */
+	YCPValue MemoryStats ();
+	/* TYPEINFO: integer() */
+	YCPValue PoolGeneration ();
 	/* TYPEINFO: boolean() */
 	YCPValue Connect ();
 	/* TYPEINFO: string(string)*/
@@ -409,6 +911,19 @@ class PkgFunctions
         /* TYPEINFO: void(void()) */
 	YCPValue CallbackFileConflictFinish( const YCPValue& args );
 
+	/* TYPEINFO: void(void(integer,integer)) */
+	YCPValue CallbackPoolChanged( const YCPValue& args );
+	/* TYPEINFO: void(void(string,boolean)) */
+	YCPValue CallbackSolverTestCaseDone( const YCPValue& args );
+
+	// progress callback rate limit
+	/* TYPEINFO: boolean(map<string,any>) */
+	YCPValue SetProgressThrottle( const YCPMap& settings );
+	/* TYPEINFO: map<string,any>() */
+	YCPValue ProgressThrottleStats();
+	/* TYPEINFO: boolean() */
+	YCPValue ProgressAbort();
+
 	// Script (patch installation) callbacks
 	/* TYPEINFO: void(void(string,string,string,string)) */
 	YCPValue CallbackScriptStart( const YCPValue& /*nil*/ args );
@@ -523,6 +1038,8 @@ class PkgFunctions
 	YCPValue SourceMediaData (const YCPInteger&);
 	/* TYPEINFO: map<string,any>(integer)*/
 	YCPValue SourceProductData (const YCPInteger&);
+	/* TYPEINFO: map<integer,map<string,any> >(list<string>)*/
+	YCPValue SourceGetAll (const YCPList&);
 	/* TYPEINFO: string(integer,integer,string)*/
 	YCPValue SourceProvideFile (const YCPInteger&, const YCPInteger&, const YCPString&);
 	/* TYPEINFO: string(integer,integer,string)*/
@@ -531,6 +1048,8 @@ class PkgFunctions
 	YCPValue SourceProvideDirectory(const YCPInteger& id, const YCPInteger& mid, const YCPString& d, const YCPBoolean &optional, const YCPBoolean &recursive);
 	/* TYPEINFO: string(integer,integer,string,boolean,boolean)*/
 	YCPValue SourceProvideSignedDirectory(const YCPInteger& id, const YCPInteger& mid, const YCPString& d, const YCPBoolean &optional, const YCPBoolean &recursive);
+	/* TYPEINFO: map<string,string>(integer,list<map<string,any> >)*/
+	YCPValue SourceProvideFiles(const YCPInteger& id, const YCPList& files);
 	/* TYPEINFO: string(integer,integer,string,boolean)*/
 	YCPValue SourceProvideSignedFile(const YCPInteger& id, const YCPInteger& mid, const YCPString& f, const YCPBoolean &optional);
 	/* TYPEINFO: string(integer,integer,string,boolean)*/
@@ -567,6 +1086,14 @@ class PkgFunctions
 	YCPValue RepositoryScan(const YCPString& url);
 	/* TYPEINFO: integer(map<string,any>)*/
 	YCPValue RepositoryAdd(const YCPMap &params);
+	/* TYPEINFO: boolean(list<integer>,integer)*/
+	YCPValue SourceWait(const YCPList &ids, const YCPInteger &timeout);
+	/* TYPEINFO: map<string,any>() */
+	YCPValue SourceLoadStats();
+	/* TYPEINFO: boolean(string)*/
+	YCPValue PoolSnapshotSave(const YCPString &path);
+	/* TYPEINFO: boolean(string)*/
+	YCPValue PoolSnapshotLoad(const YCPString &path);
 	/* TYPEINFO: void()*/
 	YCPValue SkipRefresh();
 
@@ -593,6 +1120,8 @@ class PkgFunctions
 	YCPInteger TargetAvailable (const YCPString&);
 	/* TYPEINFO: integer(string)*/
 	YCPInteger TargetBlockSize (const YCPString&);
+	/* TYPEINFO: map<string,integer>(string)*/
+	YCPValue TargetDiskStats (const YCPString&);
 	/* TYPEINFO: boolean(string)*/
 	YCPBoolean TargetInstall (const YCPString&);
 	/* TYPEINFO: boolean(string)*/
@@ -619,6 +1148,8 @@ class PkgFunctions
 	// package related
 	/* TYPEINFO: list<string>(symbol,boolean)*/
 	YCPValue GetPackages (const YCPSymbol& which, const YCPBoolean& names_only);
+	/* TYPEINFO: map<symbol,list<string> >(list<symbol>,boolean)*/
+	YCPValue GetPackagesMulti (const YCPList& which, const YCPBoolean& names_only);
 	/* TYPEINFO: list<string>(boolean,boolean,boolean,boolean)*/
 	YCPValue FilterPackages (const YCPBoolean& byAuto, const YCPBoolean& byApp, const YCPBoolean& byUser, const YCPBoolean& names_only);
 	/* TYPEINFO: boolean(string)*/
@@ -629,6 +1160,8 @@ class PkgFunctions
 	YCPValue IsSelected (const YCPString& tag);
 	/* TYPEINFO: boolean(string)*/
 	YCPValue IsAvailable (const YCPString& tag);
+	/* TYPEINFO: map<string,map<string,boolean> >(list<string>)*/
+	YCPValue CapabilitiesStatus (const YCPList& tags);
 	/* TYPEINFO: boolean(string)*/
 	YCPValue PkgAvailable(const YCPString& package);
 	/* TYPEINFO: map<string,any>(list<string>)*/
@@ -651,8 +1184,14 @@ class PkgFunctions
 	YCPValue PkgProperties (const YCPString& package);
 	/* TYPEINFO: list<map<string,any> >(string)*/
 	YCPValue PkgPropertiesAll (const YCPString& package);
+	/* TYPEINFO: map<string,map<string,any> >(list<string>,list<string>)*/
+	YCPValue PkgPropertiesBatch (const YCPList& names, const YCPList& keys);
 	/* TYPEINFO: list<string>(string,symbol)*/
 	YCPList  PkgGetFilelist (const YCPString& package, const YCPSymbol& which);
+	/* TYPEINFO: map<string,any>(string,symbol,map<string,any>)*/
+	YCPValue PkgGetFilelistEx (const YCPString& package, const YCPSymbol& which, const YCPMap& options);
+	/* TYPEINFO: map<string,list<map<string,any> > >(list<string>)*/
+	YCPValue FileOwners (const YCPList& paths);
 	/* TYPEINFO: map<string,list<integer>>(string)*/
 	YCPValue PkgDU(const YCPString& package);
 	/* TYPEINFO: boolean()*/
@@ -663,6 +1202,12 @@ class PkgFunctions
 	YCPValue SaveState ();
 	/* TYPEINFO: boolean(boolean)*/
 	YCPValue RestoreState (const YCPBoolean&);
+	/* TYPEINFO: boolean(string)*/
+	YCPValue StateCheckpoint (const YCPString&);
+	/* TYPEINFO: boolean(string)*/
+	YCPValue StateRollback (const YCPString&);
+	/* TYPEINFO: list<map<string,any> >(string,string)*/
+	YCPValue StateDiff (const YCPString&, const YCPString&);
 	/* TYPEINFO: map<symbol,integer>(map<string,any>)*/
 	YCPValue PkgUpdateAll (const YCPMap& options);
 	/* TYPEINFO: list<list<any>>(string) */
@@ -692,11 +1237,18 @@ class PkgFunctions
 	YCPBoolean PkgSolve (const YCPBoolean& filter);
 	/* TYPEINFO: boolean(string)*/
 	YCPValue CreateSolverTestCase(const YCPString &dir);
+	/* TYPEINFO: boolean(string,map<string,any>) */
+	YCPValue CreateSolverTestCaseOptions(const YCPString &dir, const YCPMap &options);
+	/* TYPEINFO: boolean(integer) */
+	YCPValue SolverTestCaseWait(const YCPInteger &timeout);
 	/* TYPEINFO: boolean()*/
 	YCPBoolean PkgSolveCheckTargetOnly ();
 	/* TYPEINFO: integer()*/
 	YCPValue PkgSolveErrors ();
+	/* TYPEINFO: map<string,any>()*/
+	YCPValue PkgSolveStats ();
         YCPValue CommitHelper(const zypp::ZYppCommitPolicy *policy);
+        bool PrefetchPackages(unsigned jobs, const zypp::ZYppCommitPolicy &policy);
 	/* TYPEINFO: list<any>(integer)*/
 	YCPValue PkgCommit (const YCPInteger& medianr);
 	/* TYPEINFO: list<any>(map<string,any>)*/
@@ -709,6 +1261,8 @@ class PkgFunctions
 	YCPValue GetUpgradeRepos();
 	/* TYPEINFO: boolean(integer)*/
 	YCPValue RemoveUpgradeRepo(const YCPInteger &repo);
+	/* TYPEINFO: boolean(list<integer>)*/
+	YCPValue SetUpgradeRepos(const YCPList &repos);
 
 	/* TYPEINFO: boolean(map<string,any>)*/
 	YCPValue AddLock(const YCPMap &lock);
@@ -716,6 +1270,10 @@ class PkgFunctions
 	YCPValue GetLocks();
 	/* TYPEINFO: boolean(integer)*/
 	YCPValue RemoveLock(const YCPInteger &lock_idx);
+	/* TYPEINFO: boolean(list<map<string,any> >)*/
+	YCPValue AddLocks(const YCPList &locks);
+	/* TYPEINFO: boolean(list<integer>)*/
+	YCPValue RemoveLocks(const YCPList &ids);
 
 	/* TYPEINFO: list<list<integer>>()*/
 	YCPValue PkgMediaSizes ();
@@ -735,6 +1293,8 @@ class PkgFunctions
 
 	/* TYPEINFO: boolean(string)*/
 	YCPBoolean RpmChecksig( const YCPString & filename );
+	/* TYPEINFO: map<string,boolean>(list<string>,integer)*/
+	YCPValue RpmChecksigBatch( const YCPList & files, const YCPInteger & jobs );
 
 	// architecture related
 	/* TYPEINFO: string()*/
@@ -758,16 +1318,28 @@ class PkgFunctions
         YCPValue ResolvableNeutral( const YCPString& name_r, const YCPSymbol& kind_r, const YCPBoolean& force_r );
 	/* TYPEINFO: boolean(string,symbol)*/
         YCPValue ResolvableSetSoftLock( const YCPString& name_r, const YCPSymbol& kind_r );
+	/* TYPEINFO: list<symbol>(list<map<string,any> >)*/
+        YCPValue ResolvableTransact( const YCPList& jobs );
 	/* TYPEINFO: list<map<string,any> >(string,symbol,string)*/
         YCPValue ResolvableProperties(const YCPString& name, const YCPSymbol& kind_r, const YCPString& version);
 	/* TYPEINFO: list<map<string,any> >(string,symbol,string)*/
         YCPValue ResolvableDependencies(const YCPString& name, const YCPSymbol& kind_r, const YCPString& version);
+	/* TYPEINFO: list<map<string,any> >(string,symbol,string,list<string>)*/
+        YCPValue ResolvablePropertiesKeys(const YCPString& name, const YCPSymbol& kind_r, const YCPString& version, const YCPList& keys);
+	/* TYPEINFO: integer(string,symbol,string,list<string>)*/
+        YCPValue ResolvablePropertiesOpen(const YCPString& name, const YCPSymbol& kind_r, const YCPString& version, const YCPList& keys);
+	/* TYPEINFO: list<map<string,any> >(integer,integer)*/
+        YCPValue ResolvablePropertiesNext(const YCPInteger& cursor, const YCPInteger& batch_size);
+	/* TYPEINFO: boolean(integer)*/
+        YCPValue ResolvablePropertiesClose(const YCPInteger& cursor);
 	/* TYPEINFO: integer(symbol)*/
 	YCPValue ResolvablePreselectPatches(const YCPSymbol& kind_r);
 	/* TYPEINFO: integer(symbol)*/
 	YCPValue ResolvableCountPatches(const YCPSymbol& kind_r);
 	/* TYPEINFO: boolean(symbol,symbol)*/
 	YCPValue IsAnyResolvable(const YCPSymbol& kind_r, const YCPSymbol& status);
+	/* TYPEINFO: map<string,any>()*/
+	YCPValue BaseProductInfo();
 
 	// keyring related
 	/* TYPEINFO: boolean(string,boolean)*/
@@ -778,6 +1350,8 @@ class PkgFunctions
 	YCPValue DeleteGPGKey(const YCPString&, const YCPBoolean&);
 	/* TYPEINFO: map<string,any>(string)*/
 	YCPValue CheckGPGKeyFile(const YCPString&);
+	/* TYPEINFO: map<string,boolean>(list<string>,boolean)*/
+	YCPValue ImportGPGKeys(const YCPList& files, const YCPBoolean& trusted);
 
 	/* TYPEINFO: boolean()*/
 	YCPValue SourceReleaseAll ();
@@ -799,6 +1373,8 @@ class PkgFunctions
 	YCPValue ServiceRefresh(const YCPString&);
 	/* TYPEINFO: boolean(string)*/
 	YCPValue ServiceForceRefresh(const YCPString&);
+	/* TYPEINFO: map<string,boolean>(map<string,any>)*/
+	YCPValue ServiceRefreshAll(const YCPMap&);
 	/* TYPEINFO: string(string)*/
 	YCPValue ServiceURL(const YCPString &alias);
 	/* TYPEINFO: string(string)*/
@@ -824,7 +1400,12 @@ class PkgFunctions
     /* TYPEINFO: boolean(string) */
     YCPValue UrlSchemeIsDownloading(const YCPString &url_scheme);
 
-        YCPValue ResolvablePropertiesEx(const YCPString& name, const YCPSymbol& kind_r, const YCPString& version, bool dependencies);
+	// network related functions
+	/* TYPEINFO: map<string,any>(boolean)*/
+	YCPValue NetworkStatus(const YCPBoolean &refresh);
+
+        YCPValue ResolvablePropertiesEx(const YCPString& name, const YCPSymbol& kind_r, const YCPString& version, bool dependencies,
+	    const std::set<std::string> &keys = std::set<std::string>());
 	YCPValue ResolvableSetPatches(const YCPSymbol& kind_r, bool preselect);
 
 	/**
@@ -839,6 +1420,10 @@ class PkgFunctions
 
 	// must be public, used in callbacks
 	RepoId logFindAlias(const std::string &alias) const;
+	// the loaded pool repository of the ID, noRepository if not loaded
+	zypp::Repository PoolRepository(RepoId id) const;
+	// the ID of a loaded pool repository, -1 if not known (e.g. @System)
+	RepoId PoolRepoId(const zypp::Repository &repository) const;
 
 	RepoId LastReportedRepo() const;
 	int LastReportedMedium() const;
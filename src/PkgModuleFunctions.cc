@@ -49,15 +49,15 @@ PkgModuleFunctions::~PkgModuleFunctions()
 
 Y2Function* PkgModuleFunctions::createFunctionCall (const string name, constFunctionTypePtr type)
 {
-    vector<string>::iterator it = find (_registered_functions.begin ()
-	, _registered_functions.end (), name);
-    if (it == _registered_functions.end ())
+    boost::unordered_map<std::string, unsigned int>::const_iterator it = _function_index.find (name);
+    if (it == _function_index.end ())
     {
 	y2error ("No such function %s", name.c_str ());
 	return NULL;
     }
 
-    return new Y2PkgFunction (name, &pkg_functions, it - _registered_functions.begin ());
+    // the registered name is used, it lives as long as the namespace
+    return new Y2PkgFunction (_registered_functions[it->second], &pkg_functions, it->second);
 }
 
 YCPValue PkgModuleFunctions::evaluate(bool cse)
@@ -69,5 +69,24 @@ YCPValue PkgModuleFunctions::evaluate(bool cse)
 void PkgModuleFunctions::registerFunctions()
 {
 #include "PkgBuiltinTable.h"
+
+    // build the lookup index, the first registration wins (like the former linear search)
+    _function_index.reserve (_registered_functions.size ());
+    for (unsigned int i = 0; i < _registered_functions.size (); ++i)
+    {
+	_function_index.insert (std::make_pair (_registered_functions[i], i));
+    }
+
+    // the list of the builtins skipping the lazy load must follow the renamed
+    // and removed builtins, a stale name would hide a missing new one
+    // (checked by testsuite/lazy_load_test.cc)
+    const std::set<std::string> &lazy_safe (PkgFunctions::LazySafeBuiltins ());
+    for (std::set<std::string>::const_iterator it = lazy_safe.begin (); it != lazy_safe.end (); ++it)
+    {
+	if (_function_index.find (*it) == _function_index.end ())
+	{
+	    y2internal ("Unknown builtin in the lazy load list: Pkg::%s", it->c_str ());
+	}
+    }
 }
 
@@ -24,6 +24,7 @@
 #define PkgModuleFunctions_h
 
 #include <string>
+#include <boost/unordered_map.hpp>
 #include <y2/Y2Namespace.h>
 #include "PkgFunctions.h"
 
@@ -68,5 +69,7 @@ class PkgModuleFunctions : public Y2Namespace
 
 	PkgFunctions pkg_functions;
         std::vector<std::string> _registered_functions;
+        // function name => index in _registered_functions
+        boost::unordered_map<std::string, unsigned int> _function_index;
 };
 #endif // PkgModuleFunctions_h
@@ -0,0 +1,145 @@
+/*
+ * File:   PkgProfiler.cc
+ *
+ * Collect the call statistics of the Pkg builtins.
+ */
+
+#include "PkgProfiler.h"
+#include "log.h"
+
+#include <cstdlib>
+#include <ctime>
+#include <algorithm>
+#include <fstream>
+
+PkgProfiler::PkgProfiler()
+  : _active(false)
+{
+  const char *env = ::getenv("Y2PKG_PROFILE");
+
+  if (env != NULL)
+  {
+    _active = true;
+
+    if (env[0] == '/')
+      _save_path = env;
+
+    y2milestone("Y2PKG_PROFILE is set, profiling the Pkg builtins (output: %s)",
+      _save_path.empty() ? "log" : _save_path.c_str());
+  }
+}
+
+PkgProfiler::~PkgProfiler()
+{
+  if (!_save_path.empty())
+    save(_save_path);
+  else if (_active)
+    log();
+}
+
+void PkgProfiler::start(bool reset)
+{
+  if (reset)
+    _entries.clear();
+
+  _active = true;
+}
+
+void PkgProfiler::stop()
+{
+  _active = false;
+}
+
+void PkgProfiler::record(unsigned position, const std::string &name, long long time, unsigned long long bytes)
+{
+  Entry &entry = _entries[position];
+
+  if (entry.calls == 0)
+    entry.name = name;
+
+  ++entry.calls;
+  entry.total_time += time;
+  entry.result_bytes += bytes;
+
+  if (time > entry.max_time)
+    entry.max_time = time;
+}
+
+// sort by the total time, the slowest first
+static bool slowerEntry(const PkgProfiler::Entry *a, const PkgProfiler::Entry *b)
+{
+  return a->total_time > b->total_time;
+}
+
+std::vector<const PkgProfiler::Entry*> PkgProfiler::sorted() const
+{
+  std::vector<const Entry*> ret;
+  ret.reserve(_entries.size());
+
+  for (Entries::const_iterator it = _entries.begin(); it != _entries.end(); ++it)
+    ret.push_back(&it->second);
+
+  std::sort(ret.begin(), ret.end(), slowerEntry);
+  return ret;
+}
+
+void PkgProfiler::log() const
+{
+  std::vector<const Entry*> entries(sorted());
+
+  y2milestone("Pkg builtin profile (%zd builtins):", entries.size());
+
+  for (std::vector<const Entry*>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+  {
+    const Entry &entry = **it;
+    y2milestone("  %s: calls: %llu, total: %lldus, avg: %lldus, max: %lldus, result: %lluB",
+      entry.name.c_str(), entry.calls, entry.total_time, entry.total_time / (long long)entry.calls,
+      entry.max_time, entry.result_bytes);
+  }
+}
+
+bool PkgProfiler::save(const std::string &path) const
+{
+  std::ofstream out(path.c_str());
+
+  if (!out)
+  {
+    y2error("Cannot write the profile to %s", path.c_str());
+    return false;
+  }
+
+  out << "builtin\tcalls\ttotal_us\tmax_us\tresult_bytes\n";
+
+  std::vector<const Entry*> entries(sorted());
+  for (std::vector<const Entry*>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+  {
+    const Entry &entry = **it;
+    out << entry.name << '\t' << entry.calls << '\t' << entry.total_time << '\t'
+      << entry.max_time << '\t' << entry.result_bytes << '\n';
+  }
+
+  out.close();
+
+  if (!out)
+  {
+    y2error("Cannot write the profile to %s", path.c_str());
+    return false;
+  }
+
+  y2milestone("Profile of %zd builtins saved to %s", entries.size(), path.c_str());
+  return true;
+}
+
+long long PkgProfiler::now()
+{
+  struct timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+long long PkgProfiler::nowMs()
+{
+  struct timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
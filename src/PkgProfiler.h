@@ -0,0 +1,75 @@
+/*
+ * File:   PkgProfiler.h
+ *
+ * Collect the call statistics of the Pkg builtins (number of calls,
+ * total and max. time, size of the results).
+ *
+ * (Note: the YCP interpreter is single threaded, no locking is needed.
+ * The nested calls (e.g. from a callback) are counted in the time of
+ * the calling builtin as well.)
+ */
+
+#ifndef PKGPROFILER_H
+#define PKGPROFILER_H
+
+#include <string>
+#include <map>
+#include <vector>
+
+class PkgProfiler {
+
+public:
+  struct Entry {
+    Entry() : calls(0), total_time(0), max_time(0), result_bytes(0) {}
+
+    std::string name;
+    unsigned long long calls;
+    // in microseconds
+    long long total_time;
+    long long max_time;
+    // the size of the results in the YCP string representation
+    unsigned long long result_bytes;
+  };
+
+  // builtin position => statistics
+  typedef std::map<unsigned, Entry> Entries;
+
+  // the profiler is started at load time if the Y2PKG_PROFILE
+  // environment variable is set, if the value is an absolute path
+  // the statistics are saved there at exit (see save())
+  PkgProfiler();
+
+  ~PkgProfiler();
+
+  bool active() const { return _active; }
+
+  void start(bool reset);
+  void stop();
+
+  // record a finished call
+  void record(unsigned position, const std::string &name, long long time, unsigned long long bytes);
+
+  const Entries & entries() const { return _entries; }
+
+  // write the statistics (sorted by the total time) to the y2log
+  void log() const;
+
+  // save the statistics to a file in a machine readable format
+  // (tab separated values, header line first)
+  bool save(const std::string &path) const;
+
+  // monotonic time in microseconds
+  static long long now();
+  // monotonic time in milliseconds
+  static long long nowMs();
+
+private:
+  // the statistics sorted by the total time
+  std::vector<const Entry*> sorted() const;
+
+  bool _active;
+  std::string _save_path;
+  Entries _entries;
+};
+
+#endif	/* PKGPROFILER_H */
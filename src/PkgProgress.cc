@@ -10,8 +10,12 @@ void PkgProgress::Start( const std::string &process, const std::list<std::string
 {
     if (!running)
     {
+	// an abort requested for a previous progress
+	callback_handler.progressThrottle().clearAbort();
+
 	// get the YCP callback handler for destroy event
 	Y2Function* ycp_handler = callback_handler._ycpCallbacks.createCallback(PkgFunctions::CallbackHandler::YCPCallbacks::CB_ProcessStart);
+	PkgFunctions::CallbackHandler::YCPCallbacks::Release ycp_handler_release(callback_handler._ycpCallbacks, PkgFunctions::CallbackHandler::YCPCallbacks::CB_ProcessStart, ycp_handler);
 
 	y2debug("ProcessStart");
 
@@ -39,6 +43,7 @@ void PkgProgress::Start( const std::string &process, const std::list<std::string
 	}
 
 	running = true;
+	_limiter.reset();
 
 	if (stages.size() > 0)
 	{
@@ -59,6 +64,7 @@ void PkgProgress::NextStage()
     {
 	// get the YCP callback handler for destroy event
 	Y2Function* ycp_handler = callback_handler._ycpCallbacks.createCallback(PkgFunctions::CallbackHandler::YCPCallbacks::CB_ProcessNextStage);
+	PkgFunctions::CallbackHandler::YCPCallbacks::Release ycp_handler_release(callback_handler._ycpCallbacks, PkgFunctions::CallbackHandler::YCPCallbacks::CB_ProcessNextStage, ycp_handler);
 
 	// is the callback registered?
 	if (ycp_handler != NULL)
@@ -75,8 +81,26 @@ void PkgProgress::Done()
     if (running)
     {
 	y2debug("ProcessDone");
+
+	callback_handler.progressThrottle().clearAbort();
+
+	// deliver the last deferred progress
+	int pending;
+	if (_limiter.takePending(pending))
+	{
+	    Y2Function* progress_handler = callback_handler._ycpCallbacks.createCallback(PkgFunctions::CallbackHandler::YCPCallbacks::CB_ProcessProgress);
+	    PkgFunctions::CallbackHandler::YCPCallbacks::Release progress_handler_release(callback_handler._ycpCallbacks, PkgFunctions::CallbackHandler::YCPCallbacks::CB_ProcessProgress, progress_handler);
+
+	    if (progress_handler != NULL)
+	    {
+		progress_handler->appendParameter(YCPInteger(pending));
+		progress_handler->evaluateCall();
+	    }
+	}
+
 	// get the YCP callback handler for destroy event
 	Y2Function* ycp_handler = callback_handler._ycpCallbacks.createCallback(PkgFunctions::CallbackHandler::YCPCallbacks::CB_ProcessFinished);
+	PkgFunctions::CallbackHandler::YCPCallbacks::Release ycp_handler_release(callback_handler._ycpCallbacks, PkgFunctions::CallbackHandler::YCPCallbacks::CB_ProcessFinished, ycp_handler);
 
 	// is the callback registered?
 	if (ycp_handler != NULL)
@@ -97,8 +121,21 @@ bool PkgProgress::_receiver(const zypp::ProgressData &progress)
 
     if (running)
     {
+	ZyppRecipients::ProgressThrottle &throttle = callback_handler.progressThrottle();
+
+	if (throttle.async)
+	{
+	    if (throttle.takeAbort())
+		return false;
+
+	    // coalesce the progress, the latest value is delivered later
+	    if (!_limiter.passAsync(throttle, progress.reportValue()))
+		return true;
+	}
+
 	// get the YCP callback handler for destroy event
 	Y2Function* ycp_handler = callback_handler._ycpCallbacks.createCallback(PkgFunctions::CallbackHandler::YCPCallbacks::CB_ProcessProgress);
+	PkgFunctions::CallbackHandler::YCPCallbacks::Release ycp_handler_release(callback_handler._ycpCallbacks, PkgFunctions::CallbackHandler::YCPCallbacks::CB_ProcessProgress, ycp_handler);
 
 	// is the callback registered?
 	if (ycp_handler != NULL)
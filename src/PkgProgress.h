@@ -45,6 +45,8 @@ class PkgProgress
 	const PkgFunctions::CallbackHandler &callback_handler;
 	zypp::ProgressData::ReceiverFnc progress_handler;
 	bool running;
+	// deferred progress delivery in the async mode
+	ZyppRecipients::ProgressLimiter _limiter;
 
     protected:
 	bool _receiver(const zypp::ProgressData &progress);
@@ -21,6 +21,8 @@
 
 #include "PkgService.h"
 
+#include <sstream>
+
 PkgService::PkgService() : _deleted(false), _old_alias()
 {
 }
@@ -31,7 +33,7 @@ PkgService::PkgService(const zypp::ServiceInfo &s, const std::string &old_alias)
 }
 
 PkgService::PkgService(const PkgService &s) :
-    zypp::ServiceInfo(s), _deleted(s._deleted), _old_alias(s._old_alias)
+    zypp::ServiceInfo(s), _deleted(s._deleted), _old_alias(s._old_alias), _saved(s._saved)
 {
 }
 
@@ -58,3 +60,20 @@ void PkgService::setOrigAlias(const std::string& orig_alias)
 {
     _old_alias = orig_alias;
 }
+
+std::string PkgService::iniContent() const
+{
+    std::ostringstream str;
+    dumpAsIniOn(str);
+    return str.str();
+}
+
+bool PkgService::isModified() const
+{
+    return _saved.empty() || _saved != iniContent();
+}
+
+void PkgService::setSaved()
+{
+    _saved = iniContent();
+}
@@ -42,10 +42,23 @@ class PkgService : public zypp::ServiceInfo
 
         void setOrigAlias(const std::string& orig_alias);
 
+	// has the service been changed since the last load or save?
+	bool isModified() const;
+
+	// the current state has been loaded from or written to disk
+	void setSaved();
+
+	// not saved to the current target yet (e.g. after changing the target root)
+	void resetSaved() { _saved.clear(); }
+
     private:
 
+	std::string iniContent() const;
+
 	bool _deleted;
 	std::string _old_alias;
+	// the .service file content at the last load or save, empty = not saved yet
+	std::string _saved;
 };
 
 
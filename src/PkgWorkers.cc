@@ -0,0 +1,354 @@
+/*
+ * File:   PkgWorkers.cc
+ *
+ * Run independent jobs in forked worker processes with bounded parallelism.
+ */
+
+#include "PkgWorkers.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// a finished job reported by a worker
+struct JobResult {
+  unsigned index;
+  int status;
+};
+
+// read the whole record, returns false at EOF or on error
+static bool readRecord(int fd, void *data, size_t size)
+{
+  char *ptr = static_cast<char *>(data);
+  size_t done = 0;
+
+  while (done < size)
+  {
+    ssize_t ret = ::read(fd, ptr + done, size - done);
+
+    if (ret < 0 && errno == EINTR)
+      continue;
+
+    if (ret <= 0)
+      return false;
+
+    done += ret;
+  }
+
+  return true;
+}
+
+// write the whole record, a closed peer is an error (not SIGPIPE)
+static bool writeRecord(int fd, const void *data, size_t size)
+{
+  const char *ptr = static_cast<const char *>(data);
+  size_t done = 0;
+
+  while (done < size)
+  {
+    ssize_t ret = ::send(fd, ptr + done, size - done, MSG_NOSIGNAL);
+
+    if (ret < 0 && errno == EINTR)
+      continue;
+
+    if (ret <= 0)
+      return false;
+
+    done += ret;
+  }
+
+  return true;
+}
+
+PkgWorkers::PkgWorkers(unsigned max_jobs, const ChildSetupFnc &child_setup, const ChildSetupFnc &child_cleanup)
+  : _max_jobs(max_jobs > 0 ? max_jobs : defaultJobs()),
+  _child_setup(child_setup),
+  _child_cleanup(child_cleanup)
+{
+}
+
+unsigned PkgWorkers::defaultJobs()
+{
+  long cpus = ::sysconf(_SC_NPROCESSORS_ONLN);
+  return cpus > 0 ? cpus : 1;
+}
+
+unsigned PkgWorkers::add(const Job &job)
+{
+  _jobs.push_back(job);
+  return _jobs.size() - 1;
+}
+
+bool PkgWorkers::start(Worker &worker)
+{
+  int fds[2];
+
+  // the socket is not inherited by the programs started by the jobs
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+  {
+    y2error("Cannot create a worker socket: %s", ::strerror(errno));
+    return false;
+  }
+
+  pid_t pid = ::fork();
+
+  if (pid == 0)
+  {
+    // child process
+    ::close(fds[0]);
+
+    // the sockets of the other workers, a worker exits when the parent
+    // closes its socket
+    for (std::vector<Worker>::const_iterator it = _running.begin(); it != _running.end(); ++it)
+      ::close(it->fd);
+
+    workerLoop(fds[1]);
+
+    // do not run the atexit handlers and the static destructors,
+    // they belong to the parent process
+    ::_exit(0);
+  }
+
+  ::close(fds[1]);
+
+  if (pid < 0)
+  {
+    y2error("Cannot fork a worker process: %s", ::strerror(errno));
+    ::close(fds[0]);
+    return false;
+  }
+
+  y2debug("Started worker process %d", pid);
+
+  worker.pid = pid;
+  worker.fd = fds[0];
+  worker.job = -1;
+
+  return true;
+}
+
+// runs in the worker process, the jobs are read from the socket
+// until the parent closes it
+void PkgWorkers::workerLoop(int fd)
+{
+  bool setup = true;
+
+  try
+  {
+    if (_child_setup)
+      _child_setup();
+  }
+  catch (...)
+  {
+    setup = false;
+  }
+
+  unsigned index;
+
+  while (readRecord(fd, &index, sizeof(index)))
+  {
+    JobResult result;
+    result.index = index;
+    result.status = JOB_FAILED;
+
+    try
+    {
+      if (setup && index < _jobs.size())
+        result.status = _jobs[index]();
+    }
+    catch (...)
+    {
+      result.status = JOB_FAILED;
+    }
+
+    if (!writeRecord(fd, &result, sizeof(result)))
+      break;
+  }
+
+  try
+  {
+    if (_child_cleanup)
+      _child_cleanup();
+  }
+  catch (...)
+  {
+  }
+}
+
+bool PkgWorkers::sendJob(Worker &worker, unsigned index)
+{
+  if (!writeRecord(worker.fd, &index, sizeof(index)))
+  {
+    y2error("Cannot pass job %u to worker process %d", index, worker.pid);
+    return false;
+  }
+
+  worker.job = index;
+  return true;
+}
+
+// close the socket (the worker exits) and reap the process
+void PkgWorkers::finishWorker(Worker &worker)
+{
+  ::close(worker.fd);
+
+  int status;
+  while (::waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {}
+
+  y2debug("Worker process %d finished", worker.pid);
+}
+
+void PkgWorkers::killRunning()
+{
+  for (std::vector<Worker>::const_iterator it = _running.begin(); it != _running.end(); ++it)
+  {
+    y2milestone("Killing worker process %d", it->pid);
+    ::kill(it->pid, SIGTERM);
+  }
+
+  for (std::vector<Worker>::iterator it = _running.begin(); it != _running.end(); ++it)
+    finishWorker(*it);
+
+  _running.clear();
+}
+
+bool PkgWorkers::run(const FinishedFnc &finished)
+{
+  unsigned next = 0;
+  bool aborted = false;
+  unsigned workers = std::min<size_t>(_max_jobs, _jobs.size());
+
+  y2milestone("Running %zd jobs in %u worker processes", _jobs.size(), workers);
+
+  // start the workers, each of them gets the first job
+  while (!aborted && _running.size() < workers && next < _jobs.size())
+  {
+    Worker worker;
+
+    if (start(worker))
+    {
+      if (sendJob(worker, next))
+      {
+        _running.push_back(worker);
+        ++next;
+        continue;
+      }
+
+      finishWorker(worker);
+    }
+    // continue with the already started workers
+    else if (!_running.empty())
+    {
+      break;
+    }
+
+    if (finished && !finished(next, JOB_FAILED))
+      aborted = true;
+
+    ++next;
+  }
+
+  while (!aborted && !_running.empty())
+  {
+    std::vector<struct pollfd> fds(_running.size());
+
+    for (unsigned i = 0; i < _running.size(); ++i)
+    {
+      fds[i].fd = _running[i].fd;
+      fds[i].events = POLLIN;
+      fds[i].revents = 0;
+    }
+
+    if (::poll(&fds[0], fds.size(), -1) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      y2error("Cannot wait for the worker processes: %s", ::strerror(errno));
+      aborted = true;
+      break;
+    }
+
+    // backwards, a finished worker is removed from the list
+    for (unsigned i = fds.size(); i-- > 0 && !aborted;)
+    {
+      if (fds[i].revents == 0)
+        continue;
+
+      Worker &worker = _running[i];
+      JobResult result;
+
+      if (!readRecord(worker.fd, &result, sizeof(result)))
+      {
+        int job = worker.job;
+        finishWorker(worker);
+        _running.erase(_running.begin() + i);
+
+        if (job >= 0)
+        {
+          y2error("Worker process for job %d has died", job);
+
+          if (finished && !finished(job, JOB_FAILED))
+            aborted = true;
+        }
+
+        continue;
+      }
+
+      y2debug("Job %u finished with status %d", result.index, result.status);
+      worker.job = -1;
+
+      // keep the worker busy while the result is processed
+      if (next < _jobs.size() && sendJob(worker, next))
+      {
+        ++next;
+      }
+      else
+      {
+        finishWorker(worker);
+        _running.erase(_running.begin() + i);
+      }
+
+      if (finished && !finished(result.index, result.status))
+        aborted = true;
+    }
+  }
+
+  if (aborted)
+  {
+    y2warning("Aborting the remaining jobs");
+
+    std::vector<unsigned> killed;
+    for (std::vector<Worker>::const_iterator it = _running.begin(); it != _running.end(); ++it)
+    {
+      if (it->job >= 0)
+        killed.push_back(it->job);
+    }
+
+    killRunning();
+
+    if (finished)
+    {
+      for (std::vector<unsigned>::const_iterator it = killed.begin(); it != killed.end(); ++it)
+        finished(*it, JOB_ABORTED);
+
+      for (; next < _jobs.size(); ++next)
+        finished(next, JOB_ABORTED);
+    }
+  }
+  // all workers have died
+  else if (finished)
+  {
+    for (; next < _jobs.size(); ++next)
+      finished(next, JOB_FAILED);
+  }
+
+  return !aborted;
+}
@@ -0,0 +1,82 @@
+/*
+ * File:   PkgWorkers.h
+ *
+ * Run independent jobs in forked worker processes with bounded parallelism.
+ *
+ * (Note: libzypp, the media backend and the YCP interpreter are not thread
+ * safe, a forked child gets its own private copy of all that state so
+ * the jobs cannot corrupt the main process. The jobs must not call back
+ * into YCP, the results are passed back only via the job status.
+ *
+ * At most max_jobs worker processes are forked, each of them runs several
+ * jobs one after another. The next job is passed to a worker when it reports
+ * the previous result through its socket, the parent just waits in poll().)
+ */
+
+#ifndef PKGWORKERS_H
+#define PKGWORKERS_H
+
+#include <vector>
+#include <sys/types.h>
+
+#include <boost/function.hpp>
+
+class PkgWorkers {
+
+public:
+  // job exit status values
+  enum JobStatus {
+    JOB_DONE = 0,
+    JOB_SKIPPED = 1,
+    JOB_FAILED = 2,
+    // the job has not been started or it has been killed
+    JOB_ABORTED = 3
+  };
+
+  // the job runs in the child process, returns the JobStatus
+  typedef boost::function<int ()> Job;
+  // called in the parent process for each finished job,
+  // return false to abort the remaining jobs
+  typedef boost::function<bool (unsigned index, int status)> FinishedFnc;
+  // called in the child process before running the job
+  typedef boost::function<void ()> ChildSetupFnc;
+
+  // child_cleanup is called in the child process after its last job
+  PkgWorkers(unsigned max_jobs, const ChildSetupFnc &child_setup = ChildSetupFnc(),
+    const ChildSetupFnc &child_cleanup = ChildSetupFnc());
+
+  // add a job, returns its index
+  unsigned add(const Job &job);
+
+  unsigned size() const { return _jobs.size(); }
+
+  // run all jobs, the finished callback is called in the parent process
+  // in the order the jobs finished, returns false when aborted
+  bool run(const FinishedFnc &finished = FinishedFnc());
+
+  // the default number of jobs (number of online CPUs)
+  static unsigned defaultJobs();
+
+private:
+  struct Worker {
+    pid_t pid;
+    // the job indexes are sent to the worker, the results are read back
+    int fd;
+    // the running job index, -1 = none
+    int job;
+  };
+
+  bool start(Worker &worker);
+  bool sendJob(Worker &worker, unsigned index);
+  void finishWorker(Worker &worker);
+  void workerLoop(int fd);
+  void killRunning();
+
+  unsigned _max_jobs;
+  ChildSetupFnc _child_setup;
+  ChildSetupFnc _child_cleanup;
+  std::vector<Job> _jobs;
+  std::vector<Worker> _running;
+};
+
+#endif	/* PKGWORKERS_H */
@@ -0,0 +1,186 @@
+/*
+ * File:   PoolChanges.cc
+ *
+ * Pool change notification.
+ */
+
+#include <Callbacks.h>
+#include <Callbacks.YCP.h>
+
+#include <PkgFunctions.h>
+#include "log.h"
+
+#include <ycp/YCPInteger.h>
+#include <ycp/YCPBoolean.h>
+
+#include <map>
+
+/*
+ * The builtins which change the pool state (resolvable status, solver
+ * settings, locks...), libzypp does not report these changes. The loaded
+ * and removed repositories and the target are also detected by the pool
+ * serial number, see PoolChangesLeave(). The table drives the CB_PoolChanged
+ * callback and PoolGeneration() (a missing builtin is not reported) and
+ * LazySafeBuiltins() (a selection changing builtin never skips the lazy load,
+ * see testsuite/lazy_load_test.cc).
+ */
+unsigned PkgFunctions::PoolChangesOf(const std::string &builtin)
+{
+    static const struct
+    {
+	const char *builtin;
+	unsigned changes;
+    } pool_changing_builtins[] = {
+	// selection
+	{ "PkgInstall", POOL_CHANGED_SELECTION }, { "PkgSrcInstall", POOL_CHANGED_SELECTION },
+	{ "PkgDelete", POOL_CHANGED_SELECTION }, { "PkgTaboo", POOL_CHANGED_SELECTION },
+	{ "PkgNeutral", POOL_CHANGED_SELECTION }, { "PkgReset", POOL_CHANGED_SELECTION },
+	{ "PkgApplReset", POOL_CHANGED_SELECTION }, { "PkgMarkLicenseConfirmed", POOL_CHANGED_SELECTION },
+	{ "DoProvide", POOL_CHANGED_SELECTION }, { "DoRemove", POOL_CHANGED_SELECTION },
+	{ "TargetInstall", POOL_CHANGED_SELECTION }, { "TargetRemove", POOL_CHANGED_SELECTION },
+	{ "RestoreState", POOL_CHANGED_SELECTION }, { "StateRollback", POOL_CHANGED_SELECTION },
+	{ "ResolvableInstall", POOL_CHANGED_SELECTION }, { "ResolvableInstallArchVersion", POOL_CHANGED_SELECTION },
+	{ "ResolvableInstallRepo", POOL_CHANGED_SELECTION }, { "ResolvableUpdate", POOL_CHANGED_SELECTION },
+	{ "ResolvableRemove", POOL_CHANGED_SELECTION }, { "ResolvableNeutral", POOL_CHANGED_SELECTION },
+	{ "ResolvableSetSoftLock", POOL_CHANGED_SELECTION }, { "ResolvableTransact", POOL_CHANGED_SELECTION },
+	{ "ResolvablePreselectPatches", POOL_CHANGED_SELECTION }, { "ResolvableSetPatches", POOL_CHANGED_SELECTION },
+	// solver
+	{ "PkgSolve", POOL_CHANGED_SOLVER }, { "PkgSolveCheckTargetOnly", POOL_CHANGED_SOLVER },
+	{ "PkgUpdateAll", POOL_CHANGED_SELECTION | POOL_CHANGED_SOLVER },
+	{ "SetSolverFlags", POOL_CHANGED_SOLVER }, { "SetArchitecture", POOL_CHANGED_SOLVER },
+	{ "AddUpgradeRepo", POOL_CHANGED_SOLVER }, { "RemoveUpgradeRepo", POOL_CHANGED_SOLVER },
+	{ "SetUpgradeRepos", POOL_CHANGED_SOLVER },
+	// repositories
+	{ "SourceStartManager", POOL_CHANGED_REPOS }, { "SourceStartCache", POOL_CHANGED_REPOS },
+	{ "SourceRestore", POOL_CHANGED_REPOS }, { "SourceLoad", POOL_CHANGED_REPOS },
+	{ "SourceCreate", POOL_CHANGED_REPOS }, { "SourceCreateBase", POOL_CHANGED_REPOS },
+	{ "SourceCreateEx", POOL_CHANGED_REPOS }, { "SourceCreateType", POOL_CHANGED_REPOS },
+	{ "RepositoryAdd", POOL_CHANGED_REPOS }, { "SourceDelete", POOL_CHANGED_REPOS },
+	{ "SourceSetEnabled", POOL_CHANGED_REPOS }, { "SourceChangeUrl", POOL_CHANGED_REPOS },
+	{ "SourceReleaseAll", POOL_CHANGED_REPOS }, { "SourceFinishAll", POOL_CHANGED_REPOS },
+	{ "SourceSetPriority", POOL_CHANGED_REPOS }, { "SourceRaisePriority", POOL_CHANGED_REPOS },
+	{ "SourceLowerPriority", POOL_CHANGED_REPOS }, { "SourceEditSet", POOL_CHANGED_REPOS },
+	{ "SourceRefreshNow", POOL_CHANGED_REPOS }, { "SourceForceRefreshNow", POOL_CHANGED_REPOS },
+	{ "ServiceRefresh", POOL_CHANGED_REPOS }, { "ServiceForceRefresh", POOL_CHANGED_REPOS },
+	{ "ServiceRefreshAll", POOL_CHANGED_REPOS }, { "ServiceDelete", POOL_CHANGED_REPOS },
+	{ "ServiceSet", POOL_CHANGED_REPOS },
+	// target
+	{ "TargetInit", POOL_CHANGED_TARGET }, { "TargetRebuildInit", POOL_CHANGED_TARGET },
+	{ "TargetInitialize", POOL_CHANGED_TARGET }, { "TargetInitializeOptions", POOL_CHANGED_TARGET },
+	{ "TargetLoad", POOL_CHANGED_TARGET }, { "TargetFinish", POOL_CHANGED_TARGET },
+	{ "TargetRebuildDB", POOL_CHANGED_TARGET }, { "TargetInitDU", POOL_CHANGED_TARGET },
+	{ "PkgCommit", POOL_CHANGED_SELECTION | POOL_CHANGED_TARGET },
+	{ "Commit", POOL_CHANGED_SELECTION | POOL_CHANGED_TARGET },
+	// locks
+	{ "AddLock", POOL_CHANGED_SELECTION | POOL_CHANGED_LOCKS },
+	{ "AddLocks", POOL_CHANGED_SELECTION | POOL_CHANGED_LOCKS },
+	{ "RemoveLock", POOL_CHANGED_SELECTION | POOL_CHANGED_LOCKS },
+	{ "RemoveLocks", POOL_CHANGED_SELECTION | POOL_CHANGED_LOCKS },
+	// locales
+	{ "SetAdditionalLocales", POOL_CHANGED_LOCALES }, { "SetPackageLocale", POOL_CHANGED_LOCALES },
+	// everything
+	{ "PoolSnapshotLoad", POOL_CHANGED_REPOS | POOL_CHANGED_SOLVER | POOL_CHANGED_TARGET
+	    | POOL_CHANGED_LOCKS | POOL_CHANGED_LOCALES }
+    };
+
+    static std::map<std::string, unsigned> table;
+
+    if (table.empty())
+    {
+	for (unsigned i = 0; i < sizeof(pool_changing_builtins) / sizeof(pool_changing_builtins[0]); ++i)
+	{
+	    table[pool_changing_builtins[i].builtin] = pool_changing_builtins[i].changes;
+	}
+    }
+
+    std::map<std::string, unsigned>::const_iterator it = table.find(builtin);
+    return it == table.end() ? 0 : it->second;
+}
+
+void PkgFunctions::PoolChangesLeave(const std::string &builtin, const YCPValue &ret)
+{
+    if (pool_changes_depth > 0)
+	--pool_changes_depth;
+
+    unsigned changes = PoolChangesOf(builtin);
+
+    // a failed request (e.g. an unknown package) has not changed anything,
+    // a failed solver run has new results (the problems)
+    if (changes != 0 && ((changes & POOL_CHANGED_SOLVER) || ret.isNull() || !ret->isBoolean()
+	|| ret->asBoolean()->value()))
+    {
+	pool_changes |= changes;
+    }
+
+    // do not connect to libzypp only because of the check
+    if (zypp_pointer != NULL)
+    {
+	unsigned serial = zypp_pointer->pool().serial().serial();
+
+	if (serial != pool_changes_serial)
+	{
+	    pool_changes |= POOL_CHANGED_REPOS;
+	    pool_changes_serial = serial;
+	}
+    }
+
+    // report the whole batch after the outermost call, the changes done
+    // by the callback itself are reported after the next call
+    if (pool_changes == 0 || pool_changes_depth > 0 || pool_changes_notifying)
+	return;
+
+    unsigned reported = pool_changes;
+    pool_changes = 0;
+    ++pool_generation;
+
+    y2debug("Pool changed by Pkg::%s: generation %lld, changes %u", builtin.c_str(), pool_generation, reported);
+
+    CallPoolChanged(reported);
+}
+
+void PkgFunctions::CallPoolChanged(unsigned changes)
+{
+    Y2Function* ycp_handler = _callbackHandler._ycpCallbacks.createCallback(CallbackHandler::YCPCallbacks::CB_PoolChanged);
+    CallbackHandler::YCPCallbacks::Release ycp_handler_release(_callbackHandler._ycpCallbacks, CallbackHandler::YCPCallbacks::CB_PoolChanged, ycp_handler);
+
+    // is the callback registered?
+    if (ycp_handler != NULL)
+    {
+	pool_changes_notifying = true;
+
+	try
+	{
+	    ycp_handler->appendParameter(YCPInteger(pool_generation));
+	    ycp_handler->appendParameter(YCPInteger(changes));
+	    ycp_handler->evaluateCall();
+	}
+	catch (...)
+	{
+	    pool_changes_notifying = false;
+	    throw;
+	}
+
+	pool_changes_notifying = false;
+    }
+}
+
+/****************************************************************************************
+ * @builtin PoolGeneration
+ *
+ * @short Get the pool generation number
+ * @description
+ * The number is increased after each builtin call which has changed the pool state,
+ * a client can remember it and skip recomputing its data (disk usage, media sizes,
+ * package lists...) if it has not been changed. The changes can also be reported
+ * by a callback, see CallbackPoolChanged(), the reported kinds are:
+ * 1 = resolvable selection, 2 = solver (PkgSolve(), the solver settings, the upgrade
+ * repositories), 4 = repositories (loaded, removed, changed priority),
+ * 8 = target (initialized, released, committed), 16 = locks, 32 = requested locales.
+ *
+ * @return integer the current generation number
+ **/
+YCPValue
+PkgFunctions::PoolGeneration()
+{
+    return YCPInteger(pool_generation);
+}
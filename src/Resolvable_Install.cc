@@ -27,12 +27,15 @@
 
 #include "PkgFunctions.h"
 #include "log.h"
+#include "ycpTools.h"
 
 #include <ycp/YCPVoid.h>
 #include <ycp/YCPBoolean.h>
 #include <ycp/YCPSymbol.h>
 #include <ycp/YCPString.h>
 #include <ycp/YCPInteger.h>
+#include <ycp/YCPList.h>
+#include <ycp/YCPMap.h>
 
 /**
    @builtin ResolvableInstallArchVersion
@@ -522,3 +525,204 @@ PkgFunctions::ResolvableSetSoftLock ( const YCPString& name_r, const YCPSymbol&
     return YCPBoolean(ret);
 }
 
+// a helper function - read an optional string value from a job map,
+// returns false if the value is not a string
+static bool jobString(const YCPMap &job, const char *key, std::string &value)
+{
+    YCPValue val = job->value(YCPString(key));
+
+    if (val.isNull())
+	return true;
+
+    if (!val->isString())
+	return false;
+
+    value = val->asString()->value();
+    return true;
+}
+
+// a helper function - read an optional symbol value from a job map,
+// returns false if the value is not a symbol
+static bool jobSymbol(const YCPMap &job, const char *key, std::string &value)
+{
+    YCPValue val = job->value(YCPString(key));
+
+    if (val.isNull())
+	return true;
+
+    if (!val->isSymbol())
+	return false;
+
+    value = val->asSymbol()->symbol();
+    return true;
+}
+
+/**
+   @builtin ResolvableTransact
+   @short Install, update, remove or reset many resolvables at once
+   @description
+   Applies all jobs in one call, the problems are logged only once at the end.
+   A job is a map:
+
+   <code>
+   $[ "name" : string (required),
+      "kind" : symbol (`package (default), `patch, `pattern, `product or `srcpackage),
+      "action" : symbol (`install (default), `update, `remove or `neutral),
+      "arch" : string, "version" : string, "repo" : integer (optional, only for `install,
+        the available resolvable matching all the values is installed) ]
+   </code>
+
+   The result for each job (in the same order):
+   `ok - the status has been changed, `not_found - the resolvable or the required
+   version was not found, `failed - the status cannot be changed (e.g. it is locked),
+   `invalid - invalid job definition
+
+   @param list<map> jobs the jobs
+   @return list<symbol> result of each job, nil if the argument is not a list
+   @usage Pkg::ResolvableTransact([$["name":"foo"], $["name":"bar", "action":`remove],
+     $["name":"base", "kind":`pattern]]) -> [`ok, `ok, `not_found]
+*/
+YCPValue
+PkgFunctions::ResolvableTransact( const YCPList& jobs )
+{
+    if (jobs.isNull())
+    {
+	y2error("ResolvableTransact: nil parameter");
+	return YCPVoid();
+    }
+
+    YCPList ret;
+    std::map<std::string, unsigned> results;
+    // the already resolved repositories (ID => alias)
+    std::map<long long, std::string> repo_aliases;
+
+    for (int i = 0; i < jobs->size(); ++i)
+    {
+	std::string result("invalid");
+
+	try
+	{
+	    if (!jobs->value(i)->isMap())
+	    {
+		y2error("ResolvableTransact: job %d is not a map: %s", i, jobs->value(i)->toString().c_str());
+		ret->add(YCPSymbol(result));
+		++results[result];
+		continue;
+	    }
+
+	    YCPMap job(jobs->value(i)->asMap());
+
+	    std::string name;
+	    std::string req_kind("package");
+	    std::string action("install");
+	    std::string arch;
+	    std::string version;
+	    std::string alias;
+	    zypp::Resolvable::Kind kind;
+
+	    bool valid = jobString(job, "name", name) && !name.empty()
+		&& jobSymbol(job, "kind", req_kind) && asResKind(req_kind, kind)
+		&& jobSymbol(job, "action", action)
+		&& (action == "install" || action == "update" || action == "remove" || action == "neutral")
+		&& jobString(job, "arch", arch) && jobString(job, "version", version);
+
+	    YCPValue repo_val = job->value(YCPString("repo"));
+	    if (valid && !repo_val.isNull())
+	    {
+		if (repo_val->isInteger())
+		{
+		    long long repo_id = repo_val->asInteger()->value();
+		    std::map<long long, std::string>::const_iterator known = repo_aliases.find(repo_id);
+
+		    if (known == repo_aliases.end())
+		    {
+			YRepo_Ptr repo = logFindRepository(repo_id);
+			known = repo_aliases.insert(std::make_pair(repo_id, repo ? repo->repoInfo().alias() : std::string())).first;
+		    }
+
+		    alias = known->second;
+		    valid = !alias.empty();
+		}
+		else
+		{
+		    valid = false;
+		}
+	    }
+
+	    // the arch, version and repo are supported only for installing
+	    if (valid && action != "install" && (!arch.empty() || !version.empty() || !alias.empty()))
+		valid = false;
+
+	    if (!valid)
+	    {
+		y2error("ResolvableTransact: invalid job %d: %s", i, job->toString().c_str());
+	    }
+	    else
+	    {
+		zypp::ui::Selectable::Ptr s = zypp::ui::Selectable::get(kind, name);
+
+		if (!s)
+		{
+		    result = "not_found";
+		}
+		else if (action == "install")
+		{
+		    if (arch.empty() && version.empty() && alias.empty())
+		    {
+			result = s->setToInstall(whoWantsIt) ? "ok" : "failed";
+		    }
+		    else
+		    {
+			zypp::Arch architecture(arch);
+			result = "not_found";
+
+			for_(avail_it, s->availableBegin(), s->availableEnd())
+			{
+			    zypp::ResObject::constPtr res = *avail_it;
+
+			    if ((arch.empty() || res->arch() == architecture)
+				&& (version.empty() || res->edition() == version)
+				&& (alias.empty() || res->repoInfo().alias() == alias))
+			    {
+				s->setCandidate(*avail_it);
+				result = s->setToInstall(whoWantsIt) ? "ok" : "failed";
+				break;
+			    }
+			}
+		    }
+		}
+		else if (action == "update")
+		{
+		    result = ResolvableUpdateInstallOrDelete(YCPString(name), YCPSymbol(req_kind), Update) ? "ok" : "failed";
+		}
+		else if (action == "remove")
+		{
+		    result = s->setToDelete(whoWantsIt) ? "ok" : "failed";
+		}
+		else
+		{
+		    result = s->unset(whoWantsIt) ? "ok" : "failed";
+		}
+
+		if (result != "ok")
+		{
+		    y2warning("ResolvableTransact: %s %s:%s: %s", action.c_str(), req_kind.c_str(), name.c_str(), result.c_str());
+		}
+	    }
+	}
+	catch (const zypp::Exception& excpt)
+	{
+	    y2error("ResolvableTransact: job %d failed: %s", i, excpt.asString().c_str());
+	    _last_error.setLastError(ExceptionAsString(excpt));
+	    result = "failed";
+	}
+
+	ret->add(YCPSymbol(result));
+	++results[result];
+    }
+
+    y2milestone("ResolvableTransact: %d jobs, ok: %u, not found: %u, failed: %u, invalid: %u", jobs->size(),
+	results["ok"], results["not_found"], results["failed"], results["invalid"]);
+
+    return ret;
+}
@@ -70,6 +70,61 @@ PkgFunctions::ResolvablePreselectPatches (const YCPSymbol& kind_r)
     return ResolvableSetPatches(kind_r, true);
 }
 
+// group the non-optional patches by the flags, the flags and the category
+// do not change until the pool is changed
+void PkgFunctions::BuildPatchIndex()
+{
+    unsigned serial = zypp_ptr()->pool().serial().serial();
+
+    if (patch_index.valid && patch_index.pool_serial == serial)
+	return;
+
+    long long start = PkgProfiler::now();
+
+    patch_index.buckets.clear();
+    patch_index.optional = 0;
+
+    // access to the Pool of Selectables
+    zypp::ResPoolProxy selectablePool(zypp::ResPool::instance().proxy());
+
+    for_(it, selectablePool.byKindBegin<zypp::Patch>(), selectablePool.byKindEnd<zypp::Patch>())
+    {
+	zypp::ui::Selectable::Ptr s = *it;
+
+	if (!s || !s->candidateObj())
+	    continue;
+
+	zypp::Patch::constPtr patch = zypp::asKind<zypp::Patch>(s->candidateObj().resolvable());
+
+	if (!patch)
+	    continue;
+
+	// dont auto-install optional patches
+	if (patch->category() == "optional")
+	{
+	    patch_index.optional++;
+	    continue;
+	}
+
+	patch_index.buckets["all"].push_back(s);
+
+	if (patch->interactive())
+	    patch_index.buckets["interactive"].push_back(s);
+	if (patch->restartSuggested())
+	    patch_index.buckets["affects_pkg_manager"].push_back(s);
+	if (patch->rebootSuggested())
+	    patch_index.buckets["reboot_needed"].push_back(s);
+	if (patch->reloginSuggested())
+	    patch_index.buckets["relogin_needed"].push_back(s);
+    }
+
+    patch_index.valid = true;
+    patch_index.pool_serial = serial;
+
+    y2milestone("Patch index: %zd patches, %u optional (%lldms)", patch_index.buckets["all"].size(),
+	patch_index.optional, (PkgProfiler::now() - start) / 1000);
+}
+
 // helper function
 YCPValue
 PkgFunctions::ResolvableSetPatches (const YCPSymbol& kind_r, bool preselect)
@@ -82,53 +137,28 @@ PkgFunctions::ResolvableSetPatches (const YCPSymbol& kind_r, bool preselect)
 	return YCPError("Pkg::ResolvablePreselectPatches: Wrong parameter '" + kind + "', use: `all, `interactive, `reboot_needed, `relogin_needed or `affects_pkg_manager", YCPInteger(0LL));
     }
 
-    y2milestone("Required kind of patches: %s", kind.c_str());
-
     long long needed_patches = 0LL;
 
     try
     {
-	// access to the Pool of Selectables
-	zypp::ResPoolProxy selectablePool(zypp::ResPool::instance().proxy());
-	      
-	// Iterate it's Products...
-	for_(it, selectablePool.byKindBegin<zypp::Patch>(), selectablePool.byKindEnd<zypp::Patch>())
+	BuildPatchIndex();
+
+	const std::vector<zypp::ui::Selectable::Ptr> &patches = patch_index.buckets[kind];
+
+	// the needed status depends on the current pool state, check it now
+	for_(it, patches.begin(), patches.end())
 	{
-	    y2milestone("Procesing patch %s", (*it)->name().c_str());
-	    zypp::ui::Selectable::Ptr s = *it;
+	    const zypp::ui::Selectable::Ptr &s = *it;
 
-	    if (s && s->isNeeded() && !s->isUnwanted())
+	    if (s->isNeeded() && !s->isUnwanted())
 	    {
-		zypp::Patch::constPtr patch = zypp::asKind<zypp::Patch>
-		    (s->candidateObj().resolvable());
-
-		// dont auto-install optional patches
-		if (patch->category() != "optional")
-		{
-		    if (kind == "all"
-			|| (kind == "interactive" && patch->interactive())
-			|| (kind == "affects_pkg_manager" && patch->restartSuggested())
-			|| (kind == "reboot_needed" && patch->rebootSuggested())
-			|| (kind == "relogin_needed" && patch->reloginSuggested())
-		    )
-		    {
-			if (preselect)
-			{
-			    s->setToInstall(whoWantsIt);
-			}
-
-			// count the patch
-			needed_patches++;
-		    }
-		    else
-		    {
-			y2milestone("Patch %s has not required flag", s->name().c_str());
-		    }
-		}
-		else
+		if (preselect)
 		{
-		    y2milestone("Ignoring optional patch : %s", s->name().c_str());
+		    s->setToInstall(whoWantsIt);
 		}
+
+		// count the patch
+		needed_patches++;
 	    }
 	}
     }
@@ -137,6 +167,7 @@ PkgFunctions::ResolvableSetPatches (const YCPSymbol& kind_r, bool preselect)
 	y2error("An error occurred during patch selection.");
     }
 
+    y2milestone("Needed patches (%s): %lld", kind.c_str(), needed_patches);
+
     return YCPInteger(needed_patches);
 }
-
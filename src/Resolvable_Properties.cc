@@ -46,9 +46,42 @@
 
 #include <zypp/Dep.h>
 #include <zypp/sat/LocaleSupport.h>
+#include <zypp/sat/Pool.h>
 #include <zypp/parser/ProductFileReader.h>
 #include <zypp/base/Regex.h>
 
+// is the key requested? (an empty set means all keys)
+static bool wanted(const std::set<std::string> &keys, const char *key)
+{
+    return keys.empty() || keys.find(key) != keys.end();
+}
+
+// convert the list of requested keys
+static std::set<std::string> wantedKeys(const YCPList &keys, const char *fnc)
+{
+    std::set<std::string> ret;
+
+    for (int i = 0; i < keys->size(); ++i)
+    {
+	if (keys->value(i)->isString())
+	{
+	    ret.insert(keys->value(i)->asString()->value());
+	}
+	else
+	{
+	    y2error("Pkg::%s: ignoring non-string key: %s", fnc, keys->value(i)->toString().c_str());
+	}
+    }
+
+    return ret;
+}
+
+// are the dependencies requested?
+static bool wantedDependencies(const std::set<std::string> &keys)
+{
+    return keys.find("dependencies") != keys.end() || keys.find("deps") != keys.end();
+}
+
 /**
    @builtin ResolvableProperties
 
@@ -169,6 +202,37 @@ PkgFunctions::ResolvableDependencies(const YCPString& name, const YCPSymbol& kin
     return ResolvablePropertiesEx (name, kind_r, version, true);
 }
 
+/**
+   @builtin ResolvablePropertiesKeys
+
+   @short Return only the requested properties of resolvables
+   @description
+   Same as ResolvableProperties but only the requested keys are computed
+   and returned, the other properties are skipped. This is much faster
+   and needs less memory when only few properties are needed for a large
+   number of resolvables. (E.g. the product file is read only when
+   "product_file", "product_package" or "upgrades" key is requested.)
+
+   The dependencies are evaluated if "dependencies" or "deps" key is requested.
+
+   @param name name of the resolvable, if empty returns all resolvables of the kind
+   @param kind_r kind of resolvable, can be `product, `patch, `package, `pattern or `language
+   @param version version of the resolvable, if empty all versions are returned
+   @param keys list of the requested keys, if empty all keys are returned (without the dependencies)
+   @return list<map<string,any>> list of resolvable properties, nil on error
+
+   @see ResolvableProperties for the list of supported keys
+
+   @usage Pkg::ResolvablePropertiesKeys("", `package, "", ["name", "version", "status"]);
+*/
+YCPValue
+PkgFunctions::ResolvablePropertiesKeys(const YCPString& name, const YCPSymbol& kind_r, const YCPString& version, const YCPList& keys)
+{
+    std::set<std::string> wanted_keys(wantedKeys(keys, "ResolvablePropertiesKeys"));
+
+    return ResolvablePropertiesEx (name, kind_r, version, wantedDependencies(wanted_keys), wanted_keys);
+}
+
 std::string TransactToString(zypp::ResStatus::TransactByValue trans)
 {
     std::string ret;
@@ -184,103 +248,137 @@ std::string TransactToString(zypp::ResStatus::TransactByValue trans)
     return ret;
 }
 
-YCPMap PkgFunctions::Resolvable2YCPMap(const zypp::PoolItem &item, const std::string &req_kind, bool dependencies)
+YCPMap PkgFunctions::Resolvable2YCPMap(const zypp::PoolItem &item, const std::string &req_kind, bool dependencies,
+    const std::set<std::string> &keys)
 {
     YCPMap info;
 
-    info->add(YCPString("name"), YCPString(item->name()));
+    // the ident of a package is the name, the other kinds have a "kind:" prefix
+    if (wanted(keys, "name"))
+	info->add(YCPKey::name, item->isKind<zypp::Package>() ? asYCPString(item->ident()) : YCPString(item->name()));
+
     // complete edition: [epoch:]version[-release]
-    info->add(YCPString("version"), YCPString(item->edition().asString()));
+    if (wanted(keys, "version"))
+	info->add(YCPKey::version, asYCPString(item->edition().idStr()));
 
     // parts of the edition
-    if (item->edition().epoch() == zypp::Edition::noepoch)
-        info->add(YCPString("version_epoch"), YCPVoid());
-    else
-        info->add(YCPString("version_epoch"), YCPInteger(item->edition().epoch()));
-    info->add(YCPString("version_version"), YCPString(item->edition().version()));
-    info->add(YCPString("version_release"), YCPString(item->edition().release()));
+    if (wanted(keys, "version_epoch"))
+    {
+	if (item->edition().epoch() == zypp::Edition::noepoch)
+	    info->add(YCPKey::version_epoch, YCPVoid());
+	else
+	    info->add(YCPKey::version_epoch, YCPInteger(item->edition().epoch()));
+    }
+    if (wanted(keys, "version_version"))
+	info->add(YCPKey::version_version, YCPString(item->edition().version()));
+    if (wanted(keys, "version_release"))
+	info->add(YCPKey::version_release, YCPString(item->edition().release()));
 
-    info->add(YCPString("arch"), YCPString(item->arch().asString()));
-    info->add(YCPString("description"), YCPString(item->description()));
+    if (wanted(keys, "arch"))
+	info->add(YCPKey::arch, asYCPString(item->arch().idStr()));
+    if (wanted(keys, "description"))
+	info->add(YCPKey::description, YCPString(item->description()));
 
-    std::string resolvable_summary = item->summary();
-    if (resolvable_summary.size() > 0)
+    if (wanted(keys, "summary"))
     {
-	info->add(YCPString("summary"), YCPString(resolvable_summary));
+	std::string resolvable_summary = item->summary();
+	if (resolvable_summary.size() > 0)
+	{
+	    info->add(YCPKey::summary, YCPString(resolvable_summary));
+	}
     }
 
-    // status
-    std::string stat;
-
     zypp::ResStatus status = item.status();
 
-    if (status.isToBeInstalled())
-    {
-	stat = "selected";
-    }
-    else if (status.isInstalled() || status.isSatisfied())
+    // status
+    if (wanted(keys, "status"))
     {
-	if (status.isToBeUninstalled())
+	std::string stat;
+
+	if (status.isToBeInstalled())
+	{
+	    stat = "selected";
+	}
+	else if (status.isInstalled() || status.isSatisfied())
 	{
-	    stat = "removed";
+	    if (status.isToBeUninstalled())
+	    {
+		stat = "removed";
+	    }
+	    else
+	    {
+		stat = "installed";
+	    }
 	}
 	else
 	{
-	    stat = "installed";
+	    stat = "available";
 	}
-    }
-    else
-    {
-	stat = "available";
-    }
 
-    info->add(YCPString("transact_by"), YCPSymbol(TransactToString(status.getTransactByValue())));
+	info->add(YCPKey::status, YCPSymbol(stat));
+    }
 
-    info->add(YCPString("on_system_by_user"), YCPBoolean(item.satSolvable().onSystemByUser()));
+    if (wanted(keys, "transact_by"))
+	info->add(YCPKey::transact_by, YCPSymbol(TransactToString(status.getTransactByValue())));
 
-    info->add(YCPString("status"), YCPSymbol(stat));
+    if (wanted(keys, "on_system_by_user"))
+	info->add(YCPKey::on_system_by_user, YCPBoolean(item.satSolvable().onSystemByUser()));
 
     // is the resolvable locked? (Locked or Taboo in the UI)
-    info->add(YCPString("locked"), YCPBoolean(status.isLocked()));
+    if (wanted(keys, "locked"))
+	info->add(YCPKey::locked, YCPBoolean(status.isLocked()));
 
     // source
-    info->add(YCPString("source"), YCPInteger(logFindAlias(item->repoInfo().alias())));
+    if (wanted(keys, "source"))
+	info->add(YCPKey::source, YCPInteger(PoolRepoId(item.satSolvable().repository())));
 
     // add license info if it is defined
-    std::string license = item->licenseToConfirm();
-    if (!license.empty())
+    if (wanted(keys, "license") || wanted(keys, "license_confirmed"))
     {
-	info->add(YCPString("license_confirmed"), YCPBoolean(item.status().isLicenceConfirmed()));
-	info->add(YCPString("license"), YCPString(license));
+	std::string license = item->licenseToConfirm();
+	if (!license.empty())
+	{
+	    if (wanted(keys, "license_confirmed"))
+		info->add(YCPKey::license_confirmed, YCPBoolean(item.status().isLicenceConfirmed()));
+	    if (wanted(keys, "license"))
+		info->add(YCPKey::license, YCPString(license));
+	}
     }
 
-    info->add(YCPString("download_size"), YCPInteger(item->downloadSize()));
-    info->add(YCPString("inst_size"), YCPInteger(item->installSize()));
+    if (wanted(keys, "download_size"))
+	info->add(YCPKey::download_size, YCPInteger(item->downloadSize()));
+    if (wanted(keys, "inst_size"))
+	info->add(YCPKey::inst_size, YCPInteger(item->installSize()));
 
-    info->add(YCPString("medium_nr"), YCPInteger(item->mediaNr()));
-    info->add(YCPString("vendor"), YCPString(item->vendor()));
+    if (wanted(keys, "medium_nr"))
+	info->add(YCPKey::medium_nr, YCPInteger(item->mediaNr()));
+    if (wanted(keys, "vendor"))
+	info->add(YCPKey::vendor, asYCPString(item.satSolvable().vendor()));
 
 
     // package specific info
     if( req_kind == "package" )
     {
-	zypp::Package::constPtr pkg = zypp::asKind<zypp::Package>(item.resolvable());
-	if ( pkg )
+	if (wanted(keys, "path") || wanted(keys, "location"))
 	{
-	    std::string tmp = pkg->location().filename().asString();
-	    if (!tmp.empty())
+	    zypp::Package::constPtr pkg = zypp::asKind<zypp::Package>(item.resolvable());
+	    if ( pkg )
 	    {
-		info->add(YCPString("path"), YCPString(tmp));
-	    }
+		std::string tmp = pkg->location().filename().asString();
+		if (!tmp.empty() && wanted(keys, "path"))
+		{
+		    info->add(YCPKey::path, YCPString(tmp));
+		}
 
-	    tmp = pkg->location().filename().basename();
-	    if (!tmp.empty())
+		tmp = pkg->location().filename().basename();
+		if (!tmp.empty() && wanted(keys, "location"))
+		{
+		    info->add(YCPKey::location, YCPString(tmp));
+		}
+	    } else
 	    {
-		info->add(YCPString("location"), YCPString(tmp));
+		y2error("package %s is not a package", item->name().c_str() );
 	    }
-	} else
-	{
-	    y2error("package %s is not a package", item->name().c_str() );
 	}
     }
     else if( req_kind == "srcpackage" )
@@ -289,18 +387,19 @@ YCPMap PkgFunctions::Resolvable2YCPMap(const zypp::PoolItem &item, const std::st
 	if (pkg)
 	{
 	    std::string tmp(pkg->location().filename().asString());
-	    if (!tmp.empty())
+	    if (!tmp.empty() && wanted(keys, "path"))
 	    {
-		info->add(YCPString("path"), YCPString(tmp));
+		info->add(YCPKey::path, YCPString(tmp));
 	    }
 
 	    tmp = pkg->location().filename().basename();
-	    if (!tmp.empty())
+	    if (!tmp.empty() && wanted(keys, "location"))
 	    {
-		info->add(YCPString("location"), YCPString(tmp));
+		info->add(YCPKey::location, YCPString(tmp));
 	    }
 
-	    info->add(YCPString("src_type"), YCPString(pkg->sourcePkgType()));
+	    if (wanted(keys, "src_type"))
+		info->add(YCPKey::src_type, YCPString(pkg->sourcePkgType()));
 	}
 	else
 	{
@@ -318,85 +417,124 @@ YCPMap PkgFunctions::Resolvable2YCPMap(const zypp::PoolItem &item, const std::st
 
 	std::string category(product->isTargetDistribution() ? "base" : "addon");
 
-	info->add(YCPString("category"), YCPString(category));
-	info->add(YCPString("type"), YCPString(category));
-	info->add(YCPString("relnotes_url"), YCPString(product->releaseNotesUrls().first().asString()));
+	if (wanted(keys, "category"))
+	    info->add(YCPKey::category, YCPString(category));
+	if (wanted(keys, "type"))
+	    info->add(YCPKey::type, YCPString(category));
+	if (wanted(keys, "relnotes_url"))
+	    info->add(YCPKey::relnotes_url, YCPString(product->releaseNotesUrls().first().asString()));
 
-	std::string product_summary = product->summary();
-	if (product_summary.size() > 0)
+	if (wanted(keys, "display_name") || wanted(keys, "short_name"))
 	{
-	    info->add(YCPString("display_name"), YCPString(product_summary));
+	    std::string product_summary = product->summary();
+	    if (product_summary.size() > 0 && wanted(keys, "display_name"))
+	    {
+		info->add(YCPKey::display_name, YCPString(product_summary));
+	    }
+
+	    if (wanted(keys, "short_name"))
+	    {
+		std::string product_shortname = product->shortName();
+		if (product_shortname.size() > 0)
+		{
+		    info->add(YCPKey::short_name, YCPString(product_shortname));
+		}
+		// use summary for the short name if it's defined
+		else if (product_summary.size() > 0)
+		{
+		    info->add(YCPKey::short_name, YCPString(product_summary));
+		}
+	    }
 	}
 
-	std::string product_shortname = product->shortName();
-	if (product_shortname.size() > 0)
+	if (wanted(keys, "eol"))
 	{
-	    info->add(YCPString("short_name"), YCPString(product_shortname));
+	    zypp::Date eol = product->endOfLife();
+	    if (eol > 0)
+	    {
+		info->add(YCPKey::eol, YCPInteger(eol));
+	    }
 	}
-	// use summary for the short name if it's defined
-	else if (product_summary.size() > 0)
+
+	if (wanted(keys, "update_urls"))
 	{
-	    info->add(YCPString("short_name"), YCPString(product_summary));
+	    YCPList updateUrls(asYCPList(product->updateUrls()));
+	    info->add(YCPKey::update_urls, updateUrls);
 	}
 
-        zypp::Date eol = product->endOfLife();
-        if (eol > 0)
-        {
-          info->add(YCPString("eol"), YCPInteger(eol));
-        }
-
-	YCPList updateUrls(asYCPList(product->updateUrls()));
-	info->add(YCPString("update_urls"), updateUrls);
-
-	YCPList flags;
-	std::list<std::string> pflags = product->flags();
-	for (std::list<std::string>::const_iterator flag_it = pflags.begin();
-	    flag_it != pflags.end(); ++flag_it)
+	if (wanted(keys, "flags"))
 	{
-	    flags->add(YCPString(*flag_it));
+	    YCPList flags;
+	    std::list<std::string> pflags = product->flags();
+	    for (std::list<std::string>::const_iterator flag_it = pflags.begin();
+		flag_it != pflags.end(); ++flag_it)
+	    {
+		flags->add(YCPString(*flag_it));
+	    }
+	    info->add(YCPKey::flags, flags);
 	}
-	info->add(YCPString("flags"), flags);
 
-	YCPList extraUrls( asYCPList(product->extraUrls()) );
-	if ( extraUrls.size() )
+	if (wanted(keys, "extra_urls"))
 	{
-	  info->add(YCPString("extra_urls"), extraUrls);
+	    YCPList extraUrls( asYCPList(product->extraUrls()) );
+	    if ( extraUrls.size() )
+	    {
+	      info->add(YCPKey::extra_urls, extraUrls);
+	    }
 	}
 
-	YCPList optionalUrls( asYCPList(product->optionalUrls()) );
-	if ( optionalUrls.size() )
+	if (wanted(keys, "optional_urls"))
 	{
-	  info->add(YCPString("optional_urls"), optionalUrls);
+	    YCPList optionalUrls( asYCPList(product->optionalUrls()) );
+	    if ( optionalUrls.size() )
+	    {
+	      info->add(YCPKey::optional_urls, optionalUrls);
+	    }
 	}
 
-	YCPList registerUrls( asYCPList(product->registerUrls()) );
-	if ( registerUrls.size() )
+	if (wanted(keys, "register_urls"))
 	{
-	  info->add(YCPString("register_urls"), registerUrls);
+	    YCPList registerUrls( asYCPList(product->registerUrls()) );
+	    if ( registerUrls.size() )
+	    {
+	      info->add(YCPKey::register_urls, registerUrls);
+	    }
 	}
 
-	YCPList smoltUrls( asYCPList(product->smoltUrls()) );
-	if ( smoltUrls.size() )
+	if (wanted(keys, "smolt_urls"))
 	{
-	  info->add(YCPString("smolt_urls"), smoltUrls);
+	    YCPList smoltUrls( asYCPList(product->smoltUrls()) );
+	    if ( smoltUrls.size() )
+	    {
+	      info->add(YCPKey::smolt_urls, smoltUrls);
+	    }
 	}
 
-	YCPList relNotesUrls(asYCPList(product->releaseNotesUrls()));
-	if ( relNotesUrls.size() )
+	if (wanted(keys, "relnotes_urls"))
 	{
-	  info->add(YCPString("relnotes_urls"), relNotesUrls);
+	    YCPList relNotesUrls(asYCPList(product->releaseNotesUrls()));
+	    if ( relNotesUrls.size() )
+	    {
+	      info->add(YCPKey::relnotes_urls, relNotesUrls);
+	    }
 	}
 
 	// registration data
-	info->add(YCPString("register_target"), YCPString(product->registerTarget()));
-	info->add(YCPString("register_release"), YCPString(product->registerRelease()));
-	info->add(YCPString("product_line"), YCPString(product->productLine()));
+	if (wanted(keys, "register_target"))
+	    info->add(YCPKey::register_target, YCPString(product->registerTarget()));
+	if (wanted(keys, "register_release"))
+	    info->add(YCPKey::register_release, YCPString(product->registerRelease()));
+	if (wanted(keys, "product_line"))
+	    info->add(YCPKey::product_line, YCPString(product->productLine()));
 
 	// Live CD, FTP Edition...
-	info->add(YCPString("flavor"), YCPString(product->flavor()));
+	if (wanted(keys, "flavor"))
+	    info->add(YCPKey::flavor, YCPString(product->flavor()));
 
 	// get the installed Products it would replace.
-	zypp::Product::ReplacedProducts replaced(product->replacedProducts());
+	zypp::Product::ReplacedProducts replaced;
+	if (wanted(keys, "replaces"))
+	    replaced = product->replacedProducts();
 
 	if (!replaced.empty())
 	{
@@ -411,163 +549,206 @@ YCPMap PkgFunctions::Resolvable2YCPMap(const zypp::PoolItem &item, const std::st
 		if (!replacedProduct) continue;
 
 		YCPMap rprod;
-		rprod->add(YCPString("name"), YCPString(replacedProduct->name()));
-		rprod->add(YCPString("version"), YCPString(replacedProduct->edition().asString()));
-		rprod->add(YCPString("arch"), YCPString(replacedProduct->arch().asString()));
-		rprod->add(YCPString("description"), YCPString(replacedProduct->description()));
+		rprod->add(YCPKey::name, YCPString(replacedProduct->name()));
+		rprod->add(YCPKey::version, YCPString(replacedProduct->edition().asString()));
+		rprod->add(YCPKey::arch, YCPString(replacedProduct->arch().asString()));
+		rprod->add(YCPKey::description, YCPString(replacedProduct->description()));
 
 		std::string product_summary = replacedProduct->summary();
 		if (product_summary.size() > 0)
 		{
-		    rprod->add(YCPString("display_name"), YCPString(product_summary));
+		    rprod->add(YCPKey::display_name, YCPString(product_summary));
 		}
 
 		std::string product_shortname = replacedProduct->shortName();
 		if (product_shortname.size() > 0)
 		{
-		    rprod->add(YCPString("short_name"), YCPString(product_shortname));
+		    rprod->add(YCPKey::short_name, YCPString(product_shortname));
 		}
 		// use summary for the short name if it's defined
 		else if (product_summary.size() > 0)
 		{
-		    rprod->add(YCPString("short_name"), YCPString(product_summary));
+		    rprod->add(YCPKey::short_name, YCPString(product_summary));
 		}
 	    }
 
-	    info->add(YCPString("replaces"), rep_prods);
+	    info->add(YCPKey::replaces, rep_prods);
 	}
 
-	std::string product_file;
-
-	// add reference file in /etc/products.d
-	if (status.isInstalled())
+	// reading the product file is expensive, do it only when really needed
+	if (wanted(keys, "product_file") || wanted(keys, "upgrades") || wanted(keys, "product_package"))
 	{
-	    product_file = (_target_root + "/etc/products.d/" + product->referenceFilename()).asString();
-	    y2milestone("Parsing product file %s", product_file.c_str());
-	    const zypp::parser::ProductFileData productFileData = zypp::parser::ProductFileReader::scanFile(product_file);
+	    std::string product_file;
 
-	    YCPList upgrade_list;
-
-	    for_( upit, productFileData.upgrades().begin(), productFileData.upgrades().end() )
+	    // add reference file in /etc/products.d
+	    if (status.isInstalled())
 	    {
-	      const zypp::parser::ProductFileData::Upgrade & upgrade( *upit );
+		product_file = (_target_root + "/etc/products.d/" + product->referenceFilename()).asString();
 
-	      YCPMap upgrades;
-	      upgrades->add(YCPString("name"), YCPString(upgrade.name()));
-	      upgrades->add(YCPString("summary"), YCPString(upgrade.summary()));
-	      upgrades->add(YCPString("repository"), YCPString(upgrade.repository()));
-	      upgrades->add(YCPString("notify"), YCPBoolean(upgrade.notify()));
-	      upgrades->add(YCPString("status"), YCPString(upgrade.status()));
-	      upgrades->add(YCPString("product"), YCPString(upgrade.product()));
+		if (wanted(keys, "upgrades"))
+		{
+		    y2milestone("Parsing product file %s", product_file.c_str());
+		    const zypp::parser::ProductFileData productFileData = zypp::parser::ProductFileReader::scanFile(product_file);
 
-	      upgrade_list->add(upgrades);
-	    }
+		    YCPList upgrade_list;
 
-	    info->add(YCPString("upgrades"), upgrade_list);
-	}
-	else
-	{
-	    // get the package
-	    zypp::sat::Solvable refsolvable = product->referencePackage();
+		    for_( upit, productFileData.upgrades().begin(), productFileData.upgrades().end() )
+		    {
+		      const zypp::parser::ProductFileData::Upgrade & upgrade( *upit );
 
-	    if (refsolvable != zypp::sat::Solvable::noSolvable)
-	    {
-		// create a package pointer from the SAT solvable
-		zypp::Package::Ptr refpkg(zypp::make<zypp::Package>(refsolvable));
+		      YCPMap upgrades;
+		      upgrades->add(YCPKey::name, YCPString(upgrade.name()));
+		      upgrades->add(YCPKey::summary, YCPString(upgrade.summary()));
+		      upgrades->add(YCPKey::repository, YCPString(upgrade.repository()));
+		      upgrades->add(YCPKey::notify, YCPBoolean(upgrade.notify()));
+		      upgrades->add(YCPKey::status, YCPString(upgrade.status()));
+		      upgrades->add(YCPKey::product, YCPString(upgrade.product()));
 
-		if (refpkg)
-		{
-		    info->add(YCPString("product_package"), YCPString(refpkg->name()));
+		      upgrade_list->add(upgrades);
+		    }
 
-		    // get the package files
-		    zypp::Package::FileList files( refpkg->filelist() );
-		    y2milestone("The reference package has %d files", files.size());
+		    info->add(YCPKey::upgrades, upgrade_list);
+		}
+	    }
+	    else
+	    {
+		// get the package
+		zypp::sat::Solvable refsolvable = product->referencePackage();
 
-		    zypp::str::smatch what;
-		    const zypp::str::regex product_file_regex("^/etc/products\\.d/(.*\\.prod)$");
+		if (refsolvable != zypp::sat::Solvable::noSolvable)
+		{
+		    // create a package pointer from the SAT solvable
+		    zypp::Package::Ptr refpkg(zypp::make<zypp::Package>(refsolvable));
 
-		    // find the product file
-		    for_(iter, files.begin(), files.end())
+		    if (refpkg)
 		    {
-			if (zypp::str::regex_match(*iter, what, product_file_regex))
+			if (wanted(keys, "product_package"))
+			    info->add(YCPKey::product_package, YCPString(refpkg->name()));
+
+			if (wanted(keys, "product_file"))
 			{
-			    product_file = what[1];
-			    break;
+			    // get the package files
+			    zypp::Package::FileList files( refpkg->filelist() );
+			    y2milestone("The reference package has %d files", files.size());
+
+			    zypp::str::smatch what;
+			    const zypp::str::regex product_file_regex("^/etc/products\\.d/(.*\\.prod)$");
+
+			    // find the product file
+			    for_(iter, files.begin(), files.end())
+			    {
+				if (zypp::str::regex_match(*iter, what, product_file_regex))
+				{
+				    product_file = what[1];
+				    break;
+				}
+			    }
 			}
 		    }
 		}
 	    }
-	}
 
-	if (product_file.empty())
-	{
-	    y2warning("The product file has not been found");
-	}
-	else
-	{
-	    y2milestone("Found product file %s", product_file.c_str());
-	    info->add(YCPString("product_file"), YCPString(product_file));
+	    if (wanted(keys, "product_file"))
+	    {
+		if (product_file.empty())
+		{
+		    y2warning("The product file has not been found");
+		}
+		else
+		{
+		    y2milestone("Found product file %s", product_file.c_str());
+		    info->add(YCPKey::product_file, YCPString(product_file));
+		}
+	    }
 	}
     }
     // pattern specific info
     else if ( req_kind == "pattern" ) {
 	zypp::Pattern::constPtr pattern = zypp::asKind<zypp::Pattern>(item.resolvable());
-	info->add(YCPString("category"), YCPString(pattern->category()));
-	info->add(YCPString("user_visible"), YCPBoolean(pattern->userVisible()));
-	info->add(YCPString("default"), YCPBoolean(pattern->isDefault()));
-	info->add(YCPString("icon"), YCPString(pattern->icon().asString()));
-	info->add(YCPString("script"), YCPString(pattern->script().asString()));
-	info->add(YCPString("order"), YCPString(pattern->order()));
+	if (wanted(keys, "category"))
+	    info->add(YCPKey::category, YCPString(pattern->category()));
+	if (wanted(keys, "user_visible"))
+	    info->add(YCPKey::user_visible, YCPBoolean(pattern->userVisible()));
+	if (wanted(keys, "default"))
+	    info->add(YCPKey::default_key, YCPBoolean(pattern->isDefault()));
+	if (wanted(keys, "icon"))
+	    info->add(YCPKey::icon, YCPString(pattern->icon().asString()));
+	if (wanted(keys, "script"))
+	    info->add(YCPKey::script, YCPString(pattern->script().asString()));
+	if (wanted(keys, "order"))
+	    info->add(YCPKey::order, YCPString(pattern->order()));
     }
     // patch specific info
     else if ( req_kind == "patch" )
     {
 	zypp::Patch::constPtr patch_ptr = zypp::asKind<zypp::Patch>(item.resolvable());
 
-	info->add(YCPString("interactive"), YCPBoolean(patch_ptr->interactive()));
-	info->add(YCPString("reboot_needed"), YCPBoolean(patch_ptr->rebootSuggested()));
-	info->add(YCPString("relogin_needed"), YCPBoolean(patch_ptr->reloginSuggested()));
-	info->add(YCPString("affects_pkg_manager"), YCPBoolean(patch_ptr->restartSuggested()));
-	info->add(YCPString("is_needed"), YCPBoolean(item.isBroken()));
-        // names and versions of packages, contained in the patch
-        YCPMap contents;
-        zypp::Patch::Contents c( patch_ptr->contents() );
-        for_( it, c.begin(), c.end() )
-        {
-          contents->add (YCPString (it->name()), YCPString (it->edition().c_str()));
-        }
-        info->add(YCPString("contents"), contents);
+	if (wanted(keys, "interactive"))
+	    info->add(YCPKey::interactive, YCPBoolean(patch_ptr->interactive()));
+	if (wanted(keys, "reboot_needed"))
+	    info->add(YCPKey::reboot_needed, YCPBoolean(patch_ptr->rebootSuggested()));
+	if (wanted(keys, "relogin_needed"))
+	    info->add(YCPKey::relogin_needed, YCPBoolean(patch_ptr->reloginSuggested()));
+	if (wanted(keys, "affects_pkg_manager"))
+	    info->add(YCPKey::affects_pkg_manager, YCPBoolean(patch_ptr->restartSuggested()));
+	if (wanted(keys, "is_needed"))
+	    info->add(YCPKey::is_needed, YCPBoolean(item.isBroken()));
+
+	if (wanted(keys, "contents"))
+	{
+	    // names and versions of packages, contained in the patch
+	    YCPMap contents;
+	    zypp::Patch::Contents c( patch_ptr->contents() );
+	    for_( it, c.begin(), c.end() )
+	    {
+	      contents->add (YCPString (it->name()), YCPString (it->edition().c_str()));
+	    }
+	    info->add(YCPKey::contents, contents);
+	}
     }
 
     // dependency info
     if (dependencies)
     {
-	std::set<std::string> _kinds;
-	_kinds.insert("provides");
-	_kinds.insert("prerequires");
-	_kinds.insert("requires");
-	_kinds.insert("conflicts");
-	_kinds.insert("obsoletes");
-	_kinds.insert("recommends");
-	_kinds.insert("suggests");
-	_kinds.insert("enhances");
-	_kinds.insert("supplements");
+	// resolving the dependencies is expensive, skip it if not needed
+	bool resolve = wanted(keys, "dependencies");
+	bool raw = wanted(keys, "deps");
+
+	// the dependency kinds (in the alphabetical order), the name is used
+	// as the key and the value in the result maps
+	static const struct
+	{
+	    zypp::Dep dep;
+	    const YCPString &name;
+	} dep_kinds[] = {
+	    { zypp::Dep::CONFLICTS, YCPKey::conflicts }, { zypp::Dep::ENHANCES, YCPKey::enhances },
+	    { zypp::Dep::OBSOLETES, YCPKey::obsoletes }, { zypp::Dep::PREREQUIRES, YCPKey::prerequires },
+	    { zypp::Dep::PROVIDES, YCPKey::provides }, { zypp::Dep::RECOMMENDS, YCPKey::recommends },
+	    { zypp::Dep::REQUIRES, YCPKey::requires }, { zypp::Dep::SUGGESTS, YCPKey::suggests },
+	    { zypp::Dep::SUPPLEMENTS, YCPKey::supplements }
+	};
+
 	YCPList ycpdeps;
 	YCPList rawdeps;
-	for (std::set<std::string>::const_iterator kind_it = _kinds.begin();
-	    kind_it != _kinds.end(); ++kind_it)
+	for (unsigned kind = 0; kind < sizeof(dep_kinds) / sizeof(dep_kinds[0]); ++kind)
 	{
-            zypp::Dep depkind(*kind_it);
-            zypp::Capabilities deps = item.resolvable()->dep(depkind);
+            const YCPString &kind_name = dep_kinds[kind].name;
+            zypp::Capabilities deps = item.resolvable()->dep(dep_kinds[kind].dep);
 
             // add raw dependencies
-            for_(it, deps.begin(), deps.end())
+            if (raw)
             {
-                YCPMap rawdep;
-                rawdep->add(YCPString(*kind_it), YCPString(it->asString()));
-                rawdeps->add(rawdep);
+                for_(it, deps.begin(), deps.end())
+                {
+                    YCPMap rawdep;
+                    rawdep->add(kind_name, YCPString(it->asString()));
+                    rawdeps->add(rawdep);
+                }
             }
 
+            if (!resolve)
+                continue;
+
             zypp::sat::WhatProvides prv(deps);
 
             // resolve dependencies
@@ -580,9 +761,9 @@ YCPMap PkgFunctions::Resolvable2YCPMap(const zypp::PoolItem &item, const std::st
                 else
                 {
                     YCPMap ycpdep;
-                    ycpdep->add (YCPString ("res_kind"), YCPString (d->kind().asString()));
-                    ycpdep->add (YCPString ("name"), YCPString (d->name()));
-                    ycpdep->add (YCPString ("dep_kind"), YCPString (*kind_it));
+                    ycpdep->add (YCPKey::res_kind, YCPString (d->kind().asString()));
+                    ycpdep->add (YCPKey::name, YCPString (d->name()));
+                    ycpdep->add (YCPKey::dep_kind, kind_name);
 
                     if (!ycpdeps.contains(ycpdep))
                     {
@@ -594,20 +775,78 @@ YCPMap PkgFunctions::Resolvable2YCPMap(const zypp::PoolItem &item, const std::st
 
 	if (ycpdeps.size() > 0)
 	{
-	    info->add (YCPString ("dependencies"), ycpdeps);
+	    info->add (YCPKey::dependencies, ycpdeps);
 	}
 
 	if (rawdeps.size() > 0)
 	{
-	    info->add (YCPString ("deps"), rawdeps);
+	    info->add (YCPKey::deps, rawdeps);
 	}
     }
 
     return info;
 }
 
+// add the installed and the available items of the selectable with the required version
+// (an empty version matches all items)
+static void addMatching(const zypp::ui::Selectable::Ptr &s, const std::string &version,
+    std::vector<zypp::PoolItem> &items)
+{
+    if (!s->installedEmpty())
+    {
+	// iterate over all installed packages
+	for_(inst_it, s->installedBegin(), s->installedEnd())
+	{
+	    // check version if required, compare the string directly, converting
+	    // the version to an IdString would add it to the pool string table
+	    if (version.empty() || version == inst_it->resolvable()->edition().c_str())
+	    {
+		items.push_back(*inst_it);
+	    }
+	}
+    }
+
+    if (!s->availableEmpty())
+    {
+	// iterate over all available packages
+	for_(avail_it, s->availableBegin(), s->availableEnd())
+	{
+	    // check version if required
+	    if (version.empty() || version == avail_it->resolvable()->edition().c_str())
+	    {
+		items.push_back(*avail_it);
+	    }
+	}
+    }
+}
+
+void PkgFunctions::ResolvableMatching(const zypp::ResKind &kind, const std::string &nm, const std::string &vers,
+    std::vector<zypp::PoolItem> &items)
+{
+    if (!nm.empty())
+    {
+	// direct lookup, no need to iterate over the whole pool
+	zypp::ui::Selectable::Ptr s = zypp::ui::Selectable::get(kind, nm);
+
+	if (s)
+	{
+	    addMatching(s, vers, items);
+	}
+
+	return;
+    }
+
+    for (zypp::ResPoolProxy::const_iterator it = zypp_ptr()->poolProxy().byKindBegin(kind);
+	it != zypp_ptr()->poolProxy().byKindEnd(kind);
+	++it)
+    {
+	addMatching(*it, vers, items);
+    }
+}
+
 YCPValue
-PkgFunctions::ResolvablePropertiesEx(const YCPString& name, const YCPSymbol& kind_r, const YCPString& version, bool dependencies)
+PkgFunctions::ResolvablePropertiesEx(const YCPString& name, const YCPSymbol& kind_r, const YCPString& version, bool dependencies,
+    const std::set<std::string> &keys)
 {
     zypp::Resolvable::Kind kind;
     std::string req_kind = kind_r->symbol ();
@@ -615,25 +854,21 @@ PkgFunctions::ResolvablePropertiesEx(const YCPString& name, const YCPSymbol& kin
     std::string vers = version->value();
     YCPList ret;
 
-    if( req_kind == "product" ) {
-    	kind = zypp::ResKind::product;
-    }
-    else if ( req_kind == "patch" ) {
-    	kind = zypp::ResKind::patch;
-    }
-    else if ( req_kind == "package" ) {
-	kind = zypp::ResKind::package;
-    }
-    else if ( req_kind == "srcpackage" ) {
-	kind = zypp::ResKind::srcpackage;
-    }
-    else if ( req_kind == "pattern" ) {
-	kind = zypp::ResKind::pattern;
-    }
-    else if ( req_kind == "language" )
+    if ( req_kind == "language" )
     {
 	try
 	{
+	    unsigned serial = zypp_ptr()->pool().serial().serial();
+	    const zypp::LocaleSet &requested(zypp::sat::Pool::instance().getRequestedLocales());
+
+	    // the available locales depend on the pool content only,
+	    // the requested flags on the requested locales
+	    if (locale_list_cache.valid && locale_list_cache.pool_serial == serial
+		&& locale_list_cache.requested == requested && locale_list_cache.keys == keys)
+	    {
+		return locale_list_cache.list;
+	    }
+
 	    const zypp::LocaleSet &avlocales( zypp::ResPool::instance().getAvailableLocales() );
 
 	    for_( it, avlocales.begin(), avlocales.end() )
@@ -642,13 +877,23 @@ PkgFunctions::ResolvablePropertiesEx(const YCPString& name, const YCPSymbol& kin
 
 		YCPMap lang_map;
 
-		lang_map->add(YCPString("name"), YCPString(myLocale.locale().name()));
-		lang_map->add(YCPString("code"), YCPString(myLocale.locale().code()));
-		lang_map->add(YCPString("packages"), YCPBoolean(myLocale.isAvailable()));
-		lang_map->add(YCPString("requested"), YCPBoolean(myLocale.isRequested()));
+		if (wanted(keys, "name"))
+		    lang_map->add(YCPKey::name, YCPString(myLocale.locale().name()));
+		if (wanted(keys, "code"))
+		    lang_map->add(YCPKey::code, YCPString(myLocale.locale().code()));
+		if (wanted(keys, "packages"))
+		    lang_map->add(YCPKey::packages, YCPBoolean(myLocale.isAvailable()));
+		if (wanted(keys, "requested"))
+		    lang_map->add(YCPKey::requested, YCPBoolean(myLocale.isRequested()));
 
 		ret->add(lang_map);
 	    }
+
+	    locale_list_cache.valid = true;
+	    locale_list_cache.pool_serial = serial;
+	    locale_list_cache.requested = requested;
+	    locale_list_cache.keys = keys;
+	    locale_list_cache.list = ret;
 	}
 	catch(const zypp::Exception &expt)
 	{
@@ -659,59 +904,17 @@ PkgFunctions::ResolvablePropertiesEx(const YCPString& name, const YCPSymbol& kin
 
 	return ret;
     }
-    else
+    else if (!asResKind(req_kind, kind))
     {
 	y2error("Pkg::ResolvableProperties: unknown symbol: %s", req_kind.c_str());
 	return ret;
     }
 
-   try
-   {
-	for (zypp::ResPoolProxy::const_iterator it = zypp_ptr()->poolProxy().byKindBegin(kind);
-	    it != zypp_ptr()->poolProxy().byKindEnd(kind);
-	    ++it)
-	{
-	    zypp::ui::Selectable::Ptr s = (*it);
-
-	    if (nm.empty() || nm == s->name())
-	    {
-                try
-                {
-                    if (!s->installedEmpty())
-                    {
-                        // iterate over all installed packages
-                        for_(inst_it, s->installedBegin(), s->installedEnd())
-                        {
-                            // check version if required
-                            if (vers.empty() || vers == inst_it->resolvable()->edition().asString())
-                            {
-                                ret->add(Resolvable2YCPMap(*inst_it, req_kind, dependencies));
-                            }
-                        }
-                    }
+    std::vector<zypp::PoolItem> items;
 
-                    if (!s->availableEmpty())
-                    {
-                        // iterate over all available packages
-                        for_(avail_it, s->availableBegin(), s->availableEnd())
-                        {
-                            // check version if required
-                            if (vers.empty() || vers == avail_it->resolvable()->edition().asString())
-                            {
-                                ret->add(Resolvable2YCPMap(*avail_it, req_kind, dependencies));
-                            }
-                        }
-                    }
-                }
-                catch(const zypp::Exception &expt)
-                {
-                    y2error("ResolvableProperties for \"%s\" failed: %s",
-                        s->name().c_str(), expt.asString().c_str());
-                    _last_error.setLastError(ExceptionAsString(expt));
-                    return YCPVoid();
-                }
-            }
-	}
+    try
+    {
+	ResolvableMatching(kind, nm, vers, items);
     }
     catch(const zypp::Exception &expt)
     {
@@ -720,28 +923,166 @@ PkgFunctions::ResolvablePropertiesEx(const YCPString& name, const YCPSymbol& kin
         return YCPVoid();
     }
 
+    for_(it, items.begin(), items.end())
+    {
+        try
+        {
+            ret->add(Resolvable2YCPMap(*it, req_kind, dependencies, keys));
+        }
+        catch(const zypp::Exception &expt)
+        {
+            y2error("ResolvableProperties for \"%s\" failed: %s",
+                (*it)->name().c_str(), expt.asString().c_str());
+            _last_error.setLastError(ExceptionAsString(expt));
+            return YCPVoid();
+        }
+    }
+
     return ret;
 }
 
-bool AnyResolvableHelper(zypp::Resolvable::Kind kind, bool to_install)
+/**
+   @builtin ResolvablePropertiesOpen
+
+   @short Open a cursor for reading the resolvable properties in batches
+   @description
+   Find the matching resolvables and return a cursor for reading their properties
+   by ResolvablePropertiesNext(). The properties are created only when they are read,
+   that keeps the memory usage low even for a huge number of resolvables.
+   Close the cursor by ResolvablePropertiesClose() when it is not needed anymore.
+
+   The cursor becomes invalid when the pool is changed (e.g. a repository is added or removed),
+   the status changes of the resolvables are fine.
+
+   The `language kind is not supported, use ResolvableProperties() for it.
+
+   @param name name of the resolvable, if empty returns all resolvables of the kind
+   @param kind_r kind of resolvable, can be `product, `patch, `package, `srcpackage or `pattern
+   @param version version of the resolvable, if empty all versions are returned
+   @param keys list of the requested keys, if empty all keys are returned (without the dependencies),
+     see ResolvablePropertiesKeys()
+   @return integer cursor ID, nil on error
+
+   @see ResolvableProperties for the list of supported keys
+
+   @usage integer cursor = Pkg::ResolvablePropertiesOpen("", `package, "", ["name", "version", "status"]);
+   list<map<string,any>> batch = Pkg::ResolvablePropertiesNext(cursor, 1000);
+   Pkg::ResolvablePropertiesClose(cursor);
+*/
+YCPValue
+PkgFunctions::ResolvablePropertiesOpen(const YCPString& name, const YCPSymbol& kind_r, const YCPString& version, const YCPList& keys)
 {
-    for (zypp::ResPoolProxy::const_iterator it = zypp::ResPool::instance().proxy().byKindBegin(kind);
-	it != zypp::ResPool::instance().proxy().byKindEnd(kind);
-	++it)
+    zypp::Resolvable::Kind kind;
+    std::string req_kind = kind_r->symbol ();
+
+    if (!asResKind(req_kind, kind))
+    {
+	y2error("Pkg::ResolvablePropertiesOpen: unsupported kind: %s", req_kind.c_str());
+	return YCPVoid();
+    }
+
+    ResolvableCursor cursor;
+    cursor.req_kind = req_kind;
+    cursor.keys = wantedKeys(keys, "ResolvablePropertiesOpen");
+    cursor.dependencies = wantedDependencies(cursor.keys);
+    cursor.next = 0;
+
+    try
+    {
+	cursor.pool_serial = zypp_ptr()->pool().serial().serial();
+	ResolvableMatching(kind, name->value(), version->value(), cursor.items);
+    }
+    catch(const zypp::Exception &expt)
     {
-	zypp::ui::Selectable::Fate fate = (*it)->fate();
+        y2error("ResolvablePropertiesOpen failed: %s", expt.asString().c_str());
+        _last_error.setLastError(ExceptionAsString(expt));
+        return YCPVoid();
+    }
 
-	if (to_install && fate == zypp::ui::Selectable::TO_INSTALL)
+    long long id = ++last_cursor;
+    resolvable_cursors[id] = cursor;
+
+    y2milestone("Opened resolvable cursor %lld (%zd items)", id, cursor.items.size());
+
+    return YCPInteger(id);
+}
+
+/**
+   @builtin ResolvablePropertiesNext
+
+   @short Read the next batch of the resolvable properties
+   @param cursor cursor ID returned by ResolvablePropertiesOpen()
+   @param batch_size maximum number of the returned resolvables
+   @return list<map<string,any>> resolvable properties, empty list at the end,
+     nil on error (invalid cursor, the pool has been changed)
+*/
+YCPValue
+PkgFunctions::ResolvablePropertiesNext(const YCPInteger& cursor, const YCPInteger& batch_size)
+{
+    std::map<long long, ResolvableCursor>::iterator cur = resolvable_cursors.find(cursor->value());
+
+    if (cur == resolvable_cursors.end())
+    {
+	y2error("Pkg::ResolvablePropertiesNext: invalid cursor %lld", cursor->value());
+	return YCPVoid();
+    }
+
+    if (batch_size->value() <= 0)
+    {
+	y2error("Pkg::ResolvablePropertiesNext: invalid batch size %lld", batch_size->value());
+	return YCPVoid();
+    }
+
+    ResolvableCursor &c = cur->second;
+    YCPList ret;
+
+    try
+    {
+	if (zypp_ptr()->pool().serial().serial() != c.pool_serial)
+	{
+	    y2error("Pkg::ResolvablePropertiesNext: the pool has been changed, cursor %lld is not valid", cur->first);
+	    return YCPVoid();
+	}
+
+	std::vector<zypp::PoolItem>::size_type end = c.next + batch_size->value();
+	if (end > c.items.size())
 	{
-	    return true;
+	    end = c.items.size();
 	}
-	else if (!to_install && fate == zypp::ui::Selectable::TO_DELETE)
+
+	for (; c.next < end; ++c.next)
 	{
-	    return true;
+	    ret->add(Resolvable2YCPMap(c.items[c.next], c.req_kind, c.dependencies, c.keys));
 	}
     }
+    catch(const zypp::Exception &expt)
+    {
+        y2error("ResolvablePropertiesNext failed: %s", expt.asString().c_str());
+        _last_error.setLastError(ExceptionAsString(expt));
+        return YCPVoid();
+    }
+
+    return ret;
+}
+
+/**
+   @builtin ResolvablePropertiesClose
+
+   @short Close a resolvable cursor
+   @param cursor cursor ID returned by ResolvablePropertiesOpen()
+   @return boolean false if the cursor is not valid
+*/
+YCPValue
+PkgFunctions::ResolvablePropertiesClose(const YCPInteger& cursor)
+{
+    if (resolvable_cursors.erase(cursor->value()) == 0)
+    {
+	y2error("Pkg::ResolvablePropertiesClose: invalid cursor %lld", cursor->value());
+	return YCPBoolean(false);
+    }
 
-    return false;
+    y2milestone("Closed resolvable cursor %lld", cursor->value());
+    return YCPBoolean(true);
 }
 
 /**
@@ -771,7 +1112,8 @@ PkgFunctions::IsAnyResolvable(const YCPSymbol& kind_r, const YCPSymbol& status)
 	return YCPVoid();
     }
 
-    bool to_install = stat_str == "to_install";
+    zypp::ui::Selectable::Fate fate = stat_str == "to_install" ?
+	zypp::ui::Selectable::TO_INSTALL : zypp::ui::Selectable::TO_DELETE;
 
     if( req_kind == "product" ) {
 	kind = zypp::ResKind::product;
@@ -788,11 +1130,13 @@ PkgFunctions::IsAnyResolvable(const YCPSymbol& kind_r, const YCPSymbol& status)
     else if ( req_kind == "any" ) {
 	try
 	{
+	    const TransactSummary &summary = BuildTransactSummary();
+
 	    return YCPBoolean(
-		AnyResolvableHelper(zypp::ResKind::package, to_install)
-		|| AnyResolvableHelper(zypp::ResKind::patch, to_install)
-		|| AnyResolvableHelper(zypp::ResKind::product, to_install)
-		|| AnyResolvableHelper(zypp::ResKind::pattern, to_install)
+		summary.count(zypp::ResKind::package, fate) > 0
+		|| summary.count(zypp::ResKind::patch, fate) > 0
+		|| summary.count(zypp::ResKind::product, fate) > 0
+		|| summary.count(zypp::ResKind::pattern, fate) > 0
 	    );
 	}
 	catch (...)
@@ -809,7 +1153,7 @@ PkgFunctions::IsAnyResolvable(const YCPSymbol& kind_r, const YCPSymbol& status)
 
     try
     {
-	return YCPBoolean(AnyResolvableHelper(kind, to_install));
+	return YCPBoolean(BuildTransactSummary().count(kind, fate) > 0);
     }
     catch (...)
     {
@@ -818,3 +1162,83 @@ PkgFunctions::IsAnyResolvable(const YCPSymbol& kind_r, const YCPSymbol& status)
     }
 }
 
+
+/**
+   @builtin BaseProductInfo
+   @short Get the properties of the base product
+   @description
+   Returns the base product without scanning all products via ResolvableProperties().
+   The base product is the product remembered when adding the base repository
+   (see SourceCreateBase(), the installed one is preferred), otherwise the installed
+   base product of the target system (/etc/products.d/baseproduct).
+   The result is cached until the pool is changed.
+   @return map the product properties (see ResolvableProperties()), nil if there is no base product
+*/
+YCPValue
+PkgFunctions::BaseProductInfo()
+{
+    try
+    {
+	CheckBaseProductCache();
+
+	if (!base_product_cache.info_valid)
+	{
+	    zypp::sat::Solvable found;
+
+	    if (base_product)
+	    {
+		zypp::Product::constPtr installed = FindInstalledBaseProduct();
+
+		if (installed)
+		{
+		    found = installed->satSolvable();
+		}
+		else
+		{
+		    // not installed yet, use the product from the base repository
+		    zypp::ui::Selectable::Ptr s = zypp::ui::Selectable::get(zypp::ResKind::product, base_product->name);
+
+		    if (s)
+		    {
+			for_(it, s->availableBegin(), s->availableEnd())
+			{
+			    if (it->satSolvable().edition() == base_product->edition
+				&& it->satSolvable().arch() == base_product->arch)
+			    {
+				found = it->satSolvable();
+				break;
+			    }
+			}
+		    }
+		}
+	    }
+	    else if (_target_loaded && zypp_ptr()->getTarget())
+	    {
+		zypp::Product::constPtr product = zypp_ptr()->getTarget()->baseProduct();
+
+		if (product)
+		{
+		    found = product->satSolvable();
+		}
+	    }
+
+	    base_product_cache.info = found;
+	    base_product_cache.info_valid = true;
+	}
+
+	if (base_product_cache.info == zypp::sat::Solvable::noSolvable)
+	{
+	    y2milestone("No base product found");
+	    return YCPVoid();
+	}
+
+	return Resolvable2YCPMap(zypp::PoolItem(base_product_cache.info), "product", false);
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	y2error("Cannot get the base product: %s", excpt.asString().c_str());
+	_last_error.setLastError(ExceptionAsString(excpt));
+    }
+
+    return YCPVoid();
+}
@@ -26,7 +26,9 @@
 */
 
 #include "PkgFunctions.h"
+#include "Callbacks.h"
 #include "PkgProgress.h"
+#include "PkgWorkers.h"
 #include "log.h"
 
 #include <ycp/YCPValue.h>
@@ -36,6 +38,13 @@
 #include <ycp/YCPBoolean.h>
 #include <ycp/YCPVoid.h>
 #include <zypp/RepoInfo.h>
+#include <zypp/PathInfo.h>
+#include <zypp/TmpPath.h>
+#include <zypp/base/String.h>
+#include <zypp/parser/RepoFileReader.h>
+#include <zypp/parser/ServiceFileReader.h>
+
+#include <boost/bind.hpp>
 
 
 /**
@@ -385,60 +394,12 @@ YCPValue PkgFunctions::ServiceRefreshHelper(const YCPString &alias, bool force)
 	    return YCPBoolean(false);
 	}
 
-	// reload all repositories
-	for (RepoCont::size_type idx = 0; idx != repos.size(); ++idx)
-	{
-	    YRepo_Ptr repo = repos[idx];
-
-	    // the repo has not been removed
-	    if (!repo->isDeleted())
-	    {
-		zypp::RepoInfo info(repo->repoInfo());
-		y2milestone("Reloading repository %s", info.alias().c_str());
-
-		if (repomanager->hasRepo(info))
-		{
-		    repos[idx]->repoInfo() = repomanager->getRepositoryInfo(info.alias());
-		}
-		else
-		{
-		    y2milestone("Repository %s has been removed, unloading it", (info.alias().c_str()));
-		    RemoveResolvablesFrom(repo);
-		    repo->setDeleted();
-		}
-	    }
-	}
+	// an explicit refresh probes the service again
+	InvalidateProbe(ProbeKey("service", service_manager.GetService(alias_str).url()));
 
-        y2milestone("Checking for added repositories...");
-        // check whether there are new added repositories and load them
-        std::list<zypp::RepoInfo> reps = repomanager->knownRepositories();
-        for (std::list<zypp::RepoInfo>::iterator it = reps.begin();
-            it != reps.end(); ++it)
-        {
-          y2debug("Checking repo '%s' from service '%s'", it->alias().c_str(), it->service().c_str());
-          // skip repositories from other services or already loaded repositories
-          if (it->service() != alias_str || logFindAlias(it->alias()) > 0)
-            continue;
-
-          y2milestone("Service added a new repository: %s", it->alias().c_str());
-          YRepo_Ptr new_repo = new YRepo(*it);
-          repos.push_back(new_repo);
-
-          if (it->enabled())
-          {
-            y2milestone("Refreshing repository: %s", it->alias().c_str());
-            // refresh the last added repository
-            SourceRefreshNow(repos.size() - 1);
-
-            // load resolvables
-            PkgProgress pkgprogress(_callbackHandler);
-            zypp::ProgressData progress(100);
-            progress.sendTo(pkgprogress.Receiver());
-            zypp::CombinedProgressData subprogrcv_ref(progress, 20);
-
-            LoadResolvablesFrom(new_repo, subprogrcv_ref);
-          }
-        }
+	std::set<std::string> services;
+	services.insert(alias_str);
+	SyncServiceRepos(*repomanager, services);
 
 	return YCPBoolean(true);
     }
@@ -450,6 +411,71 @@ YCPValue PkgFunctions::ServiceRefreshHelper(const YCPString &alias, bool force)
     return YCPBoolean(false);
 }
 
+/*
+ * A helper function - update the loaded repositories after refreshing
+ * the services: reload the changed repositories, unload the removed ones
+ * and add (and load) the new repositories from the refreshed services.
+ */
+void PkgFunctions::SyncServiceRepos(zypp::RepoManager &repomgr, const std::set<std::string> &services)
+{
+    // reload all repositories
+    for (RepoCont::size_type idx = 0; idx != repos.size(); ++idx)
+    {
+        YRepo_Ptr repo = repos[idx];
+
+        // the repo has not been removed
+        if (!repo->isDeleted())
+        {
+            zypp::RepoInfo info(repo->repoInfo());
+            y2milestone("Reloading repository %s", info.alias().c_str());
+
+            if (repomgr.hasRepo(info))
+            {
+                repos[idx]->repoInfo() = repomgr.getRepositoryInfo(info.alias());
+                repos[idx]->setSaved();
+            }
+            else
+            {
+                y2milestone("Repository %s has been removed, unloading it", (info.alias().c_str()));
+                RemoveResolvablesFrom(repo);
+                repo->setDeleted();
+            }
+        }
+    }
+
+    y2milestone("Checking for added repositories...");
+    // check whether there are new added repositories and load them
+    std::list<zypp::RepoInfo> reps = repomgr.knownRepositories();
+    for (std::list<zypp::RepoInfo>::iterator it = reps.begin();
+        it != reps.end(); ++it)
+    {
+      y2debug("Checking repo '%s' from service '%s'", it->alias().c_str(), it->service().c_str());
+      // skip repositories from other services or already loaded repositories
+      if (services.find(it->service()) == services.end() || logFindAlias(it->alias()) > 0)
+        continue;
+
+      y2milestone("Service added a new repository: %s", it->alias().c_str());
+      YRepo_Ptr new_repo = new YRepo(*it);
+      new_repo->setSaved();
+      RepoId new_id = AddRepo(new_repo);
+
+      if (it->enabled())
+      {
+        y2milestone("Refreshing repository: %s", it->alias().c_str());
+        // refresh the last added repository
+        SourceRefreshNow(new_id);
+
+        // load resolvables
+        PkgProgress pkgprogress(_callbackHandler);
+        zypp::ProgressData progress(100);
+        progress.sendTo(pkgprogress.Receiver());
+        zypp::CombinedProgressData subprogrcv_ref(progress, 20);
+
+        LoadResolvablesFrom(new_repo, subprogrcv_ref);
+      }
+    }
+}
+
 /**
    @builtin ServiceRefresh
    @short Refresh the service, the service must already be saved on the system!
@@ -472,6 +498,289 @@ YCPValue PkgFunctions::ServiceForceRefresh(const YCPString &alias)
    return ServiceRefreshHelper(alias, true);
 }
 
+/*
+ * A helper function - worker job for the parallel service refresh,
+ * it runs in a forked child process, see PkgWorkers.
+ * The service is refreshed in a private copy of the repository and service
+ * files, a new RepoManager must not use the real files and caches (it would
+ * remove the caches of the repositories which have not been saved yet,
+ * see bnc#802665). The parent merges the result, see MergeServiceRefresh().
+ */
+static int ServiceRefreshJob(zypp::RepoManagerOptions options, const zypp::Pathname &dir,
+    const std::string &alias, bool force)
+{
+    try
+    {
+	zypp::Pathname repos_dir(dir / "repos.d");
+	zypp::Pathname services_dir(dir / "services.d");
+
+	zypp::filesystem::assert_dir(repos_dir);
+	zypp::filesystem::assert_dir(services_dir);
+
+	if (zypp::PathInfo(options.knownReposPath).isDir())
+	    zypp::filesystem::copy_dir_content(options.knownReposPath, repos_dir);
+
+	if (zypp::PathInfo(options.knownServicesPath).isDir())
+	    zypp::filesystem::copy_dir_content(options.knownServicesPath, services_dir);
+
+	options.knownReposPath = repos_dir;
+	options.knownServicesPath = services_dir;
+	options.repoCachePath = dir / "cache";
+	options.repoRawCachePath = dir / "cache/raw";
+	options.repoSolvCachePath = dir / "cache/solv";
+	options.repoPackagesCachePath = dir / "cache/packages";
+
+	zypp::RepoManager repomgr(options);
+
+	if (force)
+	    repomgr.refreshService(alias, zypp::RepoManager::RefreshService_forceRefresh);
+	else
+	    repomgr.refreshService(alias);
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	y2error("Cannot refresh service %s: %s", alias.c_str(), excpt.asString().c_str());
+	return PkgWorkers::JOB_FAILED;
+    }
+
+    return PkgWorkers::JOB_DONE;
+}
+
+static bool CollectService(std::list<zypp::ServiceInfo> *services, const std::string &alias, const zypp::ServiceInfo &service)
+{
+    if (service.alias() == alias)
+	services->push_back(service);
+
+    return true;
+}
+
+static bool CollectServiceRepo(std::list<zypp::RepoInfo> *repos, const std::string &alias, const zypp::RepoInfo &repo)
+{
+    if (repo.service() == alias)
+	repos->push_back(repo);
+
+    return true;
+}
+
+/*
+ * A helper function - apply the service refreshed by ServiceRefreshJob()
+ * in the private copy (dir) to the shared repository manager: update the
+ * service and add, change or remove its repositories.
+ */
+static void MergeServiceRefresh(zypp::RepoManager &repomgr, const std::string &alias, const zypp::Pathname &dir)
+{
+    std::list<zypp::ServiceInfo> services;
+    std::list<zypp::RepoInfo> refreshed;
+    std::list<std::string> files;
+
+    zypp::filesystem::readdir(files, dir / "services.d", false);
+    for_(it, files.begin(), files.end())
+    {
+	if (zypp::str::hasSuffix(*it, ".service"))
+	    zypp::parser::ServiceFileReader(dir / "services.d" / *it, boost::bind(CollectService, &services, alias, _1));
+    }
+
+    files.clear();
+    zypp::filesystem::readdir(files, dir / "repos.d", false);
+    for_(it, files.begin(), files.end())
+    {
+	if (zypp::str::hasSuffix(*it, ".repo"))
+	    zypp::parser::RepoFileReader(dir / "repos.d" / *it, boost::bind(CollectServiceRepo, &refreshed, alias, _1));
+    }
+
+    if (services.empty())
+	ZYPP_THROW(zypp::Exception("Service " + alias + " not found after refresh"));
+
+    repomgr.modifyService(alias, services.front());
+
+    std::set<std::string> aliases;
+    for_(it, refreshed.begin(), refreshed.end())
+    {
+	aliases.insert(it->alias());
+    }
+
+    // the removed repositories
+    std::list<zypp::RepoInfo> known(repomgr.knownRepositories());
+    for_(it, known.begin(), known.end())
+    {
+	if (it->service() == alias && aliases.find(it->alias()) == aliases.end())
+	{
+	    y2milestone("Service %s removed repository %s", alias.c_str(), it->alias().c_str());
+	    repomgr.removeRepository(*it);
+	}
+    }
+
+    for_(it, refreshed.begin(), refreshed.end())
+    {
+	if (repomgr.hasRepo(it->alias()))
+	{
+	    repomgr.modifyRepository(it->alias(), *it);
+	}
+	else
+	{
+	    y2milestone("Service %s added repository %s", alias.c_str(), it->alias().c_str());
+	    repomgr.addRepository(*it);
+	}
+    }
+}
+
+static bool ServiceRefreshFinished(std::vector<int> *statuses, unsigned index, int status)
+{
+    (*statuses)[index] = status;
+    return true;
+}
+
+/**
+   @builtin ServiceRefreshAll
+   @short Refresh all enabled services at once
+   @description
+   The services are refreshed in parallel worker processes, the loaded
+   repositories are updated afterwards. The services must already be saved
+   on the system! The workers run without any user interaction, if only
+   one service is refreshed (or "jobs" is 1) it is refreshed as in Pkg::ServiceRefresh().
+
+   @param options $["force" : boolean (force refresh even if TTL is not reached, default false),
+     "jobs" : integer (max. number of services refreshed at once, 0 = number of CPUs,
+     the default is the "refresh_jobs" value, see Pkg::SetZConfig())]
+   @return map<string,boolean> service alias => result (false if failed), nil on error
+*/
+YCPValue PkgFunctions::ServiceRefreshAll(const YCPMap &options)
+{
+    bool force = false;
+    unsigned jobs = refresh_jobs;
+
+    if (!options.isNull())
+    {
+	YCPValue val = options->value(YCPString("force"));
+	if (!val.isNull())
+	{
+	    if (!val->isBoolean())
+	    {
+		y2error("Invalid value for \"force\" key: %s", val->toString().c_str());
+		return YCPVoid();
+	    }
+
+	    force = val->asBoolean()->value();
+	}
+
+	val = options->value(YCPString("jobs"));
+	if (!val.isNull())
+	{
+	    if (!val->isInteger() || val->asInteger()->value() < 0)
+	    {
+		y2error("Invalid value for \"jobs\" key: %s", val->toString().c_str());
+		return YCPVoid();
+	    }
+
+	    long long value = val->asInteger()->value();
+	    jobs = (value == 0) ? PkgWorkers::defaultJobs() : value;
+	}
+    }
+
+    YCPMap ret;
+
+    try
+    {
+	zypp::RepoManager* repomanager = CreateRepoManager();
+
+	std::vector<zypp::ServiceInfo> services;
+	ServiceManager::Services known = service_manager.GetServices();
+
+	for_(it, known.begin(), known.end())
+	{
+	    if (it->enabled())
+		services.push_back(*it);
+	    else
+		y2milestone("Skipping disabled service %s", it->alias().c_str());
+	}
+
+	std::set<std::string> refreshed;
+
+	if (services.size() < 2 || jobs == 1)
+	{
+	    // refresh in this process, the callbacks can be used
+	    for (unsigned i = 0; i < services.size(); ++i)
+	    {
+		const std::string &alias = services[i].alias();
+		bool result = false;
+
+		try
+		{
+		    result = service_manager.RefreshService(alias, *repomanager, force);
+		}
+		catch (const zypp::Exception& excpt)
+		{
+		    y2error("Cannot refresh service %s", alias.c_str());
+		    _last_error.setLastError(ExceptionAsString(excpt));
+		}
+
+		if (result)
+		    refreshed.insert(alias);
+
+		ret->add(YCPString(alias), YCPBoolean(result));
+	    }
+	}
+	else
+	{
+	    PkgWorkers workers(jobs, boost::bind(&CallbackHandler::disconnectReceivers, &_callbackHandler));
+	    // the private copies of the repository and service files
+	    std::vector<zypp::filesystem::TmpDir> dirs;
+
+	    for (unsigned i = 0; i < services.size(); ++i)
+	    {
+		dirs.push_back(zypp::filesystem::TmpDir());
+		workers.add(boost::bind(ServiceRefreshJob, TargetRepoManagerOptions(), dirs[i].path(),
+		    services[i].alias(), force));
+	    }
+
+	    std::vector<int> statuses(services.size(), PkgWorkers::JOB_ABORTED);
+	    workers.run(boost::bind(ServiceRefreshFinished, &statuses, _1, _2));
+
+	    // merge the results into the shared repository manager
+	    for (unsigned i = 0; i < services.size(); ++i)
+	    {
+		const std::string &alias = services[i].alias();
+		bool result = statuses[i] == PkgWorkers::JOB_DONE;
+
+		if (result)
+		{
+		    try
+		    {
+			MergeServiceRefresh(*repomanager, alias, dirs[i].path());
+			result = service_manager.ReloadService(alias, *repomanager);
+		    }
+		    catch (const zypp::Exception& excpt)
+		    {
+			y2error("Cannot update service %s: %s", alias.c_str(), excpt.asString().c_str());
+			_last_error.setLastError(ExceptionAsString(excpt));
+			result = false;
+		    }
+		}
+
+		if (result)
+		    refreshed.insert(alias);
+		else
+		    y2error("Refreshing service %s failed (status %d)", alias.c_str(), statuses[i]);
+
+		ret->add(YCPString(alias), YCPBoolean(result));
+	    }
+	}
+
+	y2milestone("Refreshed %zd of %zd services", refreshed.size(), services.size());
+
+	// merge the changes of all services at once
+	if (!refreshed.empty())
+	    SyncServiceRepos(*repomanager, refreshed);
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	_last_error.setLastError(ExceptionAsString(excpt));
+	return YCPVoid();
+    }
+
+    return ret;
+}
+
 /**
    @builtin ServiceProbe
    @short Probe service type at a URL
@@ -488,8 +797,24 @@ YCPValue PkgFunctions::ServiceProbe(const YCPString &url)
 
     try
     {
+	const zypp::Url service_url(url->asString()->value());
+	const std::string key(ProbeKey("service", service_url));
+	std::string type;
+
+	// the add-on dialogs probe the same URL again when going back and forth
+	if (CachedProbe(key, type))
+	{
+	    y2milestone("Using the probed service type of %s: %s", service_url.asString().c_str(), type.c_str());
+	    return YCPString(type);
+	}
+
 	const zypp::RepoManager* repomanager = CreateRepoManager();
-	return YCPString(service_manager.Probe(zypp::Url(url->asString()->value()), *repomanager));
+	type = service_manager.Probe(service_url, *repomanager);
+
+	if (type != zypp::repo::ServiceType(zypp::repo::ServiceType::NONE).asString())
+	    StoreProbe(key, type);
+
+	return YCPString(type);
     }
     catch (const zypp::Exception& excpt)
     {
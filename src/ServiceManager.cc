@@ -43,6 +43,7 @@ void ServiceManager::LoadServices(const zypp::RepoManager &repomgr)
 	{
 	    // set the original alias to the current one
 	    PkgService s(*it, it->alias());
+	    s.setSaved();
 	    y2milestone("Loaded service %s (%s)", s.alias().c_str(), s.url().asString().c_str());
 	    _known_services.insert(std::make_pair(s.alias(), s));
 	}
@@ -55,8 +56,10 @@ void ServiceManager::LoadServices(const zypp::RepoManager &repomgr)
     }
 }
 
-void ServiceManager::SaveServices(zypp::RepoManager &repomgr)
+unsigned ServiceManager::SaveServices(zypp::RepoManager &repomgr)
 {
+    unsigned saved = 0;
+
     for (PkgServices::iterator it = _known_services.begin(); it != _known_services.end();)
     {
         if (it->second.isDeleted())
@@ -69,6 +72,7 @@ void ServiceManager::SaveServices(zypp::RepoManager &repomgr)
             {
                 y2milestone("Removing service %s", alias.c_str());
                 repomgr.removeService(alias);
+                ++saved;
             }
 
             // erase the removed service, not needed anymore after the final removal
@@ -82,8 +86,18 @@ void ServiceManager::SaveServices(zypp::RepoManager &repomgr)
 
     for_ (it, _known_services.begin(), _known_services.end())
     {
+        // do not rewrite the unchanged services
+        if (!it->second.isModified())
+        {
+            y2debug("Service %s has not been changed", it->first.c_str());
+            continue;
+        }
+
         SavePkgService(it->second, repomgr);
+        ++saved;
     }
+
+    return saved;
 }
 
 bool ServiceManager::SaveService(const std::string &alias, zypp::RepoManager &repomgr)
@@ -126,8 +140,22 @@ bool ServiceManager::RefreshService(const std::string &alias, zypp::RepoManager
         repomgr.refreshService(serv_it->second);
     }
 
+    return ReloadService(alias, repomgr);
+}
+
+bool ServiceManager::ReloadService(const std::string &alias, const zypp::RepoManager &repomgr)
+{
+    PkgServices::iterator serv_it = _known_services.find(alias);
+
+    if (serv_it == _known_services.end() || serv_it->second.isDeleted())
+    {
+	y2error("Service '%s' does not exist", alias.c_str());
+	return false;
+    }
+
     // load the service from disk
     PkgService new_service(repomgr.getService(alias), alias);
+    new_service.setSaved();
     DBG << "Reloaded service: " << new_service;
 
     // remove the old service
@@ -229,6 +257,14 @@ void ServiceManager::Reset()
     _services_loaded = false;
 }
 
+void ServiceManager::ResetSaved()
+{
+    for_(it, _known_services.begin(), _known_services.end())
+    {
+	it->second.resetSaved();
+    }
+}
+
 
 zypp::ServiceInfo ServiceManager::GetService(const std::string &alias) const
 {
@@ -332,4 +368,6 @@ void ServiceManager::SavePkgService(PkgService &s_known, zypp::RepoManager &repo
         // use the old alias
         repomgr.modifyService(orig_alias, s_known);
     }
+
+    s_known.setSaved();
 }
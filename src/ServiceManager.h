@@ -42,7 +42,8 @@ class ServiceManager
 
 	void LoadServices(const zypp::RepoManager &repomgr);
 
-	void SaveServices(zypp::RepoManager &repomgr);
+	// save the changed services, returns the number of the written files
+	unsigned SaveServices(zypp::RepoManager &repomgr);
 
 	bool SaveService(const std::string &alias, zypp::RepoManager &repomgr);
 
@@ -56,10 +57,16 @@ class ServiceManager
 
 	bool RefreshService(const std::string &alias, zypp::RepoManager &repomgr, bool force = false);
 
+	// reload the service from disk (after it has been refreshed by a worker process)
+	bool ReloadService(const std::string &alias, const zypp::RepoManager &repomgr);
+
 	std::string Probe(const zypp::Url &url, const zypp::RepoManager &repomgr) const;
 
 	void Reset();
 
+	// save all services again at the next SaveServices() call
+	void ResetSaved();
+
 	// is there any service? (incl. deleted!)
 	bool empty() const;
 
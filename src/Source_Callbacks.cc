@@ -38,6 +38,7 @@ void PkgFunctions::CallSourceReportStart(const std::string &text)
 {
     // get the YCP callback handler
     Y2Function* ycp_handler = _callbackHandler._ycpCallbacks.createCallback(CallbackHandler::YCPCallbacks::CB_SourceReportStart);
+    CallbackHandler::YCPCallbacks::Release ycp_handler_release(_callbackHandler._ycpCallbacks, CallbackHandler::YCPCallbacks::CB_SourceReportStart, ycp_handler);
 
     // is the callback registered?
     if (ycp_handler != NULL)
@@ -55,6 +56,7 @@ void PkgFunctions::CallSourceReportEnd(const std::string &text)
 {
     // get the YCP callback handler for end event
     Y2Function* ycp_handler = _callbackHandler._ycpCallbacks.createCallback(CallbackHandler::YCPCallbacks::CB_SourceReportEnd);
+    CallbackHandler::YCPCallbacks::Release ycp_handler_release(_callbackHandler._ycpCallbacks, CallbackHandler::YCPCallbacks::CB_SourceReportEnd, ycp_handler);
 
     // is the callback registered?
     if (ycp_handler != NULL)
@@ -74,6 +76,7 @@ void PkgFunctions::CallSourceReportInit()
 {
     // get the YCP callback handler for init event
     Y2Function* ycp_handler = _callbackHandler._ycpCallbacks.createCallback(CallbackHandler::YCPCallbacks::CB_SourceReportInit);
+    CallbackHandler::YCPCallbacks::Release ycp_handler_release(_callbackHandler._ycpCallbacks, CallbackHandler::YCPCallbacks::CB_SourceReportInit, ycp_handler);
 
     // is the callback registered?
     if (ycp_handler != NULL)
@@ -87,6 +90,7 @@ void PkgFunctions::CallSourceReportDestroy()
 {
     // get the YCP callback handler for destroy event
     Y2Function* ycp_handler = _callbackHandler._ycpCallbacks.createCallback(CallbackHandler::YCPCallbacks::CB_SourceReportDestroy);
+    CallbackHandler::YCPCallbacks::Release ycp_handler_release(_callbackHandler._ycpCallbacks, CallbackHandler::YCPCallbacks::CB_SourceReportDestroy, ycp_handler);
 
     // is the callback registered?
     if (ycp_handler != NULL)
@@ -100,6 +104,7 @@ void PkgFunctions::CallInitDownload(const std::string &task)
 {
     // get the YCP callback handler for destroy event
     Y2Function* ycp_handler = _callbackHandler._ycpCallbacks.createCallback(CallbackHandler::YCPCallbacks::CB_InitDownload);
+    CallbackHandler::YCPCallbacks::Release ycp_handler_release(_callbackHandler._ycpCallbacks, CallbackHandler::YCPCallbacks::CB_InitDownload, ycp_handler);
 
     // is the callback registered?
     if (ycp_handler != NULL)
@@ -114,6 +119,7 @@ void PkgFunctions::CallDestDownload()
 {
     // get the YCP callback handler for destroy event
     Y2Function* ycp_handler = _callbackHandler._ycpCallbacks.createCallback(CallbackHandler::YCPCallbacks::CB_DestDownload);
+    CallbackHandler::YCPCallbacks::Release ycp_handler_release(_callbackHandler._ycpCallbacks, CallbackHandler::YCPCallbacks::CB_DestDownload, ycp_handler);
 
     // is the callback registered?
     if (ycp_handler != NULL)
@@ -147,6 +153,15 @@ void PkgFunctions::RefreshWithCallbacks(const zypp::RepoInfo &repo, const zypp::
 // this method should be used instead of RepoManager::probe()
 zypp::repo::RepoType PkgFunctions::ProbeWithCallbacks(const zypp::Url &url)
 {
+    const std::string key(ProbeKey("repo", url));
+    std::string cached;
+
+    if (CachedProbe(key, cached, url.schemeIsVolatile()))
+    {
+	y2milestone("Using the probed type of %s: %s", url.asString().c_str(), cached.c_str());
+	return zypp::repo::RepoType(cached);
+    }
+
     CallInitDownload(std::string(_("Probing repository ") + url.asString()));
 
     zypp::repo::RepoType repotype;
@@ -181,6 +196,74 @@ zypp::repo::RepoType PkgFunctions::ProbeWithCallbacks(const zypp::Url &url)
     // restore the probing flag
     _silent_probing = _silent_probing_old;
 
+    // do not remember a failure, the repository might be fixed meanwhile
+    if (!url.schemeIsVolatile() && repotype != zypp::repo::RepoType::NONE)
+	StoreProbe(key, repotype.asString());
+
     return repotype;
 }
 
+// the probed types are reused for this time (in microseconds)
+static const long long probe_cache_ttl = 30 * 60 * 1000000LL;
+
+// the cache key: the kind ("repo", "service") and the URL including the product
+// directory, the options which do not change the type (alias, mount options) are removed,
+// the credentials are removed as well (the key is logged)
+std::string PkgFunctions::ProbeKey(const std::string &kind, const zypp::Url &url, const zypp::Pathname &dir) const
+{
+    zypp::Url key(url);
+
+    key.setUsername("");
+    key.setPassword("");
+
+    zypp::url::ParamMap query = key.getQueryStringMap();
+    query.erase("alias");
+    query.erase("mountoptions");
+    query.erase("proxyuser");
+    query.erase("proxypass");
+    key.setQueryStringMap(query);
+
+    // normalize the path ("//", "/./", the trailing "/")
+    zypp::Pathname path(key.getPathName());
+    if (!dir.empty())
+	path /= dir;
+    key.setPathName(path.absolutename().asString());
+
+    return kind + ":" + key.asCompleteString();
+}
+
+bool PkgFunctions::CachedProbe(const std::string &key, std::string &type, bool once)
+{
+    std::map<std::string, ProbeCacheEntry>::iterator it = probe_cache.find(key);
+
+    if (it == probe_cache.end())
+	return false;
+
+    if (PkgProfiler::now() - it->second.stamp > probe_cache_ttl)
+    {
+	y2debug("Expired probe cache entry %s", key.c_str());
+	probe_cache.erase(it);
+	return false;
+    }
+
+    type = it->second.type;
+
+    if (once)
+	probe_cache.erase(it);
+
+    return true;
+}
+
+void PkgFunctions::StoreProbe(const std::string &key, const std::string &type)
+{
+    ProbeCacheEntry &entry = probe_cache[key];
+    entry.type = type;
+    entry.stamp = PkgProfiler::now();
+}
+
+void PkgFunctions::InvalidateProbe(const std::string &key)
+{
+    if (probe_cache.erase(key) > 0)
+	y2milestone("Removed probe cache entry %s", key.c_str());
+}
+
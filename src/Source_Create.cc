@@ -36,6 +36,12 @@
 
 #include <zypp/MediaProducts.h>
 #include <zypp/media/Mount.h>
+#include <zypp/media/MediaManager.h>
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#include "PkgWorkers.h"
 
 /*
   Textdomain "pkg-bindings"
@@ -45,6 +51,9 @@
 // hack: zypp/MediaProducts.h cannot be included in PkgFunctions.h
 zypp::MediaProductSet available_products;
 
+// scanned products (URL => products) for this session
+static std::map<std::string, zypp::MediaProductSet> scanned_products;
+
 // this method should be used instead of zypp::productsInMedia()
 // it initializes the download callbacks
 void PkgFunctions::ScanProductsWithCallBacks(const zypp::Url &url)
@@ -60,10 +69,26 @@ void PkgFunctions::ScanProductsWithCallBacks(const zypp::Url &url)
 
     y2milestone("Scanning products in %s ...", url.asString().c_str());
 
+    // the medium might be changed, do not cache CD/DVD
+    const bool cacheable = !url.schemeIsVolatile();
+    std::map<std::string, zypp::MediaProductSet>::const_iterator cached = scanned_products.find(url.asCompleteString());
+
     try
     {
 	available_products.clear();
-	zypp::productsInMedia(url, available_products);
+
+	if (cacheable && cached != scanned_products.end())
+	{
+	    y2milestone("Using the scanned products");
+	    available_products = cached->second;
+	}
+	else
+	{
+	    zypp::productsInMedia(url, available_products);
+
+	    if (cacheable)
+		scanned_products[url.asCompleteString()] = available_products;
+	}
     }
     catch(...)
     {
@@ -142,6 +167,169 @@ zypp::Url addRO(const zypp::Url &url)
     return ret;
 }
 
+// the URL of a product directory on the medium
+static zypp::Url productUrl(const zypp::Url &url, const zypp::Pathname &dir)
+{
+    zypp::Url ret(url);
+
+    if (!dir.asString().empty())
+    {
+	zypp::Pathname pth(ret.getPathName());
+	pth /= dir;
+
+	ret.setPathName(pth.asString());
+    }
+
+    return ret;
+}
+
+// max. number of parallel probes (the probing waits mostly for the network or the medium)
+static const unsigned max_probe_jobs = 8;
+// the probed type is passed back in the job status of the worker, the values
+// below are reserved for the PkgWorkers::JobStatus values
+static const int probed_type_status = 16;
+
+// runs in a worker process
+static int probeJob(zypp::RepoManager *repomanager, const zypp::Url &url)
+{
+    return probed_type_status + repomanager->probe(url).toEnum();
+}
+
+// probe the types of the product directories in parallel worker processes,
+// the results are stored in the probe cache for createManagedSource(),
+// a failed probe is repeated later in the main process (with the error reporting)
+void PkgFunctions::ProbeProducts(const zypp::Url &url, const std::vector<zypp::Pathname> &dirs)
+{
+    // the cache keys
+    std::vector<zypp::Url> urls;
+    std::vector<zypp::Pathname> todo;
+
+    for_(it, dirs.begin(), dirs.end())
+    {
+	zypp::Url product_url(productUrl(url, *it));
+
+	if (probe_cache.find(ProbeKey("repo", product_url)) == probe_cache.end())
+	{
+	    urls.push_back(product_url);
+	    todo.push_back(*it);
+	}
+    }
+
+    if (urls.size() < 2)
+	return;
+
+    long long start = PkgProfiler::now();
+
+    zypp::Url media_url;
+    removeAlias(url, media_url);
+    media_url = addRO(media_url);
+
+    zypp::media::MediaManager media_manager;
+    zypp::media::MediaAccessId media_id = 0;
+    bool attached = false;
+    zypp::Pathname media_root;
+
+    extern ZyppRecipients::MediaChangeSensitivity _silent_probing;
+    ZyppRecipients::MediaChangeSensitivity _silent_probing_old = _silent_probing;
+    _silent_probing = ZyppRecipients::MEDIA_CHANGE_DISABLE;
+
+    // mount the medium only once in the main process, the workers probe
+    // the mounted directories (concurrent mounting of the same medium would fail)
+    std::string scheme(media_url.getScheme());
+    if (!media_url.schemeIsDownloading() && scheme != "dir" && scheme != "file")
+    {
+	try
+	{
+	    media_id = media_manager.open(media_url);
+	    attached = true;
+	    media_manager.attach(media_id);
+	    media_root = media_manager.localRoot(media_id);
+	}
+	catch (const zypp::Exception &e)
+	{
+	    y2warning("Cannot attach %s, probing sequentially: %s", media_url.asString().c_str(), e.asString().c_str());
+	    media_root = zypp::Pathname();
+	}
+
+	if (media_root.empty())
+	{
+	    if (attached)
+		media_manager.close(media_id);
+
+	    _silent_probing = _silent_probing_old;
+	    return;
+	}
+    }
+
+    PkgWorkers workers(std::min<unsigned>(max_probe_jobs, urls.size()),
+	boost::bind(&CallbackHandler::disconnectReceivers, &_callbackHandler));
+    zypp::RepoManager* repomanager = CreateRepoManager();
+
+    for (std::vector<zypp::Url>::size_type index = 0; index < urls.size(); ++index)
+    {
+	zypp::Url probe_url(urls[index]);
+
+	if (!media_root.empty())
+	{
+	    probe_url = zypp::Url("dir:///");
+	    probe_url.setPathName((media_root / todo[index]).asString());
+	}
+
+	workers.add(boost::bind(probeJob, repomanager, probe_url));
+    }
+
+    workers.run(boost::bind(&PkgFunctions::ProbeFinished, this, boost::cref(urls), _1, _2));
+
+    if (attached)
+    {
+	try
+	{
+	    media_manager.release(media_id);
+	    media_manager.close(media_id);
+	}
+	catch (const zypp::Exception &e)
+	{
+	    y2warning("Cannot release %s: %s", media_url.asString().c_str(), e.asString().c_str());
+	}
+    }
+
+    _silent_probing = _silent_probing_old;
+
+    y2milestone("Probed %zd product directories (%lldms)", urls.size(), (PkgProfiler::now() - start) / 1000);
+}
+
+bool PkgFunctions::ProbeFinished(const std::vector<zypp::Url> &urls, unsigned index, int status)
+{
+    const zypp::Url &url = urls[index];
+
+    if (status < probed_type_status)
+    {
+	y2warning("Probing %s failed (status %d)", url.asString().c_str(), status);
+	// continue with the other probes
+	return true;
+    }
+
+    zypp::repo::RepoType repotype(zypp::repo::RepoType::Type(status - probed_type_status));
+    y2milestone("Probed %s: %s", url.asString().c_str(), repotype.asString().c_str());
+
+    // stored even for CD/DVD, the entry is used only once
+    if (repotype != zypp::repo::RepoType::NONE)
+	StoreProbe(ProbeKey("repo", url), repotype.asString());
+
+    // report the result via the usual probe callbacks
+    zypp::callback::SendReport<zypp::repo::ProbeRepoReport> report;
+    report->start(url);
+
+    if (repotype == zypp::repo::RepoType::NONE)
+	report->failedProbe(url, repotype.asString());
+    else
+	report->successProbe(url, repotype.asString());
+
+    report->finish(url, zypp::repo::ProbeRepoReport::NO_ERROR, "");
+
+    return true;
+}
+
 /** Create a Source and immediately put it into the SourceManager.
  * \return the SourceId
  * \throws Exception if Source creation fails
@@ -186,15 +374,7 @@ PkgFunctions::createManagedSource( const zypp::Url & url_r,
     // the type is not specified or is wrong, autoprobe the type 
     if (repotype == zypp::repo::RepoType::NONE)
     {
-        zypp::Url probe_url(url_r);
-
-	if (!path_r.asString().empty())
-	{
-	    zypp::Pathname pth(probe_url.getPathName());
-	    pth /= path_r;
-
-	    probe_url.setPathName(pth.asString());
-	}
+        zypp::Url probe_url(productUrl(url_r, path_r));
 
 	y2milestone("Probing source type: '%s'", probe_url.asString().c_str());
 
@@ -298,7 +478,7 @@ PkgFunctions::createManagedSource( const zypp::Url & url_r,
 
     prg.toMax();
 }
-    repos.push_back(new YRepo(repo));
+    RepoId id = AddRepo(new YRepo(repo));
 
     y2milestone("Added source '%s': '%s', enabled: %s, autorefresh: %s",
 	repo.alias().c_str(),
@@ -308,7 +488,26 @@ PkgFunctions::createManagedSource( const zypp::Url & url_r,
     );
 
     // the source is at the end of the list
-    return repos.size() - 1;
+    return id;
+}
+
+/*
+ * A helper function - the background refresh of a new repository,
+ * it runs in a forked child process, see BackgroundJobs.
+ * The probed type is passed back in the exit status.
+ */
+static int AsyncRefreshJob(zypp::RepoManager *repomanager, zypp::RepoInfo repo)
+{
+    if (repo.type() == zypp::repo::RepoType::NONE)
+	repo.setType(repomanager->probe(productUrl(*repo.baseUrlsBegin(), repo.path())));
+
+    if (repo.type() == zypp::repo::RepoType::NONE)
+	return PkgWorkers::JOB_FAILED;
+
+    repomanager->refreshMetadata(repo, zypp::RepoManager::RefreshIfNeeded);
+    repomanager->buildCache(repo, zypp::RepoManager::BuildIfNeeded);
+
+    return probed_type_status + repo.type().toEnum();
 }
 
 /****************************************************************************************
@@ -321,7 +520,11 @@ PkgFunctions::createManagedSource( const zypp::Url & url_r,
  * automatically when loading the repository content (Pkg::SourceLoad())
  *
  * @param map map with repository parameters: $[ "enabled" : boolean, "autorefresh" : boolean, "name" : string,
- *   "alias" : string, "base_urls" : list<string>, "check_alias" : boolean, "priority" : integer, "prod_dir" : string, "type" : string ] 
+ *   "alias" : string, "base_urls" : list<string>, "check_alias" : boolean, "priority" : integer, "prod_dir" : string, "type" : string,
+ *   "async_refresh" : boolean ] 
+ * If "async_refresh" is true the metadata of a remote repository is downloaded and the cache
+ * is built in the background, the function returns immediately, use Pkg::SourceWait()
+ * to wait for the result. (Pkg::SourceLoad() and Pkg::SourceRefreshNow() wait automatically.)
  * @return integer Repository ID or nil on error
  **/
 YCPValue PkgFunctions::RepositoryAdd(const YCPMap &params)
@@ -425,10 +628,8 @@ YCPValue PkgFunctions::RepositoryAdd(const YCPMap &params)
 
 	if (check_alias)
 	{
-	    // search in stored repositories
-	    std::list<zypp::RepoInfo> reps = CreateRepoManager()->knownRepositories();
-
-	    if (aliasExists(alias, reps))
+	    // search in loaded and stored repositories
+	    if (aliasExists(alias))
 	    {
 		y2error("alias %s already exists", alias.c_str());
 		return YCPVoid();
@@ -488,6 +689,18 @@ YCPValue PkgFunctions::RepositoryAdd(const YCPMap &params)
 	repo.setPriority(params->value(YCPString("priority"))->asInteger()->value());
     }
 
+    // reuse the type detected by Pkg::RepositoryProbe(), do not probe it again in the refresh
+    if (repo.type() == zypp::repo::RepoType::NONE)
+    {
+	std::string cached;
+
+	if (CachedProbe(ProbeKey("repo", first_url, repo.path()), cached, first_url.schemeIsVolatile()))
+	{
+	    y2milestone("Using the probed type: %s", cached.c_str());
+	    repo.setType(zypp::repo::RepoType(cached));
+	}
+    }
+
     // set metadata path (#293428)
     zypp::RepoManager* repomanager = CreateRepoManager();
     zypp::Pathname metadatapath = repomanager->metadataPath(repo);
@@ -495,10 +708,107 @@ YCPValue PkgFunctions::RepositoryAdd(const YCPMap &params)
 
     repo.setPackagesPath(repomanager->packagesPath(repo));
 
-    repos.push_back(new YRepo(repo));
-
     // the new source is at the end of the list
-    return YCPInteger(repos.size() - 1);
+    RepoId id = AddRepo(new YRepo(repo));
+    StartPrefetch(id);
+
+    if (!params->value( YCPString("async_refresh") ).isNull() && params->value(YCPString("async_refresh"))->isBoolean()
+	&& params->value(YCPString("async_refresh"))->asBoolean()->value())
+    {
+	// mounting a medium in a child process would leave it mounted after exiting the child
+	if (repo.enabled() && first_url.schemeIsDownloading())
+	{
+	    y2milestone("Refreshing repository %s in the background", repo.alias().c_str());
+	    async_refresh.start(id, boost::bind(AsyncRefreshJob, repomanager, repo),
+		boost::bind(&CallbackHandler::disconnectReceivers, &_callbackHandler));
+	}
+	else
+	{
+	    y2milestone("Not refreshing repository %s in the background", repo.alias().c_str());
+	}
+    }
+
+    return YCPInteger(id);
+}
+
+bool PkgFunctions::WaitAsyncRefresh(const std::set<RepoId> &ids, long long timeout)
+{
+    bool ret = async_refresh.wait(ids, timeout);
+
+    // collect the results
+    std::set<RepoId> jobs(ids.empty() ? async_refresh.ids() : ids);
+
+    for_(it, jobs.begin(), jobs.end())
+    {
+	int status = async_refresh.status(*it);
+
+	// still running or unknown
+	if (status == -1 || status == PkgWorkers::JOB_ABORTED)
+	    continue;
+
+	async_refresh.remove(*it);
+
+	YRepo_Ptr repo = logFindRepository(*it);
+	if (!repo)
+	    continue;
+
+	if (status >= probed_type_status)
+	{
+	    zypp::repo::RepoType repotype(zypp::repo::RepoType::Type(status - probed_type_status));
+	    y2milestone("Repository %s has been refreshed in the background (type %s)",
+		repo->repoInfo().alias().c_str(), repotype.asString().c_str());
+
+	    if (repo->repoInfo().type() == zypp::repo::RepoType::NONE)
+		repo->repoInfo().setType(repotype);
+	}
+	else
+	{
+	    // e.g. an unknown GPG key, the user is asked in the usual refresh
+	    y2warning("Background refresh of %s failed (status %d), it will be refreshed again",
+		repo->repoInfo().alias().c_str(), status);
+	}
+    }
+
+    return ret;
+}
+
+/****************************************************************************************
+ * @builtin SourceWait
+ *
+ * @short Wait for the background refresh of the repositories
+ * @description
+ * Wait until the repositories added by Pkg::RepositoryAdd($[ "async_refresh" : true ])
+ * are refreshed and their cache is built. The repositories without a running
+ * background refresh are considered finished. A failed background refresh is not
+ * an error here, the repository is refreshed again in Pkg::SourceLoad() (which
+ * reports the errors or asks the user as usual).
+ *
+ * @param list<integer> ids repository IDs (empty list = all repositories)
+ * @param integer timeout in milliseconds (0 = do not wait, negative = no limit)
+ * @return boolean true if all requested refreshes have finished, false on timeout
+ **/
+YCPValue PkgFunctions::SourceWait(const YCPList &ids, const YCPInteger &timeout)
+{
+    if (ids.isNull() || timeout.isNull())
+    {
+	y2error("SourceWait: nil argument!");
+	return YCPBoolean(false);
+    }
+
+    std::set<RepoId> repos;
+
+    for (int index = 0; index < ids->size(); ++index)
+    {
+	if (!ids->value(index)->isInteger())
+	{
+	    y2error("SourceWait: not an integer at index %d: %s", index, ids->value(index)->toString().c_str());
+	    return YCPBoolean(false);
+	}
+
+	repos.insert(ids->value(index)->asInteger()->value());
+    }
+
+    return YCPBoolean(WaitAsyncRefresh(repos, timeout->value()));
 }
 
 /****************************************************************************************
@@ -625,6 +935,17 @@ PkgFunctions::SourceCreateEx (const YCPString& media, const YCPString& pd, bool
 	products.insert( entry );
     }
 
+    // probe all product directories at once, createManagedSource() uses the results
+    if (type.empty() && products.size() > 1)
+    {
+	std::vector<zypp::Pathname> dirs;
+
+	for_(it, products.begin(), products.end())
+	    dirs.push_back(it->_dir);
+
+	ProbeProducts(url, dirs);
+    }
+
     // scanning has been finished
     prg.set(5);
     pkgprogress.NextStage();
@@ -645,6 +966,9 @@ PkgFunctions::SourceCreateEx (const YCPString& media, const YCPString& pd, bool
 	    RepoId id = createManagedSource(url, it->_dir, type, alias, pkgprogress, subprogrcv);
 
 	    new_repos.push_back(id);
+
+	    // download the usually requested files while loading the resolvables
+	    StartPrefetch(id);
 	}
 	catch ( const zypp::Exception& excpt)
 	{
@@ -696,6 +1020,7 @@ PkgFunctions::SourceCreateEx (const YCPString& media, const YCPString& pd, bool
     {
 	RepoId new_id = createManagedSource(url, pn, type, "", pkgprogress, subprogrcv_create);
 	new_repos.push_back(new_id);
+	StartPrefetch(new_id);
 
 	if (!scan_only)
 	{
@@ -35,6 +35,9 @@
 #include <HelpTexts.h>
 
 #include <zypp/Fetcher.h>
+#include <zypp/PathInfo.h>
+
+#include <boost/bind.hpp>
 
 /*
   Textdomain "pkg-bindings"
@@ -91,6 +94,11 @@ YCPValue PkgFunctions::SourceProvideFileCommon(const YCPInteger &id,
 		fch.reset();
 		fch.setOptions(zypp::Fetcher::AutoAddIndexes);
 
+		// a prefetched file is used if it matches the checksum
+		zypp::Pathname prefetched(download_prefetch.dir(repo->repoInfo().alias(), mid->value()));
+		if (!prefetched.empty())
+		    fch.addCachePath(prefetched);
+
 		// path - add "/" to the beginning if it's missing there
 		std::string media_path(f->value());
 		if (media_path.size() >= 1 && media_path[0] != '/')
@@ -123,7 +131,13 @@ YCPValue PkgFunctions::SourceProvideFileCommon(const YCPInteger &id,
 	    }
 	    else
 	    {
-		path = repo->mediaAccess()->provideFile(f->value(), mid->value());
+		path = download_prefetch.lookup(repo->repoInfo().alias(), f->value(), mid->value());
+
+		if (path.empty())
+		    path = repo->mediaAccess()->provideFile(f->value(), mid->value());
+		else
+		    y2milestone("Using the prefetched file");
+
 		y2milestone("local path: '%s'", path.asString().c_str());
 	    }
 	}
@@ -168,6 +182,8 @@ YCPValue PkgFunctions::SourceProvideFileCommon(const YCPInteger &id,
 	    return YCPVoid();
 	}
 
+	download_prefetch.record(f->value(), mid->value());
+
 	return YCPString(path.asString());
     }
     else
@@ -389,6 +405,174 @@ PkgFunctions::SourceProvideDirectoryInternal(const YCPInteger& id, const YCPInte
 }
 
 
+/****************************************************************************************
+ * @builtin SourceProvideFiles
+ * @short Make several files available at the local filesystem
+ * @description
+ * Download several files from a repository at once. All files are queued into one
+ * fetcher, the medium is attached only once and the download progress is reported
+ * only once for all files.
+ * Warning: The downloaded files are removed in Pkg::SourceReleaseAll()!
+ *
+ * @param integer id repository to use (id)
+ * @param list<map> files list of files to download, the supported keys:
+ *   "file" : string - file name relative to the media root (mandatory)
+ *   "medium" : integer - number of the medium (default: 1)
+ *   "optional" : boolean - the file may not exist (default: false)
+ *   "check" : string - "none" (default), "digested" (the file must have a valid checksum)
+ *     or "signed" (the file is signed, like SourceProvideSignedFile())
+ * @return map<string,string> file name => local path, missing optional files are not
+ *   included, nil when an error occured
+ * @usage Pkg::SourceProvideFiles(0, [ $["file" : "/README"], $["file" : "/control.xml", "check" : "digested"] ])
+ */
+YCPValue
+PkgFunctions::SourceProvideFiles(const YCPInteger& id, const YCPList& files)
+{
+    if (id.isNull() || files.isNull())
+    {
+	y2error("SourceProvideFiles: nil argument!");
+	return YCPVoid();
+    }
+
+    YRepo_Ptr repo = logFindRepository(id->value());
+    if (!repo)
+	return YCPVoid();
+
+    zypp::Fetcher fch;
+    fch.reset();
+    fch.setOptions(zypp::Fetcher::AutoAddIndexes);
+
+    // the requested name => path relative to the download directory
+    std::map<std::string, std::string> requested;
+    bool all_optional = true;
+
+    for (int index = 0; index < files.size(); ++index)
+    {
+	if (files->value(index).isNull() || !files->value(index)->isMap())
+	{
+	    y2error("Invalid item at index %d in the file list, map expected", index);
+	    return YCPVoid();
+	}
+
+	YCPMap file(files->value(index)->asMap());
+	YCPValue name(file->value(YCPString("file")));
+
+	if (name.isNull() || !name->isString() || name->asString()->value().empty())
+	{
+	    y2error("Missing \"file\" key in %s", file->toString().c_str());
+	    return YCPVoid();
+	}
+
+	int medium = 1;
+	YCPValue val(file->value(YCPString("medium")));
+	if (!val.isNull() && val->isInteger())
+	    medium = val->asInteger()->value();
+
+	bool optional = false;
+	val = file->value(YCPString("optional"));
+	if (!val.isNull() && val->isBoolean())
+	    optional = val->asBoolean()->value();
+
+	std::string check("none");
+	val = file->value(YCPString("check"));
+	if (!val.isNull() && val->isString())
+	    check = val->asString()->value();
+
+	// path - add "/" to the beginning if it's missing there
+	std::string media_path(name->asString()->value());
+	if (media_path[0] != '/')
+	{
+	    media_path = "/" + media_path;
+	}
+
+	zypp::OnMediaLocation mloc(media_path, medium);
+	mloc.setOptional(optional);
+
+	if (check == "none")
+	{
+	    fch.enqueue(mloc);
+	}
+	else if (check == "digested")
+	{
+	    fch.enqueueDigested(mloc);
+	}
+	else if (check == "signed")
+	{
+	    fch.addIndex(mloc);
+	}
+	else
+	{
+	    y2error("Invalid \"check\" value: %s", check.c_str());
+	    return YCPVoid();
+	}
+
+	requested[name->asString()->value()] = media_path;
+	all_optional = all_optional && optional;
+    }
+
+    CallInitDownload(_("Downloading files"));
+
+    extern ZyppRecipients::MediaChangeSensitivity _silent_probing;
+    // remember the current value
+    ZyppRecipients::MediaChangeSensitivity _silent_probing_old = _silent_probing;
+
+    // disable media change callback if all files are optional
+    if (all_optional)
+	_silent_probing = ZyppRecipients::MEDIA_CHANGE_OPTIONALFILE;
+
+    y2milestone("Downloading %zd files from repository %lld", requested.size(), id->value());
+
+    // remember the current repo (needed at GPG key import)
+    current_repo = id->value();
+
+    bool success = true;
+    zypp::filesystem::Pathname path;
+
+    try
+    {
+	// create the tmpdir in <_download_area>
+	zypp::filesystem::TmpDir tmpdir(download_area_path());
+
+	// keep a reference to the tmpdir so the directory is not deleted at the and of the block
+	tmp_dirs.push_back(tmpdir);
+	path = tmpdir.path();
+
+	fch.start(path, *repo->mediaAccess()); // uses MediaAccess to retrieve
+	fch.reset();
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	_last_error.setLastError(ExceptionAsString(excpt));
+	y2error("Downloading the files failed: %s", excpt.asString().c_str());
+	success = false;
+    }
+
+    current_repo = -1LL;
+
+    // set the original probing value
+    _silent_probing = _silent_probing_old;
+
+    CallDestDownload();
+
+    if (!success)
+	return YCPVoid();
+
+    YCPMap ret;
+
+    for_(it, requested.begin(), requested.end())
+    {
+	zypp::Pathname local(path / it->second);
+
+	// skip the missing optional files
+	if (zypp::PathInfo(local).isFile())
+	    ret->add(YCPString(it->first), YCPString(local.asString()));
+	else
+	    y2milestone("File not found: %s", it->first.c_str());
+    }
+
+    return ret;
+}
+
 
 YCPValue
 PkgFunctions::SourceRefreshHelper (const YCPInteger& id, bool forced)
@@ -413,6 +597,15 @@ PkgFunctions::SourceRefreshHelper (const YCPInteger& id, bool forced)
     // 3 steps per repository (download, cache rebuild, load resolvables)
     pkgprogress.Start(_("Refreshing Repository..."), stages, _(HelpTexts::refresh_help));
 
+    // do not refresh the repository twice at the same time
+    std::set<RepoId> pending;
+    pending.insert(id->value());
+    WaitAsyncRefresh(pending);
+
+    // an explicit refresh probes the type again if needed
+    if (!repo->repoInfo().baseUrlsEmpty())
+	InvalidateProbe(ProbeKey("repo", *repo->repoInfo().baseUrlsBegin(), repo->repoInfo().path()));
+
     try
     {
 	zypp::RepoManager* repomanager = CreateRepoManager();
@@ -473,6 +666,22 @@ PkgFunctions::SourceForceRefreshNow (const YCPInteger& id)
     return SourceRefreshHelper(id, true);
 }
 
+// download the recorded SourceProvide*() files from the repository
+// in the background
+void PkgFunctions::StartPrefetch(RepoId id)
+{
+    if (!download_prefetch.enabled())
+	return;
+
+    YRepo_Ptr repo = logFindRepository(id);
+
+    if (repo)
+    {
+	download_prefetch.start(repo->repoInfo(), download_area_path(),
+	    boost::bind(&CallbackHandler::disconnectReceivers, &_callbackHandler));
+    }
+}
+
 zypp::Pathname PkgFunctions::download_area_path()
 {
     // create the tmpdir in the default location if _download_area is empty
@@ -124,12 +124,17 @@ PkgFunctions::SourceGetCurrent (const YCPBoolean& enabled)
 YCPValue
 PkgFunctions::SourceGeneralData (const YCPInteger& id)
 {
-    YCPMap data;
-
     YRepo_Ptr repo = logFindRepository(id->value());
     if (!repo)
 	return YCPVoid ();
 
+    return RepoGeneralData(repo);
+}
+
+YCPMap PkgFunctions::RepoGeneralData(const YRepo_Ptr &repo)
+{
+    YCPMap data;
+
     // convert type to the old strings ("YaST", "YUM" or "Plaindir")
     std::string srctype = zypp2yastType(repo->repoInfo().type().asString());
 
@@ -164,7 +169,7 @@ PkgFunctions::SourceGeneralData (const YCPInteger& id)
     data->add( YCPString("keeppackages"),	YCPBoolean(repo->repoInfo().keepPackages()));
 
     // add Repository data
-    zypp::Repository repository(zypp::ResPool::instance().reposFind(repo->repoInfo().alias()));
+    zypp::Repository repository(PoolRepository(logFindAlias(repo->repoInfo().alias())));
 
     if (repository != zypp::Repository::noRepository)
     {
@@ -219,42 +224,43 @@ PkgFunctions::SourceRawURL (const YCPInteger& id)
  * @param integer SrcId Specifies the InstSrc to query.
  * @return map
  **/
-YCPValue
-PkgFunctions::SourceMediaData (const YCPInteger& id)
+/*
+ * A helper function - find the max. medium number of the available packages
+ * for each repository (alias => media count), all repositories in one pass
+ */
+static std::map<std::string, int> MediaCounts(const zypp::ResPoolProxy &proxy, const std::string &alias = std::string())
 {
-    YCPMap data;
-    YRepo_Ptr repo = logFindRepository(id->value());
-    if (!repo)
-        return YCPVoid ();
-
-    std::string alias = repo->repoInfo().alias();
-    bool found_resolvable = false;
-    int max_medium = 1;
+    std::map<std::string, int> ret;
 
     // search the maximum source number of a package in the repository
     try
     {
-	for (zypp::ResPoolProxy::const_iterator it = zypp_ptr()->poolProxy().byKindBegin(zypp::ResKind::package);
-	    it != zypp_ptr()->poolProxy().byKindEnd(zypp::ResKind::package);
+	for (zypp::ResPoolProxy::const_iterator it = proxy.byKindBegin(zypp::ResKind::package);
+	    it != proxy.byKindEnd(zypp::ResKind::package);
 	    ++it)
 	{
-	    // search in available products
+	    // search in available packages
 	    for (zypp::ui::Selectable::available_iterator aval_it = (*it)->availableBegin();
 		aval_it != (*it)->availableEnd();
 		++aval_it)
 	    {
 		zypp::Package::constPtr pkg = zypp::asKind<zypp::Package>(aval_it->resolvable());
 
-		if (pkg && pkg->repoInfo().alias() == alias)
-		{
-		    found_resolvable = true;
+		if (!pkg)
+		    continue;
+
+		const std::string &pkg_alias = pkg->repoInfo().alias();
+
+		// only the requested repository
+		if (!alias.empty() && pkg_alias != alias)
+		    continue;
 
-		    int medium = pkg->mediaNr();
+		int medium = pkg->mediaNr();
+		int &max_medium = ret.insert(std::make_pair(pkg_alias, 1)).first->second;
 
-		    if (medium > max_medium)
-		    {
-			max_medium = medium;
-		    }
+		if (medium > max_medium)
+		{
+		    max_medium = medium;
 		}
 	    }
 	}
@@ -263,17 +269,39 @@ PkgFunctions::SourceMediaData (const YCPInteger& id)
     {
     }
 
-    if (found_resolvable)
+    return ret;
+}
+
+YCPValue
+PkgFunctions::SourceMediaData (const YCPInteger& id)
+{
+    YRepo_Ptr repo = logFindRepository(id->value());
+    if (!repo)
+        return YCPVoid ();
+
+    const std::string &alias = repo->repoInfo().alias();
+    std::map<std::string, int> media_counts = MediaCounts(zypp_ptr()->poolProxy(), alias);
+    std::map<std::string, int>::const_iterator count = media_counts.find(alias);
+
+    y2warning("Pkg::SourceMediaData() doesn't return \"media_id\" and \"media_vendor\" values anymore.");
+
+    return RepoMediaData(repo, count == media_counts.end() ? 0 : count->second);
+}
+
+// media_count - number of media, 0 = no package found
+YCPMap PkgFunctions::RepoMediaData(const YRepo_Ptr &repo, int media_count)
+{
+    YCPMap data;
+
+    if (media_count > 0)
     {
-	data->add( YCPString("media_count"), YCPInteger(max_medium));
+	data->add( YCPString("media_count"), YCPInteger(media_count));
     }
     else
     {
-	y2error("No resolvable from repository '%s' found, cannot get number of media (use Pkg::SourceLoad() to load the resolvables)", alias.c_str());
+	y2error("No resolvable from repository '%s' found, cannot get number of media (use Pkg::SourceLoad() to load the resolvables)", repo->repoInfo().alias().c_str());
     }
 
-    y2warning("Pkg::SourceMediaData() doesn't return \"media_id\" and \"media_vendor\" values anymore.");
-
     // SourceMediaData returns URLs without password
     if (repo->repoInfo().baseUrlsBegin() != repo->repoInfo().baseUrlsEnd())
     {
@@ -316,64 +344,184 @@ PkgFunctions::SourceMediaData (const YCPInteger& id)
  *
  * @return map
  **/
-YCPValue
-PkgFunctions::SourceProductData (const YCPInteger& src_id)
+/*
+ * A helper function - find the first available product for each repository
+ * (alias => product), all repositories in one pass
+ */
+static std::map<std::string, zypp::Product::constPtr> RepoProducts(const zypp::ResPoolProxy &proxy, const std::string &alias = std::string())
 {
-    YCPMap ret;
-
-    YRepo_Ptr repo = logFindRepository(src_id->value());
-    if (!repo)
-        return YCPVoid ();
-
-    std::string alias = repo->repoInfo().alias();
+    std::map<std::string, zypp::Product::constPtr> ret;
 
     try
     {
-	for (zypp::ResPoolProxy::const_iterator it = zypp_ptr()->poolProxy().byKindBegin(zypp::ResKind::product);
-	    it != zypp_ptr()->poolProxy().byKindEnd(zypp::ResKind::product);
+	for (zypp::ResPoolProxy::const_iterator it = proxy.byKindBegin(zypp::ResKind::product);
+	    it != proxy.byKindEnd(zypp::ResKind::product);
 	    ++it)
 	{
-	    zypp::Product::constPtr product = NULL;
-
 	    // search in available products
 	    for (zypp::ui::Selectable::available_iterator aval_it = (*it)->availableBegin();
 		aval_it != (*it)->availableEnd();
 		++aval_it)
 	    {
 		zypp::Product::constPtr prod = zypp::asKind<zypp::Product>(aval_it->resolvable());
-		if (prod && prod->repoInfo().alias() == alias)
+		if (!prod)
+		    continue;
+
+		const std::string &prod_alias = prod->repoInfo().alias();
+
+		if (alias.empty() || prod_alias == alias)
 		{
-		    product = prod;
-		    break;
+		    // the first found product wins
+		    ret.insert(std::make_pair(prod_alias, prod));
 		}
 	    }
 
-	    if (product)
-	    {
-		ret->add( YCPString("label"),		YCPString( product->summary() ) );
-		ret->add( YCPString("vendor"),		YCPString( product->vendor() ) );
-		ret->add( YCPString("productname"),	YCPString( product->name() ) );
-		ret->add( YCPString("productversion"),	YCPString( product->edition().version() ) );
-		ret->add( YCPString("relnotesurl"), 	YCPString( product->releaseNotesUrls().first().asString()));
-		
-		ret->add( YCPString("relnotes_urls"), 	asYCPList(product->releaseNotesUrls()));
-		ret->add( YCPString("register_urls"), 	asYCPList(product->registerUrls()));
-		ret->add( YCPString("smolt_urls"), 	asYCPList(product->smoltUrls()));
-		ret->add( YCPString("update_urls"), 	asYCPList(product->updateUrls()));
-		ret->add( YCPString("extra_urls"), 	asYCPList(product->extraUrls()));
-		ret->add( YCPString("optional_urls"), 	asYCPList(product->optionalUrls()));
-
+	    if (!alias.empty() && !ret.empty())
 		break;
-	    }
 	}
+    }
+    catch (...)
+    {
+    }
+
+    return ret;
+}
+
+static YCPMap ProductData(const zypp::Product::constPtr &product)
+{
+    YCPMap ret;
+
+    ret->add( YCPString("label"),		YCPString( product->summary() ) );
+    ret->add( YCPString("vendor"),		YCPString( product->vendor() ) );
+    ret->add( YCPString("productname"),	YCPString( product->name() ) );
+    ret->add( YCPString("productversion"),	YCPString( product->edition().version() ) );
+    ret->add( YCPString("relnotesurl"), 	YCPString( product->releaseNotesUrls().first().asString()));
+
+    ret->add( YCPString("relnotes_urls"), 	asYCPList(product->releaseNotesUrls()));
+    ret->add( YCPString("register_urls"), 	asYCPList(product->registerUrls()));
+    ret->add( YCPString("smolt_urls"), 	asYCPList(product->smoltUrls()));
+    ret->add( YCPString("update_urls"), 	asYCPList(product->updateUrls()));
+    ret->add( YCPString("extra_urls"), 	asYCPList(product->extraUrls()));
+    ret->add( YCPString("optional_urls"), 	asYCPList(product->optionalUrls()));
+
+    return ret;
+}
+
+YCPValue
+PkgFunctions::SourceProductData (const YCPInteger& src_id)
+{
+    YRepo_Ptr repo = logFindRepository(src_id->value());
+    if (!repo)
+        return YCPVoid ();
+
+    const std::string &alias = repo->repoInfo().alias();
+    std::map<std::string, zypp::Product::constPtr> products = RepoProducts(zypp_ptr()->poolProxy(), alias);
+    std::map<std::string, zypp::Product::constPtr>::const_iterator it = products.find(alias);
+
+    if (it == products.end())
+    {
+	y2warning("Product for source '%lld' not found", src_id->value());
+	return YCPMap();
+    }
+
+    return ProductData(it->second);
+}
+
+/****************************************************************************************
+ * @builtin SourceGetAll
+ * @short Return the data of all repositories at once
+ * @description
+ * Returns the requested data for all (not deleted) repositories in one call,
+ * the pool is scanned only once for all repositories.
+ *
+ * The supported keys:
+ * "general" (map, see Pkg::SourceGeneralData()), "media" (map, see Pkg::SourceMediaData()),
+ * "product" (map, see Pkg::SourceProductData(), an empty map if not found),
+ * "url" (string, see Pkg::SourceURL()), "raw_url" (string, see Pkg::SourceRawURL())
+ *
+ * @param list<string> keys the requested data, empty list = all
+ * @return map $[ SrcId : $[ "general" : map, "media" : map, ... ] ] or nil on an invalid key
+ * @usage Pkg::SourceGetAll(["general", "url"]) -> $[0 : $["general" : $[...], "url" : "http://..."]]
+ **/
+YCPValue
+PkgFunctions::SourceGetAll (const YCPList& keys)
+{
+    const char *known[] = { "general", "media", "product", "url", "raw_url" };
+    const unsigned known_count = sizeof(known) / sizeof(known[0]);
+    bool wanted[known_count];
 
-	if(ret->size() == 0)
+    for (unsigned i = 0; i < known_count; ++i)
+	wanted[i] = keys.isNull() || keys->isEmpty();
+
+    if (!keys.isNull())
+    {
+	for (int k = 0; k < keys->size(); ++k)
 	{
-	    y2warning("Product for source '%lld' not found", src_id->value());
+	    if (!keys->value(k)->isString())
+	    {
+		y2error("Pkg::SourceGetAll: invalid key %s, a string is expected", keys->value(k)->toString().c_str());
+		return YCPVoid();
+	    }
+
+	    std::string key = keys->value(k)->asString()->value();
+	    unsigned i = 0;
+
+	    while (i < known_count && key != known[i])
+		++i;
+
+	    if (i == known_count)
+	    {
+		y2error("Pkg::SourceGetAll: unknown key \"%s\"", key.c_str());
+		return YCPVoid();
+	    }
+
+	    wanted[i] = true;
 	}
     }
-    catch (...)
+
+    // scan the pool only once for all repositories
+    std::map<std::string, int> media_counts;
+    std::map<std::string, zypp::Product::constPtr> products;
+
+    if (wanted[1])
+	media_counts = MediaCounts(zypp_ptr()->poolProxy());
+
+    if (wanted[2])
+	products = RepoProducts(zypp_ptr()->poolProxy());
+
+    YCPMap ret;
+
+    RepoId index = 0LL;
+    for (RepoCont::const_iterator it = repos.begin(); it != repos.end(); ++it, ++index)
     {
+	if ((*it)->isDeleted())
+	    continue;
+
+	const std::string &alias = (*it)->repoInfo().alias();
+	YCPMap data;
+
+	if (wanted[0])
+	    data->add(YCPString("general"), RepoGeneralData(*it));
+
+	if (wanted[1])
+	{
+	    std::map<std::string, int>::const_iterator count = media_counts.find(alias);
+	    data->add(YCPString("media"), RepoMediaData(*it, count == media_counts.end() ? 0 : count->second));
+	}
+
+	if (wanted[2])
+	{
+	    std::map<std::string, zypp::Product::constPtr>::const_iterator product = products.find(alias);
+	    data->add(YCPString("product"), product == products.end() ? YCPMap() : ProductData(product->second));
+	}
+
+	if (wanted[3])
+	    data->add(YCPString("url"), GetSourceUrl(YCPInteger(index), false));
+
+	if (wanted[4])
+	    data->add(YCPString("raw_url"), GetSourceUrl(YCPInteger(index), true));
+
+	ret->add(YCPInteger(index), data);
     }
 
     return ret;
@@ -27,6 +27,10 @@
 
 #include <PkgFunctions.h>
 #include "log.h"
+#include "Callbacks.h"
+#include "TreeCopy.h"
+
+#include <boost/bind.hpp>
 
 #include <zypp/ExternalProgram.h>
 
@@ -146,45 +150,10 @@ bool PkgFunctions::CopyToDir(const std::string &source, const std::string &targe
 	return false;
     }
 
-    const char* argv[] =
-    {
-      "cp",
-      // preserve the time stamps and permissions
-      "-a",
-      // fill the parameters later
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      NULL,
-      NULL
-    };
-
-    int pos = 2;
-
-    if (recursive)
-    {
-	argv[pos++] = "-r";
-    }
-
-    if (backup)
-    {
-	argv[pos++] = "-b";
-    }
-
-    // finish parameter list
-    argv[pos++] = "--";
-
-    // source
-    argv[pos++] = source.c_str();
-
-    // target
-    argv[pos++] = target.c_str();
-
-    // discard stderr, no pty, stderr_fd = -1, use the default locale
-    zypp::ExternalProgram prog(argv, zypp::ExternalProgram::Discard_Stderr, false, -1, true);
+    // like "cp -a", but the files are cloned or copied in the kernel when possible
+    TreeCopy tree_copy(0, backup, boost::bind(&CallbackHandler::disconnectReceivers, &_callbackHandler));
 
-    if (prog.close())
+    if (!tree_copy.copy(source, target, recursive))
     {
 	// error message (followed by detailed description)
 	const std::string msg = _("Error: Cannot copy the cache to the target directory\n");
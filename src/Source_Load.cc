@@ -32,8 +32,19 @@
 #include "log.h"
 
 #include <PkgProgress.h>
+#include <PkgWorkers.h>
 #include <HelpTexts.h>
 
+#include <ycp/YCPBoolean.h>
+#include <ycp/YCPInteger.h>
+#include <ycp/YCPString.h>
+#include <ycp/YCPVoid.h>
+
+#include <zypp/sat/Pool.h>
+
+#include <set>
+#include <sstream>
+
 /*
   Textdomain "pkg-bindings"
 */
@@ -125,7 +136,10 @@ PkgFunctions::SourceRestore()
 	for (std::list<zypp::RepoInfo>::iterator it = reps.begin();
 	    it != reps.end(); ++it)
 	{
-	    repos.push_back(new YRepo(*it));
+	    YRepo_Ptr repo = new YRepo(*it);
+	    // the same as on disk, no need to save it
+	    repo->setSaved();
+	    AddRepo(repo);
 	}
     }
     catch (const zypp::Exception& excpt)
@@ -171,6 +185,7 @@ void PkgFunctions::CallRefreshStarted()
 {
     // get the YCP callback handler for destroy event
     Y2Function* ycp_handler = _callbackHandler._ycpCallbacks.createCallback(CallbackHandler::YCPCallbacks::CB_StartSourceRefresh);
+    CallbackHandler::YCPCallbacks::Release ycp_handler_release(_callbackHandler._ycpCallbacks, CallbackHandler::YCPCallbacks::CB_StartSourceRefresh, ycp_handler);
 
     // is the callback registered?
     if (ycp_handler != NULL)
@@ -184,6 +199,7 @@ void PkgFunctions::CallRefreshDone()
 {
     // get the YCP callback handler for destroy event
     Y2Function* ycp_handler = _callbackHandler._ycpCallbacks.createCallback(CallbackHandler::YCPCallbacks::CB_DoneSourceRefresh);
+    CallbackHandler::YCPCallbacks::Release ycp_handler_release(_callbackHandler._ycpCallbacks, CallbackHandler::YCPCallbacks::CB_DoneSourceRefresh, ycp_handler);
 
     // is the callback registered?
     if (ycp_handler != NULL)
@@ -199,11 +215,295 @@ YCPValue PkgFunctions::SkipRefresh()
     return YCPVoid();
 }
 
+/*
+ * A helper function - worker job for the parallel refresh,
+ * it runs in a forked child process, see PkgWorkers
+ * The solv cache is built, too (pipelined load).
+ */
+static int RefreshJob(zypp::RepoManager *repomanager, const zypp::RepoInfo &repo)
+{
+    int ret = PkgWorkers::JOB_SKIPPED;
+
+    zypp::RepoManager::RefreshCheckStatus ref_stat = repomanager->checkIfToRefreshMetadata(repo, *(repo.baseUrlsBegin()));
+
+    if (ref_stat == zypp::RepoManager::REFRESH_NEEDED)
+    {
+	repomanager->refreshMetadata(repo, zypp::RepoManager::RefreshIfNeeded);
+	ret = PkgWorkers::JOB_DONE;
+    }
+
+    repomanager->buildCache(repo, zypp::RepoManager::BuildIfNeeded);
+
+    return ret;
+}
+
+// the shared state of the parallel refresh
+struct ParallelRefreshState
+{
+    typedef boost::function<bool (const YRepo_Ptr &)> LoadFnc;
+
+    ParallelRefreshState(const std::vector<YRepo_Ptr> &jobs_r, zypp::ProgressData &prog_total_r,
+	volatile bool &skipped_r, const LoadFnc &load_r)
+	: jobs(jobs_r), status(jobs_r.size(), -1), start_time(PkgProfiler::now()), times(jobs_r.size(), 0),
+	next_load(0), prog_total(prog_total_r), skipped(skipped_r), load(load_r), success(true)
+    {}
+
+    const std::vector<YRepo_Ptr> &jobs;
+    // the job status, -1 = not finished yet
+    std::vector<int> status;
+    // the time from the start until the job has finished (us)
+    long long start_time;
+    std::vector<long long> times;
+    // the next job to load (the resolvables are loaded in the original order)
+    unsigned next_load;
+    std::set<YRepo_Ptr> done;
+    zypp::ProgressData &prog_total;
+    volatile bool &skipped;
+    // load the resolvables (parallel refresh), empty = no loading
+    LoadFnc load;
+    bool success;
+};
+
+static bool RefreshFinished(ParallelRefreshState *state, unsigned index, int status)
+{
+    const YRepo_Ptr &repo = state->jobs[index];
+    state->status[index] = status;
+    state->times[index] = PkgProfiler::now() - state->start_time;
+
+    if (status == PkgWorkers::JOB_DONE || status == PkgWorkers::JOB_SKIPPED)
+    {
+	y2milestone("Repository '%s' %s", repo->repoInfo().alias().c_str(),
+	    status == PkgWorkers::JOB_DONE ? "has been refreshed" : "is up to date");
+
+	// the sequential refresh adds the progress for the failed ones,
+	// (refresh + cache rebuild)
+	if (!state->prog_total.incr(200))
+	{
+	    y2warning("Refresh aborted by user");
+	    state->skipped = true;
+	}
+    }
+    else
+    {
+	y2warning("Parallel refresh of '%s' failed (status %d), will retry",
+	    repo->repoInfo().alias().c_str(), status);
+    }
+
+    // insert the finished repositories into the pool in the original order,
+    // the pool is modified only here in the main process
+    while (!state->skipped && state->next_load < state->jobs.size()
+	&& state->status[state->next_load] != -1)
+    {
+	int st = state->status[state->next_load];
+
+	if (st == PkgWorkers::JOB_DONE || st == PkgWorkers::JOB_SKIPPED)
+	{
+	    const YRepo_Ptr &loaded_repo = state->jobs[state->next_load];
+	    state->success = state->load(loaded_repo) && state->success;
+	    state->done.insert(loaded_repo);
+	}
+
+	++state->next_load;
+    }
+
+    return !state->skipped;
+}
+
+/*
+ * A helper function - refresh the remote repositories in forked worker
+ * processes. The workers run without any user interaction (e.g. they cannot
+ * ask for importing a new GPG key) so the failed repositories are left for
+ * the sequential refresh which reports errors and asks the user as usual.
+ * The progress is increased for the successfully refreshed repositories.
+ *
+ * The workers also build the solv cache and the resolvables are loaded
+ * as soon as a repository is ready (pipelined load), so the cache build
+ * and loading overlap the downloads of the other repositories.
+ *
+ * Returns the repositories which do not need to be refreshed
+ * and loaded anymore.
+ */
+std::set<YRepo_Ptr> PkgFunctions::ParallelRefresh(const RepoCont &candidates, zypp::ProgressData &prog_total, bool &success)
+{
+    zypp::RepoManager* repomanager = CreateRepoManager();
+    PkgWorkers workers(refresh_jobs, boost::bind(&CallbackHandler::disconnectReceivers, &_callbackHandler));
+    std::vector<YRepo_Ptr> jobs;
+
+    for (RepoCont::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
+    {
+	const zypp::RepoInfo &repoinfo = (*it)->repoInfo();
+
+	// only the downloading schemes, mounting a medium in a child process
+	// would leave it mounted after exiting the child
+	if (repoinfo.baseUrlsEmpty() || !repoinfo.baseUrlsBegin()->schemeIsDownloading())
+	{
+	    continue;
+	}
+
+	workers.add(boost::bind(RefreshJob, repomanager, repoinfo));
+	jobs.push_back(*it);
+    }
+
+    if (jobs.size() < 2)
+    {
+	y2milestone("Not enough remote repositories for the parallel refresh");
+	return std::set<YRepo_Ptr>();
+    }
+
+    // load objects, do network status check
+    ParallelRefreshState state(jobs, prog_total, autorefresh_skipped,
+	boost::bind(&PkgFunctions::LoadPipelinedRepo, this, _1, boost::ref(prog_total)));
+    workers.run(boost::bind(RefreshFinished, &state, _1, _2));
+    y2milestone("Loaded in parallel: %zd of %zd repositories", state.done.size(), jobs.size());
+
+    for (unsigned index = 0; index < jobs.size(); ++index)
+    {
+	int status = state.status[index];
+
+	if (status != PkgWorkers::JOB_DONE && status != PkgWorkers::JOB_SKIPPED)
+	    continue;
+
+	LoadStats::Repo &stats = RepoLoadStats(jobs[index]);
+	stats.parallel = true;
+	stats.refresh_time = state.times[index];
+	stats.refreshed = status == PkgWorkers::JOB_DONE;
+
+	if (stats.refreshed)
+	{
+	    stats.downloaded = MetadataSize(jobs[index]->repoInfo());
+	    // the cache has been rebuilt in the pipeline
+	    stats.cache_built = true;
+	}
+    }
+
+    success = state.success && success;
+    return state.done;
+}
+
+bool PkgFunctions::LoadPipelinedRepo(const YRepo_Ptr &repo, zypp::ProgressData &prog_total)
+{
+    zypp::CombinedProgressData load_subprogress(prog_total, 100);
+    return LoadResolvablesFrom(repo, load_subprogress, true);
+}
+
+/*
+ * A helper function - the solv cache matches the raw metadata,
+ * buildCache(BuildIfNeeded) would not rebuild it
+ */
+static bool CacheUpToDate(zypp::RepoManager &repomanager, const zypp::RepoInfo &repo)
+{
+    return repomanager.isCached(repo)
+	&& repomanager.cacheStatus(repo).checksum() == repomanager.metadataStatus(repo).checksum();
+}
+
+/*
+ * A helper function - worker job for the parallel cache build,
+ * it runs in a forked child process, see PkgWorkers
+ */
+static int BuildCacheJob(zypp::RepoManager *repomanager, const zypp::RepoInfo &repo)
+{
+    repomanager->buildCache(repo, zypp::RepoManager::BuildIfNeeded);
+    return PkgWorkers::JOB_DONE;
+}
+
+static bool BuildCacheFinished(ParallelRefreshState *state, unsigned index, int status)
+{
+    const YRepo_Ptr &repo = state->jobs[index];
+    state->status[index] = status;
+    state->times[index] = PkgProfiler::now() - state->start_time;
+
+    if (status != PkgWorkers::JOB_DONE)
+    {
+	y2warning("Parallel cache build of '%s' failed (status %d), will retry",
+	    repo->repoInfo().alias().c_str(), status);
+	return true;
+    }
+
+    y2milestone("The cache for '%s' is ready", repo->repoInfo().alias().c_str());
+    state->done.insert(repo);
+
+    if (!state->prog_total.incr(100))
+    {
+	y2warning("Cache build aborted by user");
+	state->skipped = true;
+    }
+
+    return !state->skipped;
+}
+
+/*
+ * A helper function - build the solv caches in forked worker processes,
+ * converting the metadata is CPU bound and independent for each repository.
+ * The resolvables are still loaded into the pool in the main process,
+ * the failed repositories are left for the sequential build which reports
+ * the errors as usual. The progress is increased for the built repositories.
+ *
+ * Returns the repositories with an up to date cache.
+ */
+std::set<YRepo_Ptr> PkgFunctions::ParallelBuildCache(const RepoCont &candidates, zypp::ProgressData &prog_total)
+{
+    if (build_jobs < 2 || candidates.size() < 2)
+    {
+	return std::set<YRepo_Ptr>();
+    }
+
+    zypp::RepoManager* repomanager = CreateRepoManager();
+    PkgWorkers workers(build_jobs, boost::bind(&CallbackHandler::disconnectReceivers, &_callbackHandler));
+    std::vector<YRepo_Ptr> jobs(candidates.begin(), candidates.end());
+    std::vector<bool> cached;
+
+    for_(it, jobs.begin(), jobs.end())
+    {
+	cached.push_back(CacheUpToDate(*repomanager, (*it)->repoInfo()));
+	workers.add(boost::bind(BuildCacheJob, repomanager, (*it)->repoInfo()));
+    }
+
+    ParallelRefreshState state(jobs, prog_total, autorefresh_skipped, ParallelRefreshState::LoadFnc());
+    workers.run(boost::bind(BuildCacheFinished, &state, _1, _2));
+    y2milestone("Built the cache in parallel: %zd of %zd repositories", state.done.size(), jobs.size());
+
+    for (unsigned index = 0; index < jobs.size(); ++index)
+    {
+	if (state.status[index] != PkgWorkers::JOB_DONE)
+	    continue;
+
+	LoadStats::Repo &stats = RepoLoadStats(jobs[index]);
+	stats.parallel = true;
+	stats.build_time = state.times[index];
+	stats.cache_built = stats.cache_built || !cached[index];
+    }
+
+    return state.done;
+}
+
+// reset the flag when leaving the scope (also by an exception)
+class ResetFlagOnExit
+{
+    public:
+	ResetFlagOnExit(bool &flag) : _flag(flag) {}
+	~ResetFlagOnExit() { _flag = false; }
+
+    private:
+	bool &_flag;
+};
+
 YCPValue
 PkgFunctions::SourceLoadImpl(PkgProgress &progress)
 {
     bool success = true;
 
+    // loading now, the lazy load is not needed anymore
+    lazy_pending = false;
+
+    load_stats = LoadStats();
+    load_stats.active = true;
+    load_stats.start_time = PkgProfiler::now();
+    // an exception would leave the next loads recording to these stats
+    ResetFlagOnExit stats_active(load_stats.active);
+
+    // the repositories added with "async_refresh" are refreshed in the background
+    WaitAsyncRefresh(std::set<RepoId>());
+
     int repos_to_load = 0;
     int repos_to_refresh = 0;
     for (RepoCont::iterator it = repos.begin();
@@ -238,6 +538,47 @@ PkgFunctions::SourceLoadImpl(PkgProgress &progress)
     // don't load packages from them
     RepoCont failed_refresh;
 
+    // repositories already refreshed and loaded by the parallel workers
+    std::set<YRepo_Ptr> refreshed;
+
+    if (repos_to_refresh > 1 && refresh_jobs > 1)
+    {
+	RepoCont candidates;
+
+	for (RepoCont::iterator it = repos.begin();
+	   it != repos.end(); ++it)
+	{
+	    if (!(*it)->repoInfo().enabled() || (*it)->isDeleted() || (*it)->isLoaded()
+		|| (*it)->repoInfo().baseUrlsEmpty())
+	    {
+		continue;
+	    }
+
+	    if (!(*it)->repoInfo().autorefresh() && !repomanager->metadataStatus((*it)->repoInfo()).empty())
+	    {
+		continue;
+	    }
+
+	    // skipped in the loop below
+	    if (!network_is_running && remoteRepo(*((*it)->repoInfo().baseUrlsBegin())))
+	    {
+		continue;
+	    }
+
+	    candidates.push_back(*it);
+	}
+
+	if (!candidates.empty())
+	{
+	    CallRefreshStarted();
+	    refresh_started_called = true;
+
+	    // in the parallel mode build the caches and load the resolvables
+	    // in the workers pipeline, too
+	    refreshed = ParallelRefresh(candidates, prog_total, success);
+	}
+    }
+
     if (repos_to_refresh > 0)
     {
 	// refresh metadata
@@ -247,6 +588,19 @@ PkgFunctions::SourceLoadImpl(PkgProgress &progress)
 	    // load resolvables only from enabled repos which are not deleted
 	    if ((*it)->repoInfo().enabled() && !(*it)->isDeleted())
 	    {
+		if (refreshed.find(*it) != refreshed.end())
+		{
+		    // the progress has been already increased
+		    y2debug("Repository '%s' has been already loaded", (*it)->repoInfo().alias().c_str());
+		    continue;
+		}
+
+		if (autorefresh_skipped)
+		{
+		    y2warning("Skipping autorefresh for the rest of repositories");
+		    break;
+		}
+
 		// sub tasks
 		zypp::CombinedProgressData refresh_subprogress(prog_total, 100);
 		zypp::ProgressData prog(100);
@@ -286,7 +640,10 @@ PkgFunctions::SourceLoadImpl(PkgProgress &progress)
 				refresh_started_called = true;
 			    }
 
+			    LoadStats::Repo &stats = RepoLoadStats(*it);
+			    long long start = PkgProfiler::now();
 			    zypp::RepoManager::RefreshCheckStatus ref_stat = repomanager->checkIfToRefreshMetadata((*it)->repoInfo(), *((*it)->repoInfo().baseUrlsBegin()));
+			    stats.check_time = PkgProfiler::now() - start;
 
 			    if (ref_stat != zypp::RepoManager::REFRESH_NEEDED)
 			    {
@@ -296,7 +653,11 @@ PkgFunctions::SourceLoadImpl(PkgProgress &progress)
 
 			    y2milestone("Autorefreshing source: %s", (*it)->repoInfo().alias().c_str());
 			    // refresh the repository
+			    start = PkgProfiler::now();
 			    RefreshWithCallbacks((*it)->repoInfo(), prog.receiver());
+			    stats.refresh_time = PkgProfiler::now() - start;
+			    stats.refreshed = true;
+			    stats.downloaded = MetadataSize((*it)->repoInfo());
 			}
 			// NOTE: subtask progresses are reported as done in the destructor
 			// no need to handle them in the exception code
@@ -304,6 +665,7 @@ PkgFunctions::SourceLoadImpl(PkgProgress &progress)
 			{
 			    // remember the failed autorefresh
 			    failed_refresh.push_back(*it);
+			    RepoLoadStats(*it).failed = true;
 
 			    if (autorefresh_skipped)
 			    {
@@ -336,6 +698,41 @@ PkgFunctions::SourceLoadImpl(PkgProgress &progress)
 
     progress.NextStage();
 
+    // the caches to rebuild below and the missing caches otherwise built
+    // by LoadResolvablesFrom(), build them in parallel at first
+    std::set<YRepo_Ptr> built;
+
+    if (!autorefresh_skipped)
+    {
+	RepoCont to_build;
+
+	for (RepoCont::iterator it = repos.begin();
+	   it != repos.end(); ++it)
+	{
+	    const zypp::RepoInfo &repoinfo = (*it)->repoInfo();
+
+	    if (!repoinfo.enabled() || (*it)->isDeleted() || (*it)->isLoaded()
+		|| refreshed.find(*it) != refreshed.end())
+	    {
+		continue;
+	    }
+
+	    // plaindir reads the packages from the medium, build it in the main process
+	    if (repoinfo.type().toEnum() == zypp::repo::RepoType::RPMPLAINDIR_e)
+	    {
+		continue;
+	    }
+
+	    if ((repoinfo.autorefresh() || !repomanager->isCached(repoinfo))
+		&& !repomanager->metadataStatus(repoinfo).empty())
+	    {
+		to_build.push_back(*it);
+	    }
+	}
+
+	built = ParallelBuildCache(to_build, prog_total);
+    }
+
     // rebuild cache
     for (RepoCont::iterator it = repos.begin();
        it != repos.end(); ++it)
@@ -343,6 +740,19 @@ PkgFunctions::SourceLoadImpl(PkgProgress &progress)
 	// load resolvables only from enabled repos which are not deleted
 	if ((*it)->repoInfo().enabled() && !(*it)->isDeleted())
 	{
+	    if (refreshed.find(*it) != refreshed.end())
+	    {
+		// already loaded in the pipeline
+		continue;
+	    }
+
+	    if (built.find(*it) != built.end())
+	    {
+		// the progress has been already increased
+		y2debug("The cache for '%s' has been already built", (*it)->repoInfo().alias().c_str());
+		continue;
+	    }
+
 	    // sub tasks
 	    zypp::CombinedProgressData rebuild_subprogress(prog_total, 100);
 	    zypp::ProgressData prog(100);
@@ -372,8 +782,13 @@ PkgFunctions::SourceLoadImpl(PkgProgress &progress)
 			// rebuild cache (the default policy is "if needed")
 			y2milestone("Rebuilding cache for '%s'...", (*it)->repoInfo().alias().c_str());
 
+			LoadStats::Repo &stats = RepoLoadStats(*it);
+			stats.cache_built = stats.cache_built || !CacheUpToDate(*repomanager, (*it)->repoInfo());
+			long long start = PkgProfiler::now();
+
 			//repomanager->buildCache((*it)->repoInfo(), zypp::RepoManager::BuildIfNeeded, prog.receiver());
 			repomanager->buildCache((*it)->repoInfo(), zypp::RepoManager::BuildIfNeeded, rebuild_subprogress);
+			stats.build_time = PkgProfiler::now() - start;
 		    }
 		    // NOTE: subtask progresses are reported as done in the descructor
 		    // no need to handle them in the exception code
@@ -421,6 +836,12 @@ PkgFunctions::SourceLoadImpl(PkgProgress &progress)
 	// load resolvables only from enabled repos which are not deleted
 	if ((*it)->repoInfo().enabled() && !(*it)->isDeleted())
 	{
+	    if (refreshed.find(*it) != refreshed.end())
+	    {
+		// already loaded in the pipeline
+		continue;
+	    }
+
 	    // check whether the refresh failed or not
 	    RepoCont::iterator failed_it = find(failed_refresh.begin(), failed_refresh.end(), *it);
 	    if (failed_it != failed_refresh.end())
@@ -450,10 +871,124 @@ PkgFunctions::SourceLoadImpl(PkgProgress &progress)
     // report 100%
     prog_total.toMax();
 
+    load_stats.valid = true;
+    load_stats.total_time = PkgProfiler::now() - load_stats.start_time;
+    load_stats.solvables = zypp::sat::Pool::instance().solvablesSize();
+    LogLoadStats();
+
     autorefresh_skipped = false;
     return YCPBoolean(success);
 }
 
+PkgFunctions::LoadStats::Repo &PkgFunctions::RepoLoadStats(const YRepo_Ptr &repo)
+{
+    return load_stats.repos[logFindAlias(repo->repoInfo().alias())];
+}
+
+long long PkgFunctions::MetadataSize(const zypp::RepoInfo &repo)
+{
+    long long files = 0;
+    return DirSize(CreateRepoManager()->metadataPath(repo), files);
+}
+
+/*
+ * A helper function - log the SourceLoad() statistics in a single line
+ * (easy to grep and parse from the collected logs)
+ */
+void PkgFunctions::LogLoadStats()
+{
+    std::ostringstream out;
+    out << "total_ms=" << load_stats.total_time / 1000 << " solvables=" << load_stats.solvables;
+
+    for_(it, load_stats.repos.begin(), load_stats.repos.end())
+    {
+	YRepo_Ptr repo = logFindRepository(it->first);
+	const LoadStats::Repo &stats = it->second;
+
+	out << " [" << (repo ? repo->repoInfo().alias() : std::string()) << ":"
+	    << " check_ms=" << stats.check_time / 1000
+	    << " refresh_ms=" << stats.refresh_time / 1000
+	    << " build_ms=" << stats.build_time / 1000
+	    << " load_ms=" << stats.load_time / 1000
+	    << " downloaded=" << stats.downloaded
+	    << " solvables=" << stats.solvables
+	    << " refreshed=" << stats.refreshed
+	    << " failed=" << stats.failed
+	    << " cache=" << (stats.cache_built ? "miss" : "hit")
+	    << " parallel=" << stats.parallel << "]";
+    }
+
+    y2milestone("SourceLoad stats: %s", out.str().c_str());
+}
+
+/****************************************************************************************
+ * @builtin SourceLoadStats
+ *
+ * @short Returns the statistics of the last SourceLoad()
+ * @description
+ * The time spent in the phases of the last Pkg::SourceLoad() (or SourceStartManager(true)
+ * or the lazy load) for each processed repository:
+ *
+ * <code>
+ * $[ "total_time" : integer (the wall time of the load in ms),
+ *    "solvables" : integer (pool size after the load),
+ *    "repos" : [ $[ "id" : integer, "alias" : string,
+ *      "check_time" : integer (checking whether to refresh, ms),
+ *      "refresh_time" : integer (downloading the metadata, ms),
+ *      "build_time" : integer (building the solv cache, ms),
+ *      "load_time" : integer (loading the solv cache into the pool, ms),
+ *      "downloaded" : integer (the size of the downloaded metadata in bytes),
+ *      "solvables" : integer (the added solvables),
+ *      "refreshed" : boolean, "failed" : boolean (the refresh has failed),
+ *      "cache_hit" : boolean (the solv cache was up to date),
+ *      "parallel" : boolean (refreshed or built by a worker process, the time
+ *        includes waiting for a free worker and the cache build is included
+ *        in the refresh time when pipelined) ], ... ] ]
+ * </code>
+ *
+ * The same values are logged in a single "SourceLoad stats" line.
+ *
+ * @return map<string,any> the statistics, nil if the repositories have not been loaded yet
+ **/
+YCPValue
+PkgFunctions::SourceLoadStats()
+{
+    if (!load_stats.valid)
+	return YCPVoid();
+
+    YCPMap ret;
+    YCPList repos_stats;
+
+    ret->add(YCPString("total_time"), YCPInteger(load_stats.total_time / 1000));
+    ret->add(YCPString("solvables"), YCPInteger(load_stats.solvables));
+
+    for_(it, load_stats.repos.begin(), load_stats.repos.end())
+    {
+	YRepo_Ptr repo = logFindRepository(it->first);
+	const LoadStats::Repo &stats = it->second;
+	YCPMap repo_stats;
+
+	repo_stats->add(YCPString("id"), YCPInteger(it->first));
+	repo_stats->add(YCPString("alias"), YCPString(repo ? repo->repoInfo().alias() : std::string()));
+	repo_stats->add(YCPString("check_time"), YCPInteger(stats.check_time / 1000));
+	repo_stats->add(YCPString("refresh_time"), YCPInteger(stats.refresh_time / 1000));
+	repo_stats->add(YCPString("build_time"), YCPInteger(stats.build_time / 1000));
+	repo_stats->add(YCPString("load_time"), YCPInteger(stats.load_time / 1000));
+	repo_stats->add(YCPString("downloaded"), YCPInteger(stats.downloaded));
+	repo_stats->add(YCPString("solvables"), YCPInteger(stats.solvables));
+	repo_stats->add(YCPString("refreshed"), YCPBoolean(stats.refreshed));
+	repo_stats->add(YCPString("failed"), YCPBoolean(stats.failed));
+	repo_stats->add(YCPString("cache_hit"), YCPBoolean(!stats.cache_built));
+	repo_stats->add(YCPString("parallel"), YCPBoolean(stats.parallel));
+
+	repos_stats->add(repo_stats);
+    }
+
+    ret->add(YCPString("repos"), repos_stats);
+
+    return ret;
+}
+
 
 /****************************************************************************************
  * @builtin SourceStartManager
@@ -516,6 +1051,22 @@ PkgFunctions::SourceStartManagerImpl(const YCPBoolean& enable, PkgProgress &prog
 	    y2warning("SourceStartManager: Some sources have not been restored, loading only the active sources...");
 	}
 
+	if (lazy_load)
+	{
+	    // the resolvables are loaded by the first builtin which needs them
+	    for (RepoCont::const_iterator it = repos.begin(); it != repos.end(); ++it)
+	    {
+		if ((*it)->repoInfo().enabled() && !(*it)->isDeleted())
+		{
+		    y2milestone("Lazy load of repository '%s' (metadata %s)", (*it)->repoInfo().alias().c_str(),
+			CreateRepoManager()->metadataStatus((*it)->repoInfo()).empty() ? "missing" : "present");
+		}
+	    }
+
+	    lazy_pending = true;
+	    return success;
+	}
+
 	// enable all sources and load the resolvables
 	success = YCPBoolean(SourceLoadImpl(progress)->asBoolean()->value() && success->asBoolean()->value());
     }
@@ -523,6 +1074,97 @@ PkgFunctions::SourceStartManagerImpl(const YCPBoolean& enable, PkgProgress &prog
     return success;
 }
 
+/*
+ * The builtins which do not need the resolvables from the repositories,
+ * they do not trigger the lazy load. All other builtins do (an unknown
+ * builtin only costs the full load, it cannot get a wrong result).
+ * A builtin changing the selection is never safe (see PoolChangesOf()), the names
+ * are checked against the registered builtins, see testsuite/lazy_load_test.cc.
+ */
+static const char *lazy_safe_builtins[] = {
+    // general
+    "SetTextLocale", "SetPackageLocale", "GetTextLocale", "GetPackageLocale",
+    "SetAdditionalLocales", "GetAdditionalLocales", "LastError", "LastErrorDetails",
+    "ProfilingStart", "ProfilingStop", "ProfilingReport", "ProfilingSave",
+    "Connect", "ExpandedUrl", "SetProgressThrottle", "ProgressThrottleStats", "ProgressAbort",
+    "ZConfig", "SetZConfig", "NetworkStatus", "UrlKnownSchemes", "UrlSchemeIsRemote",
+    "UrlSchemeIsLocal", "UrlSchemeIsVolatile", "UrlSchemeIsDownloading",
+    "GetArchitecture", "SetArchitecture", "SystemArchitecture",
+    // repository management (the pool is not used)
+    "SourceStartManager", "SourceRestore", "SourceStartCache", "SourceGetCurrent",
+    "SourceSaveAll", "SourceFinishAll", "SourceReleaseAll", "SourceGeneralData",
+    "SourceURL", "SourceRawURL", "SourceEditGet", "SourceEditSet", "SourceSetPriority",
+    "SourceSetAutorefresh", "SourceRaisePriority", "SourceLowerPriority", "SourceDelete",
+    "SourceRefreshNow", "SourceForceRefreshNow", "SourceChangeUrl", "SourceProvideFile",
+    "SourceProvideOptionalFile", "SourceProvideDirectory", "SourceProvideSignedDirectory",
+    "SourceProvideSignedFile", "SourceProvideDigestedFile", "SourceCacheCopyTo",
+    "SourceMoveDownloadArea", "RepositoryProbe", "RepositoryScan", "SkipRefresh",
+    "ServiceAliases", "ServiceAdd", "ServiceDelete", "ServiceGet", "ServiceSet",
+    "ServiceURL", "ServiceProbe", "ServiceSave", "PoolSnapshotLoad", "PoolGeneration",
+    "SolverTestCaseWait", "SourceLoadStats",
+    // target
+    "TargetInit", "TargetRebuildInit", "TargetInitialize", "TargetInitializeOptions",
+    "TargetLoad", "TargetDiskStats", "GetBackupPath", "SetBackupPath", "CreateBackups",
+    "PkgInstalled", "GPGKeys", "ImportGPGKey", "DeleteGPGKey", "CheckGPGKeyFile",
+    "GetSolverFlags", "SetSolverFlags", "PkgSolveStats", "GetLocks"
+};
+
+const std::set<std::string> &PkgFunctions::LazySafeBuiltins()
+{
+    static std::set<std::string> safe;
+
+    if (safe.empty())
+    {
+	for (unsigned i = 0; i < sizeof(lazy_safe_builtins) / sizeof(lazy_safe_builtins[0]); ++i)
+	{
+	    // the selection can be changed only in the loaded pool
+	    if (PoolChangesOf(lazy_safe_builtins[i]) & POOL_CHANGED_SELECTION)
+	    {
+		y2internal("Pkg::%s changes the selection, it cannot skip the lazy load", lazy_safe_builtins[i]);
+		continue;
+	    }
+
+	    safe.insert(lazy_safe_builtins[i]);
+	}
+    }
+
+    return safe;
+}
+
+bool PkgFunctions::LazyLoadRepos(const std::string &builtin)
+{
+    const std::set<std::string> &safe(LazySafeBuiltins());
+
+    // the callbacks only register the YCP handlers
+    if (builtin.compare(0, 8, "Callback") == 0 || safe.find(builtin) != safe.end())
+	return true;
+
+    y2milestone("Pkg::%s needs the resolvables, loading the repositories...", builtin.c_str());
+
+    try
+    {
+	// resets lazy_pending
+	SourceLoad();
+	return true;
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	y2error("Error while loading the repositories for Pkg::%s: %s", builtin.c_str(), excpt.asString().c_str());
+	_last_error.setLastError(ExceptionAsString(excpt));
+    }
+    catch (const std::exception& err)
+    {
+	y2error("Error while loading the repositories for Pkg::%s: %s", builtin.c_str(), err.what());
+	_last_error.setLastError(err.what());
+    }
+    catch (...)
+    {
+	y2error("Unknown error while loading the repositories for Pkg::%s", builtin.c_str());
+    }
+
+    return false;
+}
+
 /****************************************************************************************
  * @builtin SourceStartCache
  *
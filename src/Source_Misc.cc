@@ -74,37 +74,77 @@ YRepo_Ptr PkgFunctions::logFindRepository(RepoId id)
     return YRepo_Ptr();
 }
 
-PkgFunctions::RepoId PkgFunctions::logFindAlias(const std::string &alias) const
+PkgFunctions::RepoId PkgFunctions::AddRepo(const YRepo_Ptr &repo)
 {
-    RepoId index = 0LL;
+    RepoId id = repos.size();
+    repos.push_back(repo);
 
-    for(RepoCont::const_iterator it = repos.begin(); it != repos.end() ; ++it, ++index)
-    {
-	if (!(*it)->isDeleted() && (*it)->repoInfo().alias() == alias)
-	    return index;
-    }
+    const std::string &alias = repo->repoInfo().alias();
+    AliasIndex::iterator it = alias_index.find(alias);
 
-    return -1LL;
+    // the first not deleted repository wins (as in the sequential search)
+    if (it == alias_index.end())
+	alias_index[alias] = id;
+    else if (repos[it->second]->isDeleted())
+	it->second = id;
+
+    return id;
 }
 
-bool PkgFunctions::aliasExists(const std::string &alias, const std::list<zypp::RepoInfo> &reps) const
+void PkgFunctions::ClearRepos()
 {
-    // search in loaded repositories
-    for(RepoCont::const_iterator it = repos.begin(); it != repos.end() ; ++it)
+    repos.clear();
+    alias_index.clear();
+    pool_repos.clear();
+    pool_repo_ids.clear();
+}
+
+void PkgFunctions::RebuildAliasIndex() const
+{
+    y2debug("Rebuilding the alias index");
+    alias_index.clear();
+
+    for (RepoCont::size_type index = repos.size(); index > 0; --index)
     {
-	if (!(*it)->isDeleted() && (*it)->repoInfo().alias() == alias)
-	    return true;
+	const YRepo_Ptr &repo = repos[index - 1];
+
+	// iterate backwards, the first repository with the alias wins
+	if (!repo->isDeleted())
+	    alias_index[repo->repoInfo().alias()] = index - 1;
     }
+}
 
-    // search in stored repositories
-    for (std::list<zypp::RepoInfo>::const_iterator it = reps.begin();
-	it != reps.end(); ++it)
+PkgFunctions::RepoId PkgFunctions::logFindAlias(const std::string &alias) const
+{
+    AliasIndex::const_iterator it = alias_index.find(alias);
+
+    if (it == alias_index.end())
+	return -1LL;
+
+    const YRepo_Ptr &repo = repos[it->second];
+
+    if (repo->isDeleted() || repo->repoInfo().alias() != alias)
     {
-	if (it->alias() == alias)
-	    return true;
+	// the repository has been removed since the last lookup,
+	// there might be another one with the same alias
+	RebuildAliasIndex();
+
+	it = alias_index.find(alias);
+	return it == alias_index.end() ? -1LL : it->second;
     }
 
-    return false;
+    return it->second;
+}
+
+bool PkgFunctions::aliasExists(const std::string &alias)
+{
+    // search in loaded repositories
+    if (logFindAlias(alias) >= 0)
+	return true;
+
+    // search in stored repositories, the repository manager keeps them in memory,
+    // avoid copying the whole list
+    return CreateRepoManager()->hasRepo(alias);
 }
 
 // convert libzypp type to yast strings ("YaST", "YUM" or "Plaindir")
@@ -152,10 +192,7 @@ std::string PkgFunctions::UniqueAlias(const std::string &alias)
 
     unsigned int id = 0;
 
-    // search in stored repositories
-    std::list<zypp::RepoInfo> reps = CreateRepoManager()->knownRepositories();
-
-    while(aliasExists(ret, reps))
+    while(aliasExists(ret))
     {
 	y2milestone("Alias %s already found: %lld", ret.c_str(), logFindAlias(ret));
 
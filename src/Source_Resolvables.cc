@@ -44,12 +44,54 @@ void PkgFunctions::RemoveResolvablesFrom(YRepo_Ptr repo)
 {
     const std::string &alias = repo->repoInfo().alias();
     y2milestone("Removing resolvables from '%s'", alias.c_str());
+    RemovePoolRepo(zypp::sat::Pool::instance().reposFind(alias));
     // remove the resolvables if they have been loaded
     zypp::sat::Pool::instance().reposErase(alias);
 
     repo->resetLoaded();
 }
 
+void PkgFunctions::AddPoolRepo(RepoId id, const zypp::Repository &repository)
+{
+    if (id < 0 || repository == zypp::Repository::noRepository)
+	return;
+
+    RemovePoolRepo(repository);
+
+    std::map<RepoId, zypp::Repository>::iterator it = pool_repos.find(id);
+    if (it != pool_repos.end())
+    {
+	pool_repo_ids.erase(it->second);
+	pool_repos.erase(it);
+    }
+
+    pool_repos[id] = repository;
+    pool_repo_ids[repository] = id;
+}
+
+void PkgFunctions::RemovePoolRepo(const zypp::Repository &repository)
+{
+    std::map<zypp::Repository, RepoId>::iterator it = pool_repo_ids.find(repository);
+
+    if (it == pool_repo_ids.end())
+	return;
+
+    pool_repos.erase(it->second);
+    pool_repo_ids.erase(it);
+}
+
+zypp::Repository PkgFunctions::PoolRepository(RepoId id) const
+{
+    std::map<RepoId, zypp::Repository>::const_iterator it = pool_repos.find(id);
+    return it == pool_repos.end() ? zypp::Repository::noRepository : it->second;
+}
+
+PkgFunctions::RepoId PkgFunctions::PoolRepoId(const zypp::Repository &repository) const
+{
+    std::map<zypp::Repository, RepoId>::const_iterator it = pool_repo_ids.find(repository);
+    return it == pool_repo_ids.end() ? -1LL : it->second;
+}
+
 /*
  * A helper function - load resolvable from the repository into the pool
  */
@@ -101,8 +143,17 @@ bool PkgFunctions::LoadResolvablesFrom(YRepo_Ptr repo, const zypp::ProgressData:
 
 		    CallRefreshStarted();
 
+		    long long start = PkgProfiler::now();
 		    RefreshWithCallbacks(repoinfo);
 
+		    if (load_stats.active)
+		    {
+			LoadStats::Repo &stats = RepoLoadStats(repo);
+			stats.refresh_time += PkgProfiler::now() - start;
+			stats.refreshed = true;
+			stats.downloaded = MetadataSize(repoinfo);
+		    }
+
 		    CallRefreshDone();
 		}
 	    }
@@ -110,12 +161,26 @@ bool PkgFunctions::LoadResolvablesFrom(YRepo_Ptr repo, const zypp::ProgressData:
 	    if (refresh)
 	    {
 		y2milestone("Caching source '%s'...", repoinfo.alias().c_str());
+		long long start = PkgProfiler::now();
 		repomanager->buildCache(repoinfo, zypp::RepoManager::BuildIfNeeded, load_subprogress);
+
+		if (load_stats.active)
+		{
+		    LoadStats::Repo &stats = RepoLoadStats(repo);
+		    stats.build_time += PkgProfiler::now() - start;
+		    stats.cache_built = true;
+		}
 	    }
 	}
 
+	long long start = PkgProfiler::now();
 	repomanager->loadFromCache(repoinfo);
+
+	if (load_stats.active)
+	    RepoLoadStats(repo).load_time = PkgProfiler::now() - start;
+
 	repo->setLoaded();
+	AddPoolRepo(logFindAlias(repoinfo.alias()), zypp::sat::Pool::instance().reposFind(repoinfo.alias()));
 	//y2milestone("Loaded %zd resolvables", store.size());
     }
     catch(const zypp::repo::RepoNotCachedException &excpt )
@@ -151,6 +216,9 @@ bool PkgFunctions::LoadResolvablesFrom(YRepo_Ptr repo, const zypp::ProgressData:
     unsigned int size_end = zypp_ptr()->pool().size();
     y2milestone("Pool size at end: %d (loaded %d resolvables)", size_end, size_end - size_start);
 
+    if (load_stats.active)
+	RepoLoadStats(repo).solvables = size_end - size_start;
+
     prog.toMax();
 
     return success;
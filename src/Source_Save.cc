@@ -34,6 +34,11 @@
 
 #include <HelpTexts.h>
 
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
 /*
   Textdomain "pkg-bindings"
 */
@@ -53,6 +58,7 @@ PkgFunctions::SourceReleaseAll ()
 
     y2milestone("Removing all tmp directories");
     tmp_dirs.clear();
+    download_prefetch.clear();
 
     for (RepoCont::iterator it = repos.begin();
 	it != repos.end(); ++it)
@@ -71,6 +77,25 @@ PkgFunctions::SourceReleaseAll ()
     return YCPBoolean(ret);
 }
 
+// write the repository and service files to the disk, one syncfs()
+// for the filesystem instead of a fsync() per file
+void PkgFunctions::SyncReposDir()
+{
+    zypp::RepoManagerOptions options(_target_root);
+    int fd = ::open(options.knownReposPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+	y2warning("Cannot open %s: %s", options.knownReposPath.c_str(), ::strerror(errno));
+	return;
+    }
+
+    if (::syncfs(fd) != 0)
+	y2warning("Cannot sync %s: %s", options.knownReposPath.c_str(), ::strerror(errno));
+
+    ::close(fd);
+}
+
 /******************************************************************************
  * @builtin SourceSaveAll
  *
@@ -92,10 +117,13 @@ PkgFunctions::SourceSaveAll ()
 
     zypp::RepoManager* repomanager = CreateRepoManager();
 
+    // the number of written files
+    unsigned saved = 0;
+
     // save the services
     try
     {
-	service_manager.SaveServices(*repomanager);
+	saved += service_manager.SaveServices(*repomanager);
 	y2milestone("All services have been saved");
     }
     catch (const zypp::Exception& excpt)
@@ -176,6 +204,7 @@ PkgFunctions::SourceSaveAll ()
 		repomanager->getRepositoryInfo(repo_alias);
 		y2milestone("Removing repository '%s'", repo_alias.c_str());
 		repomanager->removeRepository((*it)->repoInfo());
+		++saved;
 		prog_total.incr();
 	    }
 	    catch (const zypp::repo::RepoNotFoundException &ex)
@@ -205,6 +234,14 @@ PkgFunctions::SourceSaveAll ()
 	{
 	    std::string current_alias = (*it)->repoInfo().alias();
 
+	    // do not rewrite the unchanged .repo files
+	    if (!(*it)->isModified())
+	    {
+		y2debug("Repository '%s' has not been changed", current_alias.c_str());
+		prog_total.incr();
+		continue;
+	    }
+
 	    try
 	    {
 		try
@@ -220,6 +257,9 @@ PkgFunctions::SourceSaveAll ()
 		    y2milestone("Adding repository '%s'", current_alias.c_str());
 		    repomanager->addRepository((*it)->repoInfo());
 		}
+
+		(*it)->setSaved();
+		++saved;
 	    }
 	    catch (zypp::Exception & excpt)
 	    {
@@ -232,7 +272,11 @@ PkgFunctions::SourceSaveAll ()
 	}
     }
 
-    y2milestone("All sources have been saved");
+    y2milestone("All sources have been saved (%u files written)", saved);
+
+    // flush the files at once (the target might be a slow USB stick)
+    if (saved > 0)
+	SyncReposDir();
 
     return YCPBoolean(ret);
 }
@@ -273,7 +317,8 @@ PkgFunctions::SourceFinishAll ()
 	}
 
 	// release all repositories
-	repos.clear();
+	ClearRepos();
+	lazy_pending = false;
 
 	// release all services
 	service_manager.Reset();
@@ -122,7 +122,7 @@ PkgFunctions::SourceSetPriority(const YCPInteger& id, const YCPInteger& priority
     repo->repoInfo().setPriority(priority->value());
 
     // apply the priority also on the loaded packages in the pool (bsc#498266),
-    zypp::Repository r(zypp::sat::Pool::instance().reposFind(repo->repoInfo().alias()));
+    zypp::Repository r(PoolRepository(id->value()));
 
     // it might not be loaded in the pool
     if (r != zypp::Repository::noRepository)
@@ -400,6 +400,9 @@ PkgFunctions::SourceDelete (const YCPInteger& id)
     try
     {
 
+	// stop the background refresh
+	async_refresh.remove(id->value());
+
 	// the resolvables cannot be used anymore, remove them
 	RemoveResolvablesFrom(repo);
 
@@ -0,0 +1,429 @@
+/*
+ * File:   Source_Snapshot.cc
+ *
+ * Save and restore the loaded repository set (pool snapshot).
+ */
+
+#include <PkgFunctions.h>
+#include "log.h"
+
+#include <ycp/YCPBoolean.h>
+#include <ycp/YCPString.h>
+
+#include <zypp/sat/Pool.h>
+#include <zypp/base/String.h>
+
+#include <boost/functional/hash.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include <unistd.h>
+
+/*
+ * The snapshot does not contain the solvables, the solv files in the repository
+ * cache are already the fast loadable (mmapped) image. It records what the module
+ * would otherwise find out again: the repository set (in the original order,
+ * i.e. the same repository IDs), which repositories have been loaded,
+ * the target root, the upgrade repositories and the requested locales.
+ * The locks are not stored, they are read from the target locks file
+ * when the target is initialized.
+ *
+ * Each repository is validated by a cookie (the repository definition
+ * and the raw metadata status), the snapshot is rejected if any repository
+ * has been changed, added or removed since it was saved.
+ */
+
+// increase when the format changes, an old snapshot is rejected
+static const char *snapshot_version = "2";
+
+// the repository definition and the downloaded metadata
+static std::string repoCookie(zypp::RepoManager &repomanager, const zypp::RepoInfo &info)
+{
+    std::ostringstream ini;
+    info.dumpAsIniOn(ini);
+
+    std::size_t seed = boost::hash<std::string>()(ini.str());
+    boost::hash_combine(seed, repomanager.metadataStatus(info).checksum());
+
+    std::ostringstream cookie;
+    cookie << std::hex << seed;
+    return cookie.str();
+}
+
+/****************************************************************************************
+ * @builtin PoolSnapshotSave
+ *
+ * @short Save the loaded repository set to a snapshot file
+ * @description
+ * Save the current repositories (and which of them are loaded), the target root,
+ * the upgrade repositories and the requested locales. Another module
+ * can then restore the state by PoolSnapshotLoad() instead of SourceStartManager()
+ * and TargetInit(). The repositories must be saved (see SourceSaveAll()),
+ * a repository changed only in memory would invalidate the snapshot.
+ *
+ * @param string path the snapshot file
+ * @return boolean true on success
+ **/
+YCPValue
+PkgFunctions::PoolSnapshotSave(const YCPString &path)
+{
+    if (path.isNull() || path->value().empty())
+    {
+	y2error("Missing snapshot file name");
+	return YCPBoolean(false);
+    }
+
+    try
+    {
+	zypp::RepoManager* repomanager = CreateRepoManager();
+
+	std::ostringstream out;
+	out << "version=" << snapshot_version << std::endl;
+
+	if (_target_loaded)
+	{
+	    out << "target=" << _target_root.asString() << std::endl;
+	}
+
+	const zypp::LocaleSet &locales = zypp::sat::Pool::instance().getRequestedLocales();
+	for_(it, locales.begin(), locales.end())
+	{
+	    out << "locale=" << it->code() << std::endl;
+	}
+
+	for_(it, repos.begin(), repos.end())
+	{
+	    if ((*it)->isDeleted())
+		continue;
+
+	    const zypp::RepoInfo &info = (*it)->repoInfo();
+	    out << "repo=" << info.alias() << '\t' << ((*it)->isLoaded() ? 1 : 0)
+		<< '\t' << repoCookie(*repomanager, info) << std::endl;
+
+	    if ((*it)->isLoaded())
+	    {
+		zypp::Repository repository(PoolRepository(logFindAlias(info.alias())));
+
+		if (repository != zypp::Repository::noRepository && zypp_ptr()->resolver()->upgradingRepo(repository))
+		{
+		    out << "upgrade=" << info.alias() << std::endl;
+		}
+	    }
+	}
+
+	// write a temporary file and rename it, a concurrent reader
+	// must not see a partial snapshot
+	std::string file(path->value());
+	std::string tmp(file + ".tmp");
+
+	{
+	    std::ofstream f(tmp.c_str());
+	    f << out.str();
+	    // the buffered data are written at close
+	    f.close();
+
+	    if (f.fail())
+	    {
+		y2error("Cannot write the snapshot file %s", tmp.c_str());
+		_last_error.setLastError("Cannot write file " + tmp);
+		::unlink(tmp.c_str());
+		return YCPBoolean(false);
+	    }
+	}
+
+	if (::rename(tmp.c_str(), file.c_str()) != 0)
+	{
+	    y2error("Cannot rename %s to %s", tmp.c_str(), file.c_str());
+	    _last_error.setLastError("Cannot write file " + file);
+	    ::unlink(tmp.c_str());
+	    return YCPBoolean(false);
+	}
+
+	y2milestone("Saved the pool snapshot to %s", file.c_str());
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	y2error("Cannot save the pool snapshot: %s", excpt.asString().c_str());
+	_last_error.setLastError(ExceptionAsString(excpt));
+	return YCPBoolean(false);
+    }
+
+    return YCPBoolean(true);
+}
+
+struct PkgFunctions::PoolSnapshot
+{
+    std::string target;
+    zypp::LocaleSet locales;
+    // alias, loaded, cookie
+    std::vector<std::pair<std::string, std::pair<bool, std::string> > > repos;
+    std::set<std::string> upgrade;
+};
+
+/*
+ * A helper function - validate and apply the snapshot, returns false
+ * if the snapshot is outdated, the caller rolls back the partial changes
+ * then (also when an exception is thrown)
+ */
+bool PkgFunctions::PoolSnapshotApply(const PoolSnapshot &snapshot)
+{
+    // another target is already loaded
+    if (!snapshot.target.empty() && _target_loaded && _target_root != snapshot.target)
+    {
+	y2milestone("Target %s is loaded, not using the snapshot", _target_root.asString().c_str());
+	return false;
+    }
+
+    // the repositories are read from the target
+    if (!snapshot.target.empty() && _target_root != snapshot.target)
+    {
+	SetTarget(snapshot.target);
+    }
+
+    zypp::RepoManager* repomanager = CreateRepoManager();
+
+    // validate all repositories before loading anything
+    std::list<zypp::RepoInfo> known = repomanager->knownRepositories();
+
+    if (known.size() != snapshot.repos.size())
+    {
+	y2milestone("The repositories have been changed (%zd known, %zd in the snapshot)",
+	    known.size(), snapshot.repos.size());
+	return false;
+    }
+
+    std::vector<zypp::RepoInfo> infos;
+
+    for_(it, snapshot.repos.begin(), snapshot.repos.end())
+    {
+	std::list<zypp::RepoInfo>::const_iterator info = known.begin();
+
+	while (info != known.end() && info->alias() != it->first)
+	    ++info;
+
+	if (info == known.end() || repoCookie(*repomanager, *info) != it->second.second
+	    || (it->second.first && !repomanager->isCached(*info)))
+	{
+	    y2milestone("Repository %s has been changed, not using the snapshot", it->first.c_str());
+	    return false;
+	}
+
+	infos.push_back(*info);
+    }
+
+    if (service_manager.empty())
+    {
+	service_manager.LoadServices(*repomanager);
+    }
+
+    for (unsigned index = 0; index < infos.size(); ++index)
+    {
+	YRepo_Ptr repo = new YRepo(infos[index]);
+	// the same as on disk, no need to save it
+	repo->setSaved();
+	AddRepo(repo);
+
+	if (snapshot.repos[index].second.first)
+	{
+	    repomanager->loadFromCache(infos[index]);
+	    repo->setLoaded();
+	    AddPoolRepo(logFindAlias(infos[index].alias()), zypp::sat::Pool::instance().reposFind(infos[index].alias()));
+	}
+    }
+
+    if (!snapshot.locales.empty())
+    {
+	zypp::sat::Pool::instance().setRequestedLocales(snapshot.locales);
+    }
+
+    for_(it, snapshot.upgrade.begin(), snapshot.upgrade.end())
+    {
+	zypp::Repository repository(PoolRepository(logFindAlias(*it)));
+
+	if (repository != zypp::Repository::noRepository)
+	{
+	    zypp_ptr()->resolver()->addUpgradeRepo(repository);
+	}
+    }
+
+    // initialize the target at the end, the persistent locks
+    // are applied to the whole pool (the system solv cache
+    // is validated by libzypp itself)
+    if (!snapshot.target.empty())
+    {
+	if (!TargetInitInternal(YCPString(snapshot.target), false)->asBoolean()->value())
+	{
+	    y2warning("Cannot initialize the target %s, not using the snapshot", snapshot.target.c_str());
+	    return false;
+	}
+
+	// the target was already loaded, apply the locks to the new repositories
+	ApplyTargetLocks();
+    }
+
+    return true;
+}
+
+/*
+ * A helper function - remove the partially restored snapshot,
+ * the caller can use the usual SourceStartManager() and TargetInit() calls then
+ */
+void PkgFunctions::PoolSnapshotRollback(const zypp::Pathname &root, bool target_loaded, bool services_loaded,
+    const zypp::LocaleSet &locales)
+{
+    try
+    {
+	for_(it, repos.begin(), repos.end())
+	{
+	    zypp::Repository repository(zypp::sat::Pool::instance().reposFind((*it)->repoInfo().alias()));
+
+	    if (repository != zypp::Repository::noRepository && zypp_ptr()->resolver()->upgradingRepo(repository))
+	    {
+		zypp_ptr()->resolver()->removeUpgradeRepo(repository);
+	    }
+
+	    RemoveResolvablesFrom(*it);
+	}
+
+	ClearRepos();
+
+	if (!services_loaded)
+	    service_manager.Reset();
+
+	zypp::sat::Pool::instance().setRequestedLocales(locales);
+
+	// release the target loaded by the snapshot
+	if (!target_loaded && _target_loaded)
+	{
+	    zypp_ptr()->finishTarget();
+	    _target_loaded = false;
+	}
+
+	if (_target_root != root)
+	{
+	    SetTarget(root.asString());
+	}
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	y2error("Cannot roll back the pool snapshot: %s", excpt.asString().c_str());
+    }
+
+    solve_fingerprint_valid = false;
+    lock_cache.valid = false;
+}
+
+/****************************************************************************************
+ * @builtin PoolSnapshotLoad
+ *
+ * @short Restore the repository set from a snapshot file
+ * @description
+ * Restore the state saved by PoolSnapshotSave(), the recorded repositories are
+ * loaded directly from the cache without any refresh. It can be used instead of
+ * SourceStartManager(true) and TargetInit() only when no repository is known yet.
+ *
+ * Nothing is changed if the snapshot is missing or outdated (any
+ * repository has been changed, added or removed) or if restoring it fails,
+ * the partial changes are rolled back. The caller should then use the usual
+ * SourceStartManager() and TargetInit() calls.
+ *
+ * @param string path the snapshot file
+ * @return boolean true if the state has been restored
+ **/
+YCPValue
+PkgFunctions::PoolSnapshotLoad(const YCPString &path)
+{
+    if (path.isNull() || path->value().empty())
+    {
+	y2error("Missing snapshot file name");
+	return YCPBoolean(false);
+    }
+
+    if (!repos.empty())
+    {
+	y2warning("Number of registered repositories: %zd, not using the snapshot", repos.size());
+	return YCPBoolean(false);
+    }
+
+    long long start = PkgProfiler::now();
+
+    std::ifstream in(path->value().c_str());
+
+    if (!in)
+    {
+	y2milestone("Pool snapshot %s not found", path->value().c_str());
+	return YCPBoolean(false);
+    }
+
+    std::string version;
+    PoolSnapshot snapshot;
+    std::string line;
+
+    while (std::getline(in, line))
+    {
+	std::string::size_type pos = line.find('=');
+
+	if (pos == std::string::npos)
+	    continue;
+
+	std::string key(line.substr(0, pos));
+	std::string value(line.substr(pos + 1));
+
+	if (key == "version")
+	    version = value;
+	else if (key == "target")
+	    snapshot.target = value;
+	else if (key == "locale")
+	    snapshot.locales.insert(zypp::Locale(value));
+	else if (key == "upgrade")
+	    snapshot.upgrade.insert(value);
+	else if (key == "repo")
+	{
+	    std::vector<std::string> fields;
+	    zypp::str::split(value, std::back_inserter(fields), "\t");
+
+	    if (fields.size() == 3)
+		snapshot.repos.push_back(std::make_pair(fields[0], std::make_pair(fields[1] == "1", fields[2])));
+	}
+    }
+
+    if (version != snapshot_version)
+    {
+	y2warning("Unsupported pool snapshot version '%s'", version.c_str());
+	return YCPBoolean(false);
+    }
+
+    // the original state for the rollback
+    zypp::Pathname root(_target_root);
+    bool target_loaded = _target_loaded;
+    bool services_loaded = !service_manager.empty();
+    zypp::LocaleSet locales(zypp::sat::Pool::instance().getRequestedLocales());
+    bool restored = false;
+
+    try
+    {
+	restored = PoolSnapshotApply(snapshot);
+    }
+    catch (const zypp::Exception& excpt)
+    {
+	y2error("Cannot load the pool snapshot: %s", excpt.asString().c_str());
+	_last_error.setLastError(ExceptionAsString(excpt));
+    }
+
+    if (!restored)
+    {
+	PoolSnapshotRollback(root, target_loaded, services_loaded, locales);
+	return YCPBoolean(false);
+    }
+
+    solve_fingerprint_valid = false;
+    lock_cache.valid = false;
+
+    y2milestone("Restored %zd repositories from the pool snapshot %s (%lldms)", snapshot.repos.size(),
+	path->value().c_str(), (PkgProfiler::now() - start) / 1000);
+
+    return YCPBoolean(true);
+}
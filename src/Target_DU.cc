@@ -27,6 +27,7 @@
 
 #include <PkgFunctions.h>
 #include "log.h"
+#include "ycpTools.h"
 
 #include <ycp/YCPVoid.h>
 #include <ycp/YCPBoolean.h>
@@ -36,8 +37,32 @@
 #include <ycp/YCPMap.h>
 
 #include <sys/statvfs.h>
+#include <time.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
 
 #include <zypp/DiskUsageCounter.h>
+#include <zypp/base/Easy.h>
+#include <zypp/sat/Pool.h>
+
+// the statvfs() results are reused for this time (in miliseconds),
+// the callers usually ask for all values of a directory at once
+static const long long disk_stats_ttl = 1000;
+
+struct DiskStats
+{
+    long long used;
+    long long size;
+    long long bsize;
+    long long available;
+    // when the values have been read (monotonic time in ms)
+    long long time;
+};
+
+// directory => the last statvfs() result
+static std::map<std::string, DiskStats> disk_stats_cache;
 
 /** ------------------------
  * INTERNAL
@@ -48,11 +73,24 @@
 static void
 get_disk_stats (const char *fs, long long *used, long long *size, long long *bsize, long long *available)
 {
+    long long now = PkgProfiler::nowMs();
+    std::map<std::string, DiskStats>::const_iterator cached = disk_stats_cache.find(fs);
+
+    if (cached != disk_stats_cache.end() && now - cached->second.time < disk_stats_ttl)
+    {
+	*used = cached->second.used;
+	*size = cached->second.size;
+	*bsize = cached->second.bsize;
+	*available = cached->second.available;
+	return;
+    }
+
     struct statvfs sb;
     if (statvfs (fs, &sb) < 0)
     {
 	*used = *size = *bsize = *available = -1;
 	y2error("statvfs() failed: %s", strerror(errno));
+	disk_stats_cache.erase(fs);
 	return;
     }
     *bsize = sb.f_frsize ? : sb.f_bsize;		// block size
@@ -61,6 +99,13 @@ get_disk_stats (const char *fs, long long *used, long long *size, long long *bsi
     *available = sb.f_bavail * *bsize;			// available for non-root user
 
     y2debug("stavfs: dir: %s, sb.f_frsize: %lu, sb.f_bsize: %lu, sb.f_blocks: %lu, sb.f_bfree: %lu, sb.f_bavail: %lu, bsize: %lld, size: %lld, used: %lld, available: %lld", fs, sb.f_frsize, sb.f_bsize, sb.f_blocks, sb.f_bfree, sb.f_bavail, *bsize, *size, *used, *available);
+
+    DiskStats &stats = disk_stats_cache[fs];
+    stats.used = *used;
+    stats.size = *size;
+    stats.bsize = *bsize;
+    stats.available = *available;
+    stats.time = now;
 }
 
 
@@ -135,6 +180,34 @@ PkgFunctions::TargetBlockSize (const YCPString& dir)
     return YCPInteger (bsize);
 }
 
+/** ------------------------
+ *
+ * @builtin TargetDiskStats
+ *
+ * @short Return all disk statistics of partition at directory at once
+ * @description
+ * The same values as returned by Pkg::TargetCapacity(), Pkg::TargetUsed(),
+ * Pkg::TargetAvailable() and Pkg::TargetBlockSize() but read by a single
+ * statvfs() call. The values of a directory are cached for a second.
+ * @param string directory
+ * @return map $[ "capacity" : integer, "used" : integer, "available" : integer,
+ *   "block_size" : integer ] (-1 values on error)
+ */
+YCPValue
+PkgFunctions::TargetDiskStats (const YCPString& dir)
+{
+    long long used, size, bsize, avail;
+    get_disk_stats (dir->value().c_str(), &used, &size, &bsize, &avail);
+
+    YCPMap ret;
+    ret->add(YCPKey::capacity, YCPInteger(size));
+    ret->add(YCPKey::used, YCPInteger(used));
+    ret->add(YCPKey::available, YCPInteger(avail));
+    ret->add(YCPKey::block_size, YCPInteger(bsize));
+
+    return ret;
+}
+
 // helper funtion
 // initialize the disk usage counter with the current values from the system
 void PkgFunctions::SetCurrentDU()
@@ -144,6 +217,7 @@ void PkgFunctions::SetCurrentDU()
 
     // set the mount points
     zypp_ptr()->setPartitions(system);
+    du_cache.reset();
 }
 
 YCPMap PkgFunctions::MPS2YCPMap(const zypp::DiskUsageCounter::MountPointSet &mps)
@@ -215,92 +289,37 @@ PkgFunctions::TargetInitDU (const YCPList& dirlist)
 
     zypp::DiskUsageCounter::MountPointSet mount_points;
 
+    // the same decoder for all partitions
+    YcpMapLoad partition("Pkg::TargetInitDU");
+    std::string &dname(partition.arg<YT_STRING, std::string>("name"));
+    long long &dfree(partition.arg<YT_INTEGER, long long>("free"));
+    long long &dused(partition.arg<YT_INTEGER, long long>("used"));
+    std::string &filesystem(partition.arg<YT_STRING, std::string>("filesystem", std::string()));
+    bool &readonly(partition.arg<YT_BOOLEAN, bool>("readonly", false));
+    bool &growonly(partition.arg<YT_BOOLEAN, bool>("growonly", false));
+
     for (int i = 0; i < dirlist->size(); ++i)
     {
-	bool good = true;
-	YCPMap partmap;
-	std::string dname;
-	std::string filesystem;
-	long long dfree = 0LL;
-	long long dused = 0LL;
         zypp::DiskUsageCounter::MountPoint::HintFlags flags = zypp::DiskUsageCounter::MountPoint::NoHint;
 
-	if (dirlist->value(i)->isMap())
-	{
-	    partmap = dirlist->value(i)->asMap();
-	}
-	else
-	{
-	   good = false;
-	}
-
-	if (good
-	    && !partmap->value(YCPString("name")).isNull()
-	    && partmap->value(YCPString("name"))->isString())
-	{
-	    dname = partmap->value(YCPString("name"))->asString()->value();
-	}
-	else
-	{
-	    y2error("Pkg::TargetInitDU: \"name\" key is missing");
-	    good = false;
-	}
-
-	if (good
-	    && !partmap->value(YCPString("free")).isNull()
-	    && partmap->value(YCPString("free"))->isInteger())
-	{
-	    dfree = partmap->value(YCPString("free"))->asInteger()->value();
-	}
-	else
-	{
-	    y2error("Pkg::TargetInitDU: \"free\" key is missing");
-	    good = false;
-	}
-
-	if (good
-	    && !partmap->value(YCPString("used")).isNull()
-	    && partmap->value(YCPString("used"))->isInteger())
-	{
-	    dused = partmap->value(YCPString("used"))->asInteger()->value();
-	}
-	else
+	if (!dirlist->value(i)->isMap() || !partition.load(dirlist->value(i)->asMap()))
 	{
-	    y2error("Pkg::TargetInitDU: \"used\" key is missing");
-	    good = false;
+	    y2error ("TargetDUInit: bad item %d: %s", i, dirlist->value(i)->toString().c_str());
+	    continue;
 	}
 
-	if (good
-	    && !partmap->value(YCPString("readonly")).isNull()
-	    && partmap->value(YCPString("readonly"))->isBoolean()
-            && partmap->value(YCPString("readonly"))->asBoolean()->value())
+	if (readonly)
 	{
             y2milestone("Setting read only flag");
             flags = flags | zypp::DiskUsageCounter::MountPoint::Hint_readonly;
 	}
 
-	if (good
-	    && !partmap->value(YCPString("growonly")).isNull()
-	    && partmap->value(YCPString("growonly"))->isBoolean()
-            && partmap->value(YCPString("growonly"))->asBoolean()->value())
+	if (growonly)
 	{
             y2milestone("Setting grow only flag");
             flags = flags | zypp::DiskUsageCounter::MountPoint::Hint_growonly;
 	}
 
-	if (good
-	    && !partmap->value(YCPString("filesystem")).isNull()
-	    && partmap->value(YCPString("filesystem"))->isString())
-	{
-	    filesystem = partmap->value(YCPString("filesystem"))->asString()->value();
-	}
-
-	if (!good)
-	{
-	    y2error ("TargetDUInit: bad item %d: %s", i, dirlist->value(i)->toString().c_str());
-	    continue;
-	}
-
 	y2milestone("Adding %s", dname.c_str());
 
 	long long totalsize = dfree + dused;
@@ -321,6 +340,7 @@ PkgFunctions::TargetInitDU (const YCPList& dirlist)
     try
     {
 	zypp_ptr()->setPartitions(mount_points);
+	du_cache.reset();
     }
     catch(const zypp::Exception &excpt)
     {
@@ -333,6 +353,127 @@ PkgFunctions::TargetInitDU (const YCPList& dirlist)
     return YCPVoid();
 }
 
+// max. number of changed items for the incremental disk usage update,
+// a full recompute is faster for bigger changes (e.g. after a solver run)
+static const size_t max_du_changes = 1000;
+
+typedef std::vector<zypp::sat::Solvable::IdType> SolvableIds;
+
+/*
+ * A helper function - the disk usage change (in bytes) of the items in the "add"
+ * set (not installed items) minus the "remove" set (installed items).
+ * The installed items which are not removed are ignored by DiskUsageCounter.
+ */
+static void DUChange(const zypp::DiskUsageCounter &counter, const std::vector<zypp::sat::Solvable> &installed,
+    const SolvableIds &add, const SolvableIds &remove, unsigned mount_points, std::vector<long long> &change)
+{
+    change.clear();
+
+    if (add.empty() && remove.empty())
+    {
+	change.resize(mount_points, 0LL);
+	return;
+    }
+
+    std::vector<zypp::sat::Solvable> solvables;
+    solvables.reserve(installed.size() + add.size());
+
+    for_(it, installed.begin(), installed.end())
+    {
+	if (!std::binary_search(remove.begin(), remove.end(), it->id()))
+	    solvables.push_back(*it);
+    }
+
+    for_(it, add.begin(), add.end())
+	solvables.push_back(zypp::sat::Solvable(*it));
+
+    zypp::DiskUsageCounter::MountPointSet mps = counter.disk_usage(solvables.begin(), solvables.end());
+
+    for_(it, mps.begin(), mps.end())
+	change.push_back(it->pkg_size - it->used_size);
+}
+
+/*
+ * Update the cached disk usage with the changes of the items which changed
+ * the transaction state since the last computation. Each item changes
+ * the disk usage independently, so only the changed items are evaluated,
+ * the installed items without disk usage change are just passed to libzypp.
+ * Returns false if a full recompute is required.
+ */
+bool PkgFunctions::UpdateDUIncrementally(const SolvableIds &transacting)
+{
+    if (!du_cache.valid || du_cache.mps.empty())
+	return false;
+
+    SolvableIds started;
+    SolvableIds stopped;
+
+    std::set_difference(transacting.begin(), transacting.end(),
+	du_cache.transacting.begin(), du_cache.transacting.end(), std::back_inserter(started));
+    std::set_difference(du_cache.transacting.begin(), du_cache.transacting.end(),
+	transacting.begin(), transacting.end(), std::back_inserter(stopped));
+
+    if (started.size() + stopped.size() > max_du_changes)
+    {
+	y2debug("Too many changes (%zd), computing the disk usage from scratch", started.size() + stopped.size());
+	return false;
+    }
+
+    for_(it, du_cache.mps.begin(), du_cache.mps.end())
+    {
+	// the removed files are not freed on a grow only file system,
+	// the changes are not additive
+	if (it->growonly)
+	    return false;
+    }
+
+    // the new or removed items increase the usage (add_*),
+    // the deselected or deleted items decrease it (del_*)
+    SolvableIds add_new, add_installed, del_new, del_installed;
+
+    for_(it, started.begin(), started.end())
+    {
+	if (zypp::sat::Solvable(*it).isSystem())
+	    del_installed.push_back(*it);
+	else
+	    add_new.push_back(*it);
+    }
+
+    for_(it, stopped.begin(), stopped.end())
+    {
+	if (zypp::sat::Solvable(*it).isSystem())
+	    add_installed.push_back(*it);
+	else
+	    del_new.push_back(*it);
+    }
+
+    std::vector<zypp::sat::Solvable> installed;
+    zypp::Repository system = zypp::sat::Pool::instance().findSystemRepo();
+
+    if (system != zypp::Repository::noRepository)
+	installed.assign(system.solvablesBegin(), system.solvablesEnd());
+
+    zypp::DiskUsageCounter counter(zypp_ptr()->getPartitions());
+
+    // (add_new - del_installed) - (del_new - add_installed)
+    std::vector<long long> increase, decrease;
+    DUChange(counter, installed, add_new, del_installed, du_cache.mps.size(), increase);
+    DUChange(counter, installed, del_new, add_installed, du_cache.mps.size(), decrease);
+
+    if (increase.size() != du_cache.mps.size() || decrease.size() != du_cache.mps.size())
+	return false;
+
+    unsigned i = 0;
+    for_(it, du_cache.mps.begin(), du_cache.mps.end())
+    {
+	it->pkg_size += increase[i] - decrease[i];
+	++i;
+    }
+
+    y2debug("Updated the disk usage incrementally (%zd changed items)", started.size() + stopped.size());
+    return true;
+}
+
 /** ------------------------
  *
  * @builtin TargetGetDU
@@ -356,33 +497,62 @@ PkgFunctions::TargetInitDU (const YCPList& dirlist)
 YCPValue
 PkgFunctions::TargetGetDU ()
 {
-    YCPMap dirmap;
-
     try
     {
-	zypp::DiskUsageCounter::MountPointSet mps = zypp_ptr()->diskUsage();
-
-	if (mps.empty())
+	if (zypp_ptr()->getPartitions().empty())
 	{
 	    // mount points have not been defined
 	    y2warning("Pkg::TargetDUInit() has not been called, using data from system...");
 
 	    // set the values from the system
 	    SetCurrentDU();
+	}
+
+	unsigned serial = zypp_ptr()->pool().serial().serial();
+
+	if (du_cache.pool_serial != serial)
+	{
+	    du_cache.reset();
+	    du_cache.pool_serial = serial;
+	}
+
+	// the result depends only on the transacting items, checking the status is cheap
+	std::vector<zypp::sat::Solvable::IdType> transacting;
 
-	    // try it again
-	    mps = zypp_ptr()->diskUsage();
+	for_(it, zypp_ptr()->pool().begin(), zypp_ptr()->pool().end())
+	{
+	    if (it->status().transacts())
+	    {
+		transacting.push_back(it->satSolvable().id());
+	    }
 	}
 
-	dirmap = MPS2YCPMap(mps);
+	std::sort(transacting.begin(), transacting.end());
+
+	if (du_cache.valid && du_cache.transacting == transacting)
+	{
+	    y2debug("Using the cached disk usage");
+	    return du_cache.result;
+	}
+
+	// apply only the changes if possible, fallback to the full computation
+	if (!UpdateDUIncrementally(transacting))
+	{
+	    du_cache.mps = zypp_ptr()->diskUsage();
+	}
+
+	du_cache.result = MPS2YCPMap(du_cache.mps);
+	du_cache.transacting.swap(transacting);
+	du_cache.valid = true;
     }
     catch(const zypp::Exception &excpt)
     {
         y2error("Reading disk usage failed: %s", excpt.asString().c_str());
         _last_error.setLastError(ExceptionAsString(excpt));
+        du_cache.reset();
         return YCPVoid();
     }
 
-    return dirmap;
+    return du_cache.result;
 }
 
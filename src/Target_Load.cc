@@ -37,10 +37,57 @@
 #include <zypp/Locks.h>
 #include <zypp/ZConfig.h>
 
+#include <zypp/PathInfo.h>
+
+#include <sstream>
+
 /*
   Textdomain "pkg-bindings"
 */
 
+// "<mtime>:<size>" of the file, empty if it does not exist
+std::string PkgFunctions::FileStamp(const zypp::Pathname &file)
+{
+    zypp::PathInfo info(file);
+
+    if (!info.isExist())
+	return std::string();
+
+    std::ostringstream str;
+    str << info.mtime() << ':' << info.size();
+    return str.str();
+}
+
+// read and apply the persistent locks, skipped if neither the file
+// nor the pool nor the locks have been changed since the last call
+void PkgFunctions::ApplyTargetLocks()
+{
+    // locks are optional, might not be present on the target
+    zypp::Pathname lock_file(_target_root + zypp::ZConfig::instance().locksFile());
+
+    std::ostringstream stamp;
+    stamp << lock_file << '=' << FileStamp(lock_file) << ';' << zypp_ptr()->pool().serial().serial();
+
+    if (stamp.str() == target_locks_stamp)
+    {
+	y2milestone("Locks from %s are already applied", lock_file.asString().c_str());
+	return;
+    }
+
+    try
+    {
+	// read and apply the persistent locks
+	y2milestone("Reading locks from %s", lock_file.asString().c_str());
+	zypp::Locks::instance().readAndApply(lock_file);
+	lock_cache.valid = false;
+	target_locks_stamp = stamp.str();
+    }
+    catch (zypp::Exception & excpt)
+    {
+	y2warning("Error reading persistent locks from %s", lock_file.asString().c_str());
+    }
+}
+
 YCPValue
 PkgFunctions::TargetInitInternal(const YCPString& root, bool rebuild_rpmdb)
 {
@@ -84,6 +131,7 @@ PkgFunctions::TargetInitInternal(const YCPString& root, bool rebuild_rpmdb)
 	pkgprogress.NextStage();
         zypp_ptr()->target()->load();
 	_target_loaded = true;
+	base_product_cache.reset();
     }
     catch (zypp::Exception & excpt)
     {
@@ -92,18 +140,7 @@ PkgFunctions::TargetInitInternal(const YCPString& root, bool rebuild_rpmdb)
         return YCPError(excpt.msg().c_str(), YCPBoolean(false));
     }
 
-    // locks are optional, might not be present on the target
-    zypp::Pathname lock_file(_target_root + zypp::ZConfig::instance().locksFile());
-    try
-    {
-	// read and apply the persistent locks
-	y2milestone("Reading locks from %s", lock_file.asString().c_str());
-	zypp::Locks::instance().readAndApply(lock_file);
-    }
-    catch (zypp::Exception & excpt)
-    {
-	y2warning("Error reading persistent locks from %s", lock_file.asString().c_str());
-    }
+    ApplyTargetLocks();
 
     pkgprogress.Done();
 
@@ -0,0 +1,473 @@
+/*
+ * File:   TreeCopy.cc
+ *
+ * Copy a file or a directory tree preserving the permissions, the owners,
+ * the time stamps, the extended attributes and the hard links (like "cp -a").
+ */
+
+#include "TreeCopy.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <boost/bind.hpp>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <sys/xattr.h>
+#include <linux/fs.h>
+
+// do not fork the workers for copying just a few files
+static const unsigned files_per_job = 64;
+// the default max. number of workers, more parallel copies
+// usually do not help (the disk is the limit)
+static const unsigned default_max_jobs = 4;
+
+// copy the file content, the fastest available method first
+static bool copyData(int in, int out, off_t size)
+{
+#ifdef FICLONE
+    // share the data blocks (btrfs, xfs)
+    if (::ioctl(out, FICLONE, in) == 0)
+	return true;
+#endif
+
+    off_t done = 0;
+
+    // the file offsets are updated, the next method continues at the same place
+#ifdef SYS_copy_file_range
+    // in kernel copy, server side copy on NFS
+    while (done < size)
+    {
+	ssize_t ret = ::syscall(SYS_copy_file_range, in, NULL, out, NULL, size - done, 0);
+
+	if (ret <= 0)
+	    break;
+
+	done += ret;
+    }
+#endif
+
+    // in kernel copy, works across the filesystems also on the older kernels
+    while (done < size)
+    {
+	ssize_t ret = ::sendfile(out, in, NULL, size - done);
+
+	if (ret <= 0)
+	    break;
+
+	done += ret;
+    }
+
+    if (done >= size)
+	return true;
+
+    char buffer[64 * 1024];
+    ssize_t len;
+
+    for (;;)
+    {
+	len = ::read(in, buffer, sizeof(buffer));
+
+	if (len < 0 && errno == EINTR)
+	    continue;
+
+	if (len <= 0)
+	    break;
+
+	for (ssize_t written = 0; written < len; )
+	{
+	    ssize_t ret = ::write(out, buffer + written, len - written);
+
+	    if (ret < 0)
+	    {
+		if (errno == EINTR)
+		    continue;
+
+		return false;
+	    }
+
+	    written += ret;
+	}
+    }
+
+    return len == 0;
+}
+
+// copy the extended attributes (the ACLs are stored as the system.posix_acl_*
+// attributes), not supported by all filesystems, the errors are ignored
+static void copyXattrs(const std::string &source, const std::string &target)
+{
+    ssize_t size = ::llistxattr(source.c_str(), NULL, 0);
+
+    if (size <= 0)
+	return;
+
+    std::vector<char> names(size);
+    size = ::llistxattr(source.c_str(), &names[0], names.size());
+
+    if (size <= 0)
+	return;
+
+    std::vector<char> value;
+
+    // the names are separated by '\0'
+    for (std::vector<char>::size_type pos = 0; pos < (std::vector<char>::size_type)size; pos += ::strlen(&names[pos]) + 1)
+    {
+	const char *name = &names[pos];
+	ssize_t len = ::lgetxattr(source.c_str(), name, NULL, 0);
+
+	if (len < 0)
+	    continue;
+
+	value.resize(len + 1);
+	len = ::lgetxattr(source.c_str(), name, &value[0], value.size());
+
+	if (len < 0 || ::lsetxattr(target.c_str(), name, &value[0], len, 0) != 0)
+	    y2debug("Cannot copy attribute %s of %s: %s", name, source.c_str(), ::strerror(errno));
+    }
+}
+
+TreeCopy::TreeCopy(unsigned jobs, bool backup, const PkgWorkers::ChildSetupFnc &child_setup)
+    : _jobs(jobs > 0 ? jobs : std::min(PkgWorkers::defaultJobs(), default_max_jobs)),
+    _backup(backup),
+    _child_setup(child_setup),
+    _bytes(0),
+    _failed(false)
+{
+}
+
+bool TreeCopy::copy(const std::string &source, const std::string &target_dir, bool recursive)
+{
+    _dirs.clear();
+    _files.clear();
+    _links.clear();
+    _inodes.clear();
+    _bytes = 0;
+    _failed = false;
+
+    struct stat st;
+    if (::stat(target_dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+    {
+	y2error("Target %s is not a directory", target_dir.c_str());
+	return false;
+    }
+
+    std::string::size_type pos = source.find_last_not_of('/');
+    std::string name(pos == std::string::npos ? source : source.substr(0, pos + 1));
+    pos = name.rfind('/');
+    if (pos != std::string::npos)
+	name.erase(0, pos + 1);
+
+    // create the target directories, collect the files
+    if (!scan(source, target_dir + "/" + name, recursive))
+	return false;
+
+    // balance the workers by the file sizes
+    std::vector<Entry> sorted(_files);
+    std::stable_sort(sorted.begin(), sorted.end(), largerFirst);
+    _files.swap(sorted);
+
+    unsigned buckets = std::min<unsigned>(_jobs, _files.size() / files_per_job + 1);
+
+    if (buckets <= 1)
+    {
+	_failed = copyBucket(0, 1) != PkgWorkers::JOB_DONE;
+    }
+    else
+    {
+	PkgWorkers workers(buckets, _child_setup);
+
+	for (unsigned bucket = 0; bucket < buckets; ++bucket)
+	    workers.add(boost::bind(&TreeCopy::copyBucket, this, bucket, buckets));
+
+	if (!workers.run(boost::bind(&TreeCopy::jobFinished, this, _1, _2)))
+	    _failed = true;
+    }
+
+    // the first copies exist now
+    for (std::vector<std::pair<Entry, std::string> >::const_iterator it = _links.begin(); it != _links.end(); ++it)
+    {
+	if (!copyHardlink(it->first, it->second))
+	    _failed = true;
+    }
+
+    // the contents is complete, set the directory permissions and time stamps
+    // (the deepest directories first)
+    for (std::vector<Entry>::reverse_iterator it = _dirs.rbegin(); it != _dirs.rend(); ++it)
+	setAttributes(*it);
+
+    y2milestone("Copied %s to %s: %u files, %u directories, %llu bytes, %u jobs%s", source.c_str(),
+	target_dir.c_str(), files(), dirs(), _bytes, buckets, _failed ? " (failed)" : "");
+
+    return !_failed;
+}
+
+bool TreeCopy::largerFirst(const Entry &a, const Entry &b)
+{
+    return a.st.st_size > b.st.st_size;
+}
+
+bool TreeCopy::scan(const std::string &source, const std::string &target, bool recursive)
+{
+    Entry entry;
+    entry.source = source;
+    entry.target = target;
+
+    if (::lstat(source.c_str(), &entry.st) != 0)
+    {
+	y2error("Cannot stat %s: %s", source.c_str(), ::strerror(errno));
+	return false;
+    }
+
+    if (S_ISREG(entry.st.st_mode) && entry.st.st_nlink > 1)
+    {
+	std::pair<std::map<std::pair<dev_t, ino_t>, std::string>::iterator, bool> inode =
+	    _inodes.insert(std::make_pair(std::make_pair(entry.st.st_dev, entry.st.st_ino), target));
+
+	// another link to an already collected file
+	if (!inode.second)
+	{
+	    _links.push_back(std::make_pair(entry, inode.first->second));
+	    return true;
+	}
+    }
+
+    if (S_ISREG(entry.st.st_mode) || S_ISLNK(entry.st.st_mode))
+    {
+	_files.push_back(entry);
+	_bytes += entry.st.st_size;
+	return true;
+    }
+
+    if (!S_ISDIR(entry.st.st_mode))
+    {
+	y2warning("Skipping special file %s", source.c_str());
+	return true;
+    }
+
+    struct stat st;
+    if (::lstat(target.c_str(), &st) == 0)
+    {
+	if (!S_ISDIR(st.st_mode))
+	{
+	    y2error("Cannot overwrite %s with a directory", target.c_str());
+	    return false;
+	}
+    }
+    // writable for the owner until the contents is copied
+    else if (::mkdir(target.c_str(), 0700) != 0)
+    {
+	y2error("Cannot create directory %s: %s", target.c_str(), ::strerror(errno));
+	return false;
+    }
+
+    _dirs.push_back(entry);
+
+    if (!recursive)
+	return true;
+
+    DIR *dir = ::opendir(source.c_str());
+
+    if (!dir)
+    {
+	y2error("Cannot read directory %s: %s", source.c_str(), ::strerror(errno));
+	return false;
+    }
+
+    bool ret = true;
+    struct dirent *item;
+
+    while (ret && (item = ::readdir(dir)) != NULL)
+    {
+	if (::strcmp(item->d_name, ".") == 0 || ::strcmp(item->d_name, "..") == 0)
+	    continue;
+
+	ret = scan(source + "/" + item->d_name, target + "/" + item->d_name, recursive);
+    }
+
+    ::closedir(dir);
+
+    return ret;
+}
+
+// runs in a worker process (or in the main process for a single bucket)
+int TreeCopy::copyBucket(unsigned bucket, unsigned buckets) const
+{
+    int ret = PkgWorkers::JOB_DONE;
+
+    for (std::vector<Entry>::size_type index = bucket; index < _files.size(); index += buckets)
+    {
+	if (!copyEntry(_files[index]))
+	    ret = PkgWorkers::JOB_FAILED;
+    }
+
+    return ret;
+}
+
+bool TreeCopy::jobFinished(unsigned index, int status)
+{
+    if (status != PkgWorkers::JOB_DONE)
+    {
+	y2error("Copy job %u failed", index);
+	_failed = true;
+    }
+
+    // copy the rest anyway, like "cp" does
+    return true;
+}
+
+bool TreeCopy::copyEntry(const Entry &entry) const
+{
+    if (!prepareTarget(entry.target))
+	return false;
+
+    return S_ISLNK(entry.st.st_mode) ? copySymlink(entry) : copyFile(entry);
+}
+
+// backup or remove the existing target file
+bool TreeCopy::prepareTarget(const std::string &target) const
+{
+    struct stat st;
+
+    if (::lstat(target.c_str(), &st) != 0)
+	return true;
+
+    if (S_ISDIR(st.st_mode))
+    {
+	y2error("Cannot overwrite directory %s", target.c_str());
+	return false;
+    }
+
+    if (_backup)
+    {
+	std::string backup(target + "~");
+
+	if (::rename(target.c_str(), backup.c_str()) != 0)
+	{
+	    y2error("Cannot backup %s: %s", target.c_str(), ::strerror(errno));
+	    return false;
+	}
+    }
+    else if (::unlink(target.c_str()) != 0)
+    {
+	y2error("Cannot remove %s: %s", target.c_str(), ::strerror(errno));
+	return false;
+    }
+
+    return true;
+}
+
+bool TreeCopy::copyFile(const Entry &entry) const
+{
+    int in = ::open(entry.source.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (in < 0)
+    {
+	y2error("Cannot open %s: %s", entry.source.c_str(), ::strerror(errno));
+	return false;
+    }
+
+    int out = ::open(entry.target.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+
+    if (out < 0)
+    {
+	y2error("Cannot create %s: %s", entry.target.c_str(), ::strerror(errno));
+	::close(in);
+	return false;
+    }
+
+    bool ret = copyData(in, out, entry.st.st_size);
+
+    if (ret)
+    {
+	// the owner first, changing it would reset the setuid bits
+	if (::fchown(out, entry.st.st_uid, entry.st.st_gid) != 0)
+	    y2debug("Cannot change the owner of %s: %s", entry.target.c_str(), ::strerror(errno));
+
+	::fchmod(out, entry.st.st_mode & 07777);
+	// after chmod, it would change the ACL mask
+	copyXattrs(entry.source, entry.target);
+
+	struct timespec times[2] = { entry.st.st_atim, entry.st.st_mtim };
+	::futimens(out, times);
+    }
+    else
+    {
+	y2error("Cannot copy %s to %s: %s", entry.source.c_str(), entry.target.c_str(), ::strerror(errno));
+    }
+
+    ::close(in);
+
+    if (::close(out) != 0)
+    {
+	y2error("Cannot write %s: %s", entry.target.c_str(), ::strerror(errno));
+	ret = false;
+    }
+
+    return ret;
+}
+
+bool TreeCopy::copySymlink(const Entry &entry) const
+{
+    std::vector<char> link(entry.st.st_size + 1);
+    ssize_t len = ::readlink(entry.source.c_str(), &link[0], link.size());
+
+    if (len < 0 || len >= (ssize_t)link.size())
+    {
+	y2error("Cannot read symlink %s", entry.source.c_str());
+	return false;
+    }
+
+    link[len] = '\0';
+
+    if (::symlink(&link[0], entry.target.c_str()) != 0)
+    {
+	y2error("Cannot create symlink %s: %s", entry.target.c_str(), ::strerror(errno));
+	return false;
+    }
+
+    if (::lchown(entry.target.c_str(), entry.st.st_uid, entry.st.st_gid) != 0)
+	y2debug("Cannot change the owner of %s: %s", entry.target.c_str(), ::strerror(errno));
+
+    copyXattrs(entry.source, entry.target);
+
+    struct timespec times[2] = { entry.st.st_atim, entry.st.st_mtim };
+    ::utimensat(AT_FDCWD, entry.target.c_str(), times, AT_SYMLINK_NOFOLLOW);
+
+    return true;
+}
+
+// link the target to the first copy of the file, copy the file if that fails
+// (e.g. the first copy has failed)
+bool TreeCopy::copyHardlink(const Entry &entry, const std::string &first) const
+{
+    if (!prepareTarget(entry.target))
+	return false;
+
+    if (::link(first.c_str(), entry.target.c_str()) == 0)
+	return true;
+
+    y2debug("Cannot link %s to %s: %s", entry.target.c_str(), first.c_str(), ::strerror(errno));
+
+    return copyFile(entry);
+}
+
+void TreeCopy::setAttributes(const Entry &entry) const
+{
+    if (::chown(entry.target.c_str(), entry.st.st_uid, entry.st.st_gid) != 0)
+	y2debug("Cannot change the owner of %s: %s", entry.target.c_str(), ::strerror(errno));
+
+    ::chmod(entry.target.c_str(), entry.st.st_mode & 07777);
+    copyXattrs(entry.source, entry.target);
+
+    struct timespec times[2] = { entry.st.st_atim, entry.st.st_mtim };
+    ::utimensat(AT_FDCWD, entry.target.c_str(), times, 0);
+}
@@ -0,0 +1,75 @@
+/*
+ * File:   TreeCopy.h
+ *
+ * Copy a file or a directory tree preserving the permissions, the owners,
+ * the time stamps, the extended attributes (incl. the ACLs) and the hard
+ * links (like "cp -a").
+ *
+ * (Note: the file data are cloned (reflink) if the filesystem supports it,
+ * then copied in the kernel (copy_file_range, sendfile), a user space copy
+ * is the last fallback. Large trees are copied by several worker processes.)
+ */
+
+#ifndef TREECOPY_H
+#define TREECOPY_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "PkgWorkers.h"
+
+class TreeCopy {
+
+public:
+    // jobs - max. number of the worker processes (0 = number of CPUs, max. 4)
+    // backup - rename the existing target files to "<name>~" (like "cp -b")
+    TreeCopy(unsigned jobs, bool backup, const PkgWorkers::ChildSetupFnc &child_setup = PkgWorkers::ChildSetupFnc());
+
+    // copy the source file or directory into the target directory
+    // (target/<source basename>), a missing target directory is an error
+    bool copy(const std::string &source, const std::string &target_dir, bool recursive = true);
+
+    // statistics of the last copy
+    unsigned files() const { return _files.size() + _links.size(); }
+    unsigned dirs() const { return _dirs.size(); }
+    unsigned long long bytes() const { return _bytes; }
+
+private:
+    struct Entry {
+	std::string source;
+	std::string target;
+	struct stat st;
+    };
+
+    static bool largerFirst(const Entry &a, const Entry &b);
+    bool scan(const std::string &source, const std::string &target, bool recursive);
+    bool copyEntry(const Entry &entry) const;
+    bool copyFile(const Entry &entry) const;
+    bool copySymlink(const Entry &entry) const;
+    bool copyHardlink(const Entry &entry, const std::string &first) const;
+    bool prepareTarget(const std::string &target) const;
+    void setAttributes(const Entry &entry) const;
+    int copyBucket(unsigned bucket, unsigned buckets) const;
+    bool jobFinished(unsigned index, int status);
+
+    unsigned _jobs;
+    bool _backup;
+    PkgWorkers::ChildSetupFnc _child_setup;
+
+    std::vector<Entry> _dirs;
+    // regular files and symlinks
+    std::vector<Entry> _files;
+    // the other hard links of the already collected files (entry, the first copy)
+    std::vector<std::pair<Entry, std::string> > _links;
+    // device, inode => the first copy of a file with more hard links
+    std::map<std::pair<dev_t, ino_t>, std::string> _inodes;
+    unsigned long long _bytes;
+    bool _failed;
+};
+
+#endif	/* TREECOPY_H */
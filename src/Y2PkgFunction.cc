@@ -38,8 +38,85 @@
 // use backtrace_symbols()
 #include <execinfo.h>
 
+#include <new>
+#include <vector>
 
-    Y2PkgFunction::Y2PkgFunction (string name, PkgFunctions* instance, unsigned int pos) :
+// released Y2PkgFunction objects kept for reuse, the YCP interpreter
+// is single threaded so no locking is needed
+// (intentionally never destroyed, the calls might be deleted at exit)
+static std::vector<void*> &free_functions = *new std::vector<void*>;
+// max. number of the kept objects (nested calls need more than one)
+static const size_t max_free_functions = 32;
+
+// PoolChangesEnter()/PoolChangesLeave() pair, Leave is called even when
+// the call is left by an exception, otherwise the changes would never be
+// reported again (the nesting depth would stay above zero)
+class PoolChangesGuard
+{
+    public:
+	PoolChangesGuard(PkgFunctions *pkg, const std::string &builtin, const YCPValue &ret)
+	    : _pkg(pkg), _builtin(builtin), _ret(ret)
+	{
+	    _pkg->PoolChangesEnter();
+	}
+
+	~PoolChangesGuard()
+	{
+	    // the destructor must not throw, the errors are only logged
+	    try
+	    {
+		// report the changes (once for the outermost call)
+		_pkg->PoolChangesLeave(_builtin, _ret);
+	    }
+	    catch (...)
+	    {
+		y2internal("Caught an exception while reporting the pool changes from Pkg::%s", _builtin.c_str());
+	    }
+
+	    try
+	    {
+		_pkg->CheckSolverTestCases();
+	    }
+	    catch (...)
+	    {
+		y2internal("Caught an exception while reporting the solver testcases from Pkg::%s", _builtin.c_str());
+	    }
+	}
+
+    private:
+	PkgFunctions *_pkg;
+	const std::string &_builtin;
+	const YCPValue &_ret;
+};
+
+
+    void* Y2PkgFunction::operator new (size_t size)
+    {
+	if (size == sizeof(Y2PkgFunction) && !free_functions.empty())
+	{
+	    void *ptr = free_functions.back();
+	    free_functions.pop_back();
+	    return ptr;
+	}
+
+	return ::operator new (size);
+    }
+
+    void Y2PkgFunction::operator delete (void *ptr, size_t size)
+    {
+	if (ptr == NULL)
+	    return;
+
+	if (size == sizeof(Y2PkgFunction) && free_functions.size() < max_free_functions)
+	{
+	    free_functions.push_back(ptr);
+	    return;
+	}
+
+	::operator delete (ptr);
+    }
+
+    Y2PkgFunction::Y2PkgFunction (const string &name, PkgFunctions* instance, unsigned int pos) :
 	m_position (pos)
 	, m_instance (instance)
 	, m_param1 ( YCPNull () )
@@ -129,6 +206,39 @@
     {
 	ycpmilestone ("Pkg Builtin called: %s", name().c_str() );
 
+	YCPValue ret = YCPVoid();
+
+	// the lazy load below also changes the pool
+	PoolChangesGuard pool_changes(m_instance, m_name, ret);
+
+	PkgProfiler &profiler = m_instance->profiler();
+
+	// load the repositories skipped by the lazy SourceStartManager(),
+	// the builtin is not evaluated if that fails (see Pkg::LastError())
+	if (!m_instance->LazyLoad(m_name))
+	{
+	    ret = YCPNull();
+	}
+	else if (!profiler.active())
+	{
+	    ret = evaluateBuiltin();
+	}
+	else
+	{
+	    long long start = PkgProfiler::now();
+	    ret = evaluateBuiltin();
+	    long long time = PkgProfiler::now() - start;
+
+	    // the time needed for computing the size is not included, the result
+	    // is serialized only here (not in any other path of a builtin call)
+	    profiler.record(m_position, m_name, time, ret.isNull() ? 0 : ret->toString().size());
+	}
+
+	return ret;
+    }
+
+    YCPValue Y2PkgFunction::evaluateBuiltin ()
+    {
 	try
 	{
 	    switch (m_position) {
@@ -15,12 +15,19 @@ class Y2PkgFunction: public Y2Function
     YCPValue m_param3;
     YCPValue m_param4;
     YCPValue m_param5;
-    string m_name;
+    // refers to the registered function name in PkgModuleFunctions
+    const string &m_name;
 
     void log_backtrace();
+    YCPValue evaluateBuiltin ();
 public:
 
-    Y2PkgFunction (string name, PkgFunctions* instance, unsigned int pos);
+    Y2PkgFunction (const string &name, PkgFunctions* instance, unsigned int pos);
+
+    // the objects are allocated for each builtin call, recycle the memory
+    static void* operator new (size_t size);
+    static void operator delete (void *ptr, size_t size);
+
     bool attachParameter (const YCPValue& arg, const int position);
     constTypePtr wantedParameterType () const;
     bool appendParameter (const YCPValue& arg);
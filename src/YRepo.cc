@@ -26,6 +26,8 @@
 
 #include <YRepo.h>
 
+#include <sstream>
+
 #define y2log_component "Pkg"
 #include <ycp/y2log.h>
 
@@ -59,5 +61,22 @@ zypp::MediaSetAccess_Ptr & YRepo::mediaAccess()
     return _maccess;
 }
 
+std::string YRepo::iniContent() const
+{
+    std::ostringstream str;
+    _repo.dumpAsIniOn(str);
+    return str.str();
+}
+
+bool YRepo::isModified() const
+{
+    return _saved.empty() || _saved != iniContent();
+}
+
+void YRepo::setSaved()
+{
+    _saved = iniContent();
+}
+
 const YRepo YRepo::NOREPO;
 
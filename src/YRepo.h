@@ -28,6 +28,8 @@
 #ifndef YRepo_h
 #define YRepo_h
 
+#include <string>
+
 #include <zypp/RepoInfo.h>
 #include <zypp/MediaSetAccess.h>
 #include <zypp/base/ReferenceCounted.h>
@@ -40,6 +42,10 @@ private:
     zypp::MediaSetAccess_Ptr _maccess;
     bool _deleted;
     bool _loaded;
+    // the .repo file content at the last load or save, empty = not saved yet
+    std::string _saved;
+
+    std::string iniContent() const;
 
     YRepo() {}
 
@@ -58,6 +64,13 @@ public:
     void setLoaded() {_loaded = true;}
     void resetLoaded() {_loaded = false;}
 
+    // has the repository been changed since the last load or save?
+    bool isModified() const;
+    // the current state has been loaded from or written to disk
+    void setSaved();
+    // not saved to the current target yet (e.g. after changing the target root)
+    void resetSaved() { _saved.clear(); }
+
 public:
     static const YRepo NOREPO;
 };
@@ -27,8 +27,19 @@
 
 #include "ycpTools.h"
 
+#include <boost/unordered_map.hpp>
+
+#include <zypp/sat/Pool.h>
+
 using namespace std;
 
+namespace YCPKey {
+#define YCP_DEFINE_KEY(k) const YCPString k( #k );
+  YCP_MAP_KEYS(YCP_DEFINE_KEY)
+#undef YCP_DEFINE_KEY
+  const YCPString default_key( "default" );
+}
+
 ///////////////////////////////////////////////////////////////////
 //
 //
@@ -78,6 +89,76 @@ bool YcpArgLoad::load( const YCPList & args_r )
   return ret;
 }
 
+///////////////////////////////////////////////////////////////////
+//
+//
+//	METHOD NAME : YcpMapLoad::index
+//	METHOD TYPE : int
+//
+int YcpMapLoad::index( const std::string & key_r ) const
+{
+  for ( unsigned i = 0; i < _keys.size(); ++i ) {
+    if ( _keys[i] == key_r )
+      return i;
+  }
+  return -1;
+}
+
+///////////////////////////////////////////////////////////////////
+//
+//
+//	METHOD NAME : YcpMapLoad::load
+//	METHOD TYPE : bool
+//
+bool YcpMapLoad::load( const YCPMap & map_r )
+{
+  _error.clear();
+
+  for ( unsigned i = 0; i < _proto.size(); ++i ) {
+    _proto[i]->reset();
+    _found[i] = false;
+  }
+
+  if ( ! map_r.isNull() ) {
+    // a single pass over the map, the options have just a few keys
+    for ( YCPMap::const_iterator it = map_r->begin(); _error.empty() && it != map_r->end(); ++it ) {
+      if ( it->first.isNull() || ! it->first->isString() || it->second.isNull() || it->second->isVoid() )
+	continue;
+
+      int i = index( it->first->asString()->value() );
+      if ( i < 0 )
+	continue;
+
+      switch ( _proto[i]->load( it->second ) ) {
+      case YcpArgLoad::YcpArg::assigned:
+	_found[i] = true;
+	break;
+      case YcpArgLoad::YcpArg::wrongtype:
+	_error = stringutil::form( "\"%s\": expect %s but got %s", _keys[i].c_str(),
+				   ::asString( _proto[i]->type() ).c_str(),
+				   ::asString( it->second->valuetype() ).c_str() );
+	break;
+      case YcpArgLoad::YcpArg::badformat:
+	_error = stringutil::form( "\"%s\": malformed %s : '%s'", _keys[i].c_str(),
+				   ::asString( _proto[i]->type() ).c_str(),
+				   it->second->toString().c_str() );
+	break;
+      }
+    }
+  }
+
+  for ( unsigned i = 0; _error.empty() && i < _proto.size(); ++i ) {
+    if ( _required[i] && ! _found[i] )
+      _error = stringutil::form( "\"%s\" key is missing", _keys[i].c_str() );
+  }
+
+  if ( ! _error.empty() ) {
+    y2error( "%s: %s", _fnc.c_str(), _error.c_str() );
+    return false;
+  }
+  return true;
+}
+
 /******************************************************************
 **
 **
@@ -195,3 +276,55 @@ std::ostream & operator<<( std::ostream & str, const YCPValue & obj )
   return str << asString( obj );
 }
 
+/******************************************************************
+**
+**
+**	FUNCTION NAME : asYCPString
+**	FUNCTION TYPE : YCPString
+*/
+YCPString asYCPString( zypp::IdString id_r )
+{
+  typedef boost::unordered_map<zypp::IdString::IdType, YCPString> StringMap;
+  // never destroyed, the YCP values might be still referenced at exit
+  static StringMap * strings = new StringMap;
+  static unsigned serial = 0;
+
+  // drop the strings of the removed repositories
+  unsigned current = zypp::sat::Pool::instance().serial().serial();
+  if ( current != serial ) {
+    strings->clear();
+    serial = current;
+  }
+
+  StringMap::const_iterator it = strings->find( id_r.id() );
+  if ( it != strings->end() )
+    return it->second;
+
+  YCPString ret( id_r.asString() );
+  strings->insert( std::make_pair( id_r.id(), ret ) );
+  return ret;
+}
+
+/******************************************************************
+**
+**
+**	FUNCTION NAME : asResKind
+**	FUNCTION TYPE : bool
+*/
+bool asResKind( const std::string & name_r, zypp::ResKind & kind_r )
+{
+  if ( name_r == "product" )
+    kind_r = zypp::ResKind::product;
+  else if ( name_r == "patch" )
+    kind_r = zypp::ResKind::patch;
+  else if ( name_r == "package" )
+    kind_r = zypp::ResKind::package;
+  else if ( name_r == "srcpackage" )
+    kind_r = zypp::ResKind::srcpackage;
+  else if ( name_r == "pattern" )
+    kind_r = zypp::ResKind::pattern;
+  else
+    return false;
+
+  return true;
+}
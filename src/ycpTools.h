@@ -31,6 +31,8 @@
 #include <zypp/Pathname.h>
 #include <zypp/Url.h>
 #include <zypp/Product.h>
+#include <zypp/IdString.h>
+#include <zypp/ResKind.h>
 
 ///////////////////////////////////////////////////////////////////
 // convenience functions
@@ -72,6 +74,8 @@ class YcpArgLoad {
       public:
 	virtual ~YcpArg() {}
 	YCPValueType type() const { return _type; }
+	// restore the default value
+	virtual void reset() = 0;
 	enum Result { assigned = 0, wrongtype, badformat };
 	Result load( const YCPValue & arg_r ) {
 	  if ( arg_r->valuetype() != _type ) {
@@ -95,16 +99,21 @@ class YcpArgLoad {
     class Value : public YcpArg {
       protected:
 	Vtype _value;
+	Vtype _default;
 	virtual bool assign( const YCPValue & arg_r );
       public:
 	Value()
 	  : YcpArg( Ytype )
+	  , _value()
+	  , _default()
 	{}
 	Value( const Vtype & value_r )
 	  : YcpArg( Ytype )
 	  , _value( value_r )
+	  , _default( value_r )
 	{}
 	virtual ~Value() {}
+	virtual void reset() { _value = _default; }
 	operator Vtype &() { return _value; }
     };
     ///////////////////////////////////////////////////////////////////
@@ -157,6 +166,102 @@ class YcpArgLoad {
 
 ///////////////////////////////////////////////////////////////////
 
+///////////////////////////////////////////////////////////////////
+//
+//	CLASS NAME : YcpMapLoad
+/**
+ * Decode the keys of a YCPMap argument (options) in one pass over the map,
+ * the values are checked and converted like in YcpArgLoad. A nil value is
+ * the same as a missing key, unknown keys are ignored.
+ *
+ * <code>
+ *   YcpMapLoad opts( "Pkg::Foo" );
+ *   bool & force( opts.arg<YT_BOOLEAN, bool>( "force", false ) );
+ *   std::string & name( opts.arg<YT_STRING, std::string>( "name" ) );
+ *
+ *   if ( ! opts.load( map ) )
+ *     // opts.error() describes the (first) problem
+ * </code>
+ *
+ * The same object can load more maps, the values are reset to the defaults
+ * at each load().
+ **/
+class YcpMapLoad {
+
+  YcpMapLoad & operator=( const YcpMapLoad & );
+  YcpMapLoad            ( const YcpMapLoad & );
+
+  private:
+
+    typedef YcpArgLoad::YcpArg YcpArg;
+
+    std::string          _fnc;
+    std::vector<YcpArg*> _proto;
+    std::vector<std::string> _keys;
+    // the required keys
+    std::vector<bool>    _required;
+    // the keys found by the last load()
+    std::vector<bool>    _found;
+    std::string          _error;
+
+    YcpArg & append( const std::string & key_r, YcpArg * narg, bool required_r ) {
+      _proto.push_back( narg );
+      _keys.push_back( key_r );
+      _required.push_back( required_r );
+      _found.push_back( false );
+      return *narg;
+    }
+
+    int index( const std::string & key_r ) const;
+
+  public:
+
+    YcpMapLoad( const std::string & fnc_r = "" )
+      : _fnc( fnc_r )
+    {}
+
+    ~YcpMapLoad() {
+      for ( unsigned i = 0; i < _proto.size(); ++i ) {
+	delete _proto[i];
+      }
+    }
+
+  public:
+
+    /** A required key */
+    template<YCPValueType Ytype, typename Vtype>
+    Vtype & arg( const std::string & key_r ) {
+      YcpArgLoad::Value<Ytype,Vtype> * narg = new YcpArgLoad::Value<Ytype,Vtype>();
+      append( key_r, narg, true );
+      return *narg;
+    }
+
+    /** An optional key with the default value */
+    template<YCPValueType Ytype, typename Vtype>
+    Vtype & arg( const std::string & key_r, const Vtype & d ) {
+      YcpArgLoad::Value<Ytype,Vtype> * narg = new YcpArgLoad::Value<Ytype,Vtype>( d );
+      append( key_r, narg, false );
+      return *narg;
+    }
+
+  public:
+
+    /** Returns false (and logs the error) if a value has a wrong type
+     * or a required key is missing. */
+    bool load( const YCPMap & map_r );
+
+    /** The key has been set (not nil) in the last loaded map. */
+    bool has( const std::string & key_r ) const {
+      int i = index( key_r );
+      return i >= 0 && _found[i];
+    }
+
+    /** The error found by the last load(). */
+    const std::string & error() const { return _error; }
+};
+
+///////////////////////////////////////////////////////////////////
+
 ///////////////////////////////////////////////////////////////////
 //
 // Common load templates
@@ -206,6 +311,15 @@ inline bool YcpArgLoad::Value<YT_INTEGER, int>::assign( const YCPValue & arg_r )
   return true;
 }
 
+///////////////////////////////////////////////////////////////////
+// YT_SYMBOL
+///////////////////////////////////////////////////////////////////
+template<>
+inline bool YcpArgLoad::Value<YT_SYMBOL, std::string>::assign( const YCPValue & arg_r ) {
+  _value = arg_r->asSymbol()->symbol();
+  return true;
+}
+
 ///////////////////////////////////////////////////////////////////
 // YT_STRING
 ///////////////////////////////////////////////////////////////////
@@ -256,6 +370,60 @@ inline YCPList asYCPList( const zypp::Product::UrlList & urls_r )
    return ret;
 }
 
+///////////////////////////////////////////////////////////////////
+//
+// Shared YCPStrings for the pool strings
+//
+///////////////////////////////////////////////////////////////////
+
+/** The same YCPString object is returned for the same pool string until
+ * the pool is changed. (The names, archs, editions and vendors repeat in the
+ * large listings, sharing them saves the allocations and the memory.) */
+extern YCPString asYCPString( zypp::IdString id_r );
+
+/** Convert the kind symbol name ("product", "patch", "package", "srcpackage"
+ * or "pattern"), returns false for an unknown kind (kind_r is not changed). */
+extern bool asResKind( const std::string & name_r, zypp::ResKind & kind_r );
+
+///////////////////////////////////////////////////////////////////
+//
+// Shared map keys
+//
+///////////////////////////////////////////////////////////////////
+
+/** The keys of the maps built for each resolvable, package, GPG key or
+ * partition, use YCPKey::name instead of YCPString("name") to avoid
+ * creating a new YCPString for each key of each map. */
+#define YCP_MAP_KEYS(K) \
+    K(affects_pkg_manager) K(arch) K(available) K(block_size) \
+    K(capacity) K(category) K(code) K(conflicts) K(contents) \
+    K(created) K(created_raw) K(dep_kind) K(dependencies) K(deps) \
+    K(description) K(display_name) K(download_size) K(enhances) K(eol) \
+    K(expires) K(expires_raw) K(extra_urls) K(filesystem) \
+    K(fingerprint) K(flags) K(flavor) K(free) K(growonly) K(icon) \
+    K(id) K(inst_size) K(interactive) K(is_needed) K(kind) K(license) \
+    K(license_confirmed) K(location) K(locked) K(medianr) K(medium_nr) \
+    K(name) K(notify) K(obsoletes) K(on_system_by_user) \
+    K(optional_urls) K(order) K(packages) K(path) K(prerequires) \
+    K(product) K(product_file) K(product_line) K(product_package) \
+    K(provides) K(readonly) K(reboot_needed) K(recommends) \
+    K(register_release) K(register_target) K(register_urls) \
+    K(relnotes_url) K(relnotes_urls) K(relogin_needed) K(replaces) \
+    K(repository) K(requested) K(requires) K(res_kind) K(script) \
+    K(short_name) K(smolt_urls) K(source) K(src_type) K(srcid) \
+    K(status) K(suggests) K(summary) K(supplements) K(transact_by) \
+    K(trusted) K(type) K(update_urls) K(upgrades) K(used) \
+    K(user_visible) K(vendor) K(version) K(version_epoch) \
+    K(version_release) K(version_version)
+
+namespace YCPKey {
+#define YCP_DECLARE_KEY(k) extern const YCPString k;
+  YCP_MAP_KEYS(YCP_DECLARE_KEY)
+#undef YCP_DECLARE_KEY
+  // "default" is a C++ keyword
+  extern const YCPString default_key;
+}
+
 ///////////////////////////////////////////////////////////////////
 
 #endif // ycpTools_h
@@ -0,0 +1,101 @@
+/*
+ * File:   disk_usage_test.cc
+ *
+ * Unit test of the incremental disk usage (TargetGetDU).
+ *
+ * The cached disk usage is updated only with the changed items,
+ * the result must be the same as the full computation (TargetInitDU()
+ * drops the cache).
+ */
+
+#include "test_tools.h"
+#include "test_repo.h"
+
+#include <PkgFunctions.h>
+
+#include <ycp/YCPBoolean.h>
+#include <ycp/YCPInteger.h>
+#include <ycp/YCPList.h>
+#include <ycp/YCPMap.h>
+#include <ycp/YCPString.h>
+
+#include <zypp/TmpPath.h>
+
+static const unsigned packages = 500;
+
+static YCPList Partitions()
+{
+    YCPList partitions;
+    const char *dirs[] = { "/", "/usr", "/usr/share/bench" };
+
+    for (unsigned i = 0; i < sizeof(dirs) / sizeof(dirs[0]); ++i)
+    {
+	YCPMap partition;
+	partition->add(YCPString("name"), YCPString(dirs[i]));
+	partition->add(YCPString("free"), YCPInteger(10LL * 1024 * 1024));
+	partition->add(YCPString("used"), YCPInteger(1024LL * 1024));
+	partition->add(YCPString("readonly"), YCPBoolean(false));
+	partitions->add(partition);
+    }
+
+    return partitions;
+}
+
+// the cached (incremental) result must match the full computation
+static void CheckDU(PkgFunctions &pkg, const char *step)
+{
+    YCPValue cached = pkg.TargetGetDU();
+    // the cached result is returned again
+    YCPValue again = pkg.TargetGetDU();
+
+    pkg.TargetInitDU(Partitions());
+    YCPValue full = pkg.TargetGetDU();
+
+    if (!TEST_CHECK(!cached.isNull() && !full.isNull() && cached->toString() == full->toString()))
+    {
+	std::cerr << step << ": incremental " << (cached.isNull() ? "nil" : cached->toString())
+	    << ", full " << (full.isNull() ? "nil" : full->toString()) << std::endl;
+    }
+
+    TEST_CHECK(!again.isNull() && !cached.isNull() && again->toString() == cached->toString());
+}
+
+int main()
+{
+    zypp::filesystem::TmpDir root;
+    PkgFunctions pkg;
+
+    if (!StartTestSystem(pkg, root.path(), packages))
+	return TestResult("disk_usage_test");
+
+    TEST_CHECK(IsTrue(pkg.TargetInitDU(Partitions())));
+    YCPValue initial = pkg.TargetGetDU();
+    TEST_CHECK(!initial.isNull());
+
+    // a single new item
+    pkg.PkgInstall(YCPString(TestPackageName(10)));
+    CheckDU(pkg, "one package");
+
+    // more items in a batch
+    for (unsigned index = 20; index <= 60; index += 10)
+	pkg.PkgInstall(YCPString(TestPackageName(index)));
+    CheckDU(pkg, "more packages");
+
+    // a deselected item decreases the usage
+    pkg.PkgNeutral(YCPString(TestPackageName(30)));
+    CheckDU(pkg, "deselected package");
+
+    // the selected and deselected items at once
+    pkg.PkgNeutral(YCPString(TestPackageName(40)));
+    pkg.PkgInstall(YCPString(TestPackageName(70)));
+    CheckDU(pkg, "mixed changes");
+
+    // back to the initial state
+    for (unsigned index = 10; index <= 70; index += 10)
+	pkg.PkgNeutral(YCPString(TestPackageName(index)));
+
+    YCPValue reverted = pkg.TargetGetDU();
+    TEST_CHECK(!reverted.isNull() && reverted->toString() == initial->toString());
+
+    return TestResult("disk_usage_test");
+}
@@ -0,0 +1,38 @@
+/*
+ * File:   lazy_load_test.cc
+ *
+ * Unit test of the list of the builtins skipping the lazy repository load.
+ *
+ * Each name must be a registered builtin, a stale name (a renamed or
+ * removed builtin) would hide a missing new one.
+ */
+
+#include "test_tools.h"
+
+#include <PkgFunctions.h>
+#include <PkgModuleFunctions.h>
+
+#include <y2/Y2Function.h>
+
+#include <set>
+#include <string>
+
+int main()
+{
+    PkgModuleFunctions ns;
+
+    const std::set<std::string> &safe(PkgFunctions::LazySafeBuiltins());
+    TEST_CHECK(!safe.empty());
+
+    for (std::set<std::string>::const_iterator it = safe.begin(); it != safe.end(); ++it)
+    {
+	Y2Function *call = ns.createFunctionCall(*it, constFunctionTypePtr());
+
+	if (!TEST_CHECK(call != NULL))
+	    std::cerr << "Unknown builtin in the lazy load list: Pkg::" << *it << std::endl;
+
+	delete call;
+    }
+
+    return TestResult("lazy_load_test");
+}
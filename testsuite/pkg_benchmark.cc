@@ -0,0 +1,144 @@
+/*
+ * File:   pkg_benchmark.cc
+ *
+ * Benchmark of the core Pkg builtins on a synthetic pool.
+ *
+ * Usage: pkg_benchmark <solvables> [<results file>]
+ *
+ * A scratch root with a generated rpm-md repository is created, the timed
+ * builtins are called directly (without the YCP interpreter). The results
+ * are written as tab separated values (solvables, builtin, time in
+ * microseconds), the header line first. Run "make benchmark" in the testsuite
+ * directory for the 10k/60k/150k pools.
+ */
+
+#include "test_repo.h"
+
+#include <PkgFunctions.h>
+#include <PkgProfiler.h>
+
+#include <ycp/YCPBoolean.h>
+#include <ycp/YCPInteger.h>
+#include <ycp/YCPList.h>
+#include <ycp/YCPMap.h>
+#include <ycp/YCPString.h>
+#include <ycp/YCPSymbol.h>
+
+#include <zypp/PathInfo.h>
+#include <zypp/TmpPath.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+class Benchmark
+{
+    public:
+
+	Benchmark(unsigned solvables, std::ostream &out) : _solvables(solvables), _out(out), _start(0) {}
+
+	void start()
+	{
+	    _start = PkgProfiler::now();
+	}
+
+	// record the time since start()
+	void done(const char *builtin, const YCPValue &ret)
+	{
+	    long long time = PkgProfiler::now() - _start;
+
+	    if (ret.isNull())
+		std::cerr << "Pkg::" << builtin << " has failed" << std::endl;
+
+	    _out << _solvables << '\t' << builtin << '\t' << time << std::endl;
+	}
+
+    private:
+
+	unsigned _solvables;
+	std::ostream &_out;
+	long long _start;
+};
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || std::atoi(argv[1]) <= 0)
+    {
+	std::cerr << "Usage: " << argv[0] << " <solvables> [<results file>]" << std::endl;
+	return 1;
+    }
+
+    unsigned solvables = std::atoi(argv[1]);
+
+    // write the header line only to a new file
+    bool header = argc < 3 || !zypp::PathInfo(argv[2]).isFile() || zypp::PathInfo(argv[2]).size() == 0;
+
+    std::ofstream file;
+    if (argc > 2)
+	file.open(argv[2], std::ios_base::app);
+
+    std::ostream &out = argc > 2 ? file : std::cout;
+
+    if (!out)
+    {
+	std::cerr << "Cannot write " << argv[2] << std::endl;
+	return 1;
+    }
+
+    zypp::filesystem::TmpDir root;
+    CreateTestSystem(root.path(), solvables);
+
+    if (header)
+	out << "solvables\tbuiltin\ttime_us" << std::endl;
+
+    Benchmark bench(solvables, out);
+    PkgFunctions pkg;
+
+    bench.start();
+    bench.done("TargetInitialize", pkg.TargetInitialize(YCPString(root.path().asString())));
+
+    bench.start();
+    bench.done("SourceStartManager", pkg.SourceStartManager(YCPBoolean(true)));
+
+    bench.start();
+    bench.done("GetPackages", pkg.GetPackages(YCPSymbol("available"), YCPBoolean(true)));
+
+    bench.start();
+    bench.done("ResolvableProperties", pkg.ResolvableProperties(YCPString(""), YCPSymbol("package"), YCPString("")));
+
+    // select every 100th package, the solver adds the dependencies
+    for (unsigned index = 100; index <= solvables; index += 100)
+    {
+	pkg.PkgInstall(YCPString(TestPackageName(index)));
+    }
+
+    bench.start();
+    bench.done("PkgSolve", pkg.PkgSolve(YCPBoolean(false)));
+
+    bench.start();
+    bench.done("FilterPackages", pkg.FilterPackages(YCPBoolean(true), YCPBoolean(true), YCPBoolean(true), YCPBoolean(true)));
+
+    YCPMap partition;
+    partition->add(YCPString("name"), YCPString("/"));
+    partition->add(YCPString("free"), YCPInteger(10LL * 1024 * 1024));
+    partition->add(YCPString("used"), YCPInteger(1024LL * 1024));
+    partition->add(YCPString("readonly"), YCPBoolean(false));
+
+    YCPList partitions;
+    partitions->add(partition);
+
+    bench.start();
+    bench.done("TargetInitDU", pkg.TargetInitDU(partitions));
+
+    bench.start();
+    bench.done("TargetGetDU", pkg.TargetGetDU());
+
+    // the second call uses the cached results
+    bench.start();
+    bench.done("TargetGetDU (cached)", pkg.TargetGetDU());
+
+    bench.start();
+    bench.done("PkgMediaSizes", pkg.PkgMediaSizes());
+
+    return 0;
+}
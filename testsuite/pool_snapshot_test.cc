@@ -0,0 +1,102 @@
+/*
+ * File:   pool_snapshot_test.cc
+ *
+ * Unit test of the pool snapshot (PoolSnapshotSave/PoolSnapshotLoad).
+ *
+ * The saved state is restored after releasing the repositories and
+ * the target, an outdated snapshot is rejected and rolled back.
+ */
+
+#include "test_tools.h"
+#include "test_repo.h"
+
+#include <PkgFunctions.h>
+
+#include <ycp/YCPBoolean.h>
+#include <ycp/YCPList.h>
+#include <ycp/YCPString.h>
+
+#include <zypp/TmpPath.h>
+
+#include <fstream>
+#include <sstream>
+
+static const unsigned packages = 200;
+
+// release the repositories and the target
+static void Release(PkgFunctions &pkg)
+{
+    TEST_CHECK(IsTrue(pkg.SourceFinishAll()));
+    TEST_CHECK(IsTrue(pkg.TargetFinish()));
+    TEST_CHECK(!IsTrue(pkg.PkgAvailable(YCPString(TestPackageName(1)))));
+}
+
+static std::string Repos(PkgFunctions &pkg)
+{
+    YCPValue repos = pkg.SourceGetCurrent(YCPBoolean(false));
+    return repos.isNull() ? "nil" : repos->toString();
+}
+
+static std::string ReadFile(const zypp::Pathname &path)
+{
+    std::ifstream in(path.c_str());
+    std::ostringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+int main()
+{
+    zypp::filesystem::TmpDir root;
+    PkgFunctions pkg;
+
+    // the snapshot stores the loaded target only
+    if (!StartTestSystem(pkg, root.path(), packages, true))
+	return TestResult("pool_snapshot_test");
+
+    YCPString snapshot((root.path() / "pool.snapshot").asString());
+
+    std::string repos(Repos(pkg));
+    TEST_CHECK(IsTrue(pkg.PkgAvailable(YCPString(TestPackageName(1)))));
+
+    // save
+    TEST_CHECK(IsTrue(pkg.PoolSnapshotSave(snapshot)));
+
+    std::string content(ReadFile(snapshot->value()));
+    TEST_CHECK(content.find("version=") == 0);
+    TEST_CHECK(content.find("target=" + root.path().asString() + "\n") != std::string::npos);
+    TEST_CHECK(content.find("repo=bench\t1\t") != std::string::npos);
+
+    // the repositories are already registered
+    TEST_CHECK(!IsTrue(pkg.PoolSnapshotLoad(snapshot)));
+
+    // restore
+    Release(pkg);
+    TEST_CHECK(IsTrue(pkg.PoolSnapshotLoad(snapshot)));
+    TEST_CHECK(Repos(pkg) == repos);
+    TEST_CHECK(IsTrue(pkg.PkgAvailable(YCPString(TestPackageName(1)))));
+    TEST_CHECK(IsTrue(pkg.PkgAvailable(YCPString(TestPackageName(packages)))));
+
+    // a missing snapshot
+    Release(pkg);
+    TEST_CHECK(!IsTrue(pkg.PoolSnapshotLoad(YCPString((root.path() / "missing.snapshot").asString()))));
+    TEST_CHECK(!IsTrue(pkg.PkgAvailable(YCPString(TestPackageName(1)))));
+
+    // the repository has been changed, the snapshot is rejected and nothing is loaded
+    {
+	std::ofstream out((root.path() / "etc/zypp/repos.d/bench.repo").c_str(), std::ios_base::app);
+	out << "priority=50" << std::endl;
+    }
+
+    TEST_CHECK(!IsTrue(pkg.PoolSnapshotLoad(snapshot)));
+    TEST_CHECK(!IsTrue(pkg.PkgAvailable(YCPString(TestPackageName(1)))));
+
+    YCPValue current = pkg.SourceGetCurrent(YCPBoolean(false));
+    TEST_CHECK(!current.isNull() && current->isList() && current->asList()->size() == 0);
+
+    // the usual initialization still works after the rollback
+    TEST_CHECK(IsTrue(pkg.SourceStartManager(YCPBoolean(true))));
+    TEST_CHECK(IsTrue(pkg.PkgAvailable(YCPString(TestPackageName(1)))));
+
+    return TestResult("pool_snapshot_test");
+}
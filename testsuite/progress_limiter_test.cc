@@ -0,0 +1,138 @@
+/*
+ * File:   progress_limiter_test.cc
+ *
+ * Unit test of the progress rate limiting (ProgressLimiter).
+ *
+ * The time limits are set to 0 or to a very long interval so the results
+ * do not depend on the speed of the machine.
+ */
+
+#include "test_tools.h"
+
+#include <Callbacks.h>
+
+using ZyppRecipients::ProgressLimiter;
+using ZyppRecipients::ProgressThrottle;
+
+// the percent limit only
+static void TestDelta()
+{
+    ProgressThrottle throttle;
+    throttle.min_delta = 5;
+    throttle.min_interval = 0;
+    throttle.timeout = 0;
+
+    ProgressLimiter limiter;
+    limiter.reset();
+
+    TEST_CHECK(!limiter.pass(throttle, 1));
+    TEST_CHECK(!limiter.pass(throttle, 4));
+    TEST_CHECK(limiter.pass(throttle, 5));
+    // the delta is counted from the last reported value
+    TEST_CHECK(!limiter.pass(throttle, 9));
+    TEST_CHECK(limiter.pass(throttle, 10));
+    // a decreasing progress is a change as well
+    TEST_CHECK(limiter.pass(throttle, 2));
+    // 100% and the finish are always reported
+    TEST_CHECK(limiter.pass(throttle, 100));
+    TEST_CHECK(limiter.pass(throttle, 100));
+    limiter.reset(50);
+    TEST_CHECK(limiter.pass(throttle, 51, true));
+
+    TEST_CHECK(throttle.forwarded == 6);
+    TEST_CHECK(throttle.suppressed == 3);
+}
+
+// the minimal interval between two reports
+static void TestInterval()
+{
+    ProgressThrottle throttle;
+    throttle.min_delta = 1;
+    // not reached during the test
+    throttle.min_interval = 3600 * 1000LL;
+    throttle.timeout = 0;
+
+    ProgressLimiter limiter;
+    limiter.reset();
+
+    TEST_CHECK(!limiter.pass(throttle, 50));
+    TEST_CHECK(!limiter.passAlive(throttle));
+    TEST_CHECK(limiter.pass(throttle, 100));
+    TEST_CHECK(limiter.pass(throttle, 60, true));
+
+    throttle.min_interval = 0;
+    TEST_CHECK(limiter.passAlive(throttle));
+}
+
+// the deferred (coalesced) delivery
+static void TestAsync()
+{
+    ProgressThrottle throttle;
+    throttle.min_delta = 1;
+    throttle.min_interval = 0;
+    throttle.timeout = 0;
+    throttle.async = true;
+    throttle.async_interval = 3600 * 1000LL;
+
+    ProgressLimiter limiter;
+    limiter.reset();
+
+    int value = -1;
+    TEST_CHECK(!limiter.takePending(value));
+
+    // only the latest value is kept
+    TEST_CHECK(!limiter.passAsync(throttle, 10));
+    TEST_CHECK(!limiter.passAsync(throttle, 20));
+    TEST_CHECK(!limiter.passAsync(throttle, 30));
+    TEST_CHECK(throttle.coalesced == 3);
+
+    TEST_CHECK(limiter.takePending(value));
+    TEST_CHECK(value == 30);
+    TEST_CHECK(!limiter.takePending(value));
+
+    // 100% is delivered at once and drops the pending value
+    TEST_CHECK(!limiter.passAsync(throttle, 40));
+    TEST_CHECK(limiter.passAsync(throttle, 100));
+    TEST_CHECK(!limiter.takePending(value));
+
+    // the reset drops the pending value
+    TEST_CHECK(!limiter.passAsync(throttle, 50));
+    limiter.reset();
+    TEST_CHECK(!limiter.takePending(value));
+
+    // the interval has passed
+    throttle.async_interval = 0;
+    TEST_CHECK(limiter.passAsync(throttle, 60));
+
+    // without the async mode it is the same as pass()
+    throttle.async = false;
+    throttle.async_interval = 3600 * 1000LL;
+    TEST_CHECK(limiter.passAsync(throttle, 61));
+    TEST_CHECK(!limiter.takePending(value));
+}
+
+// the abort request applies to the next tick only
+static void TestAbort()
+{
+    ProgressThrottle throttle;
+
+    TEST_CHECK(!throttle.takeAbort());
+
+    throttle.abort_requested = 1;
+    TEST_CHECK(throttle.takeAbort());
+    TEST_CHECK(!throttle.takeAbort());
+
+    throttle.abort_requested = 1;
+    throttle.clearAbort();
+    TEST_CHECK(!throttle.takeAbort());
+}
+
+int main()
+{
+    TestDelta();
+    TestInterval();
+    TestAsync();
+    TestAbort();
+
+    return TestResult("progress_limiter_test");
+}
@@ -0,0 +1,92 @@
+/*
+ * File:   solver_cache_test.cc
+ *
+ * Unit test of the solver run cache ("solver_cache" option).
+ *
+ * PkgSolve() skips the solver only if the solve fingerprint has not been
+ * changed, any change of the selection, the solver flags or the requested
+ * locales must run the solver again (see "cached" in PkgSolveStats()).
+ */
+
+#include "test_tools.h"
+#include "test_repo.h"
+
+#include <PkgFunctions.h>
+
+#include <ycp/YCPBoolean.h>
+#include <ycp/YCPList.h>
+#include <ycp/YCPMap.h>
+#include <ycp/YCPString.h>
+
+#include <zypp/TmpPath.h>
+
+static const unsigned packages = 500;
+
+// run the solver, returns true if the solver has been skipped
+static bool SolveCached(PkgFunctions &pkg)
+{
+    TEST_CHECK(pkg.PkgSolve(YCPBoolean(false))->value());
+
+    YCPValue stats = pkg.PkgSolveStats();
+
+    if (!TEST_CHECK(!stats.isNull() && stats->isMap()))
+	return false;
+
+    return IsTrue(stats->asMap()->value(YCPString("cached")));
+}
+
+static void SetSolverCache(PkgFunctions &pkg, bool enabled)
+{
+    YCPMap cfg;
+    cfg->add(YCPString("solver_cache"), YCPBoolean(enabled));
+    TEST_CHECK(IsTrue(pkg.SetZConfig(cfg)));
+}
+
+int main()
+{
+    zypp::filesystem::TmpDir root;
+    PkgFunctions pkg;
+
+    if (!StartTestSystem(pkg, root.path(), packages))
+	return TestResult("solver_cache_test");
+
+    // disabled by default
+    TEST_CHECK(!SolveCached(pkg));
+    TEST_CHECK(!SolveCached(pkg));
+
+    SetSolverCache(pkg, true);
+    TEST_CHECK(!SolveCached(pkg));
+    TEST_CHECK(SolveCached(pkg));
+
+    // the selection has been changed
+    pkg.PkgInstall(YCPString(TestPackageName(100)));
+    TEST_CHECK(!SolveCached(pkg));
+    TEST_CHECK(SolveCached(pkg));
+
+    pkg.PkgNeutral(YCPString(TestPackageName(100)));
+    TEST_CHECK(!SolveCached(pkg));
+    TEST_CHECK(SolveCached(pkg));
+
+    // the solver flags
+    YCPMap flags;
+    flags->add(YCPString("onlyRequires"), YCPBoolean(true));
+    pkg.SetSolverFlags(flags);
+    TEST_CHECK(!SolveCached(pkg));
+    TEST_CHECK(SolveCached(pkg));
+
+    // the requested locales
+    YCPList locales;
+    locales->add(YCPString("de"));
+    pkg.SetAdditionalLocales(locales);
+    TEST_CHECK(!SolveCached(pkg));
+    TEST_CHECK(SolveCached(pkg));
+
+    // switching the option drops the remembered state
+    SetSolverCache(pkg, false);
+    TEST_CHECK(!SolveCached(pkg));
+    SetSolverCache(pkg, true);
+    TEST_CHECK(!SolveCached(pkg));
+    TEST_CHECK(SolveCached(pkg));
+
+    return TestResult("solver_cache_test");
+}
@@ -0,0 +1,120 @@
+/*
+ * File:   test_repo.cc
+ *
+ * Synthetic repository for the tests and the benchmark.
+ */
+
+#include "test_repo.h"
+
+#include <zypp/PathInfo.h>
+#include <zypp/base/GzStream.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+std::string TestPackageName(unsigned index)
+{
+    std::ostringstream name;
+    name << "bench-" << std::setw(6) << std::setfill('0') << index;
+    return name.str();
+}
+
+/*
+ * Write the rpm-md metadata for the synthetic packages, each package
+ * requires the capabilities of two other packages to give the solver
+ * some work and installs a file to a few shared directories.
+ */
+void GenerateTestRepo(const zypp::Pathname &dir, unsigned count)
+{
+    zypp::Pathname repodata(dir / "repodata");
+    zypp::filesystem::assert_dir(repodata);
+
+    zypp::Pathname primary(repodata / "primary.xml.gz");
+
+    {
+	zypp::ofgzstream out(primary.c_str());
+
+	out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << std::endl
+	    << "<metadata xmlns=\"http://linux.duke.edu/metadata/common\""
+	    << " xmlns:rpm=\"http://linux.duke.edu/metadata/rpm\" packages=\"" << count << "\">" << std::endl;
+
+	for (unsigned index = 1; index <= count; ++index)
+	{
+	    std::string name(TestPackageName(index));
+
+	    out << "<package type=\"rpm\">" << std::endl
+		<< "<name>" << name << "</name>" << std::endl
+		<< "<arch>noarch</arch>" << std::endl
+		<< "<version epoch=\"0\" ver=\"1.0\" rel=\"1\"/>" << std::endl
+		<< "<checksum type=\"sha256\" pkgid=\"YES\">" << std::setw(64) << std::setfill('0') << index << "</checksum>" << std::endl
+		<< "<summary>Synthetic package " << index << "</summary>" << std::endl
+		<< "<description>Synthetic package " << index << " for the Pkg benchmark.</description>" << std::endl
+		<< "<time file=\"1\" build=\"1\"/>" << std::endl
+		<< "<size package=\"" << 1024 + index % 4096 << "\" installed=\"" << 4096 + 16 * (index % 4096)
+		<< "\" archive=\"" << 4096 + 16 * (index % 4096) << "\"/>" << std::endl
+		<< "<location href=\"noarch/" << name << "-1.0-1.noarch.rpm\"/>" << std::endl
+		<< "<format>" << std::endl
+		<< "<rpm:license>GPL-2.0</rpm:license>" << std::endl
+		<< "<rpm:group>Benchmark</rpm:group>" << std::endl
+		<< "<rpm:provides>" << std::endl
+		<< "<rpm:entry name=\"" << name << "\" flags=\"EQ\" epoch=\"0\" ver=\"1.0\" rel=\"1\"/>" << std::endl
+		<< "<rpm:entry name=\"bench-cap-" << index << "\"/>" << std::endl
+		<< "</rpm:provides>" << std::endl;
+
+	    if (index > 1)
+	    {
+		out << "<rpm:requires>" << std::endl
+		    << "<rpm:entry name=\"bench-cap-" << index / 2 << "\"/>" << std::endl
+		    << "<rpm:entry name=\"bench-cap-" << (index + 1) / 3 << "\"/>" << std::endl
+		    << "</rpm:requires>" << std::endl;
+	    }
+
+	    out << "<file>/usr/share/bench/" << index % 64 << "/" << name << "</file>" << std::endl
+		<< "</format>" << std::endl
+		<< "</package>" << std::endl;
+	}
+
+	out << "</metadata>" << std::endl;
+    }
+
+    std::ofstream repomd((repodata / "repomd.xml").c_str());
+
+    repomd << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << std::endl
+	<< "<repomd xmlns=\"http://linux.duke.edu/metadata/repo\">" << std::endl
+	<< "<data type=\"primary\">" << std::endl
+	<< "<checksum type=\"sha256\">" << zypp::filesystem::checksum(primary, "sha256") << "</checksum>" << std::endl
+	<< "<location href=\"repodata/primary.xml.gz\"/>" << std::endl
+	<< "<timestamp>1</timestamp>" << std::endl
+	<< "</data>" << std::endl
+	<< "</repomd>" << std::endl;
+}
+
+void WriteTestRepoFile(const zypp::Pathname &root, const zypp::Pathname &repo)
+{
+    zypp::Pathname repos_d(root / "etc/zypp/repos.d");
+    zypp::filesystem::assert_dir(repos_d);
+
+    std::ofstream out((repos_d / "bench.repo").c_str());
+
+    out << "[bench]" << std::endl
+	<< "name=Benchmark" << std::endl
+	<< "enabled=1" << std::endl
+	<< "autorefresh=0" << std::endl
+	<< "baseurl=dir:" << repo << std::endl
+	<< "type=rpm-md" << std::endl
+	<< "gpgcheck=0" << std::endl;
+}
+
+zypp::Pathname CreateTestSystem(const zypp::Pathname &root, unsigned count)
+{
+    // do not lock the system libzypp
+    ::setenv("ZYPP_LOCKFILE_ROOT", root.c_str(), 1);
+
+    zypp::Pathname repo(root / "srv/bench");
+    GenerateTestRepo(repo, count);
+    WriteTestRepoFile(root, repo);
+
+    return repo;
+}
@@ -0,0 +1,31 @@
+/*
+ * File:   test_repo.h
+ *
+ * Synthetic repository for the tests and the benchmark.
+ *
+ * The packages are named bench-000001, bench-000002..., each package
+ * requires the capabilities of two other packages and installs a file
+ * to one of 64 shared directories in /usr/share/bench.
+ */
+
+#ifndef TEST_REPO_H
+#define TEST_REPO_H
+
+#include <string>
+
+#include <zypp/Pathname.h>
+
+// the name of the package with the index (1..count)
+std::string TestPackageName(unsigned index);
+
+// write the rpm-md metadata with count packages to the directory
+void GenerateTestRepo(const zypp::Pathname &dir, unsigned count);
+
+// add the repository (alias "bench") to the repos.d in the root
+void WriteTestRepoFile(const zypp::Pathname &root, const zypp::Pathname &repo);
+
+// prepare a scratch system in root (a TmpDir) with the generated repository,
+// the libzypp lock file is created there as well, returns the repository path
+zypp::Pathname CreateTestSystem(const zypp::Pathname &root, unsigned count);
+
+#endif // TEST_REPO_H
@@ -0,0 +1,22 @@
+/*
+ * File:   test_tools.cc
+ *
+ * Helpers for the unit tests using the generated test system.
+ */
+
+#include "test_tools.h"
+#include "test_repo.h"
+
+#include <PkgFunctions.h>
+
+#include <ycp/YCPString.h>
+
+bool StartTestSystem(PkgFunctions &pkg, const zypp::Pathname &root, unsigned packages, bool load_target)
+{
+    CreateTestSystem(root, packages);
+
+    YCPString target(root.asString());
+
+    return TEST_CHECK(IsTrue(load_target ? pkg.TargetInit(target, YCPBoolean(false)) : pkg.TargetInitialize(target)))
+	&& TEST_CHECK(IsTrue(pkg.SourceStartManager(YCPBoolean(true))));
+}
@@ -0,0 +1,67 @@
+/*
+ * File:   test_tools.h
+ *
+ * Helpers for the unit tests.
+ *
+ * Each test is a separate program run by "make check", the exit status
+ * is the result (0 = passed). A failed check is reported with the file
+ * and the line and the test continues with the next check.
+ */
+
+#ifndef TEST_TOOLS_H
+#define TEST_TOOLS_H
+
+#include <iostream>
+
+#include <ycp/YCPBoolean.h>
+
+#include <zypp/Pathname.h>
+
+class PkgFunctions;
+
+// the number of the failed checks
+inline unsigned &TestFailures()
+{
+    static unsigned failures = 0;
+    return failures;
+}
+
+inline bool TestCheck(bool result, const char *expr, const char *file, int line)
+{
+    if (!result)
+    {
+	std::cerr << file << ":" << line << ": check failed: " << expr << std::endl;
+	++TestFailures();
+    }
+
+    return result;
+}
+
+#define TEST_CHECK(expr) TestCheck((expr), #expr, __FILE__, __LINE__)
+
+// a builtin has returned true
+inline bool IsTrue(const YCPValue &value)
+{
+    return !value.isNull() && value->isBoolean() && value->asBoolean()->value();
+}
+
+// the exit status of the test program
+inline int TestResult(const char *name)
+{
+    if (TestFailures() > 0)
+    {
+	std::cerr << name << ": " << TestFailures() << " check(s) failed" << std::endl;
+	return 1;
+    }
+
+    std::cout << name << ": passed" << std::endl;
+    return 0;
+}
+
+// create the test system with the generated repository in root (a TmpDir),
+// initialize the target (load it if load_target is set) and load the repositories,
+// returns false (the failed check is reported) if the test cannot continue,
+// see test_tools.cc
+bool StartTestSystem(PkgFunctions &pkg, const zypp::Pathname &root, unsigned packages, bool load_target = false);
+
+#endif // TEST_TOOLS_H
@@ -0,0 +1,193 @@
+/*
+ * File:   transact_summary_test.cc
+ *
+ * Unit test of the cached transaction summary (FilterPackages, IsAnyResolvable).
+ *
+ * The builtins are called through the Pkg namespace like from YCP. After
+ * each selection change (by a builtin or directly through libzypp like
+ * the package selector does) the cached result must match GetPackages()
+ * which always scans the pool.
+ */
+
+#include "test_tools.h"
+#include "test_repo.h"
+
+#include <PkgModuleFunctions.h>
+
+#include <y2/Y2Function.h>
+
+#include <ycp/YCPBoolean.h>
+#include <ycp/YCPInteger.h>
+#include <ycp/YCPList.h>
+#include <ycp/YCPMap.h>
+#include <ycp/YCPString.h>
+#include <ycp/YCPSymbol.h>
+
+#include <zypp/TmpPath.h>
+#include <zypp/ui/Selectable.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+static const unsigned packages = 200;
+
+// evaluate Pkg::<name>(params...)
+static YCPValue Call(PkgModuleFunctions &ns, const char *name,
+    const YCPValue &p1 = YCPNull(), const YCPValue &p2 = YCPNull(),
+    const YCPValue &p3 = YCPNull(), const YCPValue &p4 = YCPNull())
+{
+    Y2Function *call = ns.createFunctionCall(name, constFunctionTypePtr());
+
+    if (!TEST_CHECK(call != NULL))
+	return YCPNull();
+
+    const YCPValue *params[] = { &p1, &p2, &p3, &p4 };
+    for (unsigned i = 0; i < sizeof(params) / sizeof(params[0]) && !params[i]->isNull(); ++i)
+	call->appendParameter(*params[i]);
+
+    YCPValue ret = call->evaluateCall();
+    delete call;
+
+    return ret;
+}
+
+static std::vector<std::string> Sorted(const YCPValue &list)
+{
+    std::vector<std::string> ret;
+
+    if (!TEST_CHECK(!list.isNull() && list->isList()))
+	return ret;
+
+    for (int i = 0; i < list->asList()->size(); ++i)
+	ret.push_back(list->asList()->value(i)->asString()->value());
+
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
+
+// the cached summary must match the current pool state
+static void CheckSummary(PkgModuleFunctions &ns, const char *step)
+{
+    YCPBoolean yes(true);
+    std::vector<std::string> selected(Sorted(Call(ns, "GetPackages", YCPSymbol("selected"), yes)));
+    std::vector<std::string> filtered(Sorted(Call(ns, "FilterPackages", yes, yes, yes, yes)));
+
+    if (!TEST_CHECK(selected == filtered))
+    {
+	std::cerr << step << ": " << selected.size() << " selected packages, "
+	    << filtered.size() << " in the summary" << std::endl;
+    }
+
+    TEST_CHECK(IsTrue(Call(ns, "IsAnyResolvable", YCPSymbol("package"), YCPSymbol("to_install")))
+	== !selected.empty());
+    TEST_CHECK(IsTrue(Call(ns, "IsAnyResolvable", YCPSymbol("any"), YCPSymbol("to_install")))
+	== !selected.empty());
+}
+
+int main()
+{
+    zypp::filesystem::TmpDir root;
+    CreateTestSystem(root.path(), packages);
+
+    PkgModuleFunctions ns;
+
+    if (!TEST_CHECK(IsTrue(Call(ns, "TargetInitialize", YCPString(root.path().asString()))))
+	|| !TEST_CHECK(IsTrue(Call(ns, "SourceStartManager", YCPBoolean(true)))))
+    {
+	return TestResult("transact_summary_test");
+    }
+
+    YCPValue repos = Call(ns, "SourceGetCurrent", YCPBoolean(true));
+    if (!TEST_CHECK(!repos.isNull() && repos->isList() && repos->asList()->size() == 1))
+	return TestResult("transact_summary_test");
+
+    YCPValue repo = repos->asList()->value(0);
+    YCPSymbol package("package");
+    YCPString first(TestPackageName(packages));
+    YCPString second(TestPackageName(packages - 1));
+
+    CheckSummary(ns, "initial");
+
+    // a new selection changing builtin should be added below as well
+    Call(ns, "PkgInstall", first);
+    CheckSummary(ns, "PkgInstall");
+    TEST_CHECK(IsTrue(Call(ns, "IsAnyResolvable", package, YCPSymbol("to_install"))));
+
+    Call(ns, "StateCheckpoint", YCPString("test"));
+
+    // the solver selects the dependencies
+    Call(ns, "PkgSolve", YCPBoolean(false));
+    CheckSummary(ns, "PkgSolve");
+
+    Call(ns, "PkgNeutral", first);
+    CheckSummary(ns, "PkgNeutral");
+
+    Call(ns, "StateRollback", YCPString("test"));
+    CheckSummary(ns, "StateRollback");
+
+    Call(ns, "PkgReset");
+    CheckSummary(ns, "PkgReset");
+
+    Call(ns, "ResolvableInstall", first, package);
+    CheckSummary(ns, "ResolvableInstall");
+
+    Call(ns, "ResolvableNeutral", first, package, YCPBoolean(true));
+    CheckSummary(ns, "ResolvableNeutral");
+
+    Call(ns, "ResolvableInstallArchVersion", second, package, YCPString("noarch"), YCPString("1.0-1"));
+    CheckSummary(ns, "ResolvableInstallArchVersion");
+
+    Call(ns, "PkgApplReset");
+    CheckSummary(ns, "PkgApplReset");
+
+    Call(ns, "ResolvableInstallRepo", first, package, repo);
+    CheckSummary(ns, "ResolvableInstallRepo");
+
+    YCPMap job;
+    job->add(YCPString("name"), first);
+    job->add(YCPString("action"), YCPSymbol("neutral"));
+    YCPList jobs;
+    jobs->add(job);
+    Call(ns, "ResolvableTransact", jobs);
+    CheckSummary(ns, "ResolvableTransact");
+
+    Call(ns, "ResolvableSetSoftLock", second, package);
+    CheckSummary(ns, "ResolvableSetSoftLock");
+
+    Call(ns, "SaveState");
+    Call(ns, "PkgInstall", first);
+    Call(ns, "RestoreState", YCPBoolean(false));
+    CheckSummary(ns, "RestoreState");
+
+    // a lock might change the selection
+    Call(ns, "PkgInstall", first);
+    YCPList lock_names;
+    lock_names->add(first);
+    YCPMap lock;
+    lock->add(YCPString("solvable:name"), lock_names);
+    Call(ns, "AddLock", lock);
+    CheckSummary(ns, "AddLock");
+
+    // the package selector changes the status directly, without any builtin
+    Call(ns, "PkgReset");
+    CheckSummary(ns, "PkgReset");
+
+    zypp::ui::Selectable::Ptr selectable
+	= zypp::ui::Selectable::get(zypp::ResKind::package, TestPackageName(packages / 2));
+    if (TEST_CHECK(selectable))
+    {
+	TEST_CHECK(selectable->setStatus(zypp::ui::S_Install, zypp::ResStatus::USER));
+	CheckSummary(ns, "Selectable::setStatus(S_Install)");
+	TEST_CHECK(IsTrue(Call(ns, "IsManualSelection")));
+
+	TEST_CHECK(selectable->setStatus(zypp::ui::S_NoInst, zypp::ResStatus::USER));
+	CheckSummary(ns, "Selectable::setStatus(S_NoInst)");
+	TEST_CHECK(!IsTrue(Call(ns, "IsManualSelection")));
+    }
+
+    Call(ns, "SourceFinishAll");
+    CheckSummary(ns, "SourceFinishAll");
+
+    return TestResult("transact_summary_test");
+}
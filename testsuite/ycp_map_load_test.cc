@@ -0,0 +1,95 @@
+/*
+ * File:   ycp_map_load_test.cc
+ *
+ * Unit test of YcpMapLoad (decoding the option maps).
+ */
+
+#include "test_tools.h"
+
+#include <ycpTools.h>
+
+#include <ycp/YCPBoolean.h>
+#include <ycp/YCPInteger.h>
+#include <ycp/YCPMap.h>
+#include <ycp/YCPString.h>
+#include <ycp/YCPVoid.h>
+
+int main()
+{
+    YcpMapLoad opts("Pkg::Test");
+    bool &force(opts.arg<YT_BOOLEAN, bool>("force", false));
+    long long &size(opts.arg<YT_INTEGER, long long>("size", 42LL));
+    std::string &name(opts.arg<YT_STRING, std::string>("name"));
+
+    // all keys
+    {
+	YCPMap map;
+	map->add(YCPString("force"), YCPBoolean(true));
+	map->add(YCPString("size"), YCPInteger(1024LL));
+	map->add(YCPString("name"), YCPString("foo"));
+
+	TEST_CHECK(opts.load(map));
+	TEST_CHECK(opts.error().empty());
+	TEST_CHECK(force);
+	TEST_CHECK(size == 1024LL);
+	TEST_CHECK(name == "foo");
+	TEST_CHECK(opts.has("force") && opts.has("size") && opts.has("name"));
+    }
+
+    // the optional keys get the defaults again, the unknown keys are ignored,
+    // nil is the same as a missing key
+    {
+	YCPMap map;
+	map->add(YCPString("name"), YCPString("bar"));
+	map->add(YCPString("unknown"), YCPInteger(1LL));
+	map->add(YCPString("force"), YCPVoid());
+	// not a string key
+	map->add(YCPInteger(1LL), YCPBoolean(true));
+
+	TEST_CHECK(opts.load(map));
+	TEST_CHECK(!force);
+	TEST_CHECK(size == 42LL);
+	TEST_CHECK(name == "bar");
+	TEST_CHECK(!opts.has("force"));
+	TEST_CHECK(!opts.has("size"));
+	TEST_CHECK(opts.has("name"));
+	TEST_CHECK(!opts.has("unknown"));
+    }
+
+    // a missing required key
+    {
+	YCPMap map;
+	map->add(YCPString("force"), YCPBoolean(true));
+
+	TEST_CHECK(!opts.load(map));
+	TEST_CHECK(opts.error().find("\"name\"") != std::string::npos);
+	TEST_CHECK(opts.has("force"));
+    }
+
+    // an empty map, the required key is missing
+    TEST_CHECK(!opts.load(YCPMap()));
+    TEST_CHECK(!opts.error().empty());
+
+    // a wrong type
+    {
+	YCPMap map;
+	map->add(YCPString("name"), YCPString("foo"));
+	map->add(YCPString("size"), YCPString("large"));
+
+	TEST_CHECK(!opts.load(map));
+	TEST_CHECK(opts.error().find("\"size\"") != std::string::npos);
+	TEST_CHECK(opts.error().find("expect") != std::string::npos);
+    }
+
+    // the error is cleared by the next load
+    {
+	YCPMap map;
+	map->add(YCPString("name"), YCPString("baz"));
+
+	TEST_CHECK(opts.load(map));
+	TEST_CHECK(opts.error().empty());
+	TEST_CHECK(name == "baz");
+    }
+
+    return TestResult("ycp_map_load_test");
+}